@@ -49,6 +49,11 @@ struct ProgramConfig {
         videoHeight = 0;
         queueCount = 1;
         numDecodeImagesInFlight = 8;
+        pipelinedDecodeDepth = 0;
+        decodeFilter = 0;
+        maxTemporalLayer = 7;
+        lowLatencyOutput = false;
+        seekRandomAccessPoint = 0;
         numDecodeImagesToPreallocate = -1; // pre-allocate the maximum num of images
         numBitstreamBuffersToPreallocate = 8;
         backBufferCount = 3;
@@ -184,9 +189,13 @@ struct ProgramConfig {
                     enableHwLoadBalancing = true;
                     return true;
                 }},
-            {"--input", "-i", 1, "Input filename to decode",
+            {"--input", "-i", 1, "Input filename to decode, \"-\" for the standard input. Pipes, FIFOs and "
+                                 "Unix sockets carry an elementary stream or MPEG-TS",
                 [this](const char **args, const ProgramArgs &a) {
                     videoFileName = args[0];
+                    if (videoFileName == "-") {
+                        return true;
+                    }
                     std::ifstream validVideoFileStream(videoFileName, std::ifstream::in);
                     return (bool)validVideoFileStream;
                 }},
@@ -213,6 +222,72 @@ struct ProgramConfig {
                     numDecodeImagesInFlight = std::atoi(args[0]);
                     return true;
                 }},
+            {"--pipelinedDecode", nullptr, 1,
+                "Record and submit the decode operations on a separate thread, fed with up to "
+                "this number of parsed pictures so that parsing overlaps recording (default: 0, disabled)",
+                [this](const char **args, const ProgramArgs &a) {
+                    pipelinedDecodeDepth = std::max(0, std::atoi(args[0]));
+                    return true;
+                }},
+            {"--decodeFilter", nullptr, 1,
+                "Only decode the random access pictures (\"keyframes\") or the reference pictures (\"references\"), "
+                "for thumbnails and fast scrubbing",
+                [this](const char **args, const ProgramArgs &a) {
+                    if (strcmp(args[0], "keyframes") == 0) {
+                        decodeFilter = 1;
+                        return true;
+                    } else if (strcmp(args[0], "references") == 0) {
+                        decodeFilter = 2;
+                        return true;
+                    } else {
+                        std::cerr << "Invalid decode filter \"" << args[0] << "\"" << std::endl;
+                        return false;
+                    }
+                }},
+            {"--maxTemporalLayer", nullptr, 1,
+                "Only decode the H.265 / AV1 temporal sub-layers up to this one, to lower the frame rate "
+                "when the host cannot keep up (default 7, all of them)",
+                [this](const char **args, const ProgramArgs &a) {
+                    maxTemporalLayer = std::min(std::max(0, std::atoi(args[0])), 7);
+                    return true;
+                }},
+            {"--lowLatency", nullptr, 0,
+                "Display each picture right after decoding it when the stream has no picture reordering, "
+                "and end the picture with its demuxed frame instead of waiting for the next one",
+                [this](const char **args, const ProgramArgs &a) {
+                    lowLatencyOutput = true;
+                    return true;
+                }},
+            {"--seekIndex", nullptr, 1,
+                "Random access index of the input, built with vk-video-parse-bench --index, to start decoding "
+                "at one of its random access points (elementary streams only, see --seekRandomAccessPoint)",
+                [this](const char **args, const ProgramArgs &a) {
+                    seekIndexFileName = args[0];
+                    return true;
+                }},
+            {"--seekRandomAccessPoint", nullptr, 1,
+                "Random access point of the --seekIndex index to start decoding at (default 0, the first one)",
+                [this](const char **args, const ProgramArgs &a) {
+                    seekRandomAccessPoint = std::atoi(args[0]);
+                    if (seekRandomAccessPoint < 0) {
+                        std::cerr << "The random access point must not be negative" << std::endl;
+                        return false;
+                    }
+                    return true;
+                }},
+            {"--captureParserTrace", nullptr, 1,
+                "Record the parser output (sequences, parameter sets, pictures and displays) to this file",
+                [this](const char **args, const ProgramArgs &a) {
+                    parserTraceCaptureFileName = args[0];
+                    return true;
+                }},
+            {"--replayParserTrace", nullptr, 1,
+                "Decode the parser output recorded with --captureParserTrace instead of parsing the input, "
+                "which is still read to pace the replay",
+                [this](const char **args, const ProgramArgs &a) {
+                    parserTraceReplayFileName = args[0];
+                    return true;
+                }},
             {"--displayBackBufferSize", nullptr, 1,
                 "Size of display back-buffers swapchain queue size",
                 [this](const char **args, const ProgramArgs &a) {
@@ -355,7 +430,8 @@ struct ProgramConfig {
             // This allows us to give better error messages as we don't expect any values to start with `-`
             if (!disableValueCheck) {
                 for (int j = 1; j <= flag->numArgs; j++) {
-                    if (argv[i + j][0] == '-') {
+                    // A lone "-" is the standard input
+                    if ((argv[i + j][0] == '-') && (argv[i + j][1] != '\0')) {
                         std::cerr << "Invalid value \"" << argv[i + j] << "\" for \"" << argv[i] << "\" "
                             "(we don't allow values starting with `-` by default). You probably missed to "
                             "set a value for \"" << argv[i] << "\"." << std::endl;
@@ -443,6 +519,11 @@ struct ProgramConfig {
     int videoHeight;
     int queueCount;
     int32_t numDecodeImagesInFlight;
+    int32_t pipelinedDecodeDepth;
+    uint32_t decodeFilter; // VK_PARSER_DECODE_FILTER_XXX: 0 = all, 1 = random access, 2 = reference pictures
+    uint32_t maxTemporalLayer; // Highest temporal sub-layer decoded, 7 (VK_PARSER_TEMPORAL_LAYER_ALL) = all
+    bool lowLatencyOutput; // Immediate output of the streams without reordering
+    int32_t seekRandomAccessPoint; // Random access point of seekIndexFileName decoding starts at
     int32_t numDecodeImagesToPreallocate;
     int32_t numBitstreamBuffersToPreallocate;
     int backBufferCount;
@@ -451,6 +532,9 @@ struct ProgramConfig {
 
     std::string videoFileName;
     std::string outputFileName;
+    std::string parserTraceCaptureFileName;
+    std::string parserTraceReplayFileName;
+    std::string seekIndexFileName;
     int gpuIndex;
     int loopCount;
     int queueId;
@@ -0,0 +1,36 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKCODECUTILS_VKALLOCATIONCOUNTER_H_
+#define _VKCODECUTILS_VKALLOCATIONCOUNTER_H_
+
+#include <stdint.h>
+
+// Counts the heap allocations made through operator new, to check that the steady-state
+// parse path does not allocate. The counting operator new is only built in with the
+// ENABLE_ALLOCATION_COUNTER CMake option (VK_VIDEO_ALLOCATION_COUNTER), in the program
+// that links VkAllocationCounter.cpp: only vk-video-parse-bench does. It checks the parser
+// library and VulkanVideoParser, on the streams it is run on, and nothing past them: the
+// decode path of VkVideoDecoder needs a device and may still allocate per picture.
+// On Windows the allocations of the parser DLL go through its own runtime and are not counted.
+class VkAllocationCounter {
+public:
+    static bool IsEnabled();
+    // Number of allocations since the start of the program, 0 if the counter is not enabled
+    static uint64_t GetAllocationCount();
+};
+
+#endif /* _VKCODECUTILS_VKALLOCATIONCOUNTER_H_ */
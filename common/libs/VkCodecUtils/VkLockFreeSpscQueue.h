@@ -0,0 +1,96 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VKCODECUTILS_VKLOCKFREESPSCQUEUE_H_
+#define _VKCODECUTILS_VKLOCKFREESPSCQUEUE_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+// Bounded single-producer, single-consumer ring of nodes that are filled and consumed
+// in place. The producer fills the node returned by GetProducerNode() and publishes it
+// with PushProducerNode(); the consumer processes the node returned by GetConsumerNode()
+// and hands it back with PopConsumerNode(). Neither side ever blocks: a null node means
+// the ring is full (producer) or empty (consumer) and the caller decides how to wait.
+template <typename QueueNodeType>
+class VkLockFreeSpscQueue {
+public:
+    VkLockFreeSpscQueue(uint32_t maxPendingQueueNodes = 4)
+     : m_maxPendingQueueNodes(maxPendingQueueNodes)
+     , m_indexMask(0)
+     , m_nodes()
+     , m_head(0)
+     , m_headPadding()
+     , m_tail(0)
+    {
+        assert(maxPendingQueueNodes > 0);
+        uint32_t numNodes = 1;
+        while (numNodes < maxPendingQueueNodes) {
+            numNodes <<= 1;
+        }
+        m_indexMask = numNodes - 1;
+        m_nodes.resize(numNodes);
+    }
+
+    // Producer side
+    QueueNodeType* GetProducerNode() {
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        if ((head - m_tail.load(std::memory_order_acquire)) >= m_maxPendingQueueNodes) {
+            return nullptr;
+        }
+        return &m_nodes[head & m_indexMask];
+    }
+
+    void PushProducerNode() {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer side
+    QueueNodeType* GetConsumerNode() {
+        const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_nodes[tail & m_indexMask];
+    }
+
+    void PopConsumerNode() {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // True once the consumer has popped every node pushed so far
+    bool Empty() const {
+        return (m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire));
+    }
+
+    uint32_t Size() const {
+        return (m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+
+private:
+    const uint32_t             m_maxPendingQueueNodes;
+    uint32_t                   m_indexMask;
+    std::vector<QueueNodeType> m_nodes;
+    // The indices only ever grow, and wrap around together with the unsigned arithmetic.
+    // The padding keeps them on separate cache lines, so that the two threads do not contend.
+    std::atomic<uint32_t>      m_head; // written by the producer only
+    uint8_t                    m_headPadding[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t>      m_tail; // written by the consumer only
+};
+
+#endif /* _VKCODECUTILS_VKLOCKFREESPSCQUEUE_H_ */
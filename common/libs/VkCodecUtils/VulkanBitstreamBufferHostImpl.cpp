@@ -0,0 +1,258 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "VkCodecUtils/VulkanBitstreamBufferHostImpl.h"
+
+VkResult
+VulkanBitstreamBufferHostImpl::Create(VkDeviceSize bufferSize, VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment,
+        const void* pInitializeBufferMemory, VkDeviceSize initializeBufferMemorySize,
+        VkSharedBaseObj<VulkanBitstreamBufferHostImpl>& vulkanBitstreamBuffer)
+{
+    VkSharedBaseObj<VulkanBitstreamBufferHostImpl> vkBitstreamBuffer(new VulkanBitstreamBufferHostImpl(bufferOffsetAlignment,
+                                                                                                         bufferSizeAlignment));
+    if (!vkBitstreamBuffer) {
+        assert(!"Out of host memory!");
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkResult result = vkBitstreamBuffer->Initialize(bufferSize,
+                                                    pInitializeBufferMemory,
+                                                    initializeBufferMemorySize);
+    if (result == VK_SUCCESS) {
+        vulkanBitstreamBuffer = vkBitstreamBuffer;
+    } else {
+        assert(!"Initialize failed!");
+    }
+
+    return result;
+}
+
+VkDeviceSize VulkanBitstreamBufferHostImpl::Clone(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset,
+                                                  VkSharedBaseObj<VulkanBitstreamBuffer>& vulkanBitstreamBuffer)
+{
+    VkSharedBaseObj<VulkanBitstreamBufferHostImpl> vkBitstreamBuffer(new VulkanBitstreamBufferHostImpl(m_bufferOffsetAlignment,
+                                                                                                         m_bufferSizeAlignment));
+    if (!vkBitstreamBuffer) {
+        assert(!"Out of host memory!");
+        return 0;
+    }
+
+    const uint8_t* oldBufPtr = nullptr;
+    if (copySize) {
+        oldBufPtr = CheckAccess(copyOffset, copySize);
+    }
+    VkResult result = vkBitstreamBuffer->Initialize(newSize, oldBufPtr, copySize);
+    if (result != VK_SUCCESS) {
+        assert(!"Initialize failed!");
+        return 0;
+    }
+    vulkanBitstreamBuffer = vkBitstreamBuffer;
+
+    return newSize;
+}
+
+VkResult VulkanBitstreamBufferHostImpl::Initialize(VkDeviceSize bufferSize,
+                                                   const void* pInitializeBufferMemory,
+                                                   VkDeviceSize initializeBufferMemorySize)
+{
+    bufferSize = ((bufferSize + (m_bufferSizeAlignment - 1)) & ~(m_bufferSizeAlignment - 1));
+    if (initializeBufferMemorySize > bufferSize) {
+        assert(!"The initialization data does not fit in the buffer!");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    m_buffer.resize((size_t)bufferSize);
+    if (pInitializeBufferMemory && initializeBufferMemorySize) {
+        memcpy(m_buffer.data(), pInitializeBufferMemory, (size_t)initializeBufferMemorySize);
+    }
+
+    return VK_SUCCESS;
+}
+
+VkDeviceSize VulkanBitstreamBufferHostImpl::GetMaxSize() const
+{
+    return m_buffer.size();
+}
+
+VkDeviceSize VulkanBitstreamBufferHostImpl::GetOffsetAlignment() const
+{
+    return m_bufferOffsetAlignment;
+}
+
+VkDeviceSize VulkanBitstreamBufferHostImpl::GetSizeAlignment() const
+{
+    return m_bufferSizeAlignment;
+}
+
+VkDeviceSize VulkanBitstreamBufferHostImpl::Resize(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset)
+{
+    if (m_buffer.size() >= newSize) {
+        return m_buffer.size();
+    }
+
+    newSize = ((newSize + (m_bufferSizeAlignment - 1)) & ~(m_bufferSizeAlignment - 1));
+    if (copyOffset) {
+        assert((copyOffset + copySize) <= m_buffer.size());
+        memmove(m_buffer.data(), m_buffer.data() + copyOffset, (size_t)copySize);
+    }
+    m_buffer.resize((size_t)newSize);
+
+    return newSize;
+}
+
+uint8_t* VulkanBitstreamBufferHostImpl::CheckAccess(VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (offset + size <= m_buffer.size()) {
+        return const_cast<uint8_t*>(m_buffer.data()) + offset;
+    }
+
+    assert(!"Bad buffer access - out of range!");
+    return nullptr;
+}
+
+int64_t VulkanBitstreamBufferHostImpl::MemsetData(uint32_t value, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    uint8_t* writeData = CheckAccess(offset, size);
+    if (writeData == nullptr) {
+        return -1;
+    }
+    memset(writeData, (int)value, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHostImpl::CopyDataToBuffer(uint8_t *dstBuffer, VkDeviceSize dstOffset,
+                                                        VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        return -1;
+    }
+    memcpy(dstBuffer + dstOffset, readData, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHostImpl::CopyDataToBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& dstBuffer, VkDeviceSize dstOffset,
+                                                        VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        assert(!"Could not CopyDataToBuffer!");
+        return -1;
+    }
+    return dstBuffer->CopyDataFromBuffer(readData, 0, dstOffset, size);
+}
+
+int64_t VulkanBitstreamBufferHostImpl::CopyDataFromBuffer(const uint8_t *sourceBuffer, VkDeviceSize srcOffset,
+                                                          VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    uint8_t* writeData = CheckAccess(dstOffset, size);
+    if (writeData == nullptr) {
+        return -1;
+    }
+    memcpy(writeData, sourceBuffer + srcOffset, (size_t)size);
+    return size;
+}
+
+int64_t VulkanBitstreamBufferHostImpl::CopyDataFromBuffer(const VkSharedBaseObj<VulkanBitstreamBuffer>& sourceBuffer,
+                                                          VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    VkDeviceSize maxSize = 0;
+    const uint8_t* readData = sourceBuffer->GetReadOnlyDataPtr(srcOffset, maxSize);
+    if ((readData == nullptr) || (maxSize < size)) {
+        assert(!"Could not CopyDataFromBuffer!");
+        return -1;
+    }
+
+    return CopyDataFromBuffer(readData, 0, dstOffset, size);
+}
+
+uint8_t* VulkanBitstreamBufferHostImpl::GetDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize)
+{
+    uint8_t* readData = CheckAccess(offset, 1);
+    if (readData == nullptr) {
+        assert(!"Could not GetDataPtr()!");
+        return nullptr;
+    }
+    maxSize = m_buffer.size() - offset;
+    return readData;
+}
+
+const uint8_t* VulkanBitstreamBufferHostImpl::GetReadOnlyDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize) const
+{
+    uint8_t* readData = CheckAccess(offset, 1);
+    if (readData == nullptr) {
+        assert(!"Could not GetReadOnlyDataPtr()!");
+        return nullptr;
+    }
+    maxSize = m_buffer.size() - offset;
+    return readData;
+}
+
+uint32_t VulkanBitstreamBufferHostImpl::AddStreamMarker(uint32_t streamOffset)
+{
+    m_streamMarkers.push_back(streamOffset);
+    return (uint32_t)(m_streamMarkers.size() - 1);
+}
+
+uint32_t VulkanBitstreamBufferHostImpl::SetStreamMarker(uint32_t streamOffset, uint32_t index)
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    if (!(index < (uint32_t)m_streamMarkers.size())) {
+        return uint32_t(-1);
+    }
+    m_streamMarkers[index] = streamOffset;
+    return index;
+}
+
+uint32_t VulkanBitstreamBufferHostImpl::GetStreamMarker(uint32_t index) const
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    return m_streamMarkers[index];
+}
+
+uint32_t VulkanBitstreamBufferHostImpl::GetStreamMarkersCount() const
+{
+    return (uint32_t)m_streamMarkers.size();
+}
+
+const uint32_t* VulkanBitstreamBufferHostImpl::GetStreamMarkersPtr(uint32_t startIndex, uint32_t& maxCount) const
+{
+    maxCount = (uint32_t)m_streamMarkers.size() - startIndex;
+    return m_streamMarkers.data() + startIndex;
+}
+
+uint32_t VulkanBitstreamBufferHostImpl::ResetStreamMarkers()
+{
+    uint32_t oldSize = (uint32_t)m_streamMarkers.size();
+    m_streamMarkers.clear();
+    return oldSize;
+}
@@ -871,11 +871,13 @@ VulkanDeviceContext::~VulkanDeviceContext() {
 
     m_isExternallyManagedDevice = false;
 
+    if (m_libHandle) {
 #if !defined(VK_USE_PLATFORM_WIN32_KHR)
-    dlclose(m_libHandle);
+        dlclose(m_libHandle);
 #else // defined(VK_USE_PLATFORM_WIN32_KHR)
-    FreeLibrary(m_libHandle);
+        FreeLibrary(m_libHandle);
 #endif // defined(VK_USE_PLATFORM_WIN32_KHR)
+    }
 }
 
 const VkExtensionProperties* VulkanDeviceContext::FindExtension(const std::vector<VkExtensionProperties>& extensions,
@@ -30,6 +30,7 @@
 #include "VkCodecUtils/VulkanDeviceContext.h"
 #include "VkVideoCore/VulkanVideoCapabilities.h"
 #include "VulkanVideoProcessor.h"
+#include "vkvideo_parser/VulkanVideoParserTrace.h"
 #include "vulkan_interfaces.h"
 #include "nvidia_utils/vulkan/ycbcrvkinfo.h"
 #include "crcgenerator.h"
@@ -60,7 +61,9 @@ int32_t VulkanVideoProcessor::Initialize(const VulkanDeviceContext* vkDevCtx,
     const uint32_t loopCount = programConfig.loopCount;
     const uint32_t startFrame = 0;
     const int32_t  maxFrameCount = programConfig.maxFrameCount;
-    const int32_t numDecodeImagesInFlight = std::max(programConfig.numDecodeImagesInFlight, 4);
+    const uint32_t pipelinedDecodeDepth = (uint32_t)programConfig.pipelinedDecodeDepth;
+    // The pictures queued for the submit thread of the parser are in flight as well
+    const int32_t numDecodeImagesInFlight = std::max(programConfig.numDecodeImagesInFlight, 4) + (int32_t)pipelinedDecodeDepth;
     const int32_t numDecodeImagesToPreallocate = programConfig.numDecodeImagesToPreallocate;
     const int32_t numBitstreamBuffersToPreallocate = std::max(programConfig.numBitstreamBuffersToPreallocate, 4);
     const bool enableHwLoadBalancing = programConfig.enableHwLoadBalancing;
@@ -82,7 +85,10 @@ int32_t VulkanVideoProcessor::Initialize(const VulkanDeviceContext* vkDevCtx,
 
     m_vkDevCtx = vkDevCtx;
 
-    CheckInputFile(filePath);
+    // The standard input can only be read once, by the demuxer
+    if (strcmp(filePath, "-") != 0) {
+        CheckInputFile(filePath);
+    }
 
     VkResult result = VideoStreamDemuxer::Create(filePath,
                                                  forceCodecType,
@@ -183,6 +189,71 @@ int32_t VulkanVideoProcessor::Initialize(const VulkanDeviceContext* vkDevCtx,
         fprintf(stderr, "\nERROR: CreateParser() result: 0x%x\n", result);
     }
 
+    if ((result == VK_SUCCESS) && (pipelinedDecodeDepth > 0)) {
+        result = m_vkParser->EnablePipelinedDecode(pipelinedDecodeDepth);
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: EnablePipelinedDecode() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && !programConfig.parserTraceCaptureFileName.empty()) {
+        result = m_vkParser->EnableTraceCapture(programConfig.parserTraceCaptureFileName.c_str());
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: EnableTraceCapture() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && (programConfig.decodeFilter != VK_PARSER_DECODE_FILTER_NONE)) {
+        result = m_vkParser->SetDecodeFilter(programConfig.decodeFilter);
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: SetDecodeFilter() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && (programConfig.maxTemporalLayer < VK_PARSER_TEMPORAL_LAYER_ALL)) {
+        result = m_vkParser->SetMaxTemporalLayer(programConfig.maxTemporalLayer);
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: SetMaxTemporalLayer() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && programConfig.lowLatencyOutput) {
+        result = m_vkParser->EnableLowLatencyOutput();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: EnableLowLatencyOutput() result: 0x%x\n", result);
+        }
+    }
+
+    // ReadBitstreamData() hands out pieces of the byte stream, which the streamed inputs split anywhere
+    if ((result == VK_SUCCESS) && !m_usesStreamDemuxer && !m_usesFramePreparser) {
+        result = m_vkParser->EnableStreamingInput();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: EnableStreamingInput() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && m_videoStreamDemuxer->IsAv1AnnexB()) {
+        result = m_vkParser->EnableAv1AnnexBInput();
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: EnableAv1AnnexBInput() result: 0x%x\n", result);
+        }
+    }
+
+    // MP4 samples are handed over as they are, with length-prefixed NAL units
+    size_t configurationRecordSize = 0;
+    const uint8_t* pConfigurationRecord = m_videoStreamDemuxer->GetDecoderConfigurationRecord(configurationRecordSize);
+    if ((result == VK_SUCCESS) && (pConfigurationRecord != nullptr)) {
+        result = m_vkParser->SetDecoderConfigurationRecord(pConfigurationRecord, configurationRecordSize);
+        if (result != VK_SUCCESS) {
+            fprintf(stderr, "\nERROR: SetDecoderConfigurationRecord() result: 0x%x\n", result);
+        }
+    }
+
+    if ((result == VK_SUCCESS) && !programConfig.seekIndexFileName.empty() &&
+        !InitializeSeek(programConfig.seekIndexFileName.c_str(), (size_t)programConfig.seekRandomAccessPoint)) {
+        return -1;
+    }
+
     m_loopCount = loopCount;
     m_startFrame = startFrame;
     m_maxFrameCount = maxFrameCount;
@@ -254,6 +325,9 @@ void VulkanVideoProcessor::Deinit()
     m_vkVideoDecoder = nullptr;
     m_vkVideoFrameBuffer = nullptr;
     m_videoStreamDemuxer = nullptr;
+    m_seekPending = false;
+    m_randomAccessIndex.Reset(VK_VIDEO_CODEC_OPERATION_NONE_KHR);
+    m_seekRandomAccessPoint = VulkanVideoRandomAccessIndex::invalidIndex;
 }
 
 void VulkanVideoProcessor::DumpVideoFormat(const VkParserDetectedVideoFormat* videoFormat, bool dumpData)
@@ -576,6 +650,48 @@ void VulkanVideoProcessor::Restart(void)
     m_videoStreamDemuxer->Rewind();
     m_videoFrameNum = false;
     m_currentBitstreamOffset = 0;
+    VkParserRandomAccessPoint randomAccessPoint;
+    if (m_randomAccessIndex.GetRandomAccessPoint(m_seekRandomAccessPoint, &randomAccessPoint)) {
+        m_currentBitstreamOffset = randomAccessPoint.llOffset;
+        m_seekPending = true;
+    }
+}
+
+// Decoding starts at a random access point of the index vk-video-parse-bench --index built for the
+// input. The index has byte stream offsets, so only the elementary streams read in place can seek.
+bool VulkanVideoProcessor::InitializeSeek(const char* pIndexFileName, size_t randomAccessPoint)
+{
+    if (m_usesStreamDemuxer || m_usesFramePreparser) {
+        std::cerr << "Seek: the random access index only applies to elementary streams" << std::endl;
+        return false;
+    }
+    if (!m_randomAccessIndex.Read(pIndexFileName)) {
+        std::cerr << "Seek: can't read the random access index " << pIndexFileName << std::endl;
+        return false;
+    }
+    if (m_randomAccessIndex.GetVideoCodec() != m_videoStreamDemuxer->GetVideoCodec()) {
+        std::cerr << "Seek: " << pIndexFileName << " is the index of a "
+                  << VkVideoCoreProfile::CodecToName(m_randomAccessIndex.GetVideoCodec()) << " stream" << std::endl;
+        return false;
+    }
+    VkParserRandomAccessPoint randomAccessPointInfo;
+    if (!m_randomAccessIndex.GetRandomAccessPoint(randomAccessPoint, &randomAccessPointInfo)) {
+        std::cerr << "Seek: " << pIndexFileName << " only has " << m_randomAccessIndex.GetCount()
+                  << " random access points" << std::endl;
+        return false;
+    }
+    const uint8_t* pBitstreamData = nullptr;
+    if ((m_videoStreamDemuxer->ReadBitstreamData(&pBitstreamData, randomAccessPointInfo.llOffset) <= 0) ||
+        (pBitstreamData == nullptr)) {
+        std::cerr << "Seek: the input can't be read at offset " << randomAccessPointInfo.llOffset << std::endl;
+        return false;
+    }
+    std::cout << "Seek: starting at random access point " << randomAccessPoint << ", offset "
+              << randomAccessPointInfo.llOffset << std::endl;
+    m_seekRandomAccessPoint = randomAccessPoint;
+    m_currentBitstreamOffset = randomAccessPointInfo.llOffset;
+    m_seekPending = true;
+    return true;
 }
 
 bool VulkanVideoProcessor::StreamCompleted()
@@ -587,10 +703,44 @@ bool VulkanVideoProcessor::StreamCompleted()
         return false;
     } else {
         std::cout << "End of Video Stream with status  " << VK_SUCCESS << std::endl;
+        if (m_settings.pipelinedDecodeDepth > 0) {
+            DumpPipelineStats();
+        }
+        if (m_settings.maxTemporalLayer < VK_PARSER_TEMPORAL_LAYER_ALL) {
+            VkParserTemporalLayerStats temporalLayerStats;
+            m_vkParser->GetTemporalLayerStats(&temporalLayerStats);
+            std::cout << "Temporal sub-layers up to " << temporalLayerStats.maxTemporalLayer << ": "
+                      << temporalLayerStats.droppedPictures << " pictures dropped" << std::endl;
+        }
+        if (m_settings.lowLatencyOutput) {
+            VulkanVideoParserLatencyStats latencyStats;
+            m_vkParser->GetDisplayLatencyStats(&latencyStats);
+            const uint64_t displayedPictures = std::max<uint64_t>(latencyStats.displayedPictures, 1);
+            std::cout << "Decode to display delay: average " << ((double)latencyStats.delayPictures / displayedPictures)
+                      << " pictures, " << (latencyStats.delayUs / displayedPictures) << " us, max "
+                      << latencyStats.maxDelayPictures << " pictures, " << latencyStats.maxDelayUs << " us" << std::endl;
+        }
         return true;
     }
 }
 
+void VulkanVideoProcessor::DumpPipelineStats()
+{
+    VulkanVideoParserPipelineStats stats;
+    m_vkParser->GetPipelineStats(&stats);
+
+    const double msPerNs = 1.0 / 1000000.0;
+    const int64_t overlapNs = (int64_t)(stats.parseTimeNs + stats.submitTimeNs) - (int64_t)stats.elapsedTimeNs;
+    std::cout << "Pipelined decode: " << stats.decodedPictures << " pictures decoded, "
+              << stats.displayedPictures << " displayed" << std::endl
+              << "\tParse thread  : busy " << (stats.parseTimeNs * msPerNs) << " ms (filling pictures "
+              << (stats.fillTimeNs * msPerNs) << " ms), waiting " << (stats.parseWaitTimeNs * msPerNs) << " ms" << std::endl
+              << "\tSubmit thread : busy " << (stats.submitTimeNs * msPerNs) << " ms, idle "
+              << (stats.submitIdleTimeNs * msPerNs) << " ms" << std::endl
+              << "\tElapsed " << (stats.elapsedTimeNs * msPerNs) << " ms, overlap "
+              << (std::max<int64_t>(overlapNs, 0) * msPerNs) << " ms" << std::endl;
+}
+
 int32_t VulkanVideoProcessor::ParserProcessNextDataChunk()
 {
     if (m_videoStreamsCompleted) {
@@ -602,8 +752,19 @@ int32_t VulkanVideoProcessor::ParserProcessNextDataChunk()
     size_t  bitstreamBytesConsumed = 0;
     const uint8_t* pBitstreamData = nullptr;
     bool requiresPartialParsing = false;
+    uint32_t packetFlags = 0;
+    int64_t timestamp = 0;
     if (m_usesFramePreparser || m_usesStreamDemuxer) {
         bitstreamChunkSize = m_videoStreamDemuxer->DemuxFrame(&pBitstreamData);
+        timestamp = m_videoStreamDemuxer->GetFrameTimestamp();
+        // Data was lost: the parser ends the picture in progress and drops its pending timestamps
+        if (m_videoStreamDemuxer->HasFrameDiscontinuity()) {
+            packetFlags |= VK_PARSER_PKT_DISCONTINUITY;
+        }
+        // A demuxed frame holds a whole picture: no need to wait for the start of the next one to decode it
+        if (m_settings.lowLatencyOutput) {
+            packetFlags |= VK_PARSER_PKT_ENDOFPICTURE;
+        }
         assert(bitstreamBytesConsumed <= (size_t)std::numeric_limits<int32_t>::max());
         retValue = (int32_t)bitstreamChunkSize;
     } else {
@@ -615,7 +776,8 @@ int32_t VulkanVideoProcessor::ParserProcessNextDataChunk()
         assert((uint64_t)bitstreamChunkSize < (uint64_t)std::numeric_limits<size_t>::max());
         VkResult parserStatus = ParseVideoStreamData(pBitstreamData, (size_t)bitstreamChunkSize,
                                                      &bitstreamBytesConsumed,
-                                                     requiresPartialParsing);
+                                                     requiresPartialParsing,
+                                                     packetFlags, timestamp);
         if (parserStatus != VK_SUCCESS) {
             m_videoStreamsCompleted = true;
             std::cerr << "Parser: end of Video Stream with status  " << parserStatus << std::endl;
@@ -725,6 +887,15 @@ VkResult VulkanVideoProcessor::CreateParser(const char*,
 
     VkSharedBaseObj<IVulkanVideoDecoderHandler> decoderHandler(m_vkVideoDecoder);
     VkSharedBaseObj<IVulkanVideoFrameBufferParserCb> videoFrameBufferCb(m_vkVideoFrameBuffer);
+    if (!m_settings.parserTraceReplayFileName.empty()) {
+        return vulkanCreateVideoParserTraceReplayer(m_settings.parserTraceReplayFileName.c_str(),
+                                                    decoderHandler,
+                                                    videoFrameBufferCb,
+                                                    vkCodecType,
+                                                    bufferOffsetAlignment,
+                                                    bufferSizeAlignment,
+                                                    m_vkParser);
+    }
     return vulkanCreateVideoParser(decoderHandler,
                                    videoFrameBufferCb,
                                    vkCodecType,
@@ -758,5 +929,10 @@ VkResult VulkanVideoProcessor::ParseVideoStreamData(const uint8_t* pData, size_t
         packet.flags |= VK_PARSER_PKT_ENDOFSTREAM;
     }
 
+    VkParserRandomAccessPoint randomAccessPoint;
+    if (m_seekPending && (size != 0) && m_randomAccessIndex.GetRandomAccessPoint(m_seekRandomAccessPoint, &randomAccessPoint)) {
+        m_seekPending = false;
+        return m_vkParser->SeekVideoData(&randomAccessPoint, &packet, pnVideoBytes, doPartialParsing);
+    }
     return m_vkParser->ParseVideoData(&packet, pnVideoBytes, doPartialParsing);
 }
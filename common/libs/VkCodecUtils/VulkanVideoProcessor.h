@@ -18,6 +18,7 @@
 #define _VULKANVIDEOPROCESSOR_H_
 
 #include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VulkanVideoRandomAccessIndex.h"
 #include "VkVideoDecoder/VkVideoDecoder.h"
 #include "VkCodecUtils/VkVideoFrameToFile.h"
 #include "VkCodecUtils/ProgramConfig.h"
@@ -79,6 +80,9 @@ private:
         , m_videoStreamsCompleted(false)
         , m_usesStreamDemuxer(false)
         , m_usesFramePreparser(false)
+        , m_seekPending(false)
+        , m_randomAccessIndex()
+        , m_seekRandomAccessPoint(VulkanVideoRandomAccessIndex::invalidIndex)
         , m_frameToFile()
         , m_loopCount(1)
         , m_startFrame(0)
@@ -101,6 +105,8 @@ private:
                                   uint32_t flags = 0, int64_t timestamp = 0);
 
     bool StreamCompleted();
+    void DumpPipelineStats();
+    bool InitializeSeek(const char* pIndexFileName, size_t randomAccessPoint);
 
 private:
     void WaitForFrameCompletion(VulkanDecodedFrame* pFrame, 
@@ -118,6 +124,9 @@ private:
     uint32_t m_videoStreamsCompleted : 1;
     uint32_t m_usesStreamDemuxer : 1;
     uint32_t m_usesFramePreparser : 1;
+    uint32_t m_seekPending : 1;                 // The next packet starts at m_seekRandomAccessPoint
+    VulkanVideoRandomAccessIndex m_randomAccessIndex;
+    size_t   m_seekRandomAccessPoint;           // Where each loop of the stream starts, if not invalidIndex
     VkVideoFrameToFile m_frameToFile;
     int32_t   m_loopCount;
     uint32_t  m_startFrame;
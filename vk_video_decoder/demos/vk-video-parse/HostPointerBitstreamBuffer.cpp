@@ -0,0 +1,193 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include "VkCodecUtils/VulkanBitstreamBufferHostImpl.h"
+#include "HostPointerBitstreamBuffer.h"
+
+VkResult
+HostPointerBitstreamBuffer::Create(const void* pHostPointer, VkDeviceSize bufferSize,
+        VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment,
+        VkSharedBaseObj<HostPointerBitstreamBuffer>& vulkanBitstreamBuffer)
+{
+    if ((pHostPointer == nullptr) || (bufferSize == 0)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkSharedBaseObj<HostPointerBitstreamBuffer> vkBitstreamBuffer(new HostPointerBitstreamBuffer(pHostPointer, bufferSize,
+                                                                                                   bufferOffsetAlignment,
+                                                                                                   bufferSizeAlignment));
+    if (!vkBitstreamBuffer) {
+        assert(!"Out of host memory!");
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    vulkanBitstreamBuffer = vkBitstreamBuffer;
+
+    return VK_SUCCESS;
+}
+
+// The copy is a plain host memory buffer the parser can write to
+VkDeviceSize HostPointerBitstreamBuffer::Clone(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset,
+                                               VkSharedBaseObj<VulkanBitstreamBuffer>& vulkanBitstreamBuffer)
+{
+    const uint8_t* oldBufPtr = nullptr;
+    if (copySize) {
+        oldBufPtr = CheckAccess(copyOffset, copySize);
+        if (oldBufPtr == nullptr) {
+            return 0;
+        }
+    }
+    VkSharedBaseObj<VulkanBitstreamBufferHostImpl> vkBitstreamBuffer;
+    VkResult result = VulkanBitstreamBufferHostImpl::Create(newSize, m_bufferOffsetAlignment, m_bufferSizeAlignment,
+                                                            oldBufPtr, copySize, vkBitstreamBuffer);
+    if (result != VK_SUCCESS) {
+        return 0;
+    }
+    vulkanBitstreamBuffer = vkBitstreamBuffer;
+
+    return newSize;
+}
+
+VkDeviceSize HostPointerBitstreamBuffer::Resize(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset)
+{
+    // The memory belongs to the benchmark: it can't grow
+    return m_size;
+}
+
+const uint8_t* HostPointerBitstreamBuffer::CheckAccess(VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (offset + size <= m_size) {
+        return m_pData + offset;
+    }
+
+    assert(!"Bad buffer access - out of range!");
+    return nullptr;
+}
+
+int64_t HostPointerBitstreamBuffer::MemsetData(uint32_t value, VkDeviceSize offset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    assert(!"The buffer is read-only!");
+    return -1;
+}
+
+int64_t HostPointerBitstreamBuffer::CopyDataToBuffer(uint8_t *dstBuffer, VkDeviceSize dstOffset,
+                                                     VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        return -1;
+    }
+    memcpy(dstBuffer + dstOffset, readData, (size_t)size);
+    return size;
+}
+
+int64_t HostPointerBitstreamBuffer::CopyDataToBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& dstBuffer, VkDeviceSize dstOffset,
+                                                     VkDeviceSize srcOffset, VkDeviceSize size) const
+{
+    if (size == 0) {
+        return 0;
+    }
+    const uint8_t* readData = CheckAccess(srcOffset, size);
+    if (readData == nullptr) {
+        assert(!"Could not CopyDataToBuffer!");
+        return -1;
+    }
+    return dstBuffer->CopyDataFromBuffer(readData, 0, dstOffset, size);
+}
+
+int64_t HostPointerBitstreamBuffer::CopyDataFromBuffer(const uint8_t *sourceBuffer, VkDeviceSize srcOffset,
+                                                       VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    assert(!"The buffer is read-only!");
+    return -1;
+}
+
+int64_t HostPointerBitstreamBuffer::CopyDataFromBuffer(const VkSharedBaseObj<VulkanBitstreamBuffer>& sourceBuffer,
+                                                       VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    assert(!"The buffer is read-only!");
+    return -1;
+}
+
+// The parser reads the NAL units through the data pointer of its bitstream buffer, it does not write to them
+uint8_t* HostPointerBitstreamBuffer::GetDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize)
+{
+    const uint8_t* readData = GetReadOnlyDataPtr(offset, maxSize);
+    return const_cast<uint8_t*>(readData);
+}
+
+const uint8_t* HostPointerBitstreamBuffer::GetReadOnlyDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize) const
+{
+    const uint8_t* readData = CheckAccess(offset, 1);
+    if (readData == nullptr) {
+        assert(!"Could not GetReadOnlyDataPtr()!");
+        return nullptr;
+    }
+    maxSize = m_size - offset;
+    return readData;
+}
+
+uint32_t HostPointerBitstreamBuffer::AddStreamMarker(uint32_t streamOffset)
+{
+    m_streamMarkers.push_back(streamOffset);
+    return (uint32_t)(m_streamMarkers.size() - 1);
+}
+
+uint32_t HostPointerBitstreamBuffer::SetStreamMarker(uint32_t streamOffset, uint32_t index)
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    if (!(index < (uint32_t)m_streamMarkers.size())) {
+        return uint32_t(-1);
+    }
+    m_streamMarkers[index] = streamOffset;
+    return index;
+}
+
+uint32_t HostPointerBitstreamBuffer::GetStreamMarker(uint32_t index) const
+{
+    assert(index < (uint32_t)m_streamMarkers.size());
+    return m_streamMarkers[index];
+}
+
+uint32_t HostPointerBitstreamBuffer::GetStreamMarkersCount() const
+{
+    return (uint32_t)m_streamMarkers.size();
+}
+
+const uint32_t* HostPointerBitstreamBuffer::GetStreamMarkersPtr(uint32_t startIndex, uint32_t& maxCount) const
+{
+    maxCount = (uint32_t)m_streamMarkers.size() - startIndex;
+    return m_streamMarkers.data() + startIndex;
+}
+
+uint32_t HostPointerBitstreamBuffer::ResetStreamMarkers()
+{
+    uint32_t oldSize = (uint32_t)m_streamMarkers.size();
+    m_streamMarkers.clear();
+    return oldSize;
+}
@@ -0,0 +1,115 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _HOSTPOINTERBITSTREAMBUFFER_H_
+#define _HOSTPOINTERBITSTREAMBUFFER_H_
+
+#include <atomic>
+#include <vector>
+#include "VkCodecUtils/VulkanBitstreamBuffer.h"
+
+// Bitstream buffer wrapping memory owned by the benchmark (a span of the input stream), without
+// copying it, the way a device buffer imported from a host pointer would. It only exists for
+// --zeroCopy: the decoder does not import host pointers, so vk-video-dec never hands the parser
+// its packets in place. The buffer is read-only: it can't grow, and the writes fail.
+class HostPointerBitstreamBuffer : public VulkanBitstreamBuffer
+{
+public:
+
+    // The memory must outlive the buffer
+    static VkResult Create(const void* pHostPointer, VkDeviceSize bufferSize,
+                           VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment,
+                           VkSharedBaseObj<HostPointerBitstreamBuffer>& vulkanBitstreamBuffer);
+
+    virtual int32_t AddRef()
+    {
+        return ++m_refCount;
+    }
+
+    virtual int32_t Release()
+    {
+        uint32_t ret = --m_refCount;
+        // Destroy the buffer if ref-count reaches zero
+        if (ret == 0) {
+            delete this;
+        }
+        return ret;
+    }
+
+    virtual int32_t GetRefCount()
+    {
+        assert(m_refCount > 0);
+        return m_refCount;
+    }
+
+    virtual VkDeviceSize GetMaxSize() const { return m_size; }
+    virtual VkDeviceSize GetOffsetAlignment() const { return m_bufferOffsetAlignment; }
+    virtual VkDeviceSize GetSizeAlignment() const { return m_bufferSizeAlignment; }
+    virtual VkDeviceSize Resize(VkDeviceSize newSize, VkDeviceSize copySize = 0, VkDeviceSize copyOffset = 0);
+    virtual VkDeviceSize Clone(VkDeviceSize newSize, VkDeviceSize copySize, VkDeviceSize copyOffset,
+                               VkSharedBaseObj<VulkanBitstreamBuffer>& vulkanBitstreamBuffer);
+
+    virtual int64_t  MemsetData(uint32_t value, VkDeviceSize offset, VkDeviceSize size);
+    virtual int64_t  CopyDataToBuffer(uint8_t *dstBuffer, VkDeviceSize dstOffset,
+                                      VkDeviceSize srcOffset, VkDeviceSize size) const;
+    virtual int64_t  CopyDataToBuffer(VkSharedBaseObj<VulkanBitstreamBuffer>& dstBuffer, VkDeviceSize dstOffset,
+                                      VkDeviceSize srcOffset, VkDeviceSize size) const;
+    virtual int64_t  CopyDataFromBuffer(const uint8_t *sourceBuffer, VkDeviceSize srcOffset,
+                                        VkDeviceSize dstOffset, VkDeviceSize size);
+    virtual int64_t  CopyDataFromBuffer(const VkSharedBaseObj<VulkanBitstreamBuffer>& sourceBuffer, VkDeviceSize srcOffset,
+                                        VkDeviceSize dstOffset, VkDeviceSize size);
+    virtual uint8_t* GetDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize);
+    virtual const uint8_t* GetReadOnlyDataPtr(VkDeviceSize offset, VkDeviceSize &maxSize) const;
+
+    virtual void FlushRange(VkDeviceSize offset, VkDeviceSize size) const {}
+    virtual void InvalidateRange(VkDeviceSize offset, VkDeviceSize size) const {}
+
+    virtual VkBuffer GetBuffer() const { return VK_NULL_HANDLE; }
+    virtual VkDeviceMemory GetDeviceMemory() const { return VK_NULL_HANDLE; }
+
+    virtual uint32_t  AddStreamMarker(uint32_t streamOffset);
+    virtual uint32_t  SetStreamMarker(uint32_t streamOffset, uint32_t index);
+    virtual uint32_t  GetStreamMarker(uint32_t index) const;
+    virtual uint32_t  GetStreamMarkersCount() const;
+    virtual const uint32_t* GetStreamMarkersPtr(uint32_t startIndex, uint32_t& maxCount) const;
+    virtual uint32_t  ResetStreamMarkers();
+
+private:
+
+    const uint8_t* CheckAccess(VkDeviceSize offset, VkDeviceSize size) const;
+
+    HostPointerBitstreamBuffer(const void* pHostPointer, VkDeviceSize bufferSize,
+                               VkDeviceSize bufferOffsetAlignment, VkDeviceSize bufferSizeAlignment)
+        : VulkanBitstreamBuffer()
+        , m_refCount(0)
+        , m_bufferOffsetAlignment(bufferOffsetAlignment ? bufferOffsetAlignment : 1)
+        , m_bufferSizeAlignment(bufferSizeAlignment ? bufferSizeAlignment : 1)
+        , m_pData(static_cast<const uint8_t*>(pHostPointer))
+        , m_size(bufferSize)
+        , m_streamMarkers() { m_streamMarkers.reserve(256); }
+
+    virtual ~HostPointerBitstreamBuffer() { }
+
+private:
+    std::atomic<int32_t>       m_refCount;
+    VkDeviceSize               m_bufferOffsetAlignment;
+    VkDeviceSize               m_bufferSizeAlignment;
+    const uint8_t*             m_pData;
+    VkDeviceSize               m_size;
+    std::vector<uint32_t>      m_streamMarkers;
+};
+
+#endif /* _HOSTPOINTERBITSTREAMBUFFER_H_ */
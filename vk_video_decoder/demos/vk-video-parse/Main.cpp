@@ -0,0 +1,1992 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// GPU-free benchmark of the video parser: feeds an elementary stream through
+// ParseByteStream() with a stub client and reports the parsing throughput for
+// each of the SIMD instruction sets the parser can use on this CPU.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#if defined(__unix__)
+#include <signal.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "VkCodecUtils/ProgramConfig.h"
+#include "VkCodecUtils/VkAllocationCounter.h"
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "NvVideoParser/nvVulkanVideoParser.h"
+#include "NvVideoParser/nvVulkanVideoUtils.h"
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
+#include "VkDecoderUtils/VulkanVideoRandomAccessIndex.h"
+#include "vkvideo_parser/VulkanVideoParserTrace.h"
+#include "HostPointerBitstreamBuffer.h"
+#include "StubDecodeClient.h"
+#include "StubVideoDecoder.h"
+#include "StubVideoDevice.h"
+
+struct BenchConfig {
+    BenchConfig()
+        : inputFileName()
+        , codec(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , simdIsa(-1)
+        , numReps(10)
+        , packetSize(64 * 1024)
+        , zeroCopySpanSize(0)
+        , perNaluStartCodeScan(false)
+        , indexFileName()
+        , probeSize(0)
+        , probe(false)
+        , nalLengthSize(0)
+        , allocationWarmupPictures(0)
+        , decodeFilter(VK_PARSER_DECODE_FILTER_NONE)
+        , maxTemporalLayer(VK_PARSER_TEMPORAL_LAYER_ALL)
+        , lowLatencyOutput(false)
+        , segmentSize(0)
+        , chunkSize(0)
+        , streamingInput(false)
+        , av1AnnexB(false)
+        , outputHash(false)
+        , demux(false)
+        , pipeSize(0)
+        , pipeCheck(false)
+        , captureTraceFileName()
+        , checkTraceFileName()
+        , parameterSetCheck(false)
+        , pipelinedPictures(0) { }
+
+    std::string inputFileName;
+    VkVideoCodecOperationFlagBitsKHR codec;
+    int32_t simdIsa; // -1 = all the instruction sets supported by the CPU
+    uint32_t numReps;
+    size_t packetSize;
+    size_t zeroCopySpanSize; // 0 = the parser copies the packets into its own bitstream buffers
+    bool perNaluStartCodeScan;
+    std::string indexFileName; // Build a random access index instead of benchmarking
+    size_t probeSize; // 0 = the first packet
+    bool probe; // Probe the sequence header instead of benchmarking
+    uint32_t nalLengthSize; // Compare Annex B and length-prefixed (MP4 sample) input with this length field size
+    uint32_t allocationWarmupPictures; // Fail on heap allocations after this number of pictures, 0 = not checked
+    uint32_t decodeFilter; // VK_PARSER_DECODE_FILTER_XXX
+    uint32_t maxTemporalLayer; // Highest H.265 / AV1 temporal sub-layer parsed
+    bool lowLatencyOutput; // Immediate output of the streams without reordering
+    size_t segmentSize; // Compare contiguous and scatter-gather input with packets scattered in segments of this size
+    size_t chunkSize; // Compare AV1 temporal unit packets with the byte stream split in chunks of up to this size
+    bool streamingInput; // Set by chunkSize: packets split the byte stream anywhere
+    bool av1AnnexB; // Set by chunkSize and demux: AV1 Annex B input
+    bool outputHash; // Set by chunkSize: hash the output of the parser to compare the runs
+    bool demux; // Read the input through the native container demuxers of vk-video-dec
+    size_t pipeSize; // 0 = the whole input
+    bool pipeCheck; // Compare demuxing the input from a file and from a pipe
+    std::string captureTraceFileName; // Capture the VulkanVideoParser trace of the input into this file
+    std::string checkTraceFileName; // Compare the VulkanVideoParser trace of the input with this golden trace
+    bool parameterSetCheck; // Check the session parameters updates of the parameter sets of the input on a stub device
+    uint32_t pipelinedPictures; // Compare the pipelined decode of VulkanVideoParser, with this many pictures in flight, with the inline one
+};
+
+struct BitstreamPacket {
+    size_t offset;
+    size_t size;
+    uint32_t span; // index of the zero-copy span holding the packet
+};
+
+static const struct {
+    const char* name;
+    uint32_t simdIsa;
+} simdIsaNames[] = {
+    { "c",      VK_PARSER_SIMD_ISA_C },
+    { "ssse3",  VK_PARSER_SIMD_ISA_SSSE3 },
+    { "avx2",   VK_PARSER_SIMD_ISA_AVX2 },
+    { "avx512", VK_PARSER_SIMD_ISA_AVX512 },
+    { "neon",   VK_PARSER_SIMD_ISA_NEON },
+    { "sve",    VK_PARSER_SIMD_ISA_SVE },
+};
+
+static bool ParseArgs(int argc, const char **argv, BenchConfig& config)
+{
+    using ProgramArgs = ProgramConfig::ProgramArgs;
+    ProgramArgs spec = {
+        {"--help", nullptr, 0, "Show this help",
+            [argv](const char **, const ProgramArgs &a) {
+                ProgramConfig::showHelp(argv, a);
+                exit(EXIT_SUCCESS);
+                return true;
+            }},
+        {"--input", "-i", 1, "Input elementary stream (Annex B H.264/H.265, AV1 OBUs or IVF), \"-\" for the standard input with --demux",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.inputFileName = args[0];
+                return true;
+            }},
+        {"--codec", nullptr, 1, "Codec of the input: h264, h265, av1 or vp9 (default: from the file)",
+            [&config](const char **args, const ProgramArgs &a) {
+                if ((strcmp(args[0], "avc") == 0) || (strcmp(args[0], "h264") == 0)) {
+                    config.codec = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+                } else if ((strcmp(args[0], "hevc") == 0) || (strcmp(args[0], "h265") == 0)) {
+                    config.codec = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+                } else if (strcmp(args[0], "av1") == 0) {
+                    config.codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+#ifdef ENABLE_VP9_DECODER
+                } else if (strcmp(args[0], "vp9") == 0) {
+                    config.codec = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+#endif
+                } else {
+                    std::cerr << "Invalid codec \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--isa", nullptr, 1, "SIMD instruction set: c, ssse3, avx2, avx512, neon, sve or all (default: all)",
+            [&config](const char **args, const ProgramArgs &a) {
+                if (strcmp(args[0], "all") == 0) {
+                    config.simdIsa = -1;
+                    return true;
+                }
+                for (size_t i = 0; i < sizeof(simdIsaNames) / sizeof(simdIsaNames[0]); i++) {
+                    if (strcmp(args[0], simdIsaNames[i].name) == 0) {
+                        config.simdIsa = simdIsaNames[i].simdIsa;
+                        return true;
+                    }
+                }
+                std::cerr << "Invalid instruction set \"" << args[0] << "\"" << std::endl;
+                return false;
+            }},
+        {"--reps", "-r", 1, "Number of times the stream is parsed per instruction set (default: 10)",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.numReps = std::max(1, atoi(args[0]));
+                return true;
+            }},
+        {"--packetSize", nullptr, 1, "Size of the packets Annex B streams are split into, 0 for a single packet (default: 65536)",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.packetSize = strtoull(args[0], nullptr, 0);
+                return true;
+            }},
+        {"--zeroCopy", nullptr, 1, "Hand H.264/H.265 packets to the parser in host-pointer bitstream buffers of this size instead of letting it copy them, 0 for the whole file",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.zeroCopySpanSize = strtoull(args[0], nullptr, 0);
+                if (config.zeroCopySpanSize == 0) {
+                    config.zeroCopySpanSize = SIZE_MAX;
+                }
+                return true;
+            }},
+        {"--perNaluStartCodeScan", nullptr, 0, "Search one start code at a time instead of indexing each packet",
+            [&config](const char **, const ProgramArgs &a) {
+                config.perNaluStartCodeScan = true;
+                return true;
+            }},
+        {"--index", nullptr, 1, "Build the random access index of the input into this file, then seek to each random access point",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.indexFileName = args[0];
+                return true;
+            }},
+        {"--probe", nullptr, 1, "Probe the format of the input from a prefix of this size, 0 for the first packet, and report the time to format",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.probeSize = strtoull(args[0], nullptr, 0);
+                config.probe = true;
+                return true;
+            }},
+        {"--decodeFilter", nullptr, 1, "Only decode the random access pictures (\"keyframes\") or the reference pictures (\"references\")",
+            [&config](const char **args, const ProgramArgs &a) {
+                if (strcmp(args[0], "keyframes") == 0) {
+                    config.decodeFilter = VK_PARSER_DECODE_FILTER_RANDOM_ACCESS;
+                } else if (strcmp(args[0], "references") == 0) {
+                    config.decodeFilter = VK_PARSER_DECODE_FILTER_REFERENCE;
+                } else {
+                    std::cerr << "Invalid decode filter \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--maxTemporalLayer", nullptr, 1, "Only parse the H.265 / AV1 temporal sub-layers up to this one",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.maxTemporalLayer = (uint32_t)std::min(std::max(0, atoi(args[0])), (int)VK_PARSER_TEMPORAL_LAYER_ALL);
+                return true;
+            }},
+        {"--lowLatency", nullptr, 0, "Display the pictures right after decoding them when the stream has no reordering",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.lowLatencyOutput = true;
+                return true;
+            }},
+        {"--lengthPrefixed", nullptr, 1, "Repackage H.264/H.265 input as MP4 samples with NAL unit length fields of this size (1, 2 or 4) and compare the input paths",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.nalLengthSize = (uint32_t)atoi(args[0]);
+                if ((config.nalLengthSize != 1) && (config.nalLengthSize != 2) && (config.nalLengthSize != 4)) {
+                    std::cerr << "Invalid NAL unit length size \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--chunks", nullptr, 1, "Feed an AV1 stream in chunks of random size, up to this one, in the low overhead and in the Annex B "
+                                 "format, and check that the output is the one of whole temporal unit packets",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.chunkSize = strtoull(args[0], nullptr, 0);
+                if (config.chunkSize == 0) {
+                    std::cerr << "Invalid chunk size \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--segments", nullptr, 1, "Scatter each packet over separate buffers of this size (e.g. 1400 for RTP payloads) and compare "
+                                   "copying them into one packet with handing them over as segments",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.segmentSize = strtoull(args[0], nullptr, 0);
+                if (config.segmentSize == 0) {
+                    std::cerr << "Invalid segment size \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--demux", nullptr, 0, "Read an IVF, MP4 or MPEG-TS file, or a pipe, a FIFO or a Unix socket (\"-\" for the standard input) "
+                                "carrying MPEG-TS or an elementary stream, through the demuxers of vk-video-dec, "
+                                "report the demuxing throughput, then parse the demuxed frames as they are",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.demux = true;
+                return true;
+            }},
+        {"--pipe", nullptr, 1, "Demux the first bytes of an MPEG-TS file or of an elementary stream, up to this size or 0 for "
+                               "all of them, from a file and from a pipe, and compare the output of the parser",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.pipeSize = (size_t)strtoull(args[0], nullptr, 0);
+                config.pipeCheck = true;
+                return true;
+            }},
+        {"--captureParserTrace", nullptr, 1, "Parse the input through VulkanVideoParser, the parser layer of vk-video-dec, "
+                                             "and capture its output trace into this file",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.captureTraceFileName = args[0];
+                return true;
+            }},
+        {"--checkParserTrace", nullptr, 1, "Fail if the VulkanVideoParser trace of the input differs from this golden trace, "
+                                           "or if replaying the golden trace gives another output than parsing the input",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.checkTraceFileName = args[0];
+                return true;
+            }},
+        {"--parameterSetCheck", nullptr, 0, "Fail if a parameter set resent with the same content creates or updates "
+                                            "video session parameters, with VkVideoDecoder's session parameters on a stub device",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.parameterSetCheck = true;
+                return true;
+            }},
+        {"--pipelinedDecode", nullptr, 1, "Fail if the pipelined decode of VulkanVideoParser, with this number of pictures in flight, "
+                                          "hands other pictures to the decoder than the inline decode",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.pipelinedPictures = (uint32_t)atoi(args[0]);
+                if (config.pipelinedPictures == 0) {
+                    std::cerr << "Invalid number of pictures in flight \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+        {"--allocationCheck", nullptr, 1, "Fail if the parser, or VulkanVideoParser on top of it, allocates heap memory once this "
+                                          "number of pictures has been decoded, requires a build with ENABLE_ALLOCATION_COUNTER",
+            [&config](const char **args, const ProgramArgs &a) {
+                config.allocationWarmupPictures = (uint32_t)atoi(args[0]);
+                if (config.allocationWarmupPictures == 0) {
+                    std::cerr << "Invalid number of warm-up pictures \"" << args[0] << "\"" << std::endl;
+                    return false;
+                }
+                if (!VkAllocationCounter::IsEnabled()) {
+                    std::cerr << "--allocationCheck needs a build with -DENABLE_ALLOCATION_COUNTER=ON" << std::endl;
+                    return false;
+                }
+                return true;
+            }},
+    };
+
+    for (int i = 1; i < argc; i++) {
+        auto flag = std::find_if(spec.begin(), spec.end(), [&](ProgramConfig::ArgSpec &a) {
+            return (a.flag != nullptr && strcmp(argv[i], a.flag) == 0) ||
+            (a.short_flag != nullptr && strcmp(argv[i], a.short_flag) == 0);
+        });
+        if (flag == spec.end()) {
+            std::cerr << "Unknown argument \"" << argv[i] << "\"" << std::endl;
+            std::cout << std::endl;
+            ProgramConfig::showHelp(argv, spec);
+            return false;
+        }
+
+        if (i + flag->numArgs >= argc) {
+            std::cerr << "Missing arguments for \"" << argv[i] << "\"" << std::endl;
+            return false;
+        }
+
+        if (!flag->lambda(argv + i + 1, spec)) {
+            return false;
+        }
+
+        i += flag->numArgs;
+    }
+
+    if (config.inputFileName.empty()) {
+        std::cerr << "No input file specified" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static uint32_t ReadLe32(const uint8_t* pData)
+{
+    return (uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+// Splits an IVF file into its frames. Returns false if the data is not an IVF file.
+static bool SplitIvfFrames(const std::vector<uint8_t>& data, VkVideoCodecOperationFlagBitsKHR& codec,
+                           std::vector<BitstreamPacket>& packets)
+{
+    if ((data.size() < 32) || (memcmp(data.data(), "DKIF", 4) != 0)) {
+        return false;
+    }
+
+    if (codec == VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+        if (memcmp(&data[8], "AV01", 4) == 0) {
+            codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+#ifdef ENABLE_VP9_DECODER
+        } else if (memcmp(&data[8], "VP90", 4) == 0) {
+            codec = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+#endif
+        }
+    }
+
+    size_t offset = data[6] | (data[7] << 8); // header size
+    while (offset + 12 <= data.size()) {
+        BitstreamPacket packet = BitstreamPacket();
+        packet.size = ReadLe32(&data[offset]);
+        packet.offset = offset + 12; // skip the frame size and the 64-bit timestamp
+        if (packet.offset + packet.size > data.size()) {
+            break;
+        }
+        packets.push_back(packet);
+        offset = packet.offset + packet.size;
+    }
+    return true;
+}
+
+static size_t ReadLeb128(const uint8_t* pData, size_t size, uint64_t& value)
+{
+    value = 0;
+    for (size_t i = 0; (i < 8) && (i < size); i++) {
+        value |= (uint64_t)(pData[i] & 0x7f) << (i * 7);
+        if (!(pData[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+enum { OBU_TEMPORAL_DELIMITER = 2 };
+
+// Walks the OBUs of an AV1 low overhead bitstream (AV1 spec section 5). Splits the data at the
+// temporal delimiters if packets is not null, and returns the number of OBUs.
+static uint64_t WalkAv1Obus(const uint8_t* pData, size_t size, size_t baseOffset, std::vector<BitstreamPacket>* packets)
+{
+    uint64_t numObus = 0;
+    size_t offset = 0;
+    while (offset < size) {
+        const uint8_t obuHeader = pData[offset];
+        const uint32_t obuType = (obuHeader >> 3) & 0xf;
+        const size_t headerSize = (obuHeader & 0x04) ? 2 : 1; // obu_extension_flag
+        uint64_t obuSize = size - offset - std::min(headerSize, size - offset);
+        size_t lebSize = 0;
+        if (obuHeader & 0x02) { // obu_has_size_field
+            if (offset + headerSize >= size) {
+                break;
+            }
+            lebSize = ReadLeb128(pData + offset + headerSize, size - offset - headerSize, obuSize);
+            if (lebSize == 0) {
+                break;
+            }
+        }
+        if (packets && (obuType == OBU_TEMPORAL_DELIMITER)) {
+            if (!packets->empty()) {
+                packets->back().size = baseOffset + offset - packets->back().offset;
+            }
+            BitstreamPacket packet = { baseOffset + offset, 0, 0 };
+            packets->push_back(packet);
+        }
+        numObus++;
+        offset += std::min<uint64_t>(headerSize + lebSize + obuSize, size - offset);
+    }
+    if (packets && !packets->empty()) {
+        packets->back().size = baseOffset + size - packets->back().offset;
+    }
+    return numObus;
+}
+
+static uint64_t CountStartCodes(const std::vector<uint8_t>& data)
+{
+    uint64_t numStartCodes = 0;
+    for (size_t i = 2; i < data.size(); i++) {
+        if ((data[i] == 0x01) && (data[i - 1] == 0x00) && (data[i - 2] == 0x00)) {
+            numStartCodes++;
+        }
+    }
+    return numStartCodes;
+}
+
+static VkVideoCodecOperationFlagBitsKHR GetCodecFromFileName(const std::string& fileName)
+{
+    const size_t extPos = fileName.rfind('.');
+    if (extPos == std::string::npos) {
+        return VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+    }
+    const std::string ext = fileName.substr(extPos + 1);
+    if ((ext == "264") || (ext == "h264") || (ext == "avc") || (ext == "jsv")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+    } else if ((ext == "265") || (ext == "h265") || (ext == "hevc") || (ext == "bit")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+    } else if ((ext == "obu") || (ext == "av1")) {
+        return VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+    }
+    return VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+}
+
+static void PrintVideoStreamFormat(const VideoStreamFormat& format)
+{
+    printf("probe: %s (confidence %u)", format.pName, format.confidence);
+    if (format.hasSequenceInfo) {
+        const char* chromaFormat = (format.chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) ? "4:0:0" :
+                                   (format.chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR) ? "4:2:2" :
+                                   (format.chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR) ? "4:4:4" : "4:2:0";
+        printf(", profile %u, %s, %d/%d bits, %dx%d coded, %dx%d display", format.profileIdc, chromaFormat,
+               format.lumaBitDepth, format.chromaBitDepth, format.codedWidth, format.codedHeight,
+               format.displayWidth, format.displayHeight);
+    }
+    printf("\n");
+}
+
+static bool GetStdExtensionVersion(VkVideoCodecOperationFlagBitsKHR codec, VkExtensionProperties& stdExtensionVersion)
+{
+    memset(&stdExtensionVersion, 0, sizeof(stdExtensionVersion));
+    switch ((uint32_t)codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_SPEC_VERSION;
+        return true;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_SPEC_VERSION;
+        return true;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_SPEC_VERSION;
+        return true;
+#ifdef ENABLE_VP9_DECODER
+    case VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR:
+        return true;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+struct BenchResult {
+    double seconds;
+    StubDecodeClient::Counters counters;
+    VkParserParameterSetStats parameterSetStats; // Summed over all the reps
+    uint64_t droppedPictures; // Above the temporal sub-layer limit, summed over all the reps
+};
+
+static VkResult CreateParser(const BenchConfig& config, uint32_t simdIsa, bool indexRandomAccessPoints,
+                             StubDecodeClient& client, VkSharedBaseObj<VulkanVideoDecodeParser>& parser)
+{
+    VkExtensionProperties stdExtensionVersion;
+    GetStdExtensionVersion(config.codec, stdExtensionVersion);
+
+    VkParserInitDecodeParameters initParams;
+    memset(&initParams, 0, sizeof(initParams));
+    initParams.interfaceVersion = NV_VULKAN_VIDEO_PARSER_API_VERSION;
+    initParams.pClient = &client;
+    initParams.defaultMinBufferSize = 2 * 1024 * 1024;
+    initParams.bufferOffsetAlignment = 256;
+    initParams.bufferSizeAlignment = 256;
+    initParams.referenceClockRate = 0;
+    initParams.errorThreshold = 0;
+    initParams.outOfBandPictureParameters = true;
+    initParams.perNaluStartCodeScan = config.perNaluStartCodeScan;
+    initParams.simdIsa = simdIsa;
+    initParams.indexRandomAccessPoints = indexRandomAccessPoints;
+    initParams.decodeFilter = config.decodeFilter;
+    initParams.lowLatencyOutput = config.lowLatencyOutput;
+    initParams.reportDisplayLatency = true;
+    initParams.streamingInput = config.streamingInput;
+    initParams.av1AnnexB = config.av1AnnexB;
+
+    return CreateVulkanVideoDecodeParser(config.codec, &stdExtensionVersion, nullptr, 0, &initParams, parser);
+}
+
+// Parses the whole stream numReps times with the given instruction set; only the
+// ParseByteStream() calls are timed.
+static VkResult RunBench(const BenchConfig& config, uint32_t simdIsa, const std::vector<uint8_t>& data,
+                         const std::vector<BitstreamPacket>& packets, BenchResult& result)
+{
+
+    // In zero-copy mode the input is imported span by span, the way the pages of a
+    // memory mapped file would be imported into device buffers from host pointers.
+    std::vector<VkSharedBaseObj<HostPointerBitstreamBuffer>> spans;
+    for (size_t offset = 0; (config.zeroCopySpanSize != 0) && (offset < data.size()); offset += config.zeroCopySpanSize) {
+        VkSharedBaseObj<HostPointerBitstreamBuffer> span;
+        VkResult vkResult = HostPointerBitstreamBuffer::Create(data.data() + offset,
+                                                               std::min(config.zeroCopySpanSize, data.size() - offset),
+                                                               256, 256, span);
+        if (vkResult != VK_SUCCESS) {
+            return vkResult;
+        }
+        spans.push_back(span);
+    }
+
+    StubDecodeClient client;
+    client.SetOutputHash(config.outputHash);
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        VkResult vkResult = CreateParser(config, simdIsa, false, client, parser);
+        if (vkResult != VK_SUCCESS) {
+            return vkResult;
+        }
+        parser->SetMaxTemporalLayer(config.maxTemporalLayer);
+
+        client.BeginStream(config.allocationWarmupPictures);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < packets.size(); i++) {
+            VkParserBitstreamPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            packet.pByteStream = data.data() + packets[i].offset;
+            packet.nDataLength = packets[i].size;
+            packet.bEOS = (i == (packets.size() - 1));
+            if (!spans.empty()) {
+                packet.pBitstreamBuffer = spans[packets[i].span];
+                packet.bitstreamBufferOffset = packets[i].offset - (size_t)packets[i].span * config.zeroCopySpanSize;
+            }
+            size_t parsedBytes = 0;
+            parser->ParseByteStream(&packet, &parsedBytes);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        VkParserParameterSetStats parameterSetStats;
+        parser->GetParameterSetStats(&parameterSetStats);
+        result.parameterSetStats.repeatedParameterSets += parameterSetStats.repeatedParameterSets;
+        result.parameterSetStats.parsedParameterSets += parameterSetStats.parsedParameterSets;
+        VkParserTemporalLayerStats temporalLayerStats;
+        parser->GetTemporalLayerStats(&temporalLayerStats);
+        result.droppedPictures += temporalLayerStats.droppedPictures;
+    }
+
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    result.counters = client.GetCounters();
+    return VK_SUCCESS;
+}
+
+// Parses the stream once through VulkanVideoParser, the parser layer of vk-video-dec, into a stub
+// decoder handler instead of VkVideoDecoder. The packets are the ones of RunBench(), always copied.
+// The output of the parser is captured into pCaptureTraceFileName, if any. With pReplayTraceFileName
+// the trace replayer issues the calls of that trace instead, and the packets only pace the replay.
+// With pVideoDevice, the stub decoder creates the video session parameters on that device. With
+// pipelinedPictures, the pictures are decoded by the submit thread of the pipelined mode, and with
+// pPictureLog, the stub decoder records them.
+static VkResult RunVulkanVideoParser(const BenchConfig& config, const std::vector<uint8_t>& data,
+                                     const std::vector<BitstreamPacket>& packets, const char* pCaptureTraceFileName,
+                                     const char* pReplayTraceFileName, const VulkanDeviceContext* pVideoDevice,
+                                     uint32_t pipelinedPictures, std::vector<StubVideoDecoder::PictureRecord>* pPictureLog,
+                                     StubVideoDecoder::Counters& counters)
+{
+    VkExtensionProperties stdExtensionVersion;
+    GetStdExtensionVersion(config.codec, stdExtensionVersion);
+
+    VkSharedBaseObj<StubVideoDecoder> stubVideoDecoder;
+    VkResult result = StubVideoDecoder::Create(stubVideoDecoder);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    stubVideoDecoder->SetVideoDevice(pVideoDevice);
+    stubVideoDecoder->SetPictureLog(pPictureLog);
+    VkSharedBaseObj<IVulkanVideoDecoderHandler> decoderHandler;
+    decoderHandler = stubVideoDecoder;
+    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb> videoFrameBufferCb;
+    videoFrameBufferCb = stubVideoDecoder;
+
+    VkSharedBaseObj<IVulkanVideoParser> parser;
+    if (pReplayTraceFileName != nullptr) {
+        // The options are part of the trace
+        result = vulkanCreateVideoParserTraceReplayer(pReplayTraceFileName, decoderHandler, videoFrameBufferCb,
+                                                      config.codec, 256, 256, parser);
+    } else {
+        result = vulkanCreateVideoParser(decoderHandler, videoFrameBufferCb, config.codec, &stdExtensionVersion,
+                                         1, 1, 2 * 1024 * 1024, 256, 256, 0, parser);
+        if ((result == VK_SUCCESS) && (pCaptureTraceFileName != nullptr)) {
+            result = parser->EnableTraceCapture(pCaptureTraceFileName);
+        }
+    }
+    if ((result == VK_SUCCESS) && (pReplayTraceFileName == nullptr) && (config.decodeFilter != VK_PARSER_DECODE_FILTER_NONE)) {
+        result = parser->SetDecodeFilter(config.decodeFilter);
+    }
+    if ((result == VK_SUCCESS) && (pReplayTraceFileName == nullptr) && config.lowLatencyOutput) {
+        result = parser->EnableLowLatencyOutput();
+    }
+    if ((result == VK_SUCCESS) && (pReplayTraceFileName == nullptr) && (config.maxTemporalLayer != VK_PARSER_TEMPORAL_LAYER_ALL)) {
+        result = parser->SetMaxTemporalLayer(config.maxTemporalLayer);
+    }
+    if ((result == VK_SUCCESS) && (pipelinedPictures != 0)) {
+        result = parser->EnablePipelinedDecode(pipelinedPictures);
+    }
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    stubVideoDecoder->BeginStream(config.allocationWarmupPictures);
+    for (size_t i = 0; i < packets.size(); i++) {
+        VkParserSourceDataPacket packet = VkParserSourceDataPacket();
+        packet.payload = data.data() + packets[i].offset;
+        packet.payload_size = packets[i].size;
+        packet.flags = (i == (packets.size() - 1)) ? VK_PARSER_PKT_ENDOFSTREAM : 0;
+        size_t parsedBytes = 0;
+        parser->ParseVideoData(&packet, &parsedBytes, false);
+    }
+    parser = nullptr;
+
+    counters = stubVideoDecoder->GetCounters();
+    return VK_SUCCESS;
+}
+
+static bool ReadTraceFile(const std::string& fileName, std::vector<uint8_t>& trace)
+{
+    std::ifstream traceFile(fileName.c_str(), std::ios::binary);
+    if (!traceFile) {
+        std::cerr << "Can't open the trace file " << fileName << std::endl;
+        return false;
+    }
+    trace.assign(std::istreambuf_iterator<char>(traceFile), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Captures the VulkanVideoParser trace of the stream. When checking it against a golden trace, the new
+// trace goes next to the golden one, with a .new suffix, and is only kept if it differs: it must match
+// byte for byte, and replaying the golden trace must give the stub decoder the output of the parser.
+// Traces are in host endianness, so the golden traces only hold on little-endian hosts.
+static bool RunParserTrace(const BenchConfig& config, const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets)
+{
+    const bool check = !config.checkTraceFileName.empty();
+    const std::string captureFileName = check ? (config.checkTraceFileName + ".new") : config.captureTraceFileName;
+
+    printf("%s: %zu bytes, %zu packets, VulkanVideoParser trace %s %s\n", config.inputFileName.c_str(), data.size(),
+           packets.size(), check ? "checked against" : "captured into",
+           check ? config.checkTraceFileName.c_str() : captureFileName.c_str());
+    printf("%-10s %10s %10s %10s  %-16s\n", "run", "sequences", "pictures", "displayed", "output hash");
+
+    StubVideoDecoder::Counters reference = StubVideoDecoder::Counters();
+    bool identical = true;
+    for (uint32_t replay = 0; replay < (check ? 2 : 1); replay++) {
+        StubVideoDecoder::Counters counters = StubVideoDecoder::Counters();
+        VkResult vkResult = RunVulkanVideoParser(config, data, packets, replay ? nullptr : captureFileName.c_str(),
+                                                 replay ? config.checkTraceFileName.c_str() : nullptr, nullptr, 0, nullptr,
+                                                 counters);
+        if (vkResult != VK_SUCCESS) {
+            std::cerr << "Failed to create the VulkanVideoParser" << (replay ? " trace replayer" : "") << " ("
+                      << vkResult << ")" << std::endl;
+            return false;
+        }
+        if (replay == 0) {
+            reference = counters;
+        }
+        // The output hash covers the bitstream data of each picture and the display order
+        const bool sameOutput = (counters.outputHash == reference.outputHash) &&
+                                (counters.sequences == reference.sequences) &&
+                                (counters.decodedPictures == reference.decodedPictures) &&
+                                (counters.displayedPictures == reference.displayedPictures);
+        identical = identical && sameOutput;
+        printf("%-10s %10llu %10llu %10llu  %016llx %s\n", replay ? "replayed" : "parsed",
+               (unsigned long long)counters.sequences, (unsigned long long)counters.decodedPictures,
+               (unsigned long long)counters.displayedPictures, (unsigned long long)counters.outputHash,
+               !check ? "" : (replay == 0) ? "reference" : sameOutput ? "identical" : "DIFFERENT");
+    }
+    if (!check) {
+        return true;
+    }
+
+    std::vector<uint8_t> golden;
+    std::vector<uint8_t> trace;
+    if (!ReadTraceFile(config.checkTraceFileName, golden) || !ReadTraceFile(captureFileName, trace)) {
+        return false;
+    }
+    const size_t mismatch = std::mismatch(golden.begin(), golden.begin() + std::min(golden.size(), trace.size()),
+                                          trace.begin()).first - golden.begin();
+    if ((mismatch == golden.size()) && (mismatch == trace.size())) {
+        printf("trace      %zu bytes, identical\n", trace.size());
+        remove(captureFileName.c_str());
+    } else {
+        printf("trace      %zu bytes, DIFFERENT from byte %zu of the %zu of the golden trace, see %s\n", trace.size(),
+               mismatch, golden.size(), captureFileName.c_str());
+        identical = false;
+    }
+    return identical;
+}
+
+// Parses the stream through VulkanVideoParser into the session parameters objects of VkVideoDecoder,
+// on a stub device that counts their creates and updates. Each parameter set with new content takes
+// exactly one of them, while one resent with the content the session parameters already hold must
+// keep the current session parameters: the parser only skips byte-identical repeats of the last
+// parameter sets, so after an SPS change the unchanged PPS are delivered again.
+static bool RunParameterSetCheck(const BenchConfig& config, const std::vector<uint8_t>& data,
+                                 const std::vector<BitstreamPacket>& packets)
+{
+    printf("%s: %zu bytes, %zu packets, video session parameters of the parameter sets on a stub device\n",
+           config.inputFileName.c_str(), data.size(), packets.size());
+
+    StubVideoDevice videoDevice;
+    StubVideoDevice::ResetCounters();
+    StubVideoDecoder::Counters counters = StubVideoDecoder::Counters();
+    VkResult vkResult = RunVulkanVideoParser(config, data, packets, nullptr, nullptr, &videoDevice, 0, nullptr, counters);
+    if (vkResult != VK_SUCCESS) {
+        std::cerr << "Failed to create the VulkanVideoParser (" << vkResult << ")" << std::endl;
+        return false;
+    }
+    const StubVideoDevice::Counters& deviceCounters = StubVideoDevice::GetCounters();
+
+    printf("parameter sets     %10llu received %10llu changed %10llu resent %10llu resent not mapped back\n",
+           (unsigned long long)counters.parameterSets, (unsigned long long)counters.changedParameterSets,
+           (unsigned long long)counters.resentParameterSets, (unsigned long long)counters.resentMismatches);
+    printf("session parameters %10llu created  %10llu updated %10llu destroyed, %llu video sessions\n",
+           (unsigned long long)deviceCounters.sessionParametersCreated,
+           (unsigned long long)deviceCounters.sessionParametersUpdated,
+           (unsigned long long)deviceCounters.sessionParametersDestroyed, (unsigned long long)deviceCounters.videoSessions);
+
+    bool passed = true;
+    if (counters.resentMismatches != 0) {
+        printf("FAILED: resent parameter sets replaced the current session parameters\n");
+        passed = false;
+    }
+    if ((deviceCounters.sessionParametersCreated + deviceCounters.sessionParametersUpdated) != counters.changedParameterSets) {
+        printf("FAILED: %llu session parameters creates and updates for %llu changed parameter sets\n",
+               (unsigned long long)(deviceCounters.sessionParametersCreated + deviceCounters.sessionParametersUpdated),
+               (unsigned long long)counters.changedParameterSets);
+        passed = false;
+    }
+    if (deviceCounters.sessionParametersDestroyed != deviceCounters.sessionParametersCreated) {
+        printf("FAILED: %llu session parameters not destroyed\n",
+               (unsigned long long)(deviceCounters.sessionParametersCreated - deviceCounters.sessionParametersDestroyed));
+        passed = false;
+    }
+    return passed;
+}
+
+// Parses the stream through VulkanVideoParser inline, then with the submit thread of the pipelined mode
+// calling the decoder, and compares the pictures the stub decoder gets: the same pictures must be decoded
+// and displayed in the same order, from the same bitstream data and with the same picture parameters.
+// The picture buffer indices are left out, the pictures in flight hold their buffers for longer.
+static bool RunPipelinedDecodeCheck(const BenchConfig& config, const std::vector<uint8_t>& data,
+                                    const std::vector<BitstreamPacket>& packets)
+{
+    printf("%s: %zu bytes, %zu packets, VulkanVideoParser pipelined decode with %u pictures in flight\n",
+           config.inputFileName.c_str(), data.size(), packets.size(), config.pipelinedPictures);
+    printf("%-10s %10s %10s %10s\n", "run", "sequences", "pictures", "displayed");
+
+    std::vector<StubVideoDecoder::PictureRecord> pictureLogs[2];
+    for (uint32_t pipelined = 0; pipelined < 2; pipelined++) {
+        StubVideoDecoder::Counters counters = StubVideoDecoder::Counters();
+        VkResult vkResult = RunVulkanVideoParser(config, data, packets, nullptr, nullptr, nullptr,
+                                                 pipelined ? config.pipelinedPictures : 0, &pictureLogs[pipelined], counters);
+        if (vkResult != VK_SUCCESS) {
+            std::cerr << "Failed to create the VulkanVideoParser (" << vkResult << ")" << std::endl;
+            return false;
+        }
+        printf("%-10s %10llu %10llu %10llu\n", pipelined ? "pipelined" : "inline", (unsigned long long)counters.sequences,
+               (unsigned long long)counters.decodedPictures, (unsigned long long)counters.displayedPictures);
+    }
+
+    const std::vector<StubVideoDecoder::PictureRecord>& reference = pictureLogs[0];
+    const std::vector<StubVideoDecoder::PictureRecord>& pipelined = pictureLogs[1];
+    if (reference.empty()) {
+        printf("FAILED: no pictures decoded\n");
+        return false;
+    }
+    for (size_t i = 0; i < std::max(reference.size(), pipelined.size()); i++) {
+        if ((i >= reference.size()) || (i >= pipelined.size())) {
+            printf("FAILED: %zu pictures decoded or displayed inline, %zu pipelined\n", reference.size(), pipelined.size());
+            return false;
+        }
+        const StubVideoDecoder::PictureRecord& expected = reference[i];
+        const StubVideoDecoder::PictureRecord& record = pipelined[i];
+        if ((record.displayed != expected.displayed) || (record.bitstreamDataOffset != expected.bitstreamDataOffset) ||
+            (record.bitstreamDataLen != expected.bitstreamDataLen) || (record.bitstreamDataHash != expected.bitstreamDataHash) ||
+            (record.parametersHash != expected.parametersHash)) {
+            printf("FAILED: picture %zu differs: %s, bitstream %zu + %zu, data %016llx, parameters %016llx inline, "
+                   "%s, bitstream %zu + %zu, data %016llx, parameters %016llx pipelined\n", i,
+                   expected.displayed ? "displayed" : "decoded", expected.bitstreamDataOffset, expected.bitstreamDataLen,
+                   (unsigned long long)expected.bitstreamDataHash, (unsigned long long)expected.parametersHash,
+                   record.displayed ? "displayed" : "decoded", record.bitstreamDataOffset, record.bitstreamDataLen,
+                   (unsigned long long)record.bitstreamDataHash, (unsigned long long)record.parametersHash);
+            return false;
+        }
+    }
+    printf("pipelined decode: %zu pictures decoded or displayed, identical\n", reference.size());
+    return true;
+}
+
+// Parses the [beginOffset, endOffset) range of the elementary stream, which is made of the
+// packet payloads (the offsets of the parser do not count the IVF headers).
+static void ParseStreamRange(VulkanVideoDecodeParser* pParser, const VkParserRandomAccessPoint* pRandomAccessPoint,
+                             const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets,
+                             int64_t beginOffset, int64_t endOffset)
+{
+    int64_t streamOffset = 0;
+    bool first = true;
+    for (size_t i = 0; (i < packets.size()) && (streamOffset < endOffset); streamOffset += packets[i].size, i++) {
+        const int64_t packetBegin = std::max(beginOffset, streamOffset);
+        const int64_t packetEnd = std::min(endOffset, streamOffset + (int64_t)packets[i].size);
+        if (packetBegin >= packetEnd) {
+            continue;
+        }
+        VkParserBitstreamPacket packet;
+        memset(&packet, 0, sizeof(packet));
+        packet.pByteStream = data.data() + packets[i].offset + (packetBegin - streamOffset);
+        packet.nDataLength = (size_t)(packetEnd - packetBegin);
+        packet.bEOS = (packetEnd == endOffset);
+        size_t parsedBytes = 0;
+        if (first && (pRandomAccessPoint != nullptr)) {
+            pParser->ParseByteStreamAt(pRandomAccessPoint, &packet, &parsedBytes);
+        } else {
+            pParser->ParseByteStream(&packet, &parsedBytes);
+        }
+        first = false;
+    }
+}
+
+// Same as ParseStreamRange(), through the VulkanVideoParser of vk-video-dec and its seek entry point
+static VkResult SeekVulkanVideoParser(const BenchConfig& config, const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                      const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets,
+                                      int64_t endOffset, StubVideoDecoder::Counters& counters)
+{
+    VkExtensionProperties stdExtensionVersion;
+    GetStdExtensionVersion(config.codec, stdExtensionVersion);
+
+    VkSharedBaseObj<StubVideoDecoder> stubVideoDecoder;
+    VkResult result = StubVideoDecoder::Create(stubVideoDecoder);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    VkSharedBaseObj<IVulkanVideoDecoderHandler> decoderHandler;
+    decoderHandler = stubVideoDecoder;
+    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb> videoFrameBufferCb;
+    videoFrameBufferCb = stubVideoDecoder;
+    VkSharedBaseObj<IVulkanVideoParser> parser;
+    result = vulkanCreateVideoParser(decoderHandler, videoFrameBufferCb, config.codec, &stdExtensionVersion,
+                                     1, 1, 2 * 1024 * 1024, 256, 256, 0, parser);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    stubVideoDecoder->BeginStream(0);
+    int64_t streamOffset = 0;
+    bool first = true;
+    for (size_t i = 0; (i < packets.size()) && (streamOffset < endOffset); streamOffset += packets[i].size, i++) {
+        const int64_t packetBegin = std::max(pRandomAccessPoint->llOffset, streamOffset);
+        const int64_t packetEnd = std::min(endOffset, streamOffset + (int64_t)packets[i].size);
+        if (packetBegin >= packetEnd) {
+            continue;
+        }
+        VkParserSourceDataPacket packet = VkParserSourceDataPacket();
+        packet.payload = data.data() + packets[i].offset + (packetBegin - streamOffset);
+        packet.payload_size = (size_t)(packetEnd - packetBegin);
+        packet.flags = (packetEnd == endOffset) ? VK_PARSER_PKT_ENDOFSTREAM : 0;
+        size_t parsedBytes = 0;
+        result = first ? parser->SeekVideoData(pRandomAccessPoint, &packet, &parsedBytes, false) :
+                         parser->ParseVideoData(&packet, &parsedBytes, false);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        first = false;
+    }
+    parser = nullptr;
+
+    counters = stubVideoDecoder->GetCounters();
+    return VK_SUCCESS;
+}
+
+// Builds the random access index of the stream and stores it in the sidecar file, then reads
+// it back and decodes the stream again one random access point to the next.
+static bool RunIndex(const BenchConfig& config, const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets)
+{
+    int64_t streamSize = 0;
+    for (size_t i = 0; i < packets.size(); i++) {
+        streamSize += packets[i].size;
+    }
+
+    StubDecodeClient client;
+    VulkanVideoRandomAccessIndex index(config.codec);
+    client.SetRandomAccessIndex(&index);
+    VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+    if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, true, client, parser) != VK_SUCCESS) {
+        std::cerr << "Failed to create the parser" << std::endl;
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ParseStreamRange(parser, nullptr, data, packets, 0, streamSize);
+    const double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+    client.SetRandomAccessIndex(nullptr);
+
+    if (!index.Write(config.indexFileName.c_str())) {
+        return false;
+    }
+    printf("%s: %zu random access points indexed in %.3f s (%.2f MB/s)\n", config.indexFileName.c_str(),
+           index.GetCount(), seconds, (double)streamSize / seconds / 1e6);
+
+    VulkanVideoRandomAccessIndex sidecar;
+    if (!sidecar.Read(config.indexFileName.c_str())) {
+        return false;
+    }
+    if ((sidecar.GetCount() != index.GetCount()) || (sidecar.GetVideoCodec() != config.codec)) {
+        std::cerr << "The random access index read back does not match" << std::endl;
+        return false;
+    }
+
+    // Reference: all the pictures decoded from the start of the stream
+    parser = nullptr;
+    client.ResetCounters();
+    if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+        return false;
+    }
+    ParseStreamRange(parser, nullptr, data, packets, 0, streamSize);
+    const uint64_t numPictures = client.GetCounters().decodedPictures;
+
+    // Decode each random access period after seeking to it (leading pictures are not decodable)
+    uint64_t numSeekPictures = 0;
+    bool success = true;
+    for (size_t i = 0; i < sidecar.GetCount(); i++) {
+        VkParserRandomAccessPoint randomAccessPoint, nextRandomAccessPoint;
+        sidecar.GetRandomAccessPoint(i, &randomAccessPoint);
+        const int64_t endOffset = sidecar.GetRandomAccessPoint(i + 1, &nextRandomAccessPoint) ? nextRandomAccessPoint.llOffset : streamSize;
+        client.ResetCounters();
+        ParseStreamRange(parser, &randomAccessPoint, data, packets, randomAccessPoint.llOffset, endOffset);
+        if (client.GetCounters().decodedPictures == 0) {
+            std::cerr << "No picture decoded after seeking to offset " << randomAccessPoint.llOffset << std::endl;
+            success = false;
+        }
+        numSeekPictures += client.GetCounters().decodedPictures;
+
+        // The decoder seeks with VulkanVideoParser, which must get to the same pictures
+        StubVideoDecoder::Counters counters = StubVideoDecoder::Counters();
+        if (SeekVulkanVideoParser(config, &randomAccessPoint, data, packets, endOffset, counters) != VK_SUCCESS) {
+            std::cerr << "VulkanVideoParser failed to seek to offset " << randomAccessPoint.llOffset << std::endl;
+            success = false;
+        } else if (counters.decodedPictures != client.GetCounters().decodedPictures) {
+            std::cerr << "VulkanVideoParser decoded " << counters.decodedPictures << " pictures after seeking to offset "
+                      << randomAccessPoint.llOffset << ", instead of " << client.GetCounters().decodedPictures << std::endl;
+            success = false;
+        }
+    }
+    printf("%llu pictures decoded from the random access points, %llu from the start of the stream\n",
+           (unsigned long long)numSeekPictures, (unsigned long long)numPictures);
+    return success;
+}
+
+// Probes the format of the stream from a prefix of its first packet, then compares the time
+// to format with the time it takes the regular parsing path to reach BeginSequence().
+static bool RunProbe(const BenchConfig& config, const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets)
+{
+    const size_t prefixSize = (config.probeSize != 0) ? std::min(config.probeSize, packets[0].size) : packets[0].size;
+    StubDecodeClient client;
+    VkParserSequenceInfo nvsi;
+    size_t parsedBytes = 0;
+    bool found = false;
+    std::chrono::steady_clock::duration probeTime = std::chrono::steady_clock::duration::zero();
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+            std::cerr << "Failed to create the parser" << std::endl;
+            return false;
+        }
+        VkParserBitstreamPacket packet;
+        memset(&packet, 0, sizeof(packet));
+        packet.pByteStream = data.data() + packets[0].offset;
+        packet.nDataLength = prefixSize;
+        found = parser->ProbeSequenceInfo(&packet, &nvsi, &parsedBytes);
+        probeTime += std::chrono::steady_clock::now() - start;
+    }
+    if (!found) {
+        std::cerr << "No complete sequence header in the first " << prefixSize << " bytes" << std::endl;
+        return false;
+    }
+    if ((client.GetCounters().sequences != 0) || (client.GetCounters().decodedPictures != 0)) {
+        std::cerr << "The probe started a sequence" << std::endl;
+        return false;
+    }
+
+    // Reference: regular parsing of whole packets until the client gets BeginSequence()
+    std::chrono::steady_clock::duration sequenceTime = std::chrono::steady_clock::duration::zero();
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        client.ResetCounters();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+            return false;
+        }
+        for (size_t i = 0; (i < packets.size()) && (client.GetCounters().sequences == 0); i++) {
+            VkParserBitstreamPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            packet.pByteStream = data.data() + packets[i].offset;
+            packet.nDataLength = packets[i].size;
+            packet.bEOS = (i == (packets.size() - 1));
+            size_t packetParsedBytes = 0;
+            parser->ParseByteStream(&packet, &packetParsedBytes);
+        }
+        sequenceTime += std::chrono::steady_clock::now() - start;
+    }
+
+    printf("%s: %dx%d coded, %dx%d display, profile %u, chroma format %u, %u/%u bits, %d DPB slots, %d decode surfaces\n",
+           config.inputFileName.c_str(), nvsi.nCodedWidth, nvsi.nCodedHeight, nvsi.nDisplayWidth, nvsi.nDisplayHeight,
+           nvsi.codecProfile, nvsi.nChromaFormat, nvsi.uBitDepthLumaMinus8 + 8, nvsi.uBitDepthChromaMinus8 + 8,
+           nvsi.nMinNumDpbSlots, nvsi.nMinNumDecodeSurfaces);
+    printf("frame rate %u/%u, colour primaries %d, transfer %d, matrix %d, %s range\n",
+           NV_FRAME_RATE_NUM(nvsi.frameRate), NV_FRAME_RATE_DEN(nvsi.frameRate), nvsi.lColorPrimaries,
+           nvsi.lTransferCharacteristics, nvsi.lMatrixCoefficients, nvsi.uVideoFullRange ? "full" : "limited");
+    printf("time to format: %.1f us probing %zu of %zu bytes, %.1f us to BeginSequence()\n",
+           std::chrono::duration<double, std::micro>(probeTime).count() / config.numReps, parsedBytes, prefixSize,
+           std::chrono::duration<double, std::micro>(sequenceTime).count() / config.numReps);
+    return true;
+}
+
+// An Annex B stream repackaged the way an MP4 demuxer would return it: one sample per access
+// unit, NAL units prefixed by their size, and the parameter sets in an avcC/hvcC record.
+struct LengthPrefixedStream {
+    std::vector<uint8_t> configurationRecord;
+    std::vector<uint8_t> samples;
+    std::vector<BitstreamPacket> samplePackets;
+    std::vector<BitstreamPacket> accessUnitPackets; // The same access units in the Annex B data
+};
+
+static void PutBe(std::vector<uint8_t>& out, uint32_t value, uint32_t size)
+{
+    for (uint32_t i = size; i > 0; i--) {
+        out.push_back((uint8_t)(value >> (8 * (i - 1))));
+    }
+}
+
+static bool RepackageAsLengthPrefixed(VkVideoCodecOperationFlagBitsKHR codec, const std::vector<uint8_t>& data,
+                                      uint32_t nalLengthSize, LengthPrefixedStream& stream)
+{
+    struct NalUnit {
+        size_t startCode;
+        size_t begin;
+        size_t end;
+        size_t next;   // Start code of the next NAL unit
+        bool isSlice;
+        bool firstSlice;
+    };
+    const bool isH264 = (codec == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR);
+    const uint32_t numParameterSetTypes = isH264 ? 2 : 3;
+    std::vector<std::vector<uint8_t>> parameterSets[3];
+    std::vector<NalUnit> nalUnits;
+    size_t offset = 0;
+    while ((offset + 3 <= data.size()) && !((data[offset] == 0) && (data[offset + 1] == 0) && (data[offset + 2] == 1))) {
+        offset++;
+    }
+    while (offset + 3 < data.size()) {
+        // NAL unit payload between this start code and the next one (minus the trailing zero bytes)
+        NalUnit nalUnit = NalUnit();
+        nalUnit.startCode = offset;
+        nalUnit.begin = offset + 3;
+        size_t end = nalUnit.begin;
+        while ((end + 3 <= data.size()) && !((data[end] == 0) && (data[end + 1] == 0) && (data[end + 2] == 1))) {
+            end++;
+        }
+        nalUnit.next = (end + 3 > data.size()) ? data.size() : end;
+        nalUnit.end = nalUnit.next;
+        offset = nalUnit.next;
+        while ((nalUnit.end > nalUnit.begin) && (data[nalUnit.end - 1] == 0)) {
+            nalUnit.end--;
+        }
+        if ((nalUnit.end - nalUnit.begin) < 2) {
+            continue;
+        }
+        // The slices of a new picture start with first_mb_in_slice == 0 / first_slice_segment_in_pic_flag set
+        const uint32_t nalType = isH264 ? (data[nalUnit.begin] & 0x1f) : ((data[nalUnit.begin] >> 1) & 0x3f);
+        const uint32_t headerSize = isH264 ? 1 : 2;
+        nalUnit.isSlice = isH264 ? ((nalType >= 1) && (nalType <= 5)) : (nalType < 32);
+        nalUnit.firstSlice = nalUnit.isSlice && ((nalUnit.end - nalUnit.begin) > headerSize) &&
+                             (data[nalUnit.begin + headerSize] & 0x80);
+        nalUnits.push_back(nalUnit);
+
+        // Parameter sets go to the record (up to 16 of each type), and stay in band as well
+        const uint32_t type = isH264 ? (nalType - 7) : (nalType - 32);
+        if ((type < numParameterSetTypes) && (parameterSets[type].size() < 16)) {
+            parameterSets[type].push_back(std::vector<uint8_t>(data.begin() + nalUnit.begin, data.begin() + nalUnit.end));
+        }
+    }
+
+    // An access unit ends with its last slice, the non-VCL NAL units in front of the first
+    // slice of the next picture belong to the next one
+    size_t lastSlice = 0;
+    bool accessUnitHasSlices = false;
+    std::vector<size_t> accessUnitStarts(1, 0);
+    for (size_t i = 0; i < nalUnits.size(); i++) {
+        if (nalUnits[i].firstSlice && accessUnitHasSlices) {
+            accessUnitStarts.push_back(lastSlice + 1);
+        }
+        if (nalUnits[i].isSlice) {
+            lastSlice = i;
+            accessUnitHasSlices = true;
+        }
+    }
+    accessUnitStarts.push_back(nalUnits.size());
+
+    for (size_t au = 0; (au + 1 < accessUnitStarts.size()) && !nalUnits.empty(); au++) {
+        const NalUnit& first = nalUnits[accessUnitStarts[au]];
+        const NalUnit& last = nalUnits[accessUnitStarts[au + 1] - 1];
+        BitstreamPacket accessUnitPacket = { first.startCode, last.next - first.startCode, 0 };
+        stream.accessUnitPackets.push_back(accessUnitPacket);
+        BitstreamPacket samplePacket = { stream.samples.size(), 0, 0 };
+        for (size_t i = accessUnitStarts[au]; i < accessUnitStarts[au + 1]; i++) {
+            const size_t naluSize = nalUnits[i].end - nalUnits[i].begin;
+            if ((nalLengthSize < 4) && (naluSize >= (1u << (8 * nalLengthSize)))) {
+                std::cerr << "A NAL unit of " << naluSize << " bytes does not fit a " << nalLengthSize << "-byte length field" << std::endl;
+                return false;
+            }
+            PutBe(stream.samples, (uint32_t)naluSize, nalLengthSize);
+            stream.samples.insert(stream.samples.end(), data.begin() + nalUnits[i].begin, data.begin() + nalUnits[i].end);
+        }
+        samplePacket.size = stream.samples.size() - samplePacket.offset;
+        stream.samplePackets.push_back(samplePacket);
+    }
+    if (stream.samplePackets.empty()) {
+        return false;
+    }
+
+    std::vector<uint8_t>& record = stream.configurationRecord;
+    record.push_back(1); // configurationVersion
+    if (isH264) {
+        if (parameterSets[0].empty() || (parameterSets[0][0].size() < 4)) {
+            return false;
+        }
+        record.insert(record.end(), parameterSets[0][0].begin() + 1, parameterSets[0][0].begin() + 4); // profile, compatibility, level
+        record.push_back(0xfc | (uint8_t)(nalLengthSize - 1));
+        record.push_back(0xe0 | (uint8_t)parameterSets[0].size());
+        for (uint32_t type = 0; type < 2; type++) {
+            if (type == 1) {
+                record.push_back((uint8_t)parameterSets[1].size());
+            }
+            for (size_t i = 0; i < parameterSets[type].size(); i++) {
+                PutBe(record, (uint32_t)parameterSets[type][i].size(), 2);
+                record.insert(record.end(), parameterSets[type][i].begin(), parameterSets[type][i].end());
+            }
+        }
+    } else {
+        // The profile, tier and level fields are informative, the parser only uses the arrays
+        record.resize(21, 0);
+        record.push_back((uint8_t)(nalLengthSize - 1));
+        record.push_back((uint8_t)numParameterSetTypes);
+        for (uint32_t type = 0; type < numParameterSetTypes; type++) {
+            record.push_back(0x80 | (uint8_t)(32 + type)); // array_completeness, NAL_unit_type
+            PutBe(record, (uint32_t)parameterSets[type].size(), 2);
+            for (size_t i = 0; i < parameterSets[type].size(); i++) {
+                PutBe(record, (uint32_t)parameterSets[type][i].size(), 2);
+                record.insert(record.end(), parameterSets[type][i].begin(), parameterSets[type][i].end());
+            }
+        }
+    }
+    return true;
+}
+
+enum SampleInput {
+    SAMPLE_INPUT_ANNEX_B,         // Annex B access units, start code scan
+    SAMPLE_INPUT_BSF,             // MP4 samples rewritten to Annex B (as mp4toannexb does), then start code scan
+    SAMPLE_INPUT_LENGTH_PREFIXED, // MP4 samples parsed as they are
+};
+
+// Parses the whole stream numReps times, one access unit per packet; the sample rewrite of
+// SAMPLE_INPUT_BSF is timed along with the ParseByteStream() calls.
+static bool RunSampleBench(const BenchConfig& config, SampleInput input, const std::vector<uint8_t>& data,
+                           const LengthPrefixedStream& stream, BenchResult& result)
+{
+    const bool isAnnexB = (input == SAMPLE_INPUT_ANNEX_B);
+    const std::vector<uint8_t>& inputData = isAnnexB ? data : stream.samples;
+    const std::vector<BitstreamPacket>& packets = isAnnexB ? stream.accessUnitPackets : stream.samplePackets;
+    StubDecodeClient client;
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+            return false;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if ((input == SAMPLE_INPUT_LENGTH_PREFIXED) &&
+            !parser->SetDecoderConfigurationRecord(stream.configurationRecord.data(), stream.configurationRecord.size())) {
+            std::cerr << "The decoder configuration record was rejected" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < packets.size(); i++) {
+            const uint8_t* pSample = inputData.data() + packets[i].offset;
+            std::vector<uint8_t> annexB;
+            VkParserBitstreamPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            packet.pByteStream = pSample;
+            packet.nDataLength = packets[i].size;
+            packet.bEOS = (i == (packets.size() - 1));
+            if (input == SAMPLE_INPUT_BSF) {
+                for (size_t offset = 0; offset + config.nalLengthSize <= packets[i].size;) {
+                    uint32_t naluSize = 0;
+                    for (uint32_t j = 0; j < config.nalLengthSize; j++) {
+                        naluSize = (naluSize << 8) | pSample[offset + j];
+                    }
+                    offset += config.nalLengthSize;
+                    naluSize = (uint32_t)std::min<size_t>(naluSize, packets[i].size - offset);
+                    static const uint8_t startCode[] = { 0, 0, 0, 1 };
+                    annexB.insert(annexB.end(), startCode, startCode + sizeof(startCode));
+                    annexB.insert(annexB.end(), pSample + offset, pSample + offset + naluSize);
+                    offset += naluSize;
+                }
+                packet.pByteStream = annexB.data();
+                packet.nDataLength = annexB.size();
+            }
+            size_t parsedBytes = 0;
+            parser->ParseByteStream(&packet, &parsedBytes);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    result.counters = client.GetCounters();
+    return true;
+}
+
+static bool RunLengthPrefixed(const BenchConfig& config, const std::vector<uint8_t>& data)
+{
+    LengthPrefixedStream stream;
+    if (!RepackageAsLengthPrefixed(config.codec, data, config.nalLengthSize, stream)) {
+        std::cerr << "Failed to repackage " << config.inputFileName << " as MP4 samples" << std::endl;
+        return false;
+    }
+    printf("%s: %zu access units, %zu bytes of Annex B, %zu bytes of MP4 samples with %u-byte lengths, %zu-byte record\n",
+           config.inputFileName.c_str(), stream.samplePackets.size(), data.size(), stream.samples.size(),
+           config.nalLengthSize, stream.configurationRecord.size());
+    printf("%-16s %12s %12s %10s %10s\n", "input", "MB/s", "pictures/s", "pictures", "slices");
+
+    static const struct {
+        const char* name;
+        SampleInput input;
+    } inputs[] = {
+        { "annexb",         SAMPLE_INPUT_ANNEX_B },
+        { "mp4toannexb",    SAMPLE_INPUT_BSF },
+        { "lengthprefixed", SAMPLE_INPUT_LENGTH_PREFIXED },
+    };
+    uint64_t numPictures = 0;
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        BenchResult result = BenchResult();
+        if (!RunSampleBench(config, inputs[i].input, data, stream, result)) {
+            return false;
+        }
+        const double seconds = std::max(result.seconds, 1e-9);
+        // The throughput is relative to the Annex B stream size for all the inputs
+        printf("%-16s %12.2f %12.1f %10llu %10llu\n", inputs[i].name,
+               (double)data.size() * config.numReps / seconds / 1e6,
+               (double)result.counters.decodedPictures / seconds,
+               (unsigned long long)(result.counters.decodedPictures / config.numReps),
+               (unsigned long long)(result.counters.slices / config.numReps));
+        if ((i > 0) && (result.counters.decodedPictures != numPictures)) {
+            std::cerr << "The " << inputs[i].name << " input decodes a different number of pictures" << std::endl;
+            return false;
+        }
+        numPictures = result.counters.decodedPictures;
+    }
+    return true;
+}
+
+// Parses the whole stream numReps times, each packet scattered over segments the way a network
+// receiver would reassemble it. The copy of the segments into one contiguous packet is timed
+// along with the ParseByteStream() calls.
+static bool RunSegmentBench(const BenchConfig& config, bool gather, const std::vector<std::vector<uint8_t>>& segmentData,
+                            const std::vector<std::vector<VkParserBitstreamSegment>>& packetSegments, BenchResult& result)
+{
+    size_t maxPacketSize = 0;
+    for (size_t i = 0; i < packetSegments.size(); i++) {
+        size_t packetSize = 0;
+        for (size_t j = 0; j < packetSegments[i].size(); j++) {
+            packetSize += packetSegments[i][j].size;
+        }
+        maxPacketSize = std::max(maxPacketSize, packetSize);
+    }
+    std::vector<uint8_t> contiguousPacket(maxPacketSize);
+
+    StubDecodeClient client;
+    client.SetOutputHash(true);
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+            return false;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < packetSegments.size(); i++) {
+            const std::vector<VkParserBitstreamSegment>& segments = packetSegments[i];
+            VkParserBitstreamPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            packet.bEOS = (i == (packetSegments.size() - 1));
+            size_t parsedBytes = 0;
+            if (gather) {
+                for (size_t j = 0; j < segments.size(); j++) {
+                    memcpy(contiguousPacket.data() + packet.nDataLength, segments[j].pData, segments[j].size);
+                    packet.nDataLength += segments[j].size;
+                }
+                packet.pByteStream = contiguousPacket.data();
+                parser->ParseByteStream(&packet, &parsedBytes);
+            } else {
+                parser->ParseByteStreamSegments(&packet, segments.data(), (uint32_t)segments.size(), &parsedBytes);
+            }
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    result.counters = client.GetCounters();
+    return true;
+}
+
+static bool RunSegments(const BenchConfig& config, const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets)
+{
+    // Every segment has its own allocation, so that the packets really are scattered in memory
+    std::vector<std::vector<uint8_t>> segmentData;
+    std::vector<std::vector<VkParserBitstreamSegment>> packetSegments(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) {
+        for (size_t offset = 0; offset < packets[i].size; offset += config.segmentSize) {
+            const uint8_t* pSegment = data.data() + packets[i].offset + offset;
+            segmentData.push_back(std::vector<uint8_t>(pSegment, pSegment + std::min(config.segmentSize, packets[i].size - offset)));
+        }
+    }
+    for (size_t i = 0, segment = 0; i < packets.size(); i++) {
+        for (size_t offset = 0; offset < packets[i].size; offset += config.segmentSize, segment++) {
+            VkParserBitstreamSegment packetSegment = { segmentData[segment].data(), segmentData[segment].size() };
+            packetSegments[i].push_back(packetSegment);
+        }
+    }
+    printf("%s: %zu bytes, %zu packets, %zu segments of up to %zu bytes, %u reps\n", config.inputFileName.c_str(),
+           data.size(), packets.size(), segmentData.size(), config.segmentSize, config.numReps);
+    printf("%-16s %12s %12s %10s %10s  %s\n", "input", "MB/s", "pictures/s", "pictures", "slices", "output");
+
+    static const struct {
+        const char* name;
+        bool gather;
+    } inputs[] = {
+        { "copy+contiguous", true },
+        { "segments",        false },
+    };
+    StubDecodeClient::Counters reference = StubDecodeClient::Counters();
+    bool identical = true;
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        BenchResult result = BenchResult();
+        if (!RunSegmentBench(config, inputs[i].gather, segmentData, packetSegments, result)) {
+            return false;
+        }
+        if (i == 0) {
+            reference = result.counters;
+        }
+        // The output hash covers the bitstream data of each picture and the display order, not only their number
+        const bool sameOutput = (result.counters.outputHash == reference.outputHash) &&
+                                (result.counters.decodedPictures == reference.decodedPictures) &&
+                                (result.counters.displayedPictures == reference.displayedPictures);
+        identical = identical && sameOutput;
+        const double seconds = std::max(result.seconds, 1e-9);
+        printf("%-16s %12.2f %12.1f %10llu %10llu  %016llx %s\n", inputs[i].name,
+               (double)data.size() * config.numReps / seconds / 1e6,
+               (double)result.counters.decodedPictures / seconds,
+               (unsigned long long)(result.counters.decodedPictures / config.numReps),
+               (unsigned long long)(result.counters.slices / config.numReps),
+               (unsigned long long)result.counters.outputHash,
+               (i == 0) ? "reference" : sameOutput ? "identical" : "DIFFERENT");
+    }
+    return identical;
+}
+
+static size_t WriteLeb128(uint64_t value, std::vector<uint8_t>& data)
+{
+    size_t size = 0;
+    do {
+        const uint8_t byte = value & 0x7f;
+        value >>= 7;
+        data.push_back(byte | ((value != 0) ? 0x80 : 0));
+        size++;
+    } while (value != 0);
+    return size;
+}
+
+enum { OBU_FRAME_HEADER = 3, OBU_FRAME = 6 };
+
+// Rewrites the temporal units of an AV1 low overhead bitstream in the Annex B length delimited format
+// (temporal_unit() syntax), without the obu_size fields. Each frame header starts a frame unit.
+static void RepackageAsAv1AnnexB(const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& temporalUnits,
+                                 std::vector<uint8_t>& annexB)
+{
+    for (size_t i = 0; i < temporalUnits.size(); i++) {
+        const uint8_t* pData = data.data() + temporalUnits[i].offset;
+        const size_t size = temporalUnits[i].size;
+        std::vector<std::vector<uint8_t>> frameUnits(1);
+        bool frameUnitHasFrame = false;
+        for (size_t offset = 0; offset < size;) {
+            const uint8_t obuHeader = pData[offset];
+            const uint32_t obuType = (obuHeader >> 3) & 0xf;
+            const size_t headerSize = (obuHeader & 0x04) ? 2 : 1;
+            uint64_t obuSize = 0;
+            size_t lebSize = 0;
+            if (obuHeader & 0x02) {
+                lebSize = ReadLeb128(pData + offset + headerSize, size - offset - headerSize, obuSize);
+            } else {
+                obuSize = size - offset - headerSize;
+            }
+            if ((obuType == OBU_FRAME_HEADER) || (obuType == OBU_FRAME)) {
+                if (frameUnitHasFrame) {
+                    frameUnits.push_back(std::vector<uint8_t>());
+                }
+                frameUnitHasFrame = true;
+            }
+            std::vector<uint8_t>& frameUnit = frameUnits.back();
+            WriteLeb128(headerSize + obuSize, frameUnit);
+            frameUnit.push_back(obuHeader & ~0x02);
+            frameUnit.insert(frameUnit.end(), pData + offset + 1, pData + offset + headerSize);
+            frameUnit.insert(frameUnit.end(), pData + offset + headerSize + lebSize, pData + offset + headerSize + lebSize + obuSize);
+            offset += headerSize + lebSize + obuSize;
+        }
+        std::vector<uint8_t> temporalUnit;
+        for (size_t j = 0; j < frameUnits.size(); j++) {
+            WriteLeb128(frameUnits[j].size(), temporalUnit);
+            temporalUnit.insert(temporalUnit.end(), frameUnits[j].begin(), frameUnits[j].end());
+        }
+        WriteLeb128(temporalUnit.size(), annexB);
+        annexB.insert(annexB.end(), temporalUnit.begin(), temporalUnit.end());
+    }
+}
+
+// Splits the data in chunks of 1 to chunkSize bytes, always the same ones for a given size
+static std::vector<BitstreamPacket> SplitInChunks(size_t dataSize, size_t chunkSize)
+{
+    std::vector<BitstreamPacket> chunks;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> chunkSizes(1, chunkSize);
+    for (size_t offset = 0; offset < dataSize;) {
+        BitstreamPacket chunk = { offset, std::min(chunkSizes(rng), dataSize - offset), 0 };
+        chunks.push_back(chunk);
+        offset += chunk.size;
+    }
+    return chunks;
+}
+
+// Parses the AV1 stream one temporal unit per packet, then split in random chunks, in the low overhead and in
+// the Annex B format. All the runs must decode and display the same pictures, with the same tile data.
+static bool RunChunks(const BenchConfig& config, const std::vector<uint8_t>& data, const std::vector<BitstreamPacket>& packets)
+{
+    // The temporal units, without the IVF frame headers
+    std::vector<uint8_t> obus;
+    std::vector<BitstreamPacket> temporalUnits;
+    for (size_t i = 0; i < packets.size(); i++) {
+        BitstreamPacket temporalUnit = { obus.size(), packets[i].size, 0 };
+        temporalUnits.push_back(temporalUnit);
+        obus.insert(obus.end(), data.begin() + packets[i].offset, data.begin() + packets[i].offset + packets[i].size);
+    }
+    std::vector<uint8_t> annexB;
+    RepackageAsAv1AnnexB(obus, temporalUnits, annexB);
+    std::vector<BitstreamPacket> annexBTemporalUnits;
+    for (size_t offset = 0; offset < annexB.size();) {
+        uint64_t temporalUnitSize = 0;
+        const size_t lebSize = ReadLeb128(annexB.data() + offset, annexB.size() - offset, temporalUnitSize);
+        BitstreamPacket temporalUnit = { offset, lebSize + (size_t)temporalUnitSize, 0 };
+        annexBTemporalUnits.push_back(temporalUnit);
+        offset += temporalUnit.size;
+    }
+    printf("%s: %zu temporal units, %zu bytes (%zu in Annex B), chunks of up to %zu bytes, %u reps\n",
+           config.inputFileName.c_str(), temporalUnits.size(), obus.size(), annexB.size(), config.chunkSize, config.numReps);
+    printf("%-22s %12s %10s %10s %10s  %s\n", "input", "MB/s", "packets", "pictures", "displayed", "output");
+
+    const struct {
+        const char* name;
+        bool annexB;
+        bool chunks;
+    } inputs[] = {
+        { "temporal units",        false, false },
+        { "chunks",                false, true },
+        { "annexb temporal units", true,  false },
+        { "annexb chunks",         true,  true },
+    };
+    StubDecodeClient::Counters reference = StubDecodeClient::Counters();
+    bool identical = true;
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        BenchConfig chunkConfig = config;
+        chunkConfig.streamingInput = inputs[i].chunks;
+        chunkConfig.av1AnnexB = inputs[i].annexB;
+        chunkConfig.outputHash = true;
+        const std::vector<uint8_t>& inputData = inputs[i].annexB ? annexB : obus;
+        const std::vector<BitstreamPacket> inputPackets = inputs[i].chunks ? SplitInChunks(inputData.size(), config.chunkSize) :
+                                                          inputs[i].annexB ? annexBTemporalUnits : temporalUnits;
+        BenchResult result = BenchResult();
+        if (RunBench(chunkConfig, VK_PARSER_SIMD_ISA_AUTO, inputData, inputPackets, result) != VK_SUCCESS) {
+            return false;
+        }
+        if (i == 0) {
+            reference = result.counters;
+        }
+        const bool sameOutput = (result.counters.outputHash == reference.outputHash) &&
+                                (result.counters.decodedPictures == reference.decodedPictures) &&
+                                (result.counters.displayedPictures == reference.displayedPictures);
+        identical = identical && sameOutput;
+        printf("%-22s %12.2f %10zu %10llu %10llu  %s\n", inputs[i].name,
+               (double)inputData.size() * config.numReps / std::max(result.seconds, 1e-9) / 1e6, inputPackets.size(),
+               (unsigned long long)(result.counters.decodedPictures / config.numReps),
+               (unsigned long long)(result.counters.displayedPictures / config.numReps),
+               (i == 0) ? "reference" : sameOutput ? "identical" : "DIFFERENT");
+    }
+    return identical;
+}
+
+// Demuxes the input numReps times, then parses the demuxed frames numReps times, with their time
+// stamps and with the decoder configuration record of the container, as vk-video-dec does.
+// A pipe is demuxed and parsed once, in a single pass.
+static bool RunDemux(BenchConfig& config, const std::string& inputFileName, uint64_t& outputHash)
+{
+    struct stat fileStat;
+    const bool isFile = (stat(inputFileName.c_str(), &fileStat) == 0) && ((fileStat.st_mode & S_IFMT) == S_IFREG);
+    if (!isFile) {
+        config.numReps = 1;
+    }
+
+    // A pipe can't be probed without taking its data away, the streaming demuxer probes what it reads
+    VkSharedBaseObj<VideoStreamDemuxer> demuxer;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    VideoStreamFormat format;
+    VideoStreamProbeFile(inputFileName.c_str(), format);
+    VkResult result = VK_ERROR_FORMAT_NOT_SUPPORTED;
+    if (format.container == VideoStreamFormat::CONTAINER_IVF) {
+        result = IvfDemuxerCreate(inputFileName.c_str(), 1920, 1080, 8, demuxer);
+    } else if (format.container == VideoStreamFormat::CONTAINER_MP4) {
+        result = Mp4DemuxerCreate(inputFileName.c_str(), 1920, 1080, 8, demuxer);
+    } else if (format.container == VideoStreamFormat::CONTAINER_TS) {
+        result = TsDemuxerCreate(inputFileName.c_str(), 1920, 1080, 8, demuxer);
+    } else if (format.container == VideoStreamFormat::CONTAINER_ELEMENTARY) {
+        result = ElementaryStreamCreate(inputFileName.c_str(), config.codec, 1920, 1080, 8, demuxer);
+    } else if (!isFile) {
+        result = StreamingDemuxerCreate(inputFileName.c_str(), config.codec, 1920, 1080, 8, demuxer);
+    }
+    if (result != VK_SUCCESS) {
+        std::cerr << "The input " << inputFileName << " is neither an IVF, an MP4 nor an MPEG-TS file, "
+                     "nor an elementary stream" << std::endl;
+        return false;
+    }
+    // Elementary streams are read in the views the demuxer hands out: the whole mapped file, or what the
+    // ring buffer of a streamed input holds. Their demuxing is timed with the parsing, as for pipes.
+    const bool demuxesFrames = demuxer->IsStreamDemuxerEnabled();
+    const bool timesDemuxWithParse = !isFile || !demuxesFrames;
+    const char* pUnitName = demuxesFrames ? "frame" : "view";
+    config.streamingInput = !demuxesFrames;
+    config.av1AnnexB = demuxer->IsAv1AnnexB();
+    const double openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    config.codec = demuxer->GetVideoCodec();
+    demuxer->DumpStreamParameters();
+
+    uint64_t numFrames = 0, numBytes = 0;
+    double demuxSeconds = 0.0;
+    if (!timesDemuxWithParse) {
+        start = std::chrono::steady_clock::now();
+        for (uint32_t rep = 0; rep < config.numReps; rep++) {
+            demuxer->Rewind();
+            const uint8_t* pFrame = nullptr;
+            for (int64_t frameSize = demuxer->DemuxFrame(&pFrame); frameSize > 0; frameSize = demuxer->DemuxFrame(&pFrame)) {
+                numFrames++;
+                numBytes += (uint64_t)frameSize;
+            }
+        }
+        demuxSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    size_t configurationRecordSize = 0;
+    const uint8_t* pConfigurationRecord = demuxer->GetDecoderConfigurationRecord(configurationRecordSize);
+    StubDecodeClient client;
+    client.SetOutputHash(true);
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+    std::chrono::steady_clock::duration demuxElapsed = std::chrono::steady_clock::duration::zero();
+    uint64_t numDiscontinuities = 0;
+    for (uint32_t rep = 0; rep < config.numReps; rep++) {
+        VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+        if (CreateParser(config, VK_PARSER_SIMD_ISA_AUTO, false, client, parser) != VK_SUCCESS) {
+            std::cerr << "Failed to create the parser" << std::endl;
+            return false;
+        }
+        if ((pConfigurationRecord != nullptr) &&
+            !parser->SetDecoderConfigurationRecord(pConfigurationRecord, configurationRecordSize)) {
+            std::cerr << "The decoder configuration record was rejected" << std::endl;
+            return false;
+        }
+
+        if (isFile) {
+            demuxer->Rewind();
+        }
+        start = std::chrono::steady_clock::now();
+        // The data of a frame may not outlive the next DemuxFrame() call, so the end of the stream
+        // is signalled with an empty packet
+        uint64_t streamOffset = 0;
+        for (;;) {
+            const std::chrono::steady_clock::time_point demuxStart = std::chrono::steady_clock::now();
+            const uint8_t* pFrame = nullptr;
+            const int64_t frameSize = demuxesFrames ? demuxer->DemuxFrame(&pFrame) :
+                                                      demuxer->ReadBitstreamData(&pFrame, (int64_t)streamOffset);
+            demuxElapsed += std::chrono::steady_clock::now() - demuxStart;
+
+            VkParserBitstreamPacket packet;
+            memset(&packet, 0, sizeof(packet));
+            size_t parsedBytes = 0;
+            if ((frameSize > 0) && demuxer->HasFrameDiscontinuity()) {
+                // As VulkanVideoParser does, the discontinuity is signalled before the new data
+                packet.bDiscontinuity = true;
+                parser->ParseByteStream(&packet, &parsedBytes);
+                packet.bDiscontinuity = false;
+                numDiscontinuities++;
+            }
+            if (frameSize > 0) {
+                packet.pByteStream = pFrame;
+                packet.nDataLength = (size_t)frameSize;
+                packet.llPTS = demuxer->GetFrameTimestamp();
+                packet.bPTSValid = demuxesFrames;
+                if (timesDemuxWithParse) {
+                    numFrames++;
+                    numBytes += (uint64_t)frameSize;
+                }
+            } else {
+                packet.bEOS = true;
+            }
+            // A view the parser makes no progress on would be handed out again and again
+            if (!parser->ParseByteStream(&packet, &parsedBytes) || (!demuxesFrames && !packet.bEOS && (parsedBytes == 0))) {
+                std::cerr << "The parser failed on the " << pUnitName << " at offset " << streamOffset << " of "
+                          << inputFileName << std::endl;
+                return false;
+            }
+            if (packet.bEOS) {
+                break;
+            }
+            streamOffset += parsedBytes;
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    if (!isFile) {
+        // The back-pressure and latency counters of the streamed input
+        demuxer->DumpStreamParameters();
+    }
+    if (timesDemuxWithParse) {
+        elapsed -= demuxElapsed;
+        demuxSeconds = std::chrono::duration<double>(demuxElapsed).count();
+    }
+    demuxSeconds = std::max(demuxSeconds, 1e-9);
+
+    printf("%s: opened and indexed in %.3f ms, %llu %ss, %llu bytes, %u reps\n", inputFileName.c_str(), openSeconds * 1e3,
+           (unsigned long long)(numFrames / config.numReps), pUnitName, (unsigned long long)(numBytes / config.numReps), config.numReps);
+    // IVF and MP4 frames are handed out in place, their data is not read. MPEG-TS frames are reassembled.
+    printf("demux: %.1f ns per %s, %.1f %ss/s, %.2f Gbit/s of %s data, %llu discontinuities\n",
+           demuxSeconds * 1e9 / (double)std::max<uint64_t>(numFrames, 1), pUnitName, (double)numFrames / demuxSeconds, pUnitName, pUnitName,
+           (double)numBytes * 8.0 / demuxSeconds / 1e9, (unsigned long long)(numDiscontinuities / config.numReps));
+
+    const StubDecodeClient::Counters& counters = client.GetCounters();
+    const double parseSeconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+    printf("parse: %.2f MB/s, %.1f pictures/s, %llu pictures, %llu displayed, output %016llx\n",
+           (double)numBytes / parseSeconds / 1e6, (double)counters.decodedPictures / parseSeconds,
+           (unsigned long long)(counters.decodedPictures / config.numReps),
+           (unsigned long long)(counters.displayedPictures / config.numReps),
+           (unsigned long long)counters.outputHash);
+    outputHash = counters.outputHash;
+    return counters.decodedPictures != 0;
+}
+
+#if defined(__unix__)
+// Demuxes the first pipeSize bytes of the input from a file, then from a pipe another thread writes
+// them into, and compares the output of the parser. The pipe is read through the streaming demuxer,
+// which probes the prefix it reads: the cuts shorter than a prefix must be demuxed from it alone.
+static bool RunPipe(const BenchConfig& config)
+{
+    std::ifstream inputFile(config.inputFileName.c_str(), std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "Can't open the input file " << config.inputFileName << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    std::string fileName = config.inputFileName;
+    char cutFileName[] = "/tmp/vk-video-parse-bench-XXXXXX";
+    if ((config.pipeSize != 0) && (config.pipeSize < data.size())) {
+        // The file demuxers need a file of the cut
+        data.resize(config.pipeSize);
+        const int cutFd = mkstemp(cutFileName);
+        if (cutFd < 0) {
+            std::cerr << "Can't create a temporary file" << std::endl;
+            return false;
+        }
+        const bool written = (write(cutFd, data.data(), data.size()) == (ssize_t)data.size());
+        close(cutFd);
+        if (!written) {
+            unlink(cutFileName);
+            std::cerr << "Can't write the temporary file " << cutFileName << std::endl;
+            return false;
+        }
+        fileName = cutFileName;
+    }
+
+    BenchConfig fileConfig = config;
+    fileConfig.numReps = 1;
+    uint64_t fileOutputHash = 0;
+    const bool fileDemuxed = RunDemux(fileConfig, fileName, fileOutputHash);
+    if (fileName != config.inputFileName) {
+        unlink(cutFileName);
+    }
+
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        std::cerr << "Can't create a pipe" << std::endl;
+        return false;
+    }
+    // The reader may stop early on an error: the writes then fail instead of raising SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+    std::thread writer([&data, &pipeFds]() {
+        for (size_t offset = 0; offset < data.size();) {
+            const ssize_t written = write(pipeFds[1], data.data() + offset, data.size() - offset);
+            if (written <= 0) {
+                break;
+            }
+            offset += (size_t)written;
+        }
+        close(pipeFds[1]);
+    });
+    BenchConfig pipeConfig = config;
+    uint64_t pipeOutputHash = 0;
+    const bool pipeDemuxed = RunDemux(pipeConfig, "/dev/fd/" + std::to_string(pipeFds[0]), pipeOutputHash);
+    close(pipeFds[0]);
+    writer.join();
+
+    const bool identical = fileDemuxed && pipeDemuxed && (pipeOutputHash == fileOutputHash);
+    printf("pipe: %zu bytes, output %016llx from the file, %016llx from the pipe: %s\n", data.size(),
+           (unsigned long long)fileOutputHash, (unsigned long long)pipeOutputHash,
+           identical ? "identical" : (fileDemuxed && pipeDemuxed) ? "DIFFERENT" : "FAILED");
+    return identical;
+}
+#endif // __unix__
+
+int main(int argc, const char **argv)
+{
+    BenchConfig config;
+    if (!ParseArgs(argc, argv, config)) {
+        return EXIT_FAILURE;
+    }
+
+    // The demuxers map or stream the input themselves
+    if (config.pipeCheck) {
+#if defined(__unix__)
+        return RunPipe(config) ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+        std::cerr << "--pipe is only supported on Unix" << std::endl;
+        return EXIT_FAILURE;
+#endif
+    }
+    if (config.demux) {
+        uint64_t outputHash = 0;
+        return RunDemux(config, config.inputFileName, outputHash) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::ifstream inputFile(config.inputFileName.c_str(), std::ios::binary);
+    if (!inputFile) {
+        std::cerr << "Can't open the input file " << config.inputFileName << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    if (data.empty()) {
+        std::cerr << "The input file " << config.inputFileName << " is empty" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Split the input into the packets a demuxer would produce, and count the
+    // NAL units (OBUs for AV1, frames for VP9) they contain.
+    std::vector<BitstreamPacket> packets;
+    uint64_t numUnits = 0;
+    const bool isIvf = SplitIvfFrames(data, config.codec, packets);
+    if (!isIvf && (config.codec == VK_VIDEO_CODEC_OPERATION_NONE_KHR)) {
+        // The elementary stream is probed first, the file name only comes as a last resort
+        VideoStreamFormat format;
+        if ((VideoStreamProbe(data.data(), std::min<size_t>(data.size(), VIDEO_STREAM_PROBE_SIZE),
+                              (data.size() <= VIDEO_STREAM_PROBE_SIZE), format) != 0) &&
+            (format.container == VideoStreamFormat::CONTAINER_ELEMENTARY)) {
+            PrintVideoStreamFormat(format);
+            if (format.av1AnnexB) {
+                std::cerr << "AV1 Annex B input is only supported with --demux, or through --chunks from a low-overhead OBU stream" << std::endl;
+                return EXIT_FAILURE;
+            }
+            config.codec = format.codec;
+        } else if (format.container != VideoStreamFormat::CONTAINER_UNKNOWN) {
+            std::cerr << "The input is an " << format.pName << " file, please use --demux" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (config.codec == VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+        config.codec = GetCodecFromFileName(config.inputFileName);
+    }
+    if (!isIvf && (config.codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR)) {
+        numUnits = WalkAv1Obus(data.data(), data.size(), 0, &packets);
+    } else if (config.codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        for (size_t i = 0; i < packets.size(); i++) {
+            numUnits += WalkAv1Obus(data.data() + packets[i].offset, packets[i].size, packets[i].offset, nullptr);
+        }
+    } else if (isIvf) {
+        numUnits = packets.size();
+    } else {
+        numUnits = CountStartCodes(data);
+        const size_t packetSize = (config.packetSize != 0) ? config.packetSize : data.size();
+        const size_t spanSize = (config.zeroCopySpanSize != 0) ? config.zeroCopySpanSize : SIZE_MAX;
+        for (size_t offset = 0; offset < data.size();) {
+            // Packets never cross the end of a zero-copy span
+            const size_t spanEnd = std::min(data.size(), (offset / spanSize + 1) * spanSize);
+            BitstreamPacket packet = { offset, std::min(packetSize, spanEnd - offset), (uint32_t)(offset / spanSize) };
+            packets.push_back(packet);
+            offset += packet.size;
+        }
+    }
+    if ((config.zeroCopySpanSize != 0) && (isIvf || (config.codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR))) {
+        std::cerr << "--zeroCopy is only supported with H.264 and H.265 elementary streams" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    VkExtensionProperties stdExtensionVersion;
+    if (!GetStdExtensionVersion(config.codec, stdExtensionVersion)) {
+        std::cerr << "Unknown or unsupported codec, please use --codec" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (packets.empty()) {
+        std::cerr << "No packets found in " << config.inputFileName << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!config.captureTraceFileName.empty() || !config.checkTraceFileName.empty()) {
+        return RunParserTrace(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.parameterSetCheck) {
+        return RunParameterSetCheck(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.pipelinedPictures != 0) {
+        return RunPipelinedDecodeCheck(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!config.indexFileName.empty()) {
+        return RunIndex(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.probe) {
+        return RunProbe(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.nalLengthSize != 0) {
+        if (isIvf || ((config.codec != VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) &&
+                      (config.codec != VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR))) {
+            std::cerr << "--lengthPrefixed is only supported with H.264 and H.265 elementary streams" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return RunLengthPrefixed(config, data) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.segmentSize != 0) {
+        return RunSegments(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (config.chunkSize != 0) {
+        if (config.codec != VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+            std::cerr << "--chunks is only supported with AV1 streams" << std::endl;
+            return EXIT_FAILURE;
+        }
+        return RunChunks(config, data, packets) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    printf("%s: %zu bytes, %zu packets, %llu NAL units, %u reps, %s start code scan%s%s\n",
+           config.inputFileName.c_str(), data.size(), packets.size(), (unsigned long long)numUnits,
+           config.numReps, config.perNaluStartCodeScan ? "per-NALU" : "indexed",
+           (config.zeroCopySpanSize != 0) ? ", zero-copy" : "",
+           (config.decodeFilter == VK_PARSER_DECODE_FILTER_RANDOM_ACCESS) ? ", random access pictures only" :
+           (config.decodeFilter == VK_PARSER_DECODE_FILTER_REFERENCE) ? ", reference pictures only" : "");
+    printf("%-8s %12s %12s %14s %10s %10s %10s %10s\n", "ISA", "MB/s", "pictures/s", "NALs/s", "pictures", "buffers",
+           "PS parsed", "PS reused");
+
+    int numRuns = 0;
+    bool allocationCheckFailed = false;
+    for (size_t i = 0; i < sizeof(simdIsaNames) / sizeof(simdIsaNames[0]); i++) {
+        if ((config.simdIsa >= 0) && ((uint32_t)config.simdIsa != simdIsaNames[i].simdIsa)) {
+            continue;
+        }
+
+        BenchResult result = BenchResult();
+        VkResult vkResult = RunBench(config, simdIsaNames[i].simdIsa, data, packets, result);
+        if (vkResult == VK_ERROR_FEATURE_NOT_PRESENT) {
+            if (config.simdIsa >= 0) {
+                printf("%-8s not supported by this CPU\n", simdIsaNames[i].name);
+            }
+            continue;
+        } else if (vkResult != VK_SUCCESS) {
+            std::cerr << "Failed to create the parser (" << vkResult << ")" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const double seconds = std::max(result.seconds, 1e-9);
+        const double totalBytes = (double)data.size() * config.numReps;
+        printf("%-8s %12.2f %12.1f %14.1f %10llu %10llu %10llu %10llu\n", simdIsaNames[i].name,
+               totalBytes / seconds / 1e6,
+               (double)result.counters.decodedPictures / seconds,
+               (double)numUnits * config.numReps / seconds,
+               (unsigned long long)(result.counters.decodedPictures / config.numReps),
+               (unsigned long long)(result.counters.bitstreamBufferRequests / config.numReps),
+               (unsigned long long)(result.parameterSetStats.parsedParameterSets / config.numReps),
+               (unsigned long long)(result.parameterSetStats.repeatedParameterSets / config.numReps));
+        numRuns++;
+
+        if (config.maxTemporalLayer < VK_PARSER_TEMPORAL_LAYER_ALL) {
+            printf("%-8s %llu pictures above temporal sub-layer %u dropped\n", simdIsaNames[i].name,
+                   (unsigned long long)(result.droppedPictures / config.numReps), config.maxTemporalLayer);
+        }
+
+        printf("%-8s decode to display delay: average %.2f pictures, max %llu\n", simdIsaNames[i].name,
+               (double)result.counters.displayDelayPictures / (double)std::max<uint64_t>(result.counters.displayedPictures, 1),
+               (unsigned long long)result.counters.maxDisplayDelayPictures);
+
+        if (config.allocationWarmupPictures != 0) {
+            printf("%-8s %llu heap allocations after the first %u pictures\n", simdIsaNames[i].name,
+                   (unsigned long long)result.counters.steadyStateAllocations, config.allocationWarmupPictures);
+            if (result.counters.steadyStateAllocations != 0) {
+                allocationCheckFailed = true;
+            }
+        }
+    }
+
+    // The VulkanVideoParser layer of vk-video-dec on top of the parser. VkVideoDecoder itself,
+    // its DPB images and its per-picture decode data need a device and are not covered.
+    if ((numRuns > 0) && (config.allocationWarmupPictures != 0)) {
+        StubVideoDecoder::Counters counters = StubVideoDecoder::Counters();
+        VkResult vkResult = RunVulkanVideoParser(config, data, packets, nullptr, nullptr, nullptr, 0, nullptr, counters);
+        if (vkResult != VK_SUCCESS) {
+            std::cerr << "Failed to create the VulkanVideoParser (" << vkResult << ")" << std::endl;
+            return EXIT_FAILURE;
+        }
+        printf("VulkanVideoParser: %llu pictures, %llu heap allocations after the first %u pictures\n",
+               (unsigned long long)counters.decodedPictures, (unsigned long long)counters.steadyStateAllocations,
+               config.allocationWarmupPictures);
+        if (counters.steadyStateAllocations != 0) {
+            allocationCheckFailed = true;
+        }
+    }
+
+    return ((numRuns > 0) && !allocationCheckFailed) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include "VkCodecUtils/VkAllocationCounter.h"
+#include "StubDecodeClient.h"
+
+int32_t StubDecodeClient::BeginSequence(const VkParserSequenceInfo* pnvsi)
+{
+    m_counters.sequences++;
+    m_codec = pnvsi->eCodec;
+    return std::max<int32_t>(1, std::min<int32_t>(pnvsi->nMinNumDecodeSurfaces, MAX_PICTURE_BUFFERS));
+}
+
+bool StubDecodeClient::AllocPictureBuffer(VkPicIf** ppPicBuf)
+{
+    for (int32_t picIdx = 0; picIdx < MAX_PICTURE_BUFFERS; picIdx++) {
+        if (m_pictureBuffers[picIdx].IsAvailable()) {
+            m_pictureBuffers[picIdx].m_picIdx = picIdx;
+            m_pictureBuffers[picIdx].AddRef();
+            *ppPicBuf = &m_pictureBuffers[picIdx];
+            return true;
+        }
+    }
+
+    *ppPicBuf = nullptr;
+    return false;
+}
+
+bool StubDecodeClient::DecodePicture(VkParserPictureData* pParserPictureData)
+{
+    m_counters.decodedPictures++;
+    m_counters.slices += pParserPictureData->numSlices;
+
+    if (m_bOutputHash) {
+        const int32_t picIdx = static_cast<vkPicBuffBase*>(pParserPictureData->pCurrPic)->m_picIdx;
+        HashOutput(&picIdx, sizeof(picIdx));
+        VkDeviceSize maxSize = 0;
+        if (m_codec == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+            // The tiles of a temporal unit may be anywhere in the bitstream buffer
+            const VkParserAv1PictureData& av1 = pParserPictureData->CodecSpecific.av1;
+            for (uint32_t i = 0; i < av1.khr_info.tileCount; i++) {
+                HashOutput(pParserPictureData->bitstreamData->GetReadOnlyDataPtr(av1.tileOffsets[i], maxSize), av1.tileSizes[i]);
+            }
+        } else {
+            HashOutput(pParserPictureData->bitstreamData->GetReadOnlyDataPtr(pParserPictureData->bitstreamDataOffset, maxSize),
+                       (size_t)pParserPictureData->bitstreamDataLen);
+        }
+    }
+
+    const uint64_t allocationCount = VkAllocationCounter::GetAllocationCount();
+    if ((m_allocationWarmupPictures != 0) && (m_streamPictures >= m_allocationWarmupPictures)) {
+        m_counters.steadyStateAllocations += allocationCount - m_allocationCount;
+    }
+    m_allocationCount = allocationCount;
+    m_streamPictures++;
+    return true;
+}
+
+bool StubDecodeClient::UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                               VkSharedBaseObj<VkVideoRefCountBase>& client)
+{
+    return true;
+}
+
+bool StubDecodeClient::DisplayPicture(VkPicIf* pPicBuf, int64_t llPTS)
+{
+    m_counters.displayedPictures++;
+    if (m_bOutputHash) {
+        const int32_t picIdx = static_cast<vkPicBuffBase*>(pPicBuf)->m_picIdx;
+        HashOutput(&picIdx, sizeof(picIdx));
+        HashOutput(&llPTS, sizeof(llPTS));
+    }
+    return true;
+}
+
+// FNV-1a, chained from one call to the next
+void StubDecodeClient::HashOutput(const void* pData, size_t size)
+{
+    uint64_t hash = (m_counters.outputHash != 0) ? m_counters.outputHash : 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ ((const uint8_t*)pData)[i]) * 0x100000001b3ULL;
+    }
+    m_counters.outputHash = hash;
+}
+
+VkDeviceSize StubDecodeClient::GetBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                                  VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                                  VkDeviceSize initializeBufferMemorySize,
+                                                  VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+{
+    m_counters.bitstreamBufferRequests++;
+
+    // A decoder preallocates its bitstream buffers, so the allocations of this pool are
+    // not counted against the parser in steadyStateAllocations.
+    const uint64_t allocationCount = VkAllocationCounter::GetAllocationCount();
+    VkDeviceSize bufferSize = GetPoolBitstreamBuffer(size, minBitstreamBufferOffsetAlignment, minBitstreamBufferSizeAlignment,
+                                                     pInitializeBufferMemory, initializeBufferMemorySize, bitstreamBuffer);
+    m_allocationCount += VkAllocationCounter::GetAllocationCount() - allocationCount;
+    return bufferSize;
+}
+
+VkDeviceSize StubDecodeClient::GetPoolBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                                      VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                                      VkDeviceSize initializeBufferMemorySize,
+                                                      VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+{
+    for (size_t i = 0; i < m_bitstreamBuffers.size(); i++) {
+        VkSharedBaseObj<VulkanBitstreamBufferHostImpl>& hostBuffer = m_bitstreamBuffers[i];
+        // A buffer only referenced by this pool is no longer in use by the parser
+        if (hostBuffer->GetRefCount() != 1) {
+            continue;
+        }
+        VkDeviceSize newSize = hostBuffer->Resize(size);
+        if (newSize < size) {
+            continue;
+        }
+        hostBuffer->CopyDataFromBuffer(pInitializeBufferMemory, 0, 0, initializeBufferMemorySize);
+        hostBuffer->ResetStreamMarkers();
+        bitstreamBuffer = hostBuffer;
+        return newSize;
+    }
+
+    VkSharedBaseObj<VulkanBitstreamBufferHostImpl> newBuffer;
+    VkResult result = VulkanBitstreamBufferHostImpl::Create(size, minBitstreamBufferOffsetAlignment, minBitstreamBufferSizeAlignment,
+                                                            pInitializeBufferMemory, initializeBufferMemorySize,
+                                                            newBuffer);
+    if (result != VK_SUCCESS) {
+        return 0;
+    }
+    m_counters.bitstreamBufferAllocations++;
+    m_bitstreamBuffers.push_back(newBuffer);
+    bitstreamBuffer = newBuffer;
+    return newBuffer->GetMaxSize();
+}
+
+void StubDecodeClient::RandomAccessPoint(const VkParserRandomAccessPoint* pRandomAccessPoint)
+{
+    m_counters.randomAccessPoints++;
+    if (m_pRandomAccessIndex != nullptr) {
+        m_pRandomAccessIndex->Add(pRandomAccessPoint);
+    }
+}
+
+void StubDecodeClient::DisplayLatency(const VkParserDisplayLatency* pDisplayLatency)
+{
+    m_counters.displayDelayPictures += pDisplayLatency->delayPictures;
+    m_counters.maxDisplayDelayPictures = std::max<uint64_t>(m_counters.maxDisplayDelayPictures, pDisplayLatency->delayPictures);
+}
@@ -0,0 +1,107 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _STUBDECODECLIENT_H_
+#define _STUBDECODECLIENT_H_
+
+#include <vector>
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "VkCodecUtils/VulkanBitstreamBufferHostImpl.h"
+#include "VkDecoderUtils/VulkanVideoRandomAccessIndex.h"
+
+// Parser client that does not decode anything: it hands out host memory bitstream
+// buffers and dummy picture buffers, and only counts the callbacks it receives.
+class StubDecodeClient : public VkParserVideoDecodeClient {
+public:
+    enum { MAX_PICTURE_BUFFERS = 64 };
+
+    struct Counters {
+        uint64_t sequences;
+        uint64_t decodedPictures;
+        uint64_t slices;
+        uint64_t displayedPictures;
+        uint64_t bitstreamBufferRequests;
+        uint64_t bitstreamBufferAllocations;
+        uint64_t randomAccessPoints;
+        uint64_t steadyStateAllocations;
+        uint64_t displayDelayPictures; // Summed decode-to-display delay of the displayed pictures
+        uint64_t maxDisplayDelayPictures;
+        uint64_t outputHash; // Digest of the decoded picture data and of the displayed pictures, see SetOutputHash()
+    };
+
+    StubDecodeClient()
+        : m_counters()
+        , m_pictureBuffers()
+        , m_bitstreamBuffers()
+        , m_pRandomAccessIndex(nullptr)
+        , m_codec(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , m_bOutputHash(false)
+        , m_streamPictures(0)
+        , m_allocationWarmupPictures(0)
+        , m_allocationCount(0) { }
+
+    virtual ~StubDecodeClient() { }
+
+    void ResetCounters() { memset(&m_counters, 0, sizeof(m_counters)); }
+    const Counters& GetCounters() const { return m_counters; }
+    // Random access points are added to the index, if any
+    void SetRandomAccessIndex(VulkanVideoRandomAccessIndex* pRandomAccessIndex) { m_pRandomAccessIndex = pRandomAccessIndex; }
+    // Hashes the slice (AV1 tile) data of the decoded pictures, and the pictures displayed, into outputHash,
+    // to check that two ways of feeding the same stream give the same output
+    void SetOutputHash(bool bOutputHash) { m_bOutputHash = bOutputHash; }
+    // The heap allocations made once allocationWarmupPictures pictures of the stream have been
+    // decoded add up in steadyStateAllocations, 0 disables the count. See VkAllocationCounter.
+    void BeginStream(uint32_t allocationWarmupPictures)
+    {
+        m_streamPictures = 0;
+        m_allocationWarmupPictures = allocationWarmupPictures;
+    }
+
+    virtual int32_t BeginSequence(const VkParserSequenceInfo* pnvsi);
+    virtual bool AllocPictureBuffer(VkPicIf** ppPicBuf);
+    virtual bool DecodePicture(VkParserPictureData* pParserPictureData);
+    virtual bool UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                         VkSharedBaseObj<VkVideoRefCountBase>& client);
+    virtual bool DisplayPicture(VkPicIf* pPicBuf, int64_t llPTS);
+    virtual void UnhandledNALU(const uint8_t* pbData, size_t cbData) { }
+    virtual VkDeviceSize GetBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                            VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                            VkDeviceSize initializeBufferMemorySize,
+                                            VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer);
+    virtual void RandomAccessPoint(const VkParserRandomAccessPoint* pRandomAccessPoint);
+    virtual void DisplayLatency(const VkParserDisplayLatency* pDisplayLatency);
+
+private:
+    void HashOutput(const void* pData, size_t size);
+    VkDeviceSize GetPoolBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                        VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                        VkDeviceSize initializeBufferMemorySize,
+                                        VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer);
+
+    Counters      m_counters;
+    vkPicBuffBase m_pictureBuffers[MAX_PICTURE_BUFFERS];
+    // Buffers are recycled once the parser no longer holds a reference to them,
+    // so the steady state does not measure the host allocator.
+    std::vector<VkSharedBaseObj<VulkanBitstreamBufferHostImpl>> m_bitstreamBuffers;
+    VulkanVideoRandomAccessIndex* m_pRandomAccessIndex;
+    VkVideoCodecOperationFlagBitsKHR m_codec;
+    bool          m_bOutputHash;
+    uint32_t      m_streamPictures;
+    uint32_t      m_allocationWarmupPictures;
+    uint64_t      m_allocationCount; // At the previous picture
+};
+
+#endif /* _STUBDECODECLIENT_H_ */
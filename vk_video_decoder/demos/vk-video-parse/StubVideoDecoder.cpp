@@ -0,0 +1,310 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include "VkCodecUtils/VkAllocationCounter.h"
+#include "StubVideoDecoder.h"
+
+// FNV-1a, chained from one call to the next
+static uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ ((const uint8_t*)pData)[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template<typename T>
+static uint64_t HashValue(uint64_t hash, const T& value)
+{
+    return HashBytes(hash, &value, sizeof(value));
+}
+
+// The picture the DPB slot was last set up with, as the number of the decoded picture, -1 if none
+static int64_t GetSlotPicture(const int64_t* pDpbSlotPictures, int32_t slotIndex)
+{
+    return ((slotIndex >= 0) && (slotIndex < StubVideoDecoder::MAX_DPB_SLOTS)) ? pDpbSlotPictures[slotIndex] : -1;
+}
+
+// The picture parameters VkVideoDecoder would record the decode with, except the picture buffer indices.
+// The fields are hashed one by one: the pointers differ from a run to the next, and the Std flags have
+// undefined bits. The DPB slots are assigned as the picture buffers are released, so the references are
+// hashed as the pictures they hold.
+static uint64_t HashPictureParameters(const VkParserPerFrameDecodeParameters* pPicParams,
+                                      const VkParserDecodePictureInfo* pDecodePictureInfo,
+                                      const int64_t* pDpbSlotPictures)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = HashValue(hash, pPicParams->firstSliceIndex);
+    hash = HashValue(hash, pPicParams->numSlices);
+    hash = HashValue(hash, pPicParams->numGopReferenceSlots);
+    const StdVideoPictureParametersSet* const pParameterSets[] = { pPicParams->pStdVps, pPicParams->pStdSps, pPicParams->pStdPps };
+    for (size_t i = 0; i < sizeof(pParameterSets) / sizeof(pParameterSets[0]); i++) {
+        hash = HashValue(hash, (pParameterSets[i] != nullptr) ? pParameterSets[i]->GetContentHash() : 0);
+    }
+
+    const VkVideoDecodeInfoKHR& decodeInfo = pPicParams->decodeFrameInfo;
+    hash = HashValue(hash, decodeInfo.pSetupReferenceSlot != nullptr);
+    hash = HashValue(hash, decodeInfo.referenceSlotCount);
+    for (uint32_t i = 0; i < decodeInfo.referenceSlotCount; i++) {
+        hash = HashValue(hash, GetSlotPicture(pDpbSlotPictures, decodeInfo.pReferenceSlots[i].slotIndex));
+    }
+
+    const VkBaseInStructure* pPictureInfo = (const VkBaseInStructure*)decodeInfo.pNext;
+    if (pPictureInfo == nullptr) {
+        hash = HashValue(hash, VK_STRUCTURE_TYPE_MAX_ENUM);
+    } else if (pPictureInfo->sType == VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_PICTURE_INFO_KHR) {
+        const VkVideoDecodeH264PictureInfoKHR* pH264 = (const VkVideoDecodeH264PictureInfoKHR*)pPictureInfo;
+        hash = HashValue(hash, pH264->pStdPictureInfo->seq_parameter_set_id);
+        hash = HashValue(hash, pH264->pStdPictureInfo->pic_parameter_set_id);
+        hash = HashValue(hash, pH264->pStdPictureInfo->frame_num);
+        hash = HashValue(hash, pH264->pStdPictureInfo->idr_pic_id);
+        hash = HashValue(hash, pH264->pStdPictureInfo->PicOrderCnt);
+        hash = HashValue(hash, pH264->sliceCount);
+        hash = HashBytes(hash, pH264->pSliceOffsets, pH264->sliceCount * sizeof(pH264->pSliceOffsets[0]));
+    } else if (pPictureInfo->sType == VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_PICTURE_INFO_KHR) {
+        const VkVideoDecodeH265PictureInfoKHR* pH265 = (const VkVideoDecodeH265PictureInfoKHR*)pPictureInfo;
+        hash = HashValue(hash, pH265->pStdPictureInfo->sps_video_parameter_set_id);
+        hash = HashValue(hash, pH265->pStdPictureInfo->pps_seq_parameter_set_id);
+        hash = HashValue(hash, pH265->pStdPictureInfo->pps_pic_parameter_set_id);
+        hash = HashValue(hash, pH265->pStdPictureInfo->PicOrderCntVal);
+        for (uint32_t i = 0; i < STD_VIDEO_DECODE_H265_REF_PIC_SET_LIST_SIZE; i++) {
+            hash = HashValue(hash, GetSlotPicture(pDpbSlotPictures, (int8_t)pH265->pStdPictureInfo->RefPicSetStCurrBefore[i]));
+            hash = HashValue(hash, GetSlotPicture(pDpbSlotPictures, (int8_t)pH265->pStdPictureInfo->RefPicSetStCurrAfter[i]));
+            hash = HashValue(hash, GetSlotPicture(pDpbSlotPictures, (int8_t)pH265->pStdPictureInfo->RefPicSetLtCurr[i]));
+        }
+        hash = HashValue(hash, pH265->sliceSegmentCount);
+        hash = HashBytes(hash, pH265->pSliceSegmentOffsets, pH265->sliceSegmentCount * sizeof(pH265->pSliceSegmentOffsets[0]));
+    } else if (pPictureInfo->sType == VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_PICTURE_INFO_KHR) {
+        const VkVideoDecodeAV1PictureInfoKHR* pAv1 = (const VkVideoDecodeAV1PictureInfoKHR*)pPictureInfo;
+        hash = HashValue(hash, pAv1->pStdPictureInfo->frame_type);
+        hash = HashValue(hash, pAv1->pStdPictureInfo->current_frame_id);
+        hash = HashValue(hash, pAv1->pStdPictureInfo->OrderHint);
+        hash = HashValue(hash, pAv1->pStdPictureInfo->refresh_frame_flags);
+        for (uint32_t i = 0; i < VK_MAX_VIDEO_AV1_REFERENCES_PER_FRAME_KHR; i++) {
+            hash = HashValue(hash, GetSlotPicture(pDpbSlotPictures, pAv1->referenceNameSlotIndices[i]));
+        }
+        hash = HashValue(hash, pAv1->frameHeaderOffset);
+        hash = HashValue(hash, pAv1->tileCount);
+        hash = HashBytes(hash, pAv1->pTileOffsets, pAv1->tileCount * sizeof(pAv1->pTileOffsets[0]));
+        hash = HashBytes(hash, pAv1->pTileSizes, pAv1->tileCount * sizeof(pAv1->pTileSizes[0]));
+    } else {
+        hash = HashValue(hash, pPictureInfo->sType);
+    }
+
+    hash = HashValue(hash, pDecodePictureInfo->displayWidth);
+    hash = HashValue(hash, pDecodePictureInfo->displayHeight);
+    hash = HashValue(hash, pDecodePictureInfo->imageLayerIndex);
+    hash = HashValue(hash, pDecodePictureInfo->flags.fieldFlags);
+    hash = HashValue(hash, pDecodePictureInfo->decodePicCount);
+    hash = HashValue(hash, pDecodePictureInfo->timestamp);
+    hash = HashValue(hash, pDecodePictureInfo->viewId);
+    return hash;
+}
+
+VkResult StubVideoDecoder::Create(VkSharedBaseObj<StubVideoDecoder>& stubVideoDecoder)
+{
+    VkSharedBaseObj<StubVideoDecoder> newDecoder(new StubVideoDecoder());
+    if (!newDecoder) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    stubVideoDecoder = newDecoder;
+    return VK_SUCCESS;
+}
+
+int32_t StubVideoDecoder::StartVideoSequence(VkParserDetectedVideoFormat* pVideoFormat)
+{
+    m_counters.sequences++;
+    m_numDecodeSurfaces = std::max<int32_t>(m_numDecodeSurfaces, std::min<int32_t>(pVideoFormat->minNumDecodeSurfaces +
+                                                                                   NUM_DECODE_IMAGES_IN_FLIGHT,
+                                                                                   MAX_PICTURE_BUFFERS));
+    if ((m_vkDevCtx != nullptr) && (StartVideoSession(pVideoFormat) < 0)) {
+        return -1;
+    }
+    return m_numDecodeSurfaces;
+}
+
+// The session handling of VkVideoDecoder::StartVideoSequence(), without the capabilities of the device
+int32_t StubVideoDecoder::StartVideoSession(VkParserDetectedVideoFormat* pVideoFormat)
+{
+    VkVideoCoreProfile videoProfile(pVideoFormat->codec, pVideoFormat->chromaSubsampling, pVideoFormat->lumaBitDepth,
+                                    pVideoFormat->chromaBitDepth, pVideoFormat->codecProfile);
+    const VkExtent2D codedExtent = { pVideoFormat->coded_width, pVideoFormat->coded_height };
+    const VkFormat pictureFormat = VK_FORMAT_G8_B8R8_2PLANE_420_UNORM; // Not looked at by the stub device
+    const uint32_t maxDpbSlots = pVideoFormat->maxNumDpbSlots;
+    const uint32_t maxActiveReferencePictures = std::min<uint32_t>(maxDpbSlots, VkParserPerFrameDecodeParameters::MAX_DPB_REF_SLOTS);
+    if (!m_videoSession ||
+            !m_videoSession->IsCompatible(m_vkDevCtx, 0, 0, &videoProfile, pictureFormat, codedExtent, pictureFormat,
+                                          maxDpbSlots, maxActiveReferencePictures)) {
+        if (m_videoSession) {
+            // Every parameter set is new to the session parameters of a new session. The ones
+            // queued before the first session are created with it.
+            m_parameterSetHashes.clear();
+        }
+        VkResult result = VulkanVideoSession::Create(m_vkDevCtx, 0, 0, &videoProfile, pictureFormat, codedExtent, pictureFormat,
+                                                     maxDpbSlots, maxActiveReferencePictures, m_videoSession);
+        if (result != VK_SUCCESS) {
+            return -1;
+        }
+    }
+
+    if (m_currentPictureParameters) {
+        m_currentPictureParameters->FlushPictureParametersQueue(m_videoSession);
+    }
+    return 0;
+}
+
+bool StubVideoDecoder::UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                               VkSharedBaseObj<VkVideoRefCountBase>& client)
+{
+    m_counters.parameterSets++;
+    if (m_vkDevCtx == nullptr) {
+        return true;
+    }
+
+    // A parameter set with the content of the previous one of its id needs no session parameters
+    // create or update: AddPictureParameters() must keep the current session parameters for it.
+    const int32_t key = VkParserVideoPictureParameters::GetPictureParametersSetKey(pictureParametersObject);
+    const uint64_t contentHash = pictureParametersObject->GetContentHash();
+    std::unordered_map<int32_t, uint64_t>::const_iterator it = m_parameterSetHashes.find(key);
+    const bool resent = (key >= 0) && (contentHash != 0) && (it != m_parameterSetHashes.end()) && (it->second == contentHash);
+    const VkParserVideoPictureParameters* pPreviousPictureParameters = m_currentPictureParameters;
+
+    VkResult result = VkParserVideoPictureParameters::AddPictureParameters(m_vkDevCtx,
+                                                                           m_videoSession,
+                                                                           pictureParametersObject,
+                                                                           m_currentPictureParameters);
+    client = m_currentPictureParameters;
+
+    if (resent) {
+        m_counters.resentParameterSets++;
+        if (m_currentPictureParameters.Get() != pPreviousPictureParameters) {
+            m_counters.resentMismatches++;
+        }
+    } else {
+        m_counters.changedParameterSets++;
+        if ((key >= 0) && (contentHash != 0)) {
+            m_parameterSetHashes[key] = contentHash;
+        } else if (key >= 0) {
+            m_parameterSetHashes.erase(key);
+        }
+    }
+    return (result == VK_SUCCESS);
+}
+
+int32_t StubVideoDecoder::DecodePictureWithParameters(VkParserPerFrameDecodeParameters* pPicParams,
+                                                      VkParserDecodePictureInfo* pDecodePictureInfo)
+{
+    m_counters.decodedPictures++;
+
+    // The range a trace records for the picture, so that a replay hashes the same data
+    HashOutput(&pPicParams->currPicIdx, sizeof(pPicParams->currPicIdx));
+    const uint8_t* pData = nullptr;
+    size_t dataSize = 0;
+    if (pPicParams->bitstreamData) {
+        VkDeviceSize maxSize = 0;
+        pData = pPicParams->bitstreamData->GetReadOnlyDataPtr(pPicParams->bitstreamDataOffset, maxSize);
+        dataSize = (size_t)std::min<VkDeviceSize>(pPicParams->bitstreamDataLen, maxSize);
+        HashOutput(pData, dataSize);
+    }
+    if (m_pPictureLog != nullptr) {
+        PictureRecord record = PictureRecord();
+        record.bitstreamDataOffset = pPicParams->bitstreamDataOffset;
+        record.bitstreamDataLen = pPicParams->bitstreamDataLen;
+        record.bitstreamDataHash = HashBytes(0xcbf29ce484222325ULL, pData, dataSize);
+        record.parametersHash = HashPictureParameters(pPicParams, pDecodePictureInfo, m_dpbSlotPictures);
+        m_pPictureLog->push_back(record);
+        const VkVideoReferenceSlotInfoKHR* pSetupReferenceSlot = pPicParams->decodeFrameInfo.pSetupReferenceSlot;
+        if ((pSetupReferenceSlot != nullptr) && (pSetupReferenceSlot->slotIndex >= 0) &&
+            (pSetupReferenceSlot->slotIndex < MAX_DPB_SLOTS)) {
+            m_dpbSlotPictures[pSetupReferenceSlot->slotIndex] = (int64_t)m_counters.decodedPictures;
+        }
+    }
+
+    const uint64_t allocationCount = VkAllocationCounter::GetAllocationCount();
+    if ((m_allocationWarmupPictures != 0) && (m_streamPictures >= m_allocationWarmupPictures)) {
+        m_counters.steadyStateAllocations += allocationCount - m_allocationCount;
+    }
+    m_allocationCount = allocationCount;
+    m_streamPictures++;
+    return pPicParams->currPicIdx;
+}
+
+VkDeviceSize StubVideoDecoder::GetBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                                  VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                                  VkDeviceSize initializeBufferMemorySize,
+                                                  VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+{
+    // VkVideoDecoder preallocates its bitstream buffers, so the allocations of this pool are
+    // not counted against the parser in steadyStateAllocations.
+    const uint64_t allocationCount = VkAllocationCounter::GetAllocationCount();
+    VkDeviceSize bufferSize = 0;
+    for (size_t i = 0; (bufferSize == 0) && (i < m_bitstreamBuffers.size()); i++) {
+        VkSharedBaseObj<VulkanBitstreamBufferHostImpl>& hostBuffer = m_bitstreamBuffers[i];
+        // A buffer only referenced by this pool is no longer in use by the parser
+        if ((hostBuffer->GetRefCount() != 1) || (hostBuffer->Resize(size) < size)) {
+            continue;
+        }
+        hostBuffer->CopyDataFromBuffer(pInitializeBufferMemory, 0, 0, initializeBufferMemorySize);
+        hostBuffer->ResetStreamMarkers();
+        bitstreamBuffer = hostBuffer;
+        bufferSize = hostBuffer->GetMaxSize();
+    }
+    if (bufferSize == 0) {
+        VkSharedBaseObj<VulkanBitstreamBufferHostImpl> newBuffer;
+        if (VulkanBitstreamBufferHostImpl::Create(size, minBitstreamBufferOffsetAlignment, minBitstreamBufferSizeAlignment,
+                                                  pInitializeBufferMemory, initializeBufferMemorySize,
+                                                  newBuffer) == VK_SUCCESS) {
+            m_bitstreamBuffers.push_back(newBuffer);
+            bitstreamBuffer = newBuffer;
+            bufferSize = newBuffer->GetMaxSize();
+        }
+    }
+    m_allocationCount += VkAllocationCounter::GetAllocationCount() - allocationCount;
+    return bufferSize;
+}
+
+int32_t StubVideoDecoder::QueueDecodedPictureForDisplay(int8_t picId, VulkanVideoDisplayPictureInfo* pDispInfo)
+{
+    m_counters.displayedPictures++;
+    const int32_t picIdx = picId;
+    HashOutput(&picIdx, sizeof(picIdx));
+    HashOutput(&pDispInfo->timestamp, sizeof(pDispInfo->timestamp));
+    if (m_pPictureLog != nullptr) {
+        PictureRecord record = PictureRecord();
+        record.displayed = true;
+        record.parametersHash = (uint64_t)pDispInfo->timestamp;
+        m_pPictureLog->push_back(record);
+    }
+    return picId;
+}
+
+vkPicBuffBase* StubVideoDecoder::ReservePictureBuffer()
+{
+    for (int32_t picIdx = 0; picIdx < m_numDecodeSurfaces; picIdx++) {
+        if (m_pictureBuffers[picIdx].IsAvailable()) {
+            m_pictureBuffers[picIdx].m_picIdx = picIdx;
+            m_pictureBuffers[picIdx].AddRef();
+            return &m_pictureBuffers[picIdx];
+        }
+    }
+    return nullptr;
+}
+
+void StubVideoDecoder::HashOutput(const void* pData, size_t size)
+{
+    m_counters.outputHash = HashBytes((m_counters.outputHash != 0) ? m_counters.outputHash : 0xcbf29ce484222325ULL, pData, size);
+}
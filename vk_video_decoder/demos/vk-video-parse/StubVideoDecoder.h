@@ -0,0 +1,155 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _STUBVIDEODECODER_H_
+#define _STUBVIDEODECODER_H_
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "vkvideo_parser/VulkanVideoParser.h"
+#include "vkvideo_parser/PictureBufferBase.h"
+#include "VkCodecUtils/VulkanBitstreamBufferHostImpl.h"
+#include "VkVideoDecoder/VkParserVideoPictureParameters.h"
+
+// Decoder handler and frame buffer of VulkanVideoParser that stand in for VkVideoDecoder and
+// its Vulkan frame buffer: they hand out host memory bitstream buffers and dummy picture
+// buffers, and only count the pictures they receive. Unlike StubDecodeClient, which drives
+// the parser library directly, this runs the VulkanVideoParser layer of vk-video-dec, or a
+// trace replayer, without a device. With a (stub) device context, see SetVideoDevice(), the
+// parameter sets go through the video session parameters objects of VkVideoDecoder.
+class StubVideoDecoder : public IVulkanVideoDecoderHandler, public IVulkanVideoFrameBufferParserCb {
+public:
+    // As VkVideoDecoder, the frame buffer has room for the pictures in flight on top of the DPB
+    enum { MAX_PICTURE_BUFFERS = 32, NUM_DECODE_IMAGES_IN_FLIGHT = 8 };
+    enum { MAX_DPB_SLOTS = 32 };
+
+    struct Counters {
+        uint64_t sequences;
+        uint64_t parameterSets;
+        uint64_t changedParameterSets; // With a device: new parameter sets, or new content for their id
+        uint64_t resentParameterSets;  // With a device: same content as the previous parameter set of the id
+        uint64_t resentMismatches;     // Resent parameter sets that did not map back to the current session parameters
+        uint64_t decodedPictures;
+        uint64_t displayedPictures;
+        uint64_t steadyStateAllocations;
+        uint64_t outputHash; // Digest of the decoded picture data and of the displayed pictures
+    };
+
+    // A decoded or displayed picture, without its picture buffer index, which depends on when the
+    // picture buffers are released: the pipelined decode of VulkanVideoParser holds them longer
+    struct PictureRecord {
+        bool     displayed;
+        size_t   bitstreamDataOffset; // Decoded pictures only
+        size_t   bitstreamDataLen;
+        uint64_t bitstreamDataHash;
+        uint64_t parametersHash;      // Picture parameters of a decoded picture, time stamp of a displayed one
+    };
+
+    static VkResult Create(VkSharedBaseObj<StubVideoDecoder>& stubVideoDecoder);
+
+    virtual int32_t AddRef()
+    {
+        return ++m_refCount;
+    }
+
+    virtual int32_t Release()
+    {
+        uint32_t ret = --m_refCount;
+        if (ret == 0) {
+            delete this;
+        }
+        return ret;
+    }
+
+    const Counters& GetCounters() const { return m_counters; }
+    // The heap allocations made once allocationWarmupPictures pictures have been decoded
+    // add up in steadyStateAllocations, 0 disables the count. See VkAllocationCounter.
+    void BeginStream(uint32_t allocationWarmupPictures)
+    {
+        m_streamPictures = 0;
+        m_allocationWarmupPictures = allocationWarmupPictures;
+    }
+
+    // As VkVideoDecoder, create a video session on each new sequence, and hand the parameter sets
+    // to VkParserVideoPictureParameters::AddPictureParameters() on vkDevCtx. NULL only counts them.
+    void SetVideoDevice(const VulkanDeviceContext* vkDevCtx) { m_vkDevCtx = vkDevCtx; }
+
+    // Appends a record of each picture decoded or displayed to pPictureLog, NULL stops the records.
+    // The records are appended from the thread calling the handler, the submit thread in pipelined mode.
+    void SetPictureLog(std::vector<PictureRecord>* pPictureLog) { m_pPictureLog = pPictureLog; }
+
+    // IVulkanVideoDecoderHandler
+    virtual int32_t StartVideoSequence(VkParserDetectedVideoFormat* pVideoFormat);
+    virtual bool UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject,
+                                         VkSharedBaseObj<VkVideoRefCountBase>& client);
+    virtual int32_t DecodePictureWithParameters(VkParserPerFrameDecodeParameters* pPicParams,
+                                                VkParserDecodePictureInfo* pDecodePictureInfo);
+    virtual VkDeviceSize GetBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                            VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                            VkDeviceSize initializeBufferMemorySize,
+                                            VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer);
+
+    // IVulkanVideoFrameBufferParserCb
+    virtual int32_t QueueDecodedPictureForDisplay(int8_t picId, VulkanVideoDisplayPictureInfo* pDispInfo);
+    virtual vkPicBuffBase* ReservePictureBuffer();
+
+private:
+    StubVideoDecoder()
+        : m_refCount(0)
+        , m_counters()
+        , m_pictureBuffers()
+        , m_bitstreamBuffers()
+        , m_numDecodeSurfaces(0)
+        , m_streamPictures(0)
+        , m_allocationWarmupPictures(0)
+        , m_allocationCount(0)
+        , m_vkDevCtx(nullptr)
+        , m_videoSession()
+        , m_currentPictureParameters()
+        , m_parameterSetHashes()
+        , m_pPictureLog(nullptr)
+    {
+        for (int32_t i = 0; i < MAX_DPB_SLOTS; i++) {
+            m_dpbSlotPictures[i] = -1;
+        }
+    }
+
+    virtual ~StubVideoDecoder() { }
+
+    int32_t StartVideoSession(VkParserDetectedVideoFormat* pVideoFormat);
+
+    void HashOutput(const void* pData, size_t size);
+
+    std::atomic<int32_t> m_refCount;
+    Counters      m_counters;
+    vkPicBuffBase m_pictureBuffers[MAX_PICTURE_BUFFERS];
+    // Recycled once the parser no longer holds a reference to them, as in StubDecodeClient
+    std::vector<VkSharedBaseObj<VulkanBitstreamBufferHostImpl>> m_bitstreamBuffers;
+    int32_t       m_numDecodeSurfaces; // Picture buffers of the sequence, VulkanVideoParser rejects higher indices
+    uint32_t      m_streamPictures;
+    uint32_t      m_allocationWarmupPictures;
+    uint64_t      m_allocationCount; // At the previous picture
+    const VulkanDeviceContext* m_vkDevCtx;
+    VkSharedBaseObj<VulkanVideoSession> m_videoSession;
+    VkSharedBaseObj<VkParserVideoPictureParameters> m_currentPictureParameters;
+    std::unordered_map<int32_t, uint64_t> m_parameterSetHashes; // Content of the last parameter set of each key of the session
+    std::vector<PictureRecord>* m_pPictureLog;
+    int64_t       m_dpbSlotPictures[MAX_DPB_SLOTS]; // Decoded picture each DPB slot was last set up with, for the picture log
+};
+
+#endif /* _STUBVIDEODECODER_H_ */
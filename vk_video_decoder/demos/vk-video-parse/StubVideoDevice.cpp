@@ -0,0 +1,99 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdint.h>
+#include "StubVideoDevice.h"
+
+static StubVideoDevice::Counters s_counters = StubVideoDevice::Counters();
+static uintptr_t s_lastHandle = 0;
+
+static VKAPI_ATTR VkResult VKAPI_CALL StubCreateVideoSessionKHR(VkDevice device, const VkVideoSessionCreateInfoKHR* pCreateInfo,
+                                                                const VkAllocationCallbacks* pAllocator,
+                                                                VkVideoSessionKHR* pVideoSession)
+{
+    s_counters.videoSessions++;
+    *pVideoSession = (VkVideoSessionKHR)++s_lastHandle;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL StubDestroyVideoSessionKHR(VkDevice device, VkVideoSessionKHR videoSession,
+                                                             const VkAllocationCallbacks* pAllocator)
+{
+}
+
+// The session needs no memory, so VulkanVideoSession allocates and binds none
+static VKAPI_ATTR VkResult VKAPI_CALL StubGetVideoSessionMemoryRequirementsKHR(VkDevice device, VkVideoSessionKHR videoSession,
+                                                                               uint32_t* pMemoryRequirementsCount,
+                                                                               VkVideoSessionMemoryRequirementsKHR* pMemoryRequirements)
+{
+    *pMemoryRequirementsCount = 0;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL StubBindVideoSessionMemoryKHR(VkDevice device, VkVideoSessionKHR videoSession,
+                                                                    uint32_t bindSessionMemoryInfoCount,
+                                                                    const VkBindVideoSessionMemoryInfoKHR* pBindSessionMemoryInfos)
+{
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL StubCreateVideoSessionParametersKHR(VkDevice device,
+                                                                          const VkVideoSessionParametersCreateInfoKHR* pCreateInfo,
+                                                                          const VkAllocationCallbacks* pAllocator,
+                                                                          VkVideoSessionParametersKHR* pVideoSessionParameters)
+{
+    s_counters.sessionParametersCreated++;
+    *pVideoSessionParameters = (VkVideoSessionParametersKHR)++s_lastHandle;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL StubUpdateVideoSessionParametersKHR(VkDevice device,
+                                                                          VkVideoSessionParametersKHR videoSessionParameters,
+                                                                          const VkVideoSessionParametersUpdateInfoKHR* pUpdateInfo)
+{
+    s_counters.sessionParametersUpdated++;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL StubDestroyVideoSessionParametersKHR(VkDevice device,
+                                                                       VkVideoSessionParametersKHR videoSessionParameters,
+                                                                       const VkAllocationCallbacks* pAllocator)
+{
+    s_counters.sessionParametersDestroyed++;
+}
+
+StubVideoDevice::StubVideoDevice()
+    : VulkanDeviceContext()
+{
+    *static_cast<vk::VkInterfaceFunctions*>(this) = vk::VkInterfaceFunctions();
+    CreateVideoSessionKHR = StubCreateVideoSessionKHR;
+    DestroyVideoSessionKHR = StubDestroyVideoSessionKHR;
+    GetVideoSessionMemoryRequirementsKHR = StubGetVideoSessionMemoryRequirementsKHR;
+    BindVideoSessionMemoryKHR = StubBindVideoSessionMemoryKHR;
+    CreateVideoSessionParametersKHR = StubCreateVideoSessionParametersKHR;
+    UpdateVideoSessionParametersKHR = StubUpdateVideoSessionParametersKHR;
+    DestroyVideoSessionParametersKHR = StubDestroyVideoSessionParametersKHR;
+}
+
+const StubVideoDevice::Counters& StubVideoDevice::GetCounters()
+{
+    return s_counters;
+}
+
+void StubVideoDevice::ResetCounters()
+{
+    s_counters = StubVideoDevice::Counters();
+}
@@ -0,0 +1,42 @@
+/*
+* Copyright 2023 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _STUBVIDEODEVICE_H_
+#define _STUBVIDEODEVICE_H_
+
+#include "VkCodecUtils/VulkanDeviceContext.h"
+
+// Device context without a Vulkan device, for the video session and the session parameters
+// objects of VkVideoDecoder: the video session entry points hand out dummy handles and count
+// the session parameters the device would create, update and destroy. The other entry points
+// are left NULL, the objects driven through this context must not call them.
+class StubVideoDevice : public VulkanDeviceContext {
+public:
+    struct Counters {
+        uint64_t videoSessions;
+        uint64_t sessionParametersCreated;
+        uint64_t sessionParametersUpdated;
+        uint64_t sessionParametersDestroyed;
+    };
+
+    StubVideoDevice();
+
+    // The entry points are plain functions, so there is one set of counters for all the contexts
+    static const Counters& GetCounters();
+    static void ResetCounters();
+};
+
+#endif /* _STUBVIDEODEVICE_H_ */
@@ -91,6 +91,10 @@ public:
     StdType GetStdType() const { return m_stdType; }
     ParameterType GetParameterType() const { return m_parameterType; }
     uint32_t GetUpdateSequenceCount() const { return m_updateSequenceCount; }
+    // Hash of the coded parameter set this object was parsed from (0 if unknown): objects of the
+    // same type and id with the same non-zero hash have the same content
+    uint64_t GetContentHash() const { return m_contentHash; }
+    void SetContentHash(uint64_t contentHash) { m_contentHash = contentHash; }
 
     // VkParserVideoPictureParameters
     virtual bool GetClientObject(VkSharedBaseObj<VkVideoRefCountBase>& clientObject) const = 0;
@@ -104,6 +108,7 @@ protected:
         , m_stdType(updateType)
         , m_parameterType(itemType)
         , m_updateSequenceCount((uint32_t)updateSequenceCount)
+        , m_contentHash()
         , m_parent() { }
 
     virtual ~StdVideoPictureParametersSet()
@@ -118,6 +123,7 @@ private:
     ParameterType                                    m_parameterType;
 protected:
     uint32_t                                         m_updateSequenceCount;
+    uint64_t                                         m_contentHash;
 public:
     VkSharedBaseObj<StdVideoPictureParametersSet>    m_parent;        // SPS or PPS parent
 
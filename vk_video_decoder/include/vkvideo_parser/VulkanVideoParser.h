@@ -51,7 +51,30 @@ public:
     virtual vkPicBuffBase* ReservePictureBuffer() = 0;
 };
 
+// Per-stage counters of the pipelined decode mode, summed since the mode was enabled.
+// The parse and submit stages overlap by (parseTimeNs + submitTimeNs - elapsedTimeNs).
+struct VulkanVideoParserPipelineStats {
+    uint64_t decodedPictures;   // Pictures recorded and submitted by the submit thread
+    uint64_t displayedPictures; // Pictures queued for display by the submit thread
+    uint64_t parseTimeNs;       // Parser thread, busy in ParseVideoData()
+    uint64_t fillTimeNs;        // Parser thread, part of parseTimeNs spent filling the picture descriptors
+    uint64_t parseWaitTimeNs;   // Parser thread, waiting for a free descriptor or for the submit thread to drain
+    uint64_t submitTimeNs;      // Submit thread, busy in DecodePictureWithParameters() and QueueDecodedPictureForDisplay()
+    uint64_t submitIdleTimeNs;  // Submit thread, waiting for descriptors
+    uint64_t elapsedTimeNs;     // Wall time from the first ParseVideoData() to the last drain
+};
+
+// Decode-to-display delay of the displayed pictures, summed since the parser was created
+struct VulkanVideoParserLatencyStats {
+    uint64_t displayedPictures; // Pictures sent to QueueDecodedPictureForDisplay()
+    uint64_t delayPictures;     // Pictures decoded after each displayed one and before its display
+    uint64_t delayUs;           // Time from the decode of each displayed picture to its display
+    uint32_t maxDelayPictures;
+    uint64_t maxDelayUs;
+};
+
 struct VkParserSourceDataPacket;
+struct VkParserTemporalLayerStats;
 class IVulkanVideoParser : public VkVideoRefCountBase {
 public:
     static VkResult Create(
@@ -72,6 +95,67 @@ public:
                                     size_t* pParsedBytes,
                                     bool doPartialParsing = false) = 0;
 
+    // Fills in pVideoFormat from the first sequence header of pPacket, a prefix of the
+    // stream, without starting the video sequence. Returns VK_NOT_READY if the packet
+    // has no complete sequence header. Only supported before the first ParseVideoData().
+    virtual VkResult ProbeVideoFormat(VkParserSourceDataPacket* pPacket,
+                                      VkParserDetectedVideoFormat* pVideoFormat,
+                                      size_t* pParsedBytes = NULL) = 0;
+
+    // Seek: flushes the pictures of the current position, as at the end of the stream, replays the
+    // parameter sets of a random access point of a VulkanVideoRandomAccessIndex and parses pPacket,
+    // which must start at the llOffset of the random access point. ParseVideoData() then goes on from there.
+    virtual VkResult SeekVideoData(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                   VkParserSourceDataPacket* pPacket,
+                                   size_t* pParsedBytes,
+                                   bool doPartialParsing = false) = 0;
+
+    // Switches to length-prefixed NAL units (MP4 samples) configured from the avcC/hvcC
+    // decoder configuration record of the stream, which also carries its parameter sets.
+    // Must be called before the first ParseVideoData().
+    virtual VkResult SetDecoderConfigurationRecord(const uint8_t* pData, size_t size) = 0;
+
+    // Moves the DecodePictureWithParameters() and QueueDecodedPictureForDisplay() calls to a
+    // submit thread, fed with up to maxPicturesInFlight parsed pictures, so that parsing the
+    // next picture overlaps recording the current one. The decoder handler must then accept
+    // those calls from the submit thread. Must be called before the first ParseVideoData().
+    virtual VkResult EnablePipelinedDecode(uint32_t maxPicturesInFlight) = 0;
+
+    virtual void GetPipelineStats(VulkanVideoParserPipelineStats* pStats) = 0;
+
+    // Records every call made to the decoder handler and to the frame buffer into fileName,
+    // to be replayed later with vulkanCreateVideoParserTraceReplayer(), see
+    // VulkanVideoParserTrace.h. Must be called before the first ParseVideoData().
+    virtual VkResult EnableTraceCapture(const char* fileName) = 0;
+
+    // Only decodes and displays the pictures the decode filter (VK_PARSER_DECODE_FILTER_XXX) keeps,
+    // see VkParserInitDecodeParameters::decodeFilter. Must be called before the first ParseVideoData()
+    // and before SetDecoderConfigurationRecord().
+    virtual VkResult SetDecodeFilter(uint32_t decodeFilter) = 0;
+
+    // Temporal sub-layer decimation, to lower the frame rate of H.265 and AV1 streams when the host cannot
+    // keep up, see VulkanVideoDecodeParser::SetMaxTemporalLayer(). Can be called between ParseVideoData() calls.
+    virtual VkResult SetMaxTemporalLayer(uint32_t maxTemporalLayer) = 0;
+
+    virtual void GetTemporalLayerStats(VkParserTemporalLayerStats* pStats) = 0;
+
+    // Immediate output: streams without picture reordering have each picture queued for display right after
+    // its decode, see VkParserInitDecodeParameters::lowLatencyOutput. Must be called before the first
+    // ParseVideoData() and before SetDecoderConfigurationRecord().
+    virtual VkResult EnableLowLatencyOutput() = 0;
+
+    // Decode-to-display delay of the displayed pictures, only tracked after EnableLowLatencyOutput()
+    virtual void GetDisplayLatencyStats(VulkanVideoParserLatencyStats* pStats) = 0;
+
+    // The data comes in pieces of a byte stream, split anywhere rather than at the AV1 temporal units,
+    // see VkParserInitDecodeParameters::streamingInput. Must be called before the first ParseVideoData()
+    // and before SetDecoderConfigurationRecord().
+    virtual VkResult EnableStreamingInput() = 0;
+
+    // AV1: the byte stream is in the length delimited format of the AV1 spec Annex B, see
+    // VkParserInitDecodeParameters::av1AnnexB. Must be called before the first ParseVideoData().
+    virtual VkResult EnableAv1AnnexBInput() = 0;
+
 protected:
     virtual ~IVulkanVideoParser() { }
 };
@@ -24,7 +24,7 @@
 #include "vkvideo_parser/StdVideoPictureParametersSet.h"
 #include "VkCodecUtils/VulkanBitstreamBuffer.h"
 
-static const uint32_t NV_VULKAN_VIDEO_PARSER_API_VERSION = VK_MAKE_VIDEO_STD_VERSION(0, 9, 9);
+static const uint32_t NV_VULKAN_VIDEO_PARSER_API_VERSION = VK_MAKE_VIDEO_STD_VERSION(0, 9, 15);
 
 typedef uint32_t FrameRate;  // Packed 18-bit numerator & 14-bit denominator
 
@@ -421,8 +421,22 @@ typedef struct VkParserBitstreamPacket {
     uint32_t bEOP : 1;             // true if the packet in pByteStream is exactly one frame
     uint8_t* pbSideData;           // Auxiliary encryption information
     int32_t nSideDataLength;       // Auxiliary encrypton information length
+    // Optional (H.264/H.265): bitstream buffer that already holds pByteStream at bitstreamBufferOffset,
+    // for instance a span of a memory mapped file imported as a host pointer. The parser then
+    // references the packet data in place instead of copying it and never writes to the buffer.
+    // Only vk-video-parse-bench sets it, from its own host pointer buffers: VulkanVideoParser, and so
+    // vk-video-dec, leaves it NULL, since the decoder does not import host pointers (VK_EXT_external_memory_host).
+    VulkanBitstreamBuffer* pBitstreamBuffer;
+    VkDeviceSize bitstreamBufferOffset;
 } VkParserBitstreamPacket;
 
+// One buffer of a packet whose payload is scattered over several buffers, e.g. reassembled from RTP or MPEG-TS
+// payloads, see VulkanVideoDecodeParser::ParseByteStreamSegments()
+typedef struct VkParserBitstreamSegment {
+    const uint8_t* pData;
+    size_t size;
+} VkParserBitstreamSegment;
+
 typedef struct VkParserOperatingPointInfo {
     VkVideoCodecOperationFlagBitsKHR eCodec;
     union {
@@ -472,6 +486,62 @@ enum {
     VK_PARSER_CAPS_SVC = 0x02,
 };
 
+// Definitions for VkParserInitDecodeParameters::simdIsa
+enum {
+    VK_PARSER_SIMD_ISA_AUTO = 0,  // best instruction set supported by the CPU
+    VK_PARSER_SIMD_ISA_C,
+    VK_PARSER_SIMD_ISA_SSSE3,
+    VK_PARSER_SIMD_ISA_AVX2,
+    VK_PARSER_SIMD_ISA_AVX512,
+    VK_PARSER_SIMD_ISA_NEON,
+    VK_PARSER_SIMD_ISA_SVE,
+};
+
+// Definitions for VkParserInitDecodeParameters::decodeFilter
+enum {
+    VK_PARSER_DECODE_FILTER_NONE = 0,      // decode every picture
+    VK_PARSER_DECODE_FILTER_RANDOM_ACCESS, // only the random access pictures: H.264 IDR, H.265 IRAP, AV1 key frames
+    VK_PARSER_DECODE_FILTER_REFERENCE,     // only the pictures other pictures can refer to: H.264 nal_ref_idc != 0,
+                                           // H.265 all but the sub-layer non-reference pictures of the highest
+                                           // sub-layer, AV1 refresh_frame_flags != 0
+};
+
+// VulkanVideoDecodeParser::SetMaxTemporalLayer() value that decodes every temporal sub-layer
+// (highest AV1 temporal_id, above the highest H.265 TemporalId)
+enum { VK_PARSER_TEMPORAL_LAYER_ALL = 7 };
+
+// Definitions for VkParserRandomAccessPoint::type
+enum {
+    VK_PARSER_RANDOM_ACCESS_IDR = 1,       // H.264/H.265 IDR picture
+    VK_PARSER_RANDOM_ACCESS_CRA,           // H.265 clean random access picture
+    VK_PARSER_RANDOM_ACCESS_BLA,           // H.265 broken link access picture
+    VK_PARSER_RANDOM_ACCESS_KEY_FRAME,     // AV1 shown key frame
+};
+
+// Random access point reported by an index pass (see VkParserInitDecodeParameters::indexRandomAccessPoints)
+typedef struct VkParserRandomAccessPoint {
+    int64_t llOffset;       // Offset of the picture (first slice NAL unit or temporal unit) in the bytes passed to ParseByteStream()
+    int64_t llPTS;          // Presentation time stamp, if bPTSValid
+    bool bPTSValid;
+    uint32_t type;          // VK_PARSER_RANDOM_ACCESS_XXX
+    int32_t picOrderCnt;    // H.264/H.265 picture order count, AV1 order hint
+    int32_t vpsId;          // Active parameter set ids (-1 if not used by the codec)
+    int32_t spsId;
+    int32_t ppsId;
+    // Parameter sets to replay before decoding from llOffset: the active VPS/SPS/PPS NAL units
+    // (with start codes) for H.264/H.265, the sequence header OBU for AV1
+    const uint8_t* pParameterSets;
+    size_t parameterSetsSize;
+} VkParserRandomAccessPoint;
+
+// Decode-to-display delay of a picture, reported right before its DisplayPicture() call
+typedef struct VkParserDisplayLatency {
+    VkPicIf* pPicBuf;       // Picture about to be displayed
+    int64_t llPTS;          // Presentation time stamp it is displayed with
+    uint32_t delayPictures; // Pictures sent to DecodePicture() after this one and before its display
+    uint64_t delayUs;       // Time from its DecodePicture() call to its DisplayPicture() call, in microseconds
+} VkParserDisplayLatency;
+
 typedef struct VkParserDisplayMasteringInfo {
     // H.265 Annex D.2.27
     uint16_t display_primaries_x[3];
@@ -482,6 +552,19 @@ typedef struct VkParserDisplayMasteringInfo {
     uint32_t min_display_mastering_luminance;
 } VkParserDisplayMasteringInfo;
 
+// Parameter set NAL units (AV1: sequence header OBUs) seen by the parser
+typedef struct VkParserParameterSetStats {
+    uint64_t repeatedParameterSets;  // byte-identical to the last copy of the same parameter set: not parsed again
+    uint64_t parsedParameterSets;    // new or changed: parsed and sent to the client
+} VkParserParameterSetStats;
+
+// Temporal sub-layer decimation state, see VulkanVideoDecodeParser::SetMaxTemporalLayer()
+typedef struct VkParserTemporalLayerStats {
+    uint32_t maxTemporalLayer;           // highest sub-layer decoded now (VK_PARSER_TEMPORAL_LAYER_ALL: no decimation)
+    uint32_t requestedMaxTemporalLayer;  // last value set, applied at the next switching point if it differs
+    uint64_t droppedPictures;            // pictures of the sub-layers above the limit, discarded unparsed
+} VkParserTemporalLayerStats;
+
 // Interface to allow decoder to communicate with the client
 class VkParserVideoDecodeClient {
    public:
@@ -503,6 +586,11 @@ class VkParserVideoDecodeClient {
                                             VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
                                             VkDeviceSize initializeBufferMemorySize,
                                             VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer) = 0;
+    // Called for every random access point when the parser builds an index (not required)
+    virtual void RandomAccessPoint(const VkParserRandomAccessPoint* /*pRandomAccessPoint*/) {}
+    // Called before every DisplayPicture() call with the decode-to-display delay of the picture, if
+    // VkParserInitDecodeParameters::reportDisplayLatency is set (not required)
+    virtual void DisplayLatency(const VkParserDisplayLatency* /*pDisplayLatency*/) {}
 
    protected:
     virtual ~VkParserVideoDecodeClient() {}
@@ -524,6 +612,34 @@ typedef struct VkParserInitDecodeParameters {
 
     // If set, Picture Parameters are going to be provided via UpdatePictureParameters callback
     bool outOfBandPictureParameters;
+    // If set, the parser searches for one start code at a time instead of indexing
+    // all the start codes of a packet up front (mostly useful for benchmarking)
+    bool perNaluStartCodeScan;
+    // Instruction set used for byte stream scanning (VK_PARSER_SIMD_ISA_XXX). Initialization fails
+    // with VK_ERROR_FEATURE_NOT_PRESENT if the CPU does not support the requested one.
+    uint32_t simdIsa;
+    // If set, the parser only builds a random access index: RandomAccessPoint() is called for every
+    // random access point, and no picture is sent to DecodePicture() or DisplayPicture()
+    bool indexRandomAccessPoints;
+    // Pictures to decode (VK_PARSER_DECODE_FILTER_XXX), for thumbnails and fast scrubbing. The other ones are
+    // dropped before they reach the DPB: no picture buffer, DecodePicture() or DisplayPicture() call for them.
+    uint32_t decodeFilter;
+    // Immediate output, for low-latency streams: when the stream signals that pictures are never reordered (H.264 VUI
+    // max_num_reorder_frames == 0 or POC type 2, H.265 sps_max_num_reorder_pics == 0, AV1 single spatial layer), every
+    // picture is sent to DisplayPicture() right after its DecodePicture() call, before the parser looks at the next one.
+    bool lowLatencyOutput;
+    // If set, DisplayLatency() is called before every DisplayPicture() call. Otherwise the parser does not keep
+    // track of when the pictures were sent to DecodePicture().
+    bool reportDisplayLatency;
+    // AV1: the packets split the byte stream at arbitrary positions instead of holding one temporal unit each, e.g.
+    // for live ingest. Every OBU is parsed as soon as it is complete, and a frame is sent to DecodePicture() as soon
+    // as its last tile group is, without waiting for the end of the temporal unit. The frame of a temporal unit is
+    // displayed once the next one starts, or at the end of a bEOP packet. H.264 and H.265 packets can always be split
+    // anywhere.
+    bool streamingInput;
+    // AV1: the byte stream is in the length delimited format of the AV1 spec Annex B (temporal_unit() syntax) instead
+    // of the low overhead format of section 5. It is always parsed as with streamingInput.
+    bool av1AnnexB;
 } VkParserInitDecodeParameters;
 
 // High-level interface to video decoder (Note that parsing and decoding
@@ -532,7 +648,39 @@ class VulkanVideoDecodeParser : public virtual VkVideoRefCountBase {
    public:
     virtual VkResult Initialize(const VkParserInitDecodeParameters* pParserPictureData) = 0;
     virtual bool ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes = NULL) = 0;
+    // Scatter-gather input: parses the packet made of the numSegments buffers of pSegments, in stream order, as
+    // ParseByteStream() would parse their concatenation. Each byte is copied once, straight into the bitstream
+    // buffer, and start codes split across segments are found as they are across packets. pck only provides the
+    // flags, the PTS and the side data of the packet: its pByteStream, nDataLength and pBitstreamBuffer are
+    // ignored. pParsedBytes is the total over the segments.
+    virtual bool ParseByteStreamSegments(const VkParserBitstreamPacket* pck, const VkParserBitstreamSegment* pSegments,
+                                         uint32_t numSegments, size_t* pParsedBytes = NULL) = 0;
+    // Seek: drops the current picture, flushes the parser as at the end of the stream, replays the
+    // parameter sets of the random access point and parses pck, which must start at its llOffset.
+    // VulkanVideoParser exposes it as IVulkanVideoParser::SeekVideoData().
+    virtual bool ParseByteStreamAt(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                   const VkParserBitstreamPacket* pck, size_t* pParsedBytes = NULL) = 0;
+    // Probe: parses pck, a prefix of the stream, only up to the end of its first sequence header (H.264/H.265 SPS,
+    // AV1 sequence header) and returns the sequence information BeginSequence() would get for it (AV1: the coded
+    // extent is the maximum frame size). Nothing is decoded and BeginSequence() is not called. Returns false if
+    // pck has no complete sequence header. Only supported before the first ParseByteStream().
+    virtual bool ProbeSequenceInfo(const VkParserBitstreamPacket* pck, VkParserSequenceInfo* pSequenceInfo,
+                                   size_t* pParsedBytes = NULL) = 0;
+    // Length-prefixed input (H.264/H.265 only): parses the ISO/IEC 14496-15 decoder configuration record
+    // (avcC/hvcC) of the stream, whose parameter sets are handled as if they came in band, and from then on
+    // ParseByteStream() takes NAL units prefixed by their 1, 2 or 4-byte big-endian size (MP4 samples)
+    // instead of start codes. Must be called before the first ParseByteStream().
+    virtual bool SetDecoderConfigurationRecord(const uint8_t* pData, size_t size) = 0;
     virtual bool GetDisplayMasteringInfo(VkParserDisplayMasteringInfo* pdisp) = 0;
+    // Counts of the parameter sets parsed and of the repeated ones that were skipped since Initialize()
+    virtual void GetParameterSetStats(VkParserParameterSetStats* pStats) = 0;
+    // Temporal sub-layer decimation (H.265 TemporalId, AV1 temporal_id; H.264 streams are not affected): the NAL
+    // units (OBUs) of the sub-layers above maxTemporalLayer are discarded before their slice (frame) header is
+    // parsed. Lowering the limit takes effect at the next picture, raising it at the next picture that allows
+    // switching up to the new sub-layers: H.265 IRAP, TSA and STSA pictures, AV1 shown key frames. Can be called
+    // between ParseByteStream() calls, Initialize() resets it to VK_PARSER_TEMPORAL_LAYER_ALL.
+    virtual void SetMaxTemporalLayer(uint32_t maxTemporalLayer) = 0;
+    virtual void GetTemporalLayerStats(VkParserTemporalLayerStats* pStats) = 0;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////
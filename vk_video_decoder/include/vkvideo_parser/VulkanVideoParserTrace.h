@@ -0,0 +1,100 @@
+/*
+* Copyright 2024 NVIDIA Corporation.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _VULKANVIDEOPARSERTRACE_H_
+#define _VULKANVIDEOPARSERTRACE_H_
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include "vkvideo_parser/StdVideoPictureParametersSet.h"
+#include "vkvideo_parser/VulkanVideoParser.h"
+
+// Parser output trace: the sequence of calls VulkanVideoParser makes to the decoder
+// handler and to the frame buffer, with everything they point to, so that the decoder
+// can be driven again without the parser.
+//
+// File layout: a VulkanVideoParserTraceFileHeader followed by records, each one a
+// VulkanVideoParserTraceRecordHeader and recordSize bytes of payload. The payloads copy
+// the parser structures field for field, host endianness, with their pointers cleared
+// and the data they point to following them, so that the same stream always produces
+// the same trace.
+struct VulkanVideoParserTraceFileHeader {
+    enum { MAGIC = 0x54504b56 /* "VKPT" */, VERSION = 1 };
+    uint32_t magic;
+    uint32_t version;
+    uint32_t codec; // VkVideoCodecOperationFlagBitsKHR
+    uint32_t reserved;
+};
+
+struct VulkanVideoParserTraceRecordHeader {
+    enum RecordType {
+        RECORD_SEQUENCE = 1,      // StartVideoSequence()
+        RECORD_PARAMETER_SET = 2, // UpdatePictureParameters()
+        RECORD_DECODE = 3,        // DecodePictureWithParameters()
+        RECORD_DISPLAY = 4,       // QueueDecodedPictureForDisplay()
+    };
+    uint32_t recordType;
+    uint32_t recordSize;
+};
+
+// Capture side, used by VulkanVideoParser when the trace capture is enabled.
+// The records are written in the order of the parser callbacks.
+class VulkanVideoParserTraceWriter {
+public:
+    VulkanVideoParserTraceWriter();
+    ~VulkanVideoParserTraceWriter();
+
+    VkResult Open(const char* fileName, VkVideoCodecOperationFlagBitsKHR codecType);
+    void Close();
+    bool IsOpen() const { return (m_file != NULL); }
+
+    void WriteSequence(const VkParserDetectedVideoFormat* pVideoFormat);
+    void WriteParameterSet(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject);
+    void WriteDecodePicture(const VkParserPerFrameDecodeParameters* pPicParams,
+                            const VkParserDecodePictureInfo* pDecodePictureInfo);
+    void WriteDisplayPicture(int8_t picIdx, const VulkanVideoDisplayPictureInfo* pDispInfo);
+
+private:
+    struct ParameterSetEntry {
+        VkSharedBaseObj<StdVideoPictureParametersSet> object; // Keeps the address unique while it is mapped
+        uint32_t traceId;
+    };
+
+    uint32_t GetParameterSetTraceId(const StdVideoPictureParametersSet* pParameterSet);
+    void WriteRecord(uint32_t recordType, const std::vector<uint8_t>& payload);
+
+    FILE*                                   m_file;
+    VkVideoCodecOperationFlagBitsKHR        m_codecType;
+    uint32_t                                m_nextParameterSetTraceId;
+    // The latest parameter set of each type and id, the only ones new pictures can refer to
+    std::map<uint32_t, ParameterSetEntry>   m_parameterSets;
+};
+
+// Replay side: a IVulkanVideoParser that ignores the bitstream it is given and instead
+// issues the calls recorded in fileName. Each ParseVideoData() call replays the records up
+// to the next display, and the end of stream replays the rest. The pictures are reserved
+// from videoFrameBufferCb again and may get other indices than in the captured run.
+VkResult vulkanCreateVideoParserTraceReplayer(
+    const char* fileName,
+    VkSharedBaseObj<IVulkanVideoDecoderHandler>& decoderHandler,
+    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb>& videoFrameBufferCb,
+    VkVideoCodecOperationFlagBitsKHR videoCodecOperation,
+    uint32_t bufferOffsetAlignment,
+    uint32_t bufferSizeAlignment,
+    VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser);
+
+#endif /* _VULKANVIDEOPARSERTRACE_H_ */
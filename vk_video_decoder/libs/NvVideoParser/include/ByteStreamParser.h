@@ -27,24 +27,29 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
     {
         if (!m_bNoStartCodes)
         {
-            if (m_nalu.start_offset == 0)
-                m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+            if (m_nalu.start_offset == m_picStartOffset)
+                m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
 
             // Pad the data after the NAL unit with start_code_prefix
             // make the room for 3 bytes
-            if (((VkDeviceSize)(m_nalu.end_offset + 3) > m_bitstreamDataLen) &&
-                    !resizeBitstreamBuffer(m_nalu.end_offset + 3 - m_bitstreamDataLen)) {
-                return false;
+            if (!m_bZeroCopy)
+            {
+                if (((VkDeviceSize)(m_nalu.end_offset + 3) > m_bitstreamDataLen) &&
+                        !resizeBitstreamBuffer(m_nalu.end_offset + 3 - m_bitstreamDataLen)) {
+                    return false;
+                }
+                m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
             }
-            m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
 
             // Complete the current NAL unit (if not empty)
             nal_unit();
+            m_nalLengthBytes = 0;
+            m_nalBytesLeft = 0;
             // Decode the current picture (NOTE: may be truncated)
             end_of_picture();
             framesinpkt++;
 
-            m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
+            start_next_picture();
         }
         // Reset the PTS queue to prevent timestamps from before the discontinuity to be associated with
         // a frame past the discontinuity
@@ -107,8 +112,27 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
 
         return (m_eError == NV_NO_ERROR ? true : false);
     }
+    if (m_nalLengthSize != 0)
+    {
+        // Length-prefixed NAL units (the packet data is always copied)
+        if (!parse_length_prefixed_nal_units(pck, pdatain, curr_data_size))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        // Reference the packet data in place if it comes in a bitstream buffer
+        begin_packet(pck);
+    }
     // Parse start codes
-    while (curr_data_size > 0) {
+    const uint8_t *pdatabegin = pdatain;
+    if (m_bIndexStartCodes && (m_nalLengthSize == 0) && (curr_data_size > 0))
+    {
+        index_start_codes<T>(pdatain, (size_t)curr_data_size);
+        m_StartCodesPos = 0;
+    }
+    while ((m_nalLengthSize == 0) && (curr_data_size > 0)) {
 
         VkDeviceSize buflen = curr_data_size;
 
@@ -117,30 +141,38 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
         {
             break;
         }
-        if ((m_nalu.start_offset > 0) && ((m_nalu.end_offset - m_nalu.start_offset) < (int64_t)m_lMinBytesForBoundaryDetection))
+        if ((m_nalu.start_offset > m_picStartOffset) && ((m_nalu.end_offset - m_nalu.start_offset) < (int64_t)m_lMinBytesForBoundaryDetection))
         {
             buflen = std::min<VkDeviceSize>(buflen, (m_lMinBytesForBoundaryDetection - (m_nalu.end_offset - m_nalu.start_offset)));
         }
         bool found_start_code = false;
-        VkDeviceSize start_offset = next_start_code<T>(pdatain, (size_t)buflen, found_start_code);
+        VkDeviceSize start_offset = m_bIndexStartCodes ?
+                next_indexed_start_code(pdatain, (size_t)(pdatain - pdatabegin), (size_t)buflen, found_start_code) :
+                next_start_code<T>(pdatain, (size_t)buflen, found_start_code);
         VkDeviceSize data_used = found_start_code ? start_offset : buflen;
         if (data_used > 0)
         {
-            if (data_used > (m_bitstreamDataLen - m_nalu.end_offset))
+            VkDeviceSize bytes = data_used;
+            // In zero-copy mode, the data already is at m_nalu.end_offset in the packet buffer
+            if (!m_bZeroCopy)
             {
-                resizeBitstreamBuffer(data_used - (m_bitstreamDataLen - m_nalu.end_offset));
-            }
-            VkDeviceSize bytes = std::min<VkDeviceSize>(data_used, m_bitstreamDataLen - m_nalu.end_offset);
-            if (bytes > 0) {
-                VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
-                bitstreamBuffer->CopyDataFromBuffer(pdatain, 0, m_nalu.end_offset, bytes);
+                if (data_used > (m_bitstreamDataLen - m_nalu.end_offset))
+                {
+                    resizeBitstreamBuffer(data_used - (m_bitstreamDataLen - m_nalu.end_offset));
+                }
+                bytes = std::min<VkDeviceSize>(data_used, m_bitstreamDataLen - m_nalu.end_offset);
+                if (bytes > 0) {
+                    VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
+                    bitstreamBuffer->CopyDataFromBuffer(pdatain, 0, m_nalu.end_offset, bytes);
+                }
             }
+            assert(!m_bZeroCopy || (m_nalu.end_offset == (m_llPacketBufferBase + m_llParsedBytes)));
             m_nalu.end_offset += bytes;
             m_llParsedBytes += bytes;
             pdatain += data_used;
             curr_data_size -= data_used;
             // Check for picture boundaries before we have the entire NAL data
-            if ((m_nalu.start_offset > 0) && (m_nalu.end_offset == (m_nalu.start_offset + (int64_t)m_lMinBytesForBoundaryDetection)))
+            if ((m_nalu.start_offset > m_picStartOffset) && (m_nalu.end_offset == (m_nalu.start_offset + (int64_t)m_lMinBytesForBoundaryDetection)))
             {
                 init_dbits();
                 if (IsPictureBoundary(available_bits() >> 3)) {
@@ -150,30 +182,34 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
                         end_of_picture();
                         framesinpkt++;
                     }
-                    // This swap will copy to the new buffer most of the time.
-                    m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
-                    m_nalu.end_offset -= m_nalu.start_offset;
-                    m_nalu.start_offset = 0;
-                    m_bitstreamData.ResetStreamMarkers();
-                    m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+                    m_llNaluEndLocation = m_llParsedBytes;
+                    start_next_picture();
+                    m_llNaluEndLocation = -1;
+                    m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
                 }
             }
         }
         // Did we find a startcode ?
         if (found_start_code)
         {
-            if (m_nalu.start_offset == 0) {
-                m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+            if (m_nalu.start_offset == m_picStartOffset) {
+                m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
             }
             // Remove the trailing 00.00.01 from the NAL unit
-            m_nalu.end_offset = (m_nalu.end_offset >= 3) ? (m_nalu.end_offset - 3) : 0;
+            const int64_t startCodeBytes = std::min<int64_t>(m_nalu.end_offset, 3);
+            m_nalu.end_offset -= startCodeBytes;
+            m_llNaluEndLocation = m_llParsedBytes - startCodeBytes;
             nal_unit();
+            m_llNaluEndLocation = -1;
             if (m_bDecoderInitFailed)
             {
                 return false;
             }
             // Add back the start code prefix for the next NAL unit
-            m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
+            if (!m_bZeroCopy)
+            {
+                m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
+            }
             m_nalu.end_offset += 3;
         }
     }
@@ -184,10 +220,10 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
     }
     if (pck->bEOP || pck->bEOS)
     {
-        if (m_nalu.start_offset == 0)
-            m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+        if (m_nalu.start_offset == m_picStartOffset)
+            m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
         // Remove the trailing 00.00.01 from the NAL unit
-        if (!!m_bitstreamData && (m_nalu.end_offset >= 3) &&
+        if (!!m_bitstreamData && (m_nalu.end_offset >= m_nalu.start_offset + 3) &&
             m_bitstreamData.HasSliceStartCodeAtOffset(m_nalu.end_offset - 3))
         {
             m_nalu.end_offset = m_nalu.end_offset - 3;
@@ -196,22 +232,29 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
         nal_unit();
 
         // Pad the data after the NAL unit with start_code_prefix
-        if (((VkDeviceSize)(m_nalu.end_offset + 3) > m_bitstreamDataLen) &&
-                !resizeBitstreamBuffer(m_nalu.end_offset + 3 - m_bitstreamDataLen)) {
-            return false;
+        if (!m_bZeroCopy)
+        {
+            if (((VkDeviceSize)(m_nalu.end_offset + 3) > m_bitstreamDataLen) &&
+                    !resizeBitstreamBuffer(m_nalu.end_offset + 3 - m_bitstreamDataLen)) {
+                return false;
+            }
+            m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
+            m_nalu.end_offset += 3;
         }
-        m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
-        m_nalu.end_offset += 3;
 
         // Decode the current picture
         if ((!pck->bEOP) || (pck->bEOP && framesinpkt < 1))
         {
             end_of_picture();
 
-             m_bitstreamDataLen = swapBitstreamBuffer(0, 0);
+            m_nalu.start_offset = m_nalu.end_offset;
+            start_next_picture();
         }
-        m_nalu.end_offset = 0;
-        m_nalu.start_offset = 0;
+        // Drop whatever is left of the current picture
+        m_nalu.end_offset = m_picStartOffset;
+        m_nalu.start_offset = m_picStartOffset;
+        m_nalLengthBytes = 0;
+        m_nalBytesLeft = 0;
         m_bitstreamData.ResetStreamMarkers();
         m_llNaluStartLocation = m_llParsedBytes;
         if (pck->bEOS)
@@ -220,8 +263,33 @@ bool VulkanVideoDecoder::ParseByteStreamSimd(const VkParserBitstreamPacket* pck,
             end_of_stream();
         }
     }
+    m_packetBitstreamBuffer = nullptr;
 
     return (m_eError == NV_NO_ERROR ? true : false);
 }
 
+template<SIMD_ISA T>
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesSimd(const uint8_t *pdatain, size_t datasize)
+{
+    uint8_t *pdataout = m_rbsp.data + m_rbsp.size;
+    size_t outsize = 0;
+
+    while (datasize > 0)
+    {
+        bool found_epb = false;
+        const size_t data_used = next_emulation_prevention_byte<T>(pdatain, datasize, found_epb);
+        // Copy everything up to (but not including) the emulation_prevention_three_byte
+        const size_t bytes = found_epb ? (data_used - 1) : data_used;
+        memcpy(pdataout + outsize, pdatain, bytes);
+        outsize += bytes;
+        if (found_epb)
+        {
+            m_rbsp.emulPos[m_rbsp.numEmulPos++] = (uint32_t)(m_rbsp.size + outsize);
+        }
+        pdatain += data_used;
+        datasize -= data_used;
+    }
+    return outsize;
+}
+
 #endif //_VULKANBYTESTREAMPARSER_H_
\ No newline at end of file
@@ -281,6 +281,7 @@ class VulkanAV1Decoder : public VulkanVideoDecoder {
     bool m_bSPSReceived;
     bool m_bSPSChanged;
     bool m_obuAnnexB;
+    bool m_bBitstreamDataSubmitted; // Pictures of the bitstream buffer were handed to the client, which may still read them
     uint8_t timing_info_present;
     av1_timing_info_t timing_info;
     av1_dec_model_info_t buffer_model;
@@ -333,11 +334,19 @@ class VulkanAV1Decoder : public VulkanVideoDecoder {
     VkPicIf* m_pOutFrame[MAX_NUM_SPATIAL_LAYERS];
     bool m_showableFrame[MAX_NUM_SPATIAL_LAYERS];
 
+    // Byte stream input (streaming input or Annex B): the buffered bytes of the current temporal unit are parsed
+    // from m_nalu.start_offset to m_nalu.end_offset. Annex B size fields still to be read are counted here.
+    uint32_t m_temporalUnitBytesLeft;           // Annex B: 0 when a temporal_unit_size comes next
+    uint32_t m_frameUnitBytesLeft;              // Annex B: 0 when a frame_unit_size comes next
+
    public:
     VulkanAV1Decoder(VkVideoCodecOperationFlagBitsKHR std, bool annexB = false);
     virtual ~VulkanAV1Decoder();
 
     bool ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes) override;
+    bool ParseByteStreamSegments(const VkParserBitstreamPacket* pck, const VkParserBitstreamSegment* pSegments,
+                                 uint32_t numSegments, size_t* pParsedBytes) override;
+    bool ProbeSequenceInfo(const VkParserBitstreamPacket* pck, VkParserSequenceInfo* pSequenceInfo, size_t* pParsedBytes) override;
 
    protected:
     bool IsPictureBoundary(int32_t) override { return true; };
@@ -346,8 +355,15 @@ class VulkanAV1Decoder : public VulkanVideoDecoder {
     bool end_of_picture(uint32_t frameSize);
     void InitParser() override;
     bool BeginPicture(VkParserPictureData* pnvpd) override;
+    void get_sequence_info(const av1_seq_param_s* sps, VkParserSequenceInfo* pnvsi);
     void lEndPicture(VkPicIf* pDispPic, bool bEvict);
     bool ParseOneFrame(const uint8_t* pdatain, int32_t datasize, const VkParserBitstreamPacket* pck, int* pParsedBytes);
+    bool ParseObu(const uint8_t* pCurrOBU, const AV1ObuHeader& hdr, uint32_t pictureDataLen);
+    bool ParseStreamData(const VkParserBitstreamPacket* pck, size_t* pParsedBytes);
+    bool ParseStreamObus(bool bEndOfData);
+    void StartTemporalUnit();
+    bool NextBitstreamBuffer(VkDeviceSize copyOffset, VkDeviceSize copySize);
+    void OutputTemporalUnit();
     void EndOfStream() override;
 
     uint32_t read_u16_le(const void* vmem) {
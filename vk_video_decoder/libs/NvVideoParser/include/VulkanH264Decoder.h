@@ -752,9 +752,6 @@ protected:
         H264ParserData()
         : slh(),
           spssClientUpdateCount(),
-          spsmes(),
-          spsmesClientUpdateCount(),
-          spssvcsClientUpdateCount(),
           ppssClientUpdateCount(),
           nhe()
         {
@@ -767,11 +764,54 @@ protected:
 
         slice_header_s slh;    // first slice of the picture (for dpb management)
         uint64_t  spssClientUpdateCount[MAX_NUM_SPS];
+        uint64_t ppssClientUpdateCount[MAX_NUM_PPS];
+        nalu_header_extension_u nhe;
+    };
+
+    // MVC state (Annex H), only allocated by the first NAL unit of the extension
+    struct H264MvcState
+    {
+        H264MvcState()
+        : spsmes(),
+          pSpsmes(),
+          spsmesClientUpdateCount(),
+          CurrFrmViewPic()
+        {
+
+        }
+
+        ~H264MvcState() {
+            for (uint32_t i = 0; i < MAX_NUM_SPS; i++) {
+                spsmes[i].release();
+            }
+        }
+
         seq_parameter_set_mvc_extension_s spsmes[MAX_NUM_SPS];
+        seq_parameter_set_mvc_extension_s *pSpsmes[MAX_NUM_SPS]; // NULL until the subset SPS is parsed
         uint64_t spsmesClientUpdateCount[MAX_NUM_SPS];
+        VkPicIf *CurrFrmViewPic[1024];    // frame buffer for all views of the current frame
+    };
+
+    // SVC state (Annex G), only allocated by the first NAL unit of the extension
+    struct H264SvcState
+    {
+        H264SvcState()
+        : prefix_nal_unit_svc(),
+          layer_data(),
+          dependency_state(),
+          dependency_data(),
+          spssvcs(),
+          spssvcsClientUpdateCount()
+        {
+
+        }
+
+        prefix_nal_unit_svc_s prefix_nal_unit_svc;
+        layer_data_s layer_data[8 * 16];
+        dependency_state_s dependency_state[8];
+        dependency_data_s dependency_data[8];
+        VkSharedBaseObj<seq_parameter_set_s> spssvcs[MAX_NUM_SPS];
         uint64_t spssvcsClientUpdateCount[MAX_NUM_SPS];
-        uint64_t ppssClientUpdateCount[MAX_NUM_PPS];
-        nalu_header_extension_u nhe;
     };
 
     // CNvVideoDecoder
@@ -779,6 +819,7 @@ protected:
     virtual void InitParser();
     virtual bool IsPictureBoundary(int32_t rbsp_size);
     virtual bool BeginPicture(VkParserPictureData *pnvpd);
+    virtual bool GetRandomAccessPoint(const VkParserPictureData *pnvpd, VkParserRandomAccessPoint *pRandomAccessPoint);
     virtual void EndPicture();
     virtual void EndOfStream();
     virtual int32_t  ParseNalUnit();
@@ -795,6 +836,8 @@ private:
     int32_t seq_parameter_set_rbsp(SpsNalUnitTarget spsNalUnitTarget = SPS_NAL_UNIT_TARGET_SPS,
                                    seq_parameter_set_s *spssvc = NULL);
     bool seq_parameter_set_mvc_extension_rbsp(int32_t sps_id);
+    void alloc_extension_state(int nal_unit_type);
+    seq_parameter_set_mvc_extension_s *get_spsme(int32_t sps_id) const;
     void vui_parameters(vui_parameters_s *vui);
     void hrd_parameters(vui_parameters_s *vui, hrd_parameters_s *hrd);
     int scaling_list(unsigned char scalingList[], int sizeOfScalingList); // returns scaling_list_type
@@ -807,6 +850,7 @@ private:
 
     // DPB management
     bool dpb_sequence_start(slice_header_s *slh);
+    int32_t get_sequence_info(const seq_parameter_set_s* sps, VkParserSequenceInfo* pnvsi);
     void dpb_picture_start(pic_parameter_set_s *pps, slice_header_s *slh);
     void dpb_picture_end();
     VkPicIf *alloc_picture();
@@ -827,6 +871,7 @@ private:
     int dpb_reordering_delay();
     void display_bumping();
     void flush_decoded_picture_buffer();
+    void release_decoded_picture_buffer();
     bool is_comp_field_pair(dpb_entry_s *dpb, slice_header_s *slh);
     bool find_comp_field_pair(slice_header_s *slh, int *iCur);
     uint8_t  derive_MaxDpbFrames(const seq_parameter_set_s *sps);
@@ -899,8 +944,6 @@ private:
     VkSharedBaseObj<pic_parameter_set_s> m_pps;  // active pps
     seq_parameter_set_mvc_extension_s *m_spsme; // active spsme
     VkSharedBaseObj<seq_parameter_set_s> m_spss[MAX_NUM_SPS];
-    seq_parameter_set_mvc_extension_s *m_spsmes[MAX_NUM_SPS];
-    VkSharedBaseObj<seq_parameter_set_s> m_spssvcs[MAX_NUM_SPS];
     VkSharedBaseObj<pic_parameter_set_s> m_ppss[MAX_NUM_PPS];
     frame_packing_arrangement_s m_fpa; // Stereo SEI
     nalu_header_extension_u m_nhe;  // current nal ubit header extension
@@ -910,17 +953,15 @@ private:
     int m_prevFrameNumOffset, m_prevFrameNum;
     int m_PrevRefFrameNum, m_PrevViewId;
     int m_MaxRefFramesPerView;
-    VkPicIf *CurrFrmViewPic[1024];    // frame buffer for all views of the current frame
-    // use SVC decoder
+    H264MvcState *m_pMvcState; // NULL until the stream has an MVC NAL unit
+    // use SVC decoder (once the stream has an SVC NAL unit, if the client supports SVC)
     bool m_bUseSVC;
+    bool m_bSvcSupported;
     bool m_bLayerFirstSlice;
     uint32_t m_iDQIdMax;
-    prefix_nal_unit_svc_s m_prefix_nal_unit_svc;
     slice_header_s m_slh_prev;
-    layer_data_s m_layer_data[8 * 16];
-    dependency_state_s m_dependency_state[8];
+    H264SvcState *m_pSvcState; // NULL until the stream has an SVC NAL unit
     dependency_state_s *m_ds; // current dependency state
-    dependency_data_s m_dependency_data[8];
     dependency_data_s *m_dd; // current dependency data
     slice_group_map_s* m_slice_group_map; // [pps_id] (base layer only)
 };
@@ -742,6 +742,7 @@ protected:
     virtual void InitParser();
     virtual bool IsPictureBoundary(int32_t rbsp_size);
     virtual bool BeginPicture(VkParserPictureData *pnvpd);
+    virtual bool GetRandomAccessPoint(const VkParserPictureData *pnvpd, VkParserRandomAccessPoint *pRandomAccessPoint);
     virtual void EndPicture();
     virtual void EndOfStream();
     virtual int32_t  ParseNalUnit();
@@ -775,7 +776,9 @@ protected:
     void getNumActiveRefLayerPics(const hevc_video_param_s *pVideoParamSet, hevc_slice_header_s *pSliceHeader);
     // DPB management
     bool dpb_sequence_start(VkSharedBaseObj<hevc_seq_param_s>& sps);
+    int32_t get_sequence_info(VkSharedBaseObj<hevc_seq_param_s>& sps, VkParserSequenceInfo* pnvsi);
     void flush_decoded_picture_buffer(int NoOutputOfPriorPicsFlag = 0);
+    int get_no_output_of_prior_pics_flag(const hevc_slice_header_s *slh) const;
     int dpb_fullness();
     int dpb_reordering_delay();
     bool dpb_empty() { return (dpb_fullness() == 0); }
@@ -19,6 +19,8 @@
 
 #include <atomic>
 #include <limits>
+#include <map>
+#include <vector>
 
 #include <cpudetect.h>
 #include "VkCodecUtils/VulkanBitstreamBuffer.h"
@@ -30,12 +32,32 @@ typedef struct NvVkNalUnit
     int64_t start_offset;     // Start offset in byte stream buffer
     int64_t end_offset;       // End offset in byte
     int64_t get_offset;       // Current read ptr in this NALU
-    int32_t get_zerocnt;     // Zero byte count
-    uint32_t get_bfr;        // Bit buffer for reading
+    uint64_t get_bfr;        // Bit buffer for reading (64-bit cache, MSB-aligned)
     uint32_t get_bfroffs;    // Offset in bit buffer
     uint32_t get_emulcnt;    // Emulation prevention byte count
 } NvVkNalUnit;
 
+// RBSP view of the current NAL unit. The emulation prevention bytes are stripped out of the byte stream
+// one chunk at a time, so that the bit reader never has to check for them.
+// A chunk is only converted when less than 8 bytes are left to read, after the bytes already read have
+// been discarded once past the first chunk, so data never holds more than two chunks plus 8 bytes.
+// An emulation prevention byte needs two zero bytes in front of it, so there is at most one emulPos
+// entry for every two bytes of data.
+typedef struct NvVkRbspView
+{
+    enum { CHUNK_SIZE = 512 };                      // Number of NAL unit bytes converted to RBSP at a time
+    enum { MAX_SIZE = 2 * CHUNK_SIZE + 8 };         // Size of data
+    enum { MAX_EMUL_POS = MAX_SIZE / 2 + 1 };       // Size of emulPos
+    uint8_t data[MAX_SIZE];         // RBSP bytes (emulation_prevention_three_byte removed)
+    uint32_t emulPos[MAX_EMUL_POS]; // Offsets in data in front of which an emulation prevention byte was removed
+    size_t numEmulPos;              // Number of valid entries in emulPos
+    size_t size;                    // Number of valid bytes in data
+    size_t readPos;                 // Next byte in data to be loaded into the bit buffer
+    size_t emulIdx;                 // First entry in emulPos not yet accounted for in get_emulcnt
+    int64_t rawOffset;              // Next byte stream offset to be converted
+    uint32_t bfr;                   // Last bytes converted (to detect 00.00.03 across chunks)
+} NvVkRbspView;
+
 // Presentation information stored with every decoded frame
 typedef struct NvVkPresentationInfo
 {
@@ -58,11 +80,23 @@ public:
     enum { MAX_SLICES = 8192 };             // Up to 8K slices per picture
     enum { MAX_DELAY = 32 };                // Maximum frame delay between decode & display
     enum { MAX_QUEUED_PTS = 16};            // Size of PTS queue
+    enum { RBSP_CHUNK_SIZE = NvVkRbspView::CHUNK_SIZE }; // Number of NAL unit bytes converted to RBSP at a time
     enum {
         NALU_DISCARD=0, // Discard this nal unit
         NALU_SLICE,     // This NALU contains picture data (keep)
         NALU_UNKNOWN,   // This NALU type is not supported (callback client)
     };
+    enum {
+        PARAMETER_SET_VPS = 0,  // Parameter set types saved for random access points
+        PARAMETER_SET_SPS,      // (the AV1 sequence header is saved as SPS 0)
+        PARAMETER_SET_PPS,
+    };
+    enum {
+        TEMPORAL_SWITCH_NONE = 0,   // Switching points for raising the temporal sub-layer limit:
+        TEMPORAL_SWITCH_STEP,       // up to the sub-layer of the picture (H.265 STSA)
+        TEMPORAL_SWITCH_UP,         // up to any sub-layer from the one of the picture (H.265 TSA)
+        TEMPORAL_SWITCH_ALL,        // up to any sub-layer (H.265 IRAP, AV1 shown key frame)
+    };
     typedef enum {
         NV_NO_ERROR = 0,         // No error detected
         NV_NON_COMPLIANT_STREAM  // Stream is not compliant with codec standards
@@ -80,12 +114,23 @@ protected:
     uint32_t m_bufferSizeAlignment;        // Minimum buffer size alignment of the bitstream data for each frame
     VulkanBitstreamBufferStream m_bitstreamData;// bitstream for the current picture
     VkDeviceSize                m_bitstreamDataLen; // bitstream buffer size
+    int64_t m_picStartOffset;                   // Offset of the current picture in m_bitstreamData (pictures are packed back to back)
+    VkDeviceSize m_maxPictureDataLen;           // Largest picture so far, used to decide if the next one fits in the current buffer
+    VkSharedBaseObj<VulkanBitstreamBuffer> m_packetBitstreamBuffer; // Client buffer holding the current packet (if any)
+    int64_t m_llPacketBufferBase;               // Offset in m_packetBitstreamBuffer of byte count 0
+    int64_t m_llNaluEndLocation;                // Byte count at m_nalu.end_offset when a picture boundary is found (-1 if unknown)
+    bool m_bZeroCopy;                           // m_bitstreamData is the client's packet buffer: it is referenced, never written
+    int64_t m_picDataEndOffset;                 // Zero-copy: end of the last slice of the current picture
     uint32_t m_BitBfr;                          // Bit Buffer for start code parsing
+    int32_t m_bIndexStartCodes;                 // Find all the start codes of a packet in a single pass
+    std::vector<size_t> m_StartCodes;           // Offsets just past the start codes found in the current packet
+    size_t m_StartCodesPos;                     // Next entry in m_StartCodes
     int32_t m_bEmulBytesPresent;                // Startcode emulation prevention bytes are present in the byte stream
     int32_t m_bNoStartCodes;                    // No startcode parsing (only rely on the presence of PTS to detect frame boundaries)
     int32_t m_bFilterTimestamps;                // Filter input timestamps in case the decoder is sending the DTS instead of the PTS
     int32_t m_MaxFrameBuffers;                  // Max frame buffers to keep as reference
     NvVkNalUnit m_nalu;                         // Current NAL unit being filled
+    NvVkRbspView m_rbsp;                        // RBSP view of the current NAL unit (if m_bEmulBytesPresent)
     size_t m_lMinBytesForBoundaryDetection;     // Min number of bytes needed to detect picture boundaries
     int64_t m_lClockRate;                       // System Reference Clock Rate
     int64_t m_lFrameDuration;                   // Approximate frame duration in units of (1/m_lClockRate) seconds
@@ -106,6 +151,12 @@ protected:
         int64_t llPTSPos;                       // PTS position in byte stream
         int32_t bDiscontinuity;                 // Discontinuity before this PTS, do not check for out of order
     } m_PTSQueue[MAX_QUEUED_PTS];
+    struct {
+        VkPicIf *pPicBuf;                       // Picture sent to DecodePicture()
+        uint64_t decodeIndex;                   // Its index in decode order (m_decodedPictureCount)
+        int64_t llDecodeTimeUs;                 // Time of its DecodePicture() call
+    } m_DecodeInfo[MAX_DELAY];                  // Keeps track of the decode-to-display latency
+    uint64_t m_decodedPictureCount;             // Pictures sent to DecodePicture() since Initialize()
     int32_t m_bDiscontinuityReported;           // Dicontinuity reported
     VkParserPictureData *m_pVkPictureData;
     int32_t m_iTargetLayer;                     // Specific to SVC only
@@ -113,6 +164,25 @@ protected:
     int32_t m_lCheckPTS;                        // Run the m_bFilterTimestamps for the first few framew to look for out of order PTS
     NVCodecErrors m_eError;
     SIMD_ISA m_NextStartCode;
+    int32_t m_bIndexRandomAccessPoints;         // Only report random access points to the client, nothing is decoded
+    uint32_t m_decodeFilter;                    // VK_PARSER_DECODE_FILTER_XXX
+    int32_t m_bLowLatencyOutput;                // Display pictures right after decoding them if the stream has no reordering
+    int32_t m_bReportDisplayLatency;            // Track m_DecodeInfo and report the display latency to the client
+    int32_t m_bStreamingInput;                  // AV1: packets split the byte stream anywhere, not at temporal unit boundaries
+    VkParserTemporalLayerStats m_temporalLayerStats; // Temporal sub-layer limit (current and requested), dropped pictures
+    std::map<uint32_t, std::vector<uint8_t>> m_parameterSetNalus; // Index mode: last copy of each parameter set (key = type << 16 | id)
+    std::vector<uint8_t> m_randomAccessParameterSets; // Parameter sets of the reported random access point
+    struct ParameterSetMemo {
+        uint64_t hash;                          // FNV-1a hash of data
+        std::vector<uint8_t> data;              // Last parsed NAL unit (start code included) or AV1 OBU
+    };
+    std::map<uint32_t, ParameterSetMemo> m_parameterSetMemos; // Last parsed copy of each parameter set (key = type << 16 | id)
+    VkParserParameterSetStats m_parameterSetStats; // Repeated parameter sets skipped / parameter sets parsed
+    uint64_t m_parameterSetHash;                // Hash of the parameter set being parsed (StdVideoPictureParametersSet content hash)
+    VkParserSequenceInfo* m_pProbeSequenceInfo; // Probe: set until the first sequence header fills it in
+    uint32_t m_nalLengthSize;                   // Length-prefixed input: size of the NAL unit length fields (0 = start codes)
+    uint32_t m_nalLengthBytes;                  // Length-prefixed input: bytes of the current length field read so far
+    size_t m_nalBytesLeft;                      // Length-prefixed input: bytes of the current NAL unit not received yet
 public:
     VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std);
     virtual ~VulkanVideoDecoder();
@@ -140,6 +210,13 @@ public:
     virtual VkResult Initialize(const VkParserInitDecodeParameters *pNvVkp);
     virtual bool Deinitialize();
     virtual bool ParseByteStream(const VkParserBitstreamPacket *pck, size_t *pParsedBytes);
+    virtual bool ParseByteStreamSegments(const VkParserBitstreamPacket *pck, const VkParserBitstreamSegment *pSegments,
+                                         uint32_t numSegments, size_t *pParsedBytes);
+    virtual bool ParseByteStreamAt(const VkParserRandomAccessPoint *pRandomAccessPoint,
+                                   const VkParserBitstreamPacket *pck, size_t *pParsedBytes);
+    virtual bool ProbeSequenceInfo(const VkParserBitstreamPacket *pck, VkParserSequenceInfo *pSequenceInfo,
+                                   size_t *pParsedBytes);
+    virtual bool SetDecoderConfigurationRecord(const uint8_t *pData, size_t size);
     template <SIMD_ISA T>
     bool ParseByteStreamSimd(const VkParserBitstreamPacket *pck, size_t *pParsedBytes);
     bool ParseByteStreamC(const VkParserBitstreamPacket *pck, size_t *pParsedBytes);
@@ -154,6 +231,9 @@ public:
     bool ParseByteStreamNEON(const VkParserBitstreamPacket* pck, size_t *pParsedBytes);
 #endif
     virtual bool GetDisplayMasteringInfo(VkParserDisplayMasteringInfo *) { return false; }
+    virtual void GetParameterSetStats(VkParserParameterSetStats *pStats) { *pStats = m_parameterSetStats; }
+    virtual void SetMaxTemporalLayer(uint32_t maxTemporalLayer);
+    virtual void GetTemporalLayerStats(VkParserTemporalLayerStats *pStats) { *pStats = m_temporalLayerStats; }
 
 protected:
     virtual void CreatePrivateContext() = 0;                   // Implemented by derived classes
@@ -164,23 +244,60 @@ protected:
     virtual void EndPicture() {}                               // Called after a picture has been decoded
     virtual void EndOfStream() {}                              // Called to reset parser
     virtual void FreeContext() = 0;
+    // Index mode: returns true and fills in the type, POC and parameter set ids if the picture is a random access point
+    virtual bool GetRandomAccessPoint(const VkParserPictureData * /*pnvpd*/, VkParserRandomAccessPoint * /*pRandomAccessPoint*/) { return false; }
 
 protected:
     // Byte stream parsing
     template<SIMD_ISA T>
     size_t next_start_code(const uint8_t *pdatain, size_t datasize, bool& found_start_code);
+    template<SIMD_ISA T>
+    void index_start_codes(const uint8_t *pdatain, size_t datasize);  // fill m_StartCodes (m_BitBfr is left unchanged)
+    size_t next_indexed_start_code(const uint8_t *pdatain, size_t pckoffset, size_t datasize, bool& found_start_code);
+    void add_start_code(size_t offset) { m_StartCodes.push_back(offset); }
+    // Emulation prevention byte removal
+    template<SIMD_ISA T>
+    size_t next_emulation_prevention_byte(const uint8_t *pdatain, size_t datasize, bool& found_epb);
+    size_t RemoveEmulationPreventionBytes(const uint8_t *pdatain, size_t datasize);
+    template <SIMD_ISA T>
+    size_t RemoveEmulationPreventionBytesSimd(const uint8_t *pdatain, size_t datasize);
+    size_t RemoveEmulationPreventionBytesC(const uint8_t *pdatain, size_t datasize);
+#if defined(__x86_64__) || defined (_M_X64)
+    size_t RemoveEmulationPreventionBytesAVX2(const uint8_t *pdatain, size_t datasize);
+    size_t RemoveEmulationPreventionBytesAVX512(const uint8_t *pdatain, size_t datasize);
+    size_t RemoveEmulationPreventionBytesSSSE3(const uint8_t *pdatain, size_t datasize);
+#elif defined(__aarch64__)
+    size_t RemoveEmulationPreventionBytesSVE(const uint8_t *pdatain, size_t datasize);
+    size_t RemoveEmulationPreventionBytesNEON(const uint8_t *pdatain, size_t datasize);
+#elif defined(__ARM_ARCH_7A__) || defined(_M_ARM64)
+    size_t RemoveEmulationPreventionBytesNEON(const uint8_t *pdatain, size_t datasize);
+#endif
+    void rbsp_fill();            // convert the next chunk of the current NAL unit into m_rbsp
     void nal_unit();
     void init_dbits();
     int32_t available_bits() {
-		// end_offset=566 - get_offset=568 for example are values seen in the debugger, causing an unsigned integer overflow below since get_btroffs is a uint32 while end_offset and get_offset are int64 explicitly casted to int32, which then gets implicitly casted to a unint32. This code could use a review from the original authors about the intentions here. The early return is to avoid the sanitizer violation and appears semantically correct.
-		if ((m_nalu.end_offset - m_nalu.get_offset) < 0)
-			return 0;
-		assert((m_nalu.end_offset - m_nalu.get_offset) < std::numeric_limits<int32_t>::max());
-                               return (int32_t)(m_nalu.end_offset - m_nalu.get_offset) * 8 + (32 - m_nalu.get_bfroffs); }
+        // The bit cache may have been refilled past end_offset (with zeros), so compute the remaining
+        // bits in 64-bit and clamp to zero once everything has been consumed.
+        const int64_t bits = (m_nalu.end_offset - m_nalu.get_offset) * 8 + (64 - (int64_t)m_nalu.get_bfroffs);
+        assert(bits < std::numeric_limits<int32_t>::max());
+        return (bits > 0) ? (int32_t)bits : 0; }
     int32_t consumed_bits() { assert((m_nalu.get_offset - m_nalu.start_offset - m_nalu.get_emulcnt) < std::numeric_limits<int32_t>::max());
-                          return (int32_t)(m_nalu.get_offset - m_nalu.start_offset - m_nalu.get_emulcnt) * 8 - (32 - m_nalu.get_bfroffs); }
-    uint32_t next_bits(uint32_t n) { return (m_nalu.get_bfr << m_nalu.get_bfroffs) >> (32 - n); } // NOTE: n must be in the [1..25] range
-    void skip_bits(uint32_t n);  // advance bitstream position
+                          return (int32_t)(m_nalu.get_offset - m_nalu.start_offset - m_nalu.get_emulcnt) * 8 - (64 - m_nalu.get_bfroffs); }
+    uint32_t next_bits(uint32_t n) { return (uint32_t)((m_nalu.get_bfr << m_nalu.get_bfroffs) >> (64 - n)); } // NOTE: n must be in the [1..32] range
+    void skip_bits(uint32_t n)   // advance bitstream position
+    {
+        m_nalu.get_bfroffs += n;
+        // Keep at least 32 unread bits in the cache so that next_bits() / u() never straddle a refill
+        if (m_nalu.get_bfroffs >= 32) {
+            if (m_bEmulBytesPresent) {
+                fill_bits<true>();
+            } else {
+                fill_bits<false>();
+            }
+        }
+    }
+    template<bool EmulBytesPresent>
+    void fill_bits();            // refill the bit cache, up to 8 bytes at a time (from m_rbsp if EmulBytesPresent)
     uint32_t u(uint32_t n);   // return next n bits, advance bitstream position
     bool flag()          { return (0 != u(1)); }     // returns flag value
     uint32_t u16_le()    { uint32_t tmp = u(8); tmp |= u(8) << 8; return tmp; }
@@ -196,11 +313,30 @@ protected:
     bool IsSequenceChange(VkParserSequenceInfo *pnvsi);
     int32_t init_sequence(VkParserSequenceInfo *pnvsi);  // Must be called by derived classes to initialize the sequence
     void display_picture(VkPicIf *pPicBuf, bool bEvict = true);
+    void picture_decoded(VkPicIf *pPicBuf);
     void rbsp_trailing_bits();
     bool end() { return m_nalu.get_offset >= m_nalu.end_offset; }
     bool more_rbsp_data();
     bool resizeBitstreamBuffer(VkDeviceSize nExtrabytes);
-    VkDeviceSize swapBitstreamBuffer(VkDeviceSize copyCurrBuffOffset, VkDeviceSize copyCurrBuffSize);
+    VkDeviceSize swapBitstreamBuffer(VkDeviceSize copyCurrBuffOffset, VkDeviceSize copyCurrBuffSize, VkDeviceSize newBufferSize = 0);
+    VkDeviceSize picture_data_offset() const;
+    void start_next_picture();
+    void begin_packet(const VkParserBitstreamPacket* pck);
+    bool use_packet_buffer(int64_t llNaluEndLocation);
+    void copy_packet_buffer_data();
+    void discard_nal_unit();
+    bool append_nal_unit_data(const uint8_t* pData, size_t size);
+    void parse_nal_unit_data(const uint8_t* pData, size_t size);
+    bool parse_length_prefixed_nal_units(const VkParserBitstreamPacket* pck, const uint8_t*& pdatain, VkDeviceSize& curr_data_size);
+    void save_parameter_set(uint32_t type, int32_t id);
+    void save_parameter_set(uint32_t type, int32_t id, const uint8_t* pData, size_t size);
+    bool is_parameter_set_repeat(uint32_t type);
+    bool is_parameter_set_repeat(uint32_t type, const uint8_t* pData, size_t size);
+    void forget_parameter_sets(uint32_t type);
+    void report_random_access_point(VkParserRandomAccessPoint* pRandomAccessPoint);
+    bool is_picture_filtered(bool bRandomAccess, bool bReference) const;
+    void update_temporal_layer_limit(uint32_t temporalId, int32_t switchType);
+    bool is_temporal_layer_dropped(uint32_t temporalId, bool bPictureStart);
 };
 
 void nvParserLog(const char* format, ...);
@@ -1,6 +1,8 @@
 #ifndef CPUDETECT_H
 #define CPUDETECT_H
 
+#include <stdint.h>
+
 enum SIMD_ISA
 {
     NOSIMD = 0,
@@ -22,6 +24,18 @@ static int inline count_trailing_zeros(unsigned long long resmask)
     return offset;
 }
 
+static int inline count_leading_zeros(uint32_t value) // value can't be 0
+{
+#ifndef _WIN32
+    int offset = __builtin_clz(value);
+#else
+    unsigned long index = 0;
+    _BitScanReverse(&index, value);
+    int offset = 31 - (int)index;
+#endif
+    return offset;
+}
+
 SIMD_ISA check_simd_support();
 
 #endif
\ No newline at end of file
@@ -64,4 +64,135 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX2>(const uint8_t *pdatai
     return i;
 }
 
+template<>
+void VulkanVideoDecoder::index_start_codes<SIMD_ISA::AVX2>(const uint8_t *pdatain, size_t datasize)
+{
+    size_t i = 0;
+    size_t datasize64 = (datasize >> 6) << 6;
+    uint32_t bfr = m_BitBfr;
+    m_StartCodes.clear();
+    if (datasize64 >= 64)
+    {
+        const __m256i v1 = _mm256_set1_epi8(1);
+        __m256i vdata = _mm256_loadu_si256((const __m256i*)pdatain);
+        __m256i vBfr = _mm256_set1_epi16(((bfr << 8) & 0xFF00) | ((bfr >> 8) & 0xFF));
+        __m256i vdata_alignr16b_init = _mm256_permute2f128_si256(vBfr, vdata, 1 | (2<<4));
+        __m256i vdata_prev1 = _mm256_alignr_epi8(vdata, vdata_alignr16b_init, 15);
+        __m256i vdata_prev2 = _mm256_alignr_epi8(vdata, vdata_alignr16b_init, 14);
+        for ( ; i < datasize64 - 64; i += 64)
+        {
+            for (int c = 0; c < 64; c += 32)
+            {
+                // hotspot begin
+                __m256i vdata_prev1or2 = _mm256_or_si256(vdata_prev2, vdata_prev1);
+                __m256i vmask = _mm256_cmpeq_epi8(_mm256_and_si256(vdata, _mm256_cmpeq_epi8(vdata_prev1or2, _mm256_setzero_si256())), v1);
+                uint32_t resmask = (uint32_t)_mm256_movemask_epi8(vmask);
+                // hotspot end
+                while (resmask)
+                {
+                    add_start_code(count_trailing_zeros(resmask) + i + c + 1);
+                    resmask &= resmask - 1;
+                }
+                // hotspot begin
+                __m256i vdata_next = _mm256_loadu_si256((const __m256i*)&pdatain[i + c + 32]);
+                __m256i vdata_alignr16b_next = _mm256_permute2f128_si256(vdata, vdata_next, 1 | (2<<4));
+                vdata_prev1 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 15);
+                vdata_prev2 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        // The remaining whole blocks, so that the scalar tail is shorter than a block
+        for ( ; ; )
+        {
+            __m256i vdata_prev1or2 = _mm256_or_si256(vdata_prev2, vdata_prev1);
+            __m256i vmask = _mm256_cmpeq_epi8(_mm256_and_si256(vdata, _mm256_cmpeq_epi8(vdata_prev1or2, _mm256_setzero_si256())), v1);
+            uint32_t resmask = (uint32_t)_mm256_movemask_epi8(vmask);
+            while (resmask)
+            {
+                add_start_code(count_trailing_zeros(resmask) + i + 1);
+                resmask &= resmask - 1;
+            }
+            i += 32;
+            if ((i + 32) > datasize)
+            {
+                break;
+            }
+            __m256i vdata_next = _mm256_loadu_si256((const __m256i*)&pdatain[i]);
+            __m256i vdata_alignr16b_next = _mm256_permute2f128_si256(vdata, vdata_next, 1 | (2<<4));
+            vdata_prev1 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 15);
+            vdata_prev2 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 14);
+            vdata = vdata_next;
+        }
+        bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    while (i < datasize)
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 1) {
+            add_start_code(i);
+        }
+    }
+}
+
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesAVX2(const uint8_t *pdatain, size_t datasize)
+{
+    return RemoveEmulationPreventionBytesSimd<SIMD_ISA::AVX2>(pdatain, datasize);
+}
+
+template<>
+size_t VulkanVideoDecoder::next_emulation_prevention_byte<SIMD_ISA::AVX2>(const uint8_t *pdatain, size_t datasize, bool& found_epb)
+{
+    size_t i = 0;
+    size_t datasize64 = (datasize >> 6) << 6;
+    if (datasize64 > 64)
+    {
+        const __m256i v3 = _mm256_set1_epi8(3);
+        __m256i vdata = _mm256_loadu_si256((const __m256i*)pdatain);
+        __m256i vBfr = _mm256_set1_epi16(((m_rbsp.bfr << 8) & 0xFF00) | ((m_rbsp.bfr >> 8) & 0xFF));
+        __m256i vdata_alignr16b_init = _mm256_permute2f128_si256(vBfr, vdata, 1 | (2<<4));
+        __m256i vdata_prev1 = _mm256_alignr_epi8(vdata, vdata_alignr16b_init, 15);
+        __m256i vdata_prev2 = _mm256_alignr_epi8(vdata, vdata_alignr16b_init, 14);
+        for ( ; i < datasize64 - 64; i += 64)
+        {
+            for (int c = 0; c < 64; c += 32)
+            {
+                // hotspot begin
+                __m256i vdata_prev1or2 = _mm256_or_si256(vdata_prev2, vdata_prev1);
+                __m256i vmask = _mm256_cmpeq_epi8(_mm256_and_si256(vdata, _mm256_cmpeq_epi8(vdata_prev1or2, _mm256_setzero_si256())), v3);
+                const int resmask = _mm256_movemask_epi8(vmask);
+                // hotspot end
+                if (resmask)
+                {
+                    const int offset = count_trailing_zeros((uint64_t) (resmask & 0xFFFFFFFF));
+                    found_epb = true;
+                    m_rbsp.bfr = 3;
+                    return offset + i + c + 1;
+                }
+                // hotspot begin
+                __m256i vdata_next = _mm256_loadu_si256((const __m256i*)&pdatain[i + c + 32]);
+                __m256i vdata_alignr16b_next = _mm256_permute2f128_si256(vdata, vdata_next, 1 | (2<<4));
+                vdata_prev1 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 15);
+                vdata_prev2 = _mm256_alignr_epi8(vdata_next, vdata_alignr16b_next, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        m_rbsp.bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    uint32_t bfr = m_rbsp.bfr;
+    do
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 3) {
+            break;
+        }
+    } while (i < datasize);
+    m_rbsp.bfr = bfr;
+    found_epb = ((bfr & 0x00ffffff) == 3);
+    return i;
+}
+
 #endif
\ No newline at end of file
@@ -67,4 +67,140 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::AVX512>(const uint8_t *pdat
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
+
+template<>
+void VulkanVideoDecoder::index_start_codes<SIMD_ISA::AVX512>(const uint8_t *pdatain, size_t datasize)
+{
+    size_t i = 0;
+    size_t datasize128 = (datasize >> 7) << 7;
+    uint32_t bfr = m_BitBfr;
+    m_StartCodes.clear();
+    if (datasize >= 64)
+    {
+        const __m512i v1 = _mm512_set1_epi8(1);
+        const __m512i v254 = _mm512_set1_epi8(-2);
+        __m512i vdata = _mm512_loadu_si512((const void*)pdatain);
+        __m512i vBfr = _mm512_set1_epi16(((bfr << 8) & 0xFF00) | ((bfr >> 8) & 0xFF));
+        __m512i vdata_alignr48b_init = _mm512_alignr_epi32(vdata, vBfr, 12);
+        __m512i vdata_prev1 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 15);
+        __m512i vdata_prev2 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 14);
+        for ( ; (i + 128) < datasize128; i += 128)
+        {
+            for (int c = 0; c < 128; c += 64)
+            {
+                // hotspot begin
+                __m512i vmask0 = _mm512_ternarylogic_epi64(vdata_prev2, vdata_prev1, vdata, 0x2);
+                __m512i vmask1 = _mm512_ternarylogic_epi64(vdata_prev2, vdata_prev1, vdata, 0xFE);
+                uint64_t resmask = _mm512_cmpeq_epi8_mask(_mm512_ternarylogic_epi64(vmask0, v254, vmask1, 0xF8), v1);
+                // hotspot end
+                while (resmask)
+                {
+                    add_start_code(count_trailing_zeros(resmask) + i + c + 1);
+                    resmask &= resmask - 1;
+                }
+                // hotspot begin
+                __m512i vdata_next = _mm512_loadu_si512((const void*)(&pdatain[i + c + 64]));
+                __m512i vdata_alignr48b_next = _mm512_alignr_epi32(vdata_next, vdata, 12);
+                vdata_prev1 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 15);
+                vdata_prev2 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        // The remaining blocks, the last one partial: small packets (e.g. scatter-gather segments) would
+        // otherwise spend most of their time in the scalar tail. The bytes past the end of the data are
+        // loaded as zeros, which never end a start code.
+        for ( ; ; )
+        {
+            __m512i vmask0 = _mm512_ternarylogic_epi64(vdata_prev2, vdata_prev1, vdata, 0x2);
+            __m512i vmask1 = _mm512_ternarylogic_epi64(vdata_prev2, vdata_prev1, vdata, 0xFE);
+            uint64_t resmask = _mm512_cmpeq_epi8_mask(_mm512_ternarylogic_epi64(vmask0, v254, vmask1, 0xF8), v1);
+            while (resmask)
+            {
+                add_start_code(count_trailing_zeros(resmask) + i + 1);
+                resmask &= resmask - 1;
+            }
+            i += 64;
+            if (i >= datasize)
+            {
+                break;
+            }
+            const size_t remaining = datasize - i;
+            const __mmask64 loadmask = (remaining >= 64) ? ~0ULL : ((1ULL << remaining) - 1);
+            __m512i vdata_next = _mm512_maskz_loadu_epi8(loadmask, (const void*)(&pdatain[i]));
+            __m512i vdata_alignr48b_next = _mm512_alignr_epi32(vdata_next, vdata, 12);
+            vdata_prev1 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 15);
+            vdata_prev2 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 14);
+            vdata = vdata_next;
+        }
+        i = datasize;
+        bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    while (i < datasize)
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 1) {
+            add_start_code(i);
+        }
+    }
+}
+
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesAVX512(const uint8_t *pdatain, size_t datasize)
+{
+    return RemoveEmulationPreventionBytesSimd<SIMD_ISA::AVX512>(pdatain, datasize);
+}
+
+template<>
+size_t VulkanVideoDecoder::next_emulation_prevention_byte<SIMD_ISA::AVX512>(const uint8_t *pdatain, size_t datasize, bool& found_epb)
+{
+    size_t i = 0;
+    size_t datasize128 = (datasize >> 7) << 7;
+    if (datasize128 > 128)
+    {
+        const __m512i v3 = _mm512_set1_epi8(3);
+        __m512i vdata = _mm512_loadu_si512((const void*)pdatain);
+        __m512i vBfr = _mm512_set1_epi16(((m_rbsp.bfr << 8) & 0xFF00) | ((m_rbsp.bfr >> 8) & 0xFF));
+        __m512i vdata_alignr48b_init = _mm512_alignr_epi32(vdata, vBfr, 12);
+        __m512i vdata_prev1 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 15);
+        __m512i vdata_prev2 = _mm512_alignr_epi8(vdata, vdata_alignr48b_init, 14);
+        for ( ; i < datasize128 - 128; i += 128)
+        {
+            for (int c = 0; c < 128; c += 64)
+            {
+                // hotspot begin
+                __m512i vdata_prev1or2 = _mm512_or_si512(vdata_prev2, vdata_prev1);
+                const uint64_t resmask = _mm512_mask_cmpeq_epi8_mask(_mm512_testn_epi8_mask(vdata_prev1or2, vdata_prev1or2), vdata, v3);
+                // hotspot end
+                if (resmask)
+                {
+                    const int offset = count_trailing_zeros(resmask);
+                    found_epb = true;
+                    m_rbsp.bfr = 3;
+                    return offset + i + c + 1;
+                }
+                // hotspot begin
+                __m512i vdata_next = _mm512_loadu_si512((const void*)(&pdatain[i + c + 64]));
+                __m512i vdata_alignr48b_next = _mm512_alignr_epi32(vdata_next, vdata, 12);
+                vdata_prev1 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 15);
+                vdata_prev2 = _mm512_alignr_epi8(vdata_next, vdata_alignr48b_next, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        m_rbsp.bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    uint32_t bfr = m_rbsp.bfr;
+    do
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 3) {
+            break;
+        }
+    } while (i < datasize);
+    m_rbsp.bfr = bfr;
+    found_epb = ((bfr & 0x00ffffff) == 3);
+    return i;
+}
 #endif
\ No newline at end of file
@@ -23,4 +23,42 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::NOSIMD>(const uint8_t *pdat
     m_BitBfr = bfr;
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
+}
+
+template<>
+void VulkanVideoDecoder::index_start_codes<SIMD_ISA::NOSIMD>(const uint8_t *pdatain, size_t datasize)
+{
+    uint32_t bfr = m_BitBfr;
+    size_t i = 0;
+    m_StartCodes.clear();
+    // process a tail (rest):
+    while (i < datasize)
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 1) {
+            add_start_code(i);
+        }
+    }
+}
+
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesC(const uint8_t *pdatain, size_t datasize)
+{
+    return RemoveEmulationPreventionBytesSimd<SIMD_ISA::NOSIMD>(pdatain, datasize);
+}
+
+template<>
+size_t VulkanVideoDecoder::next_emulation_prevention_byte<SIMD_ISA::NOSIMD>(const uint8_t *pdatain, size_t datasize, bool& found_epb)
+{
+    uint32_t bfr = m_rbsp.bfr;
+    size_t i = 0;
+    do
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 3) {
+            break;
+        }
+    } while (i < datasize);
+    m_rbsp.bfr = bfr;
+    found_epb = ((bfr & 0x00ffffff) == 3);
+    return i;
 }
\ No newline at end of file
@@ -61,4 +61,130 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SSSE3>(const uint8_t *pdata
     found_start_code = ((bfr & 0x00ffffff) == 1);
     return i;
 }
+
+template<>
+void VulkanVideoDecoder::index_start_codes<SIMD_ISA::SSSE3>(const uint8_t *pdatain, size_t datasize)
+{
+    size_t i = 0;
+    size_t datasize32 = (datasize >> 5) << 5;
+    uint32_t bfr = m_BitBfr;
+    m_StartCodes.clear();
+    if (datasize32 >= 32)
+    {
+        const __m128i v1 = _mm_set1_epi8(1);
+        __m128i vdata = _mm_loadu_si128((const __m128i*)pdatain);
+        __m128i vBfr = _mm_set1_epi16(((bfr << 8) & 0xFF00) | ((bfr >> 8) & 0xFF));
+        __m128i vdata_prev1 = _mm_alignr_epi8(vdata, vBfr, 15);
+        __m128i vdata_prev2 = _mm_alignr_epi8(vdata, vBfr, 14);
+        for ( ; i < datasize32 - 32; i += 32)
+        {
+            for (int c = 0; c < 32; c += 16)
+            {
+                // hotspot begin
+                __m128i vdata_prev1or2 = _mm_or_si128(vdata_prev2, vdata_prev1);
+                __m128i vmask = _mm_cmpeq_epi8(_mm_and_si128(vdata, _mm_cmpeq_epi8(vdata_prev1or2, _mm_setzero_si128())), v1);
+                uint32_t resmask = (uint32_t)_mm_movemask_epi8(vmask);
+                // hotspot end
+                while (resmask)
+                {
+                    add_start_code(count_trailing_zeros(resmask) + i + c + 1);
+                    resmask &= resmask - 1;
+                }
+                // hotspot begin
+                __m128i vdata_next = _mm_loadu_si128((const __m128i*)&pdatain[i + c + 16]);
+                vdata_prev1 = _mm_alignr_epi8(vdata_next, vdata, 15);
+                vdata_prev2 = _mm_alignr_epi8(vdata_next, vdata, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        // The remaining whole blocks, so that the scalar tail is shorter than a block
+        for ( ; ; )
+        {
+            __m128i vdata_prev1or2 = _mm_or_si128(vdata_prev2, vdata_prev1);
+            __m128i vmask = _mm_cmpeq_epi8(_mm_and_si128(vdata, _mm_cmpeq_epi8(vdata_prev1or2, _mm_setzero_si128())), v1);
+            uint32_t resmask = (uint32_t)_mm_movemask_epi8(vmask);
+            while (resmask)
+            {
+                add_start_code(count_trailing_zeros(resmask) + i + 1);
+                resmask &= resmask - 1;
+            }
+            i += 16;
+            if ((i + 16) > datasize)
+            {
+                break;
+            }
+            __m128i vdata_next = _mm_loadu_si128((const __m128i*)&pdatain[i]);
+            vdata_prev1 = _mm_alignr_epi8(vdata_next, vdata, 15);
+            vdata_prev2 = _mm_alignr_epi8(vdata_next, vdata, 14);
+            vdata = vdata_next;
+        }
+        bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    while (i < datasize)
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 1) {
+            add_start_code(i);
+        }
+    }
+}
+
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesSSSE3(const uint8_t *pdatain, size_t datasize)
+{
+    return RemoveEmulationPreventionBytesSimd<SIMD_ISA::SSSE3>(pdatain, datasize);
+}
+
+template<>
+size_t VulkanVideoDecoder::next_emulation_prevention_byte<SIMD_ISA::SSSE3>(const uint8_t *pdatain, size_t datasize, bool& found_epb)
+{
+    size_t i = 0;
+    size_t datasize32 = (datasize >> 5) << 5;
+    if (datasize32 > 32)
+    {
+        const __m128i v3 = _mm_set1_epi8(3);
+        __m128i vdata = _mm_loadu_si128((const __m128i*)pdatain);
+        __m128i vBfr = _mm_set1_epi16(((m_rbsp.bfr << 8) & 0xFF00) | ((m_rbsp.bfr >> 8) & 0xFF));
+        __m128i vdata_prev1 = _mm_alignr_epi8(vdata, vBfr, 15);
+        __m128i vdata_prev2 = _mm_alignr_epi8(vdata, vBfr, 14);
+        for ( ; i < datasize32 - 32; i += 32)
+        {
+            for (int c = 0; c < 32; c += 16)
+            {
+                // hotspot begin
+                __m128i vdata_prev1or2 = _mm_or_si128(vdata_prev2, vdata_prev1);
+                __m128i vmask = _mm_cmpeq_epi8(_mm_and_si128(vdata, _mm_cmpeq_epi8(vdata_prev1or2, _mm_setzero_si128())), v3);
+                const int resmask = _mm_movemask_epi8(vmask);
+                // hotspot end
+                if (resmask)
+                {
+                    const int offset = count_trailing_zeros((uint64_t) (resmask & 0xFFFFFFFF));
+                    found_epb = true;
+                    m_rbsp.bfr = 3;
+                    return offset + i + c + 1;
+                }
+                // hotspot begin
+                __m128i vdata_next = _mm_loadu_si128((const __m128i*)&pdatain[i + c + 16]);
+                vdata_prev1 = _mm_alignr_epi8(vdata_next, vdata, 15);
+                vdata_prev2 = _mm_alignr_epi8(vdata_next, vdata, 14);
+                vdata = vdata_next;
+                // hotspot end
+            }
+        } // main processing loop end
+        m_rbsp.bfr = (pdatain[i-2] << 8) | pdatain[i-1];
+    }
+    // process a tail (rest):
+    uint32_t bfr = m_rbsp.bfr;
+    do
+    {
+        bfr = (bfr << 8) | pdatain[i++];
+        if ((bfr & 0x00ffffff) == 3) {
+            break;
+        }
+    } while (i < datasize);
+    m_rbsp.bfr = bfr;
+    found_epb = ((bfr & 0x00ffffff) == 3);
+    return i;
+}
 #endif
\ No newline at end of file
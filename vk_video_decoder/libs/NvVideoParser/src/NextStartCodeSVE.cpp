@@ -70,4 +70,126 @@ size_t VulkanVideoDecoder::next_start_code<SIMD_ISA::SVE>(const uint8_t *pdatain
     return datasize;
 }
 #undef SVE_REGISTER_MAX_BYTES
+
+#define SVE_REGISTER_MAX_BYTES 256 // 2048 bits
+template<>
+void VulkanVideoDecoder::index_start_codes<SIMD_ISA::SVE>(const uint8_t *pdatain, size_t datasize)
+{
+    size_t i = 0;
+    m_StartCodes.clear();
+    {
+        static const int lanes = (int)svcntb();
+
+        svbool_t pred = svwhilelt_b8_u64(i, datasize);
+        svbool_t pred_next = svpfalse_b();
+
+        svuint8_t vdata = svld1_u8(pred, pdatain);
+        svuint8_t vBfr = svreinterpret_u8_u16(svdup_n_u16(((m_BitBfr << 8) & 0xFF00) | ((m_BitBfr >> 8) & 0xFF)));
+
+        static uint8_t data0n[SVE_REGISTER_MAX_BYTES];
+        static uint8_t isArrayFilled = 0;
+        if (!isArrayFilled)
+        {
+            for (int idx = 0; idx < lanes; idx++)
+            {
+                data0n[idx] = idx;
+            }
+            isArrayFilled = 1;
+        }
+        svuint8_t v0n = svld1_u8(svptrue_b8(), data0n);
+
+        const svbool_t vext15_mask = svcmpge_n_u8(svptrue_b8(), v0n, lanes-1);
+        const svbool_t vext14_mask = svcmpge_n_u8(svptrue_b8(), v0n, lanes-2);
+        svuint8_t vdata_prev1 = svsplice_u8(vext15_mask, vBfr, vdata);
+        svuint8_t vdata_prev2 = svsplice_u8(vext14_mask, vBfr, vdata);
+
+        for ( ; i < datasize; i += lanes)
+        {
+            // hotspot begin
+            svuint8_t vdata_prev1or2 = svorr_u8_z(pred, vdata_prev2, vdata_prev1);
+            svbool_t vmask = svcmpeq_n_u8(svcmpeq_n_u8(pred, vdata_prev1or2, 0), vdata, 1);
+            // hotspot end
+            while (svptest_any(pred, vmask))
+            {
+                const uint8_t offset = svminv_u8(vmask, v0n);
+                add_start_code((size_t)offset + i + 1);
+                vmask = svcmpgt_n_u8(vmask, v0n, offset);
+            }
+            // hotspot begin
+            pred_next = svwhilelt_b8_u64(i + lanes, datasize);
+            svuint8_t vdata_next = svld1_u8(pred_next, &pdatain[i + lanes]);
+            vdata_prev1 = svsplice_u8(vext15_mask, vdata, vdata_next);
+            vdata_prev2 = svsplice_u8(vext14_mask, vdata, vdata_next);
+            pred = pred_next;
+            vdata = vdata_next;
+            // hotspot end
+        }
+    }
+}
+#undef SVE_REGISTER_MAX_BYTES
+
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytesSVE(const uint8_t *pdatain, size_t datasize)
+{
+    return RemoveEmulationPreventionBytesSimd<SIMD_ISA::SVE>(pdatain, datasize);
+}
+
+#define SVE_REGISTER_MAX_BYTES 256 // 2048 bits
+template<>
+size_t VulkanVideoDecoder::next_emulation_prevention_byte<SIMD_ISA::SVE>(const uint8_t *pdatain, size_t datasize, bool& found_epb)
+{
+    size_t i = 0;
+    {
+        static const int lanes = (int)svcntb();
+
+        svbool_t pred = svwhilelt_b8_u64(i, datasize);
+        svbool_t pred_next = svpfalse_b();
+
+        svuint8_t vdata = svld1_u8(pred, pdatain);
+        svuint8_t vBfr = svreinterpret_u8_u16(svdup_n_u16(((m_rbsp.bfr << 8) & 0xFF00) | ((m_rbsp.bfr >> 8) & 0xFF)));
+
+        static uint8_t data0n[SVE_REGISTER_MAX_BYTES];
+        static uint8_t isArrayFilled = 0;
+        if (!isArrayFilled)
+        {
+            for (int idx = 0; idx < lanes; idx++)
+            {
+                data0n[idx] = idx;
+            }
+            isArrayFilled = 1;
+        }
+        svuint8_t v0n = svld1_u8(svptrue_b8(), data0n);
+
+        const svbool_t vext15_mask = svcmpge_n_u8(svptrue_b8(), v0n, lanes-1);
+        const svbool_t vext14_mask = svcmpge_n_u8(svptrue_b8(), v0n, lanes-2);
+        svuint8_t vdata_prev1 = svsplice_u8(vext15_mask, vBfr, vdata);
+        svuint8_t vdata_prev2 = svsplice_u8(vext14_mask, vBfr, vdata);
+
+        for ( ; i < datasize; i += lanes)
+        {
+            // hotspot begin
+            svuint8_t vdata_prev1or2 = svorr_u8_z(pred, vdata_prev2, vdata_prev1);
+            svbool_t vmask = svcmpeq_n_u8(svcmpeq_n_u8(pred, vdata_prev1or2, 0), vdata, 3);
+            // hotspot end
+            if (svptest_any(pred, vmask))
+            {
+                const uint8_t offset = svminv_u8(vmask, v0n);
+                found_epb = true;
+                m_rbsp.bfr = 3;
+                return (size_t)offset + i + 1;
+            }
+            // hotspot begin
+            pred_next = svwhilelt_b8_u64(i + lanes, datasize);
+            svuint8_t vdata_next = svld1_u8(pred_next, &pdatain[i + lanes]);
+            vdata_prev1 = svsplice_u8(vext15_mask, vdata, vdata_next);
+            vdata_prev2 = svsplice_u8(vext14_mask, vdata, vdata_next);
+            pred = pred_next;
+            vdata = vdata_next;
+            // hotspot end
+        }
+    }
+    m_rbsp.bfr = (datasize > 1) ? ((pdatain[datasize-2] << 8) | pdatain[datasize-1]) : ((m_rbsp.bfr << 8) | pdatain[0]);
+    found_epb = false;
+    return datasize;
+}
+#undef SVE_REGISTER_MAX_BYTES
 #endif
\ No newline at end of file
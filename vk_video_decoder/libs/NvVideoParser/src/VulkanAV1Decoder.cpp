@@ -39,6 +39,7 @@ VulkanAV1Decoder::VulkanAV1Decoder(VkVideoCodecOperationFlagBitsKHR std, bool an
     , m_bSPSReceived()
     , m_bSPSChanged()
     , m_obuAnnexB(annexB)
+    , m_bBitstreamDataSubmitted()
     , timing_info_present()
     , timing_info()
     , buffer_model()
@@ -77,7 +78,8 @@ VulkanAV1Decoder::VulkanAV1Decoder(VkVideoCodecOperationFlagBitsKHR std, bool an
     , m_numOutFrames()
     , m_pOutFrame{}
     , m_showableFrame{}
-
+    , m_temporalUnitBytesLeft()
+    , m_frameUnitBytesLeft()
 {
     for (int i = 0; i < STD_VIDEO_AV1_NUM_REF_FRAMES; i++) {
         ref_frame_id[i] = -1;
@@ -105,6 +107,9 @@ void VulkanAV1Decoder::InitParser()
     m_bNoStartCodes = true;
     m_bEmulBytesPresent = false;
     m_bSPSReceived = false;
+    m_bBitstreamDataSubmitted = false;
+    m_temporalUnitBytesLeft = 0;
+    m_frameUnitBytesLeft = 0;
     EndOfStream();
 }
 
@@ -132,7 +137,9 @@ void VulkanAV1Decoder::EndOfStream()
 
 bool VulkanAV1Decoder::AddBuffertoOutputQueue(VkPicIf* pDispPic, bool bShowableFrame)
 {
-    if (m_bOutputAllLayers) {
+    // Immediate output: with a single spatial layer, the frame is the only one of its temporal unit to display
+    const uint32_t spatialLayers = (uint32_t)m_OperatingPointIDCActive >> 8;
+    if (m_bOutputAllLayers || (m_bLowLatencyOutput && ((spatialLayers & (spatialLayers - 1)) == 0))) {
 /*
         if (m_numOutFrames >= MAX_NUM_SPATIAL_LAYERS)
         {
@@ -206,6 +213,14 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
 {
 	StdVideoDecodeAV1PictureInfo const* pStd = &m_PicData.std_info;
 
+    if (is_picture_filtered((pStd->frame_type == STD_VIDEO_AV1_FRAME_TYPE_KEY) && m_PicData.showFrame,
+                            pStd->refresh_frame_flags != 0)) {
+        // Empty the reference slots the frame would have refreshed, so that no later frame header
+        // (show_existing_frame) finds the frame they held before
+        UpdateFramePointers(nullptr);
+        return true;
+    }
+
     *m_pVkPictureData = VkParserPictureData();
     m_pVkPictureData->numSlices = m_PicData.tileInfo.TileCols * m_PicData.tileInfo.TileRows;  // set number of tiles as AV1 doesn't have slice concept
 
@@ -213,6 +228,8 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
     m_pVkPictureData->bitstreamData = m_bitstreamData.GetBitstreamBuffer();
     m_pVkPictureData->bitstreamDataOffset = 0; // TODO: The extra storage in this library and necessarily the app is silly.
 
+    // A new sequence header is kept until a picture starts its sequence, also when it came in a temporal
+    // unit of its own (the parameter sets replayed by ParseByteStreamAt())
     m_PicData.needsSessionReset = m_bSPSChanged;
     m_bSPSChanged = false;
 
@@ -226,13 +243,33 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
     }
 
     bool bSkipped = false;
-    if (m_pClient != nullptr) {
+    if (m_bIndexRandomAccessPoints) {
+        // Only shown key frames are random access points, nothing is decoded
+        if ((pStd->frame_type == STD_VIDEO_AV1_FRAME_TYPE_KEY) && m_PicData.showFrame) {
+            VkParserRandomAccessPoint randomAccessPoint = VkParserRandomAccessPoint();
+            randomAccessPoint.type = VK_PARSER_RANDOM_ACCESS_KEY_FRAME;
+            randomAccessPoint.picOrderCnt = pStd->OrderHint;
+            randomAccessPoint.vpsId = -1;
+            randomAccessPoint.spsId = 0;
+            randomAccessPoint.ppsId = -1;
+            for (int k = 0; k < MAX_QUEUED_PTS; k++) {
+                if (m_PTSQueue[k].bPTSValid && (m_PTSQueue[k].llPTSPos == m_llFrameStartLocation)) {
+                    randomAccessPoint.llPTS = m_PTSQueue[k].llPTS;
+                    randomAccessPoint.bPTSValid = true;
+                }
+            }
+            report_random_access_point(&randomAccessPoint);
+        }
+        bSkipped = true;
+    } else if (m_pClient != nullptr) {
         // Notify client
         if (!m_pClient->DecodePicture(m_pVkPictureData)) {
             bSkipped = true;
             // WARNING: skipped decoding current picture;
         } else {
+            picture_decoded(m_pVkPictureData->pCurrPic);
             m_nCallbackEventCount++;
+            m_bBitstreamDataSubmitted = true;
         }
     } else {
         // "WARNING: no valid render target for current picture
@@ -253,26 +290,19 @@ bool VulkanAV1Decoder::end_of_picture(uint32_t frameSize)
     return true;
 }
 
-// BeginPicture
-bool VulkanAV1Decoder::BeginPicture(VkParserPictureData* pnvpd)
+// Sequence information of a sequence header, with the maximum frame size as the coded extent
+void VulkanAV1Decoder::get_sequence_info(const av1_seq_param_s* sps, VkParserSequenceInfo* pnvsi)
 {
-    VkParserAv1PictureData* const av1 = &pnvpd->CodecSpecific.av1;
-    av1_seq_param_s *const sps = m_sps.Get();
-    assert(sps != nullptr);
-
-    av1->upscaled_width = upscaled_width;
-    av1->frame_width = frame_width;
-    av1->frame_height = frame_height;
-
-    VkParserSequenceInfo nvsi = m_ExtSeqInfo;
+    VkParserSequenceInfo& nvsi = *pnvsi;
+    nvsi = m_ExtSeqInfo;
     nvsi.eCodec         = (VkVideoCodecOperationFlagBitsKHR)VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
     nvsi.nChromaFormat  = sps->color_config.flags.mono_chrome ? 0 : (sps->color_config.subsampling_x && sps->color_config.subsampling_y) ? 1 : (!sps->color_config.subsampling_x && !sps->color_config.subsampling_y) ? 3 : 2;
     nvsi.nMaxWidth      = (sps->max_frame_width_minus_1 + 2) & ~1;
     nvsi.nMaxHeight     = (sps->max_frame_height_minus_1 + 2) & ~1;
-    nvsi.nCodedWidth    = upscaled_width;
-    nvsi.nCodedHeight   = frame_height;
-    nvsi.nDisplayWidth  = av1->upscaled_width; // (nvsi.nCodedWidth + 1) & (~1);
-    nvsi.nDisplayHeight = nvsi.nCodedHeight; //(nvsi.nCodedHeight + 1) & (~1);
+    nvsi.nCodedWidth    = sps->max_frame_width_minus_1 + 1;
+    nvsi.nCodedHeight   = sps->max_frame_height_minus_1 + 1;
+    nvsi.nDisplayWidth  = nvsi.nCodedWidth;
+    nvsi.nDisplayHeight = nvsi.nCodedHeight;
     nvsi.bProgSeq = true; // AV1 doesnt have explicit interlaced coding.
 
     nvsi.uBitDepthLumaMinus8 = sps->color_config.BitDepth - 8;
@@ -290,6 +320,27 @@ bool VulkanAV1Decoder::BeginPicture(VkParserPictureData* pnvpd)
     nvsi.lMatrixCoefficients = sps->color_config.matrix_coefficients;
 
     nvsi.hasFilmGrain = sps->flags.film_grain_params_present;
+}
+
+// BeginPicture
+bool VulkanAV1Decoder::BeginPicture(VkParserPictureData* pnvpd)
+{
+    VkParserAv1PictureData* const av1 = &pnvpd->CodecSpecific.av1;
+    av1_seq_param_s *const sps = m_sps.Get();
+    assert(sps != nullptr);
+
+    av1->upscaled_width = upscaled_width;
+    av1->frame_width = frame_width;
+    av1->frame_height = frame_height;
+
+    VkParserSequenceInfo nvsi;
+    get_sequence_info(sps, &nvsi);
+    nvsi.nCodedWidth    = upscaled_width;
+    nvsi.nCodedHeight   = frame_height;
+    nvsi.nDisplayWidth  = av1->upscaled_width; // (nvsi.nCodedWidth + 1) & (~1);
+    nvsi.nDisplayHeight = nvsi.nCodedHeight; //(nvsi.nCodedHeight + 1) & (~1);
+    nvsi.lDARWidth = nvsi.nDisplayWidth;
+    nvsi.lDARHeight = nvsi.nDisplayHeight;
 
     if (av1->needsSessionReset && !init_sequence(&nvsi))
         return false;
@@ -519,7 +570,7 @@ bool VulkanAV1Decoder::ParseOBUHeaderAndSize(const uint8_t* data, uint32_t datas
     }
 
     if (m_obuAnnexB) {
-        if (!ReadObuSize(data, datasize, &annexb_obu_length, &annexb_uleb_length)) {
+        if (!ReadObuSize(data, datasize, &annexb_obu_length, &annexb_uleb_length) || (annexb_uleb_length >= datasize)) {
             return false;
         }
     }
@@ -632,6 +683,7 @@ bool VulkanAV1Decoder::ParseObuSequenceHeader()
         return false;
 
     auto* sps = m_sps.Get();
+    sps->SetContentHash(m_parameterSetHash);
 
 	memset(&sps->color_config, 0, sizeof(sps->color_config));
 	memset(&sps->timing_info, 0, sizeof(sps->timing_info));
@@ -2294,7 +2346,7 @@ bool VulkanAV1Decoder::ParseObuTileGroup(const AV1ObuHeader& hdr)
     return (tg_end == num_tiles - 1);
 }
 
-bool IsObuInCurrentOperatingPoint(int  current_operating_point, AV1ObuHeader *hdr) {
+bool IsObuInCurrentOperatingPoint(int  current_operating_point, const AV1ObuHeader *hdr) {
     if (current_operating_point == 0) return true;
     if (((current_operating_point >> hdr->temporal_id) & 0x1) &&
         ((current_operating_point >> (hdr->spatial_id + 8)) & 0x1)) {
@@ -2306,7 +2358,6 @@ bool IsObuInCurrentOperatingPoint(int  current_operating_point, AV1ObuHeader *hd
 
 bool VulkanAV1Decoder::ParseOneFrame(const uint8_t*const pFrameStart, const int32_t frameSizeBytes, const VkParserBitstreamPacket* pck, int* pParsedBytes)
 {
-    m_bSPSChanged = false;
     AV1ObuHeader hdr;
 
 	const uint8_t* pCurrOBU = pFrameStart;
@@ -2325,83 +2376,152 @@ bool VulkanAV1Decoder::ParseOneFrame(const uint8_t*const pFrameStart, const int3
             return false;
         }
 
-        m_nalu.start_offset += hdr.header_size;
+        if (!ParseObu(pCurrOBU, hdr, frameSizeBytes)) {
+            return false;
+        }
 
-        temporal_id = hdr.temporal_id;
-        spatial_id = hdr.spatial_id;
-        if (hdr.type != AV1_OBU_TEMPORAL_DELIMITER && hdr.type != AV1_OBU_SEQUENCE_HEADER && hdr.type != AV1_OBU_PADDING) {
-            if (!IsObuInCurrentOperatingPoint(m_OperatingPointIDCActive, &hdr)) { // TODO: || !DecodeAllLayers
-                m_nalu.start_offset += hdr.payload_size;
-                pCurrOBU  += (hdr.payload_size + hdr.header_size);
-                remainingFrameBytes -= (hdr.payload_size + hdr.header_size);
-                continue;
-            }
+        pCurrOBU += (hdr.payload_size + hdr.header_size);
+        remainingFrameBytes -= (hdr.payload_size + hdr.header_size);
+
+        assert(remainingFrameBytes >= 0);
+    }
+
+    if (pParsedBytes) { // TODO: How is this useful with a boolean return value?
+        *pParsedBytes += (int)pck->nDataLength;
+    }
+
+    return true;
+}
+
+// Parses the complete OBU at m_nalu.start_offset (pCurrOBU in memory), and moves m_nalu.start_offset past it.
+// The pictures it ends hold the first pictureDataLen bytes of the bitstream buffer.
+bool VulkanAV1Decoder::ParseObu(const uint8_t* pCurrOBU, const AV1ObuHeader& hdr, uint32_t pictureDataLen)
+{
+    m_nalu.start_offset += hdr.header_size;
+
+    temporal_id = hdr.temporal_id;
+    spatial_id = hdr.spatial_id;
+    if (hdr.type != AV1_OBU_TEMPORAL_DELIMITER && hdr.type != AV1_OBU_SEQUENCE_HEADER && hdr.type != AV1_OBU_PADDING) {
+        if (!IsObuInCurrentOperatingPoint(m_OperatingPointIDCActive, &hdr)) { // TODO: || !DecodeAllLayers
+            m_nalu.start_offset += hdr.payload_size;
+            return true;
+        }
+        // Temporal sub-layer decimation: the limit is raised after the header of a shown key frame
+        const bool bFrameStart = (hdr.type == AV1_OBU_FRAME_HEADER) || (hdr.type == AV1_OBU_FRAME);
+        if (bFrameStart) {
+            update_temporal_layer_limit(hdr.temporal_id, TEMPORAL_SWITCH_NONE);
+        }
+        if (is_temporal_layer_dropped(hdr.temporal_id, bFrameStart)) {
+            m_nalu.start_offset += hdr.payload_size;
+            return true;
         }
+    }
 
 		// Prime the bit buffer with the 4 bytes
-        init_dbits();
-        switch (hdr.type) {
-        case AV1_OBU_TEMPORAL_DELIMITER:
-            ParseObuTemporalDelimiter();
+    init_dbits();
+    switch (hdr.type) {
+    case AV1_OBU_TEMPORAL_DELIMITER:
+        ParseObuTemporalDelimiter();
 			memset(m_PicData.tileOffsets, 0, sizeof(m_PicData.tileOffsets));
 			memset(m_PicData.tileSizes, 0, sizeof(m_PicData.tileSizes));
 			m_PicData.khr_info.tileCount = 0;
-            break;
+        break;
 
-        case AV1_OBU_SEQUENCE_HEADER:
-            ParseObuSequenceHeader();
-            break;
+    case AV1_OBU_SEQUENCE_HEADER:
+        if (!is_parameter_set_repeat(PARAMETER_SET_SPS, pCurrOBU, hdr.header_size + hdr.payload_size) &&
+            ParseObuSequenceHeader()) {
+            save_parameter_set(PARAMETER_SET_SPS, 0, pCurrOBU, hdr.header_size + hdr.payload_size);
+        }
+        break;
 
-        case AV1_OBU_FRAME_HEADER:
-        case AV1_OBU_FRAME:
-        {
+    case AV1_OBU_FRAME_HEADER:
+    case AV1_OBU_FRAME:
+    {
 			memset(m_PicData.tileOffsets, 0, sizeof(m_PicData.tileOffsets));
 			m_PicData.khr_info.tileCount = 0;
 			memset(m_PicData.tileSizes, 0, sizeof(m_PicData.tileSizes));
 
-            ParseObuFrameHeader();
+        ParseObuFrameHeader();
+        if (!show_existing_frame && (m_PicData.std_info.frame_type == STD_VIDEO_AV1_FRAME_TYPE_KEY) && m_PicData.showFrame) {
+            update_temporal_layer_limit(hdr.temporal_id, TEMPORAL_SWITCH_ALL);
+        }
 
-            if (show_existing_frame) break;
-            if (hdr.type != AV1_OBU_FRAME) {
-                rbsp_trailing_bits();
-            }
+        if (show_existing_frame) break;
+        if (hdr.type != AV1_OBU_FRAME) {
+            rbsp_trailing_bits();
+        }
 
-            if (hdr.type != AV1_OBU_FRAME) break;
+        if (hdr.type != AV1_OBU_FRAME) break;
 
 			byte_alignment();
-        }   // fall through
+    }   // fall through
 
-        case AV1_OBU_TILE_GROUP:
-        {
-            if (ParseObuTileGroup(hdr)) {
+    case AV1_OBU_TILE_GROUP:
+    {
+        if (ParseObuTileGroup(hdr)) {
 				// Last tile group for this frame
-                if (!end_of_picture(frameSizeBytes))
-                    return false;
-            }
-
-            break;
-        }
-        case AV1_OBU_REDUNDANT_FRAME_HEADER:
-        case AV1_OBU_PADDING:
-        case AV1_OBU_METADATA:
-        default:
-            break;
+            if (!end_of_picture(pictureDataLen))
+                return false;
         }
 
+        break;
+    }
+    case AV1_OBU_REDUNDANT_FRAME_HEADER:
+    case AV1_OBU_PADDING:
+    case AV1_OBU_METADATA:
+    default:
+        break;
+    }
+
 		// The header was skipped over to parse the payload.
-        m_nalu.start_offset += hdr.payload_size;
+    m_nalu.start_offset += hdr.payload_size;
 
-        pCurrOBU += (hdr.payload_size + hdr.header_size);
-        remainingFrameBytes -= (hdr.payload_size + hdr.header_size);
+    return true;
+}
 
-        assert(remainingFrameBytes >= 0);
-    }
+bool VulkanAV1Decoder::ProbeSequenceInfo(const VkParserBitstreamPacket* pck, VkParserSequenceInfo* pSequenceInfo, size_t* pParsedBytes)
+{
+    const uint8_t* pCurrOBU = pck->pByteStream;
+    int32_t remainingBytes = (int32_t)pck->nDataLength;
+    AV1ObuHeader hdr;
 
-    if (pParsedBytes) { // TODO: How is this useful with a boolean return value?
-        *pParsedBytes += (int)pck->nDataLength;
+    if (pParsedBytes) {
+        *pParsedBytes = 0;
+    }
+    if ((m_bitstreamData.GetBitstreamPtr() == nullptr) || (m_llParsedBytes != 0)) {
+        return false;
     }
 
-    return true;
+    while (remainingBytes > 0) {
+        memset(&hdr, 0, sizeof(hdr));
+        if (!ParseOBUHeaderAndSize(pCurrOBU, remainingBytes, &hdr) ||
+            (remainingBytes < int32_t(hdr.payload_size + hdr.header_size))) {
+            // Invalid or truncated OBU
+            return false;
+        }
+        const uint32_t obuSize = hdr.payload_size + hdr.header_size;
+        if (hdr.type == AV1_OBU_SEQUENCE_HEADER) {
+            if ((obuSize > m_bitstreamDataLen) && !resizeBitstreamBuffer(obuSize - m_bitstreamDataLen)) {
+                return false;
+            }
+            memcpy(m_bitstreamData.GetBitstreamPtr(), pCurrOBU, obuSize);
+            m_nalu.start_offset = hdr.header_size;
+            m_nalu.end_offset = obuSize;
+            init_dbits();
+            m_parameterSetHash = 0;
+            if (!ParseObuSequenceHeader()) {
+                return false;
+            }
+            get_sequence_info(m_sps.Get(), pSequenceInfo);
+            if (pParsedBytes) {
+                *pParsedBytes = (pCurrOBU + obuSize) - pck->pByteStream;
+            }
+            return true;
+        }
+        pCurrOBU += obuSize;
+        remainingBytes -= obuSize;
+    }
+    return false;
 }
 
 bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_t* pParsedBytes)
@@ -2419,6 +2539,10 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         return false;
     }
 
+    if (m_bStreamingInput || m_obuAnnexB) {
+        return ParseStreamData(pck, pParsedBytes);
+    }
+
     m_nCallbackEventCount = 0;
 
     // Handle discontinuity
@@ -2442,6 +2566,10 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         uint32_t frame_size = 0;
         frame_size = datasize;
 
+        // Scatter-gather input already is in a buffer the client is done with
+        if ((pdataStart != m_bitstreamData.GetBitstreamPtr()) && !NextBitstreamBuffer(0, 0)) {
+            return false;
+        }
         if (frame_size > (uint32_t)m_bitstreamDataLen) {
             if (!resizeBitstreamBuffer(frame_size - (m_bitstreamDataLen))) {
                 // Error: Failed to resize bitstream buffer
@@ -2452,7 +2580,10 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         if (datasize > 0) {
             m_nalu.start_offset = 0;
             m_nalu.end_offset = frame_size;
-            memcpy(m_bitstreamData.GetBitstreamPtr(), pdataStart, frame_size);
+            // Scatter-gather input already is in the bitstream buffer
+            if (pdataStart != m_bitstreamData.GetBitstreamPtr()) {
+                memcpy(m_bitstreamData.GetBitstreamPtr(), pdataStart, frame_size);
+            }
             m_llNaluStartLocation = m_llFrameStartLocation = m_llParsedBytes; // TODO: NaluStart and FrameStart are always the same here
             m_llParsedBytes += frame_size;
 
@@ -2474,7 +2605,19 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         }
     }
 
-    // display frames from output queue
+    OutputTemporalUnit();
+
+    // flush if EOS set
+    if (pck->bEOS) {
+        end_of_stream();
+    }
+
+    return true;
+}
+
+// display frames from output queue
+void VulkanAV1Decoder::OutputTemporalUnit()
+{
     int index = 0;
     while (index < m_numOutFrames) {
         AddBuffertoDispQueue(m_pOutFrame[index]);
@@ -2486,6 +2629,64 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
         index++;
     }
     m_numOutFrames = 0;
+}
+
+// Byte stream input: the packet data is appended to the bytes of the current temporal unit, and the complete
+// OBUs are parsed right away. The temporal unit stays at the start of the bitstream buffer, as with one
+// temporal unit per packet: its first byte only moves there once the previous one is over.
+bool VulkanAV1Decoder::ParseStreamData(const VkParserBitstreamPacket* pck, size_t* pParsedBytes)
+{
+    m_nCallbackEventCount = 0;
+
+    // Handle discontinuity: the buffered bytes are dropped, the packet starts a new temporal unit
+    if (pck->bDiscontinuity) {
+        memset(&m_nalu, 0, sizeof(m_nalu));
+        memset(&m_PTSQueue, 0, sizeof(m_PTSQueue));
+        m_temporalUnitBytesLeft = 0;
+        m_frameUnitBytesLeft = 0;
+        m_bDiscontinuityReported = true;
+    }
+
+    if (pck->bPTSValid) {
+        m_PTSQueue[m_lPTSPos].bPTSValid = true;
+        m_PTSQueue[m_lPTSPos].llPTS = pck->llPTS;
+        m_PTSQueue[m_lPTSPos].llPTSPos = m_llParsedBytes;
+        m_PTSQueue[m_lPTSPos].bDiscontinuity = m_bDiscontinuityReported;
+        m_bDiscontinuityReported = false;
+        m_lPTSPos = (m_lPTSPos + 1) % MAX_QUEUED_PTS;
+    }
+
+    if (pck->nDataLength > 0) {
+        const VkDeviceSize dataEnd = m_nalu.end_offset + pck->nDataLength;
+        if ((dataEnd > m_bitstreamDataLen) && !resizeBitstreamBuffer(dataEnd - m_bitstreamDataLen)) {
+            // Error: Failed to resize bitstream buffer
+            return false;
+        }
+        memcpy(m_bitstreamData.GetBitstreamPtr() + m_nalu.end_offset, pck->pByteStream, pck->nDataLength);
+        m_nalu.end_offset = dataEnd;
+        m_llParsedBytes += pck->nDataLength;
+    }
+
+    const bool bEndOfData = pck->bEOP || pck->bEOS;
+    if (!ParseStreamObus(bEndOfData)) {
+        // The rest of the buffered bytes can't be parsed, they are dropped
+        memset(&m_nalu, 0, sizeof(m_nalu));
+        m_temporalUnitBytesLeft = 0;
+        m_frameUnitBytesLeft = 0;
+        return false;
+    }
+
+    if (pParsedBytes) {
+        *pParsedBytes = pck->nDataLength;
+    }
+
+    // The end of the packet is the end of the temporal unit
+    if (bEndOfData) {
+        OutputTemporalUnit();
+        memset(&m_nalu, 0, sizeof(m_nalu));
+        m_temporalUnitBytesLeft = 0;
+        m_frameUnitBytesLeft = 0;
+    }
 
     // flush if EOS set
     if (pck->bEOS) {
@@ -2495,4 +2696,153 @@ bool VulkanAV1Decoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_
     return true;
 }
 
+// Parses the complete OBUs buffered from m_nalu.start_offset. Returns false if the bytes are not a valid
+// byte stream; without bEndOfData, a truncated OBU or size field at the end only waits for the next packet.
+bool VulkanAV1Decoder::ParseStreamObus(bool bEndOfData)
+{
+    // OBU header and size fields: obu_length (Annex B), obu_header(), obu_extension_header() and obu_size
+    const uint32_t maxObuHeaderSize = (m_obuAnnexB ? 8 : 0) + 2 + 8;
+
+    while (m_nalu.start_offset < m_nalu.end_offset) {
+        const uint8_t* pCurrOBU = m_bitstreamData.GetBitstreamPtr() + m_nalu.start_offset;
+        const uint32_t remainingBytes = (uint32_t)std::min<int64_t>(m_nalu.end_offset - m_nalu.start_offset, UINT32_MAX);
+
+        if (m_obuAnnexB && ((m_temporalUnitBytesLeft == 0) || (m_frameUnitBytesLeft == 0))) {
+            uint32_t unitSize = 0, unitSizeLength = 0;
+            if (!ReadObuSize(pCurrOBU, remainingBytes, &unitSize, &unitSizeLength)) {
+                // leb128() fields are up to 8 bytes long
+                return !bEndOfData && (remainingBytes < 8);
+            }
+            if (m_temporalUnitBytesLeft == 0) {
+                // temporal_unit_size: the previous temporal unit is over
+                OutputTemporalUnit();
+                StartTemporalUnit();
+                m_nalu.start_offset += unitSizeLength;
+                m_temporalUnitBytesLeft = unitSize;
+            } else {
+                // frame_unit_size
+                if (unitSizeLength + unitSize > m_temporalUnitBytesLeft) {
+                    return false;
+                }
+                m_nalu.start_offset += unitSizeLength;
+                m_temporalUnitBytesLeft -= unitSizeLength;
+                m_frameUnitBytesLeft = unitSize;
+            }
+            continue;
+        }
+
+        if (!m_obuAnnexB && (pCurrOBU[0] == 0)) {
+            // Allow extra zero bytes after the frame end
+            m_nalu.start_offset++;
+            continue;
+        }
+
+        AV1ObuHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        if (!ParseOBUHeaderAndSize(pCurrOBU, remainingBytes, &hdr)) {
+            return !bEndOfData && (remainingBytes < maxObuHeaderSize);
+        }
+        const uint32_t obuSize = hdr.header_size + hdr.payload_size;
+        if (m_obuAnnexB && (obuSize > m_frameUnitBytesLeft)) {
+            return false;
+        }
+        if (obuSize > remainingBytes) {
+            // Truncated OBU
+            return !bEndOfData;
+        }
+
+        if (!m_obuAnnexB && (hdr.type == AV1_OBU_TEMPORAL_DELIMITER)) {
+            OutputTemporalUnit();
+            StartTemporalUnit();
+            pCurrOBU = m_bitstreamData.GetBitstreamPtr();
+        }
+
+        // The pictures of the temporal unit end with this OBU
+        if (!ParseObu(pCurrOBU, hdr, (uint32_t)m_nalu.start_offset + obuSize)) {
+            return false;
+        }
+
+        if (m_obuAnnexB) {
+            m_frameUnitBytesLeft -= obuSize;
+            m_temporalUnitBytesLeft -= obuSize;
+            if (m_temporalUnitBytesLeft == 0) {
+                OutputTemporalUnit();
+            }
+        }
+    }
+
+    return true;
+}
+
+// Moves the bytes buffered from m_nalu.start_offset, the start of the next temporal unit, to the start of the
+// bitstream buffer, where the pictures of the previous temporal unit were.
+void VulkanAV1Decoder::StartTemporalUnit()
+{
+    const int64_t bufferedBytes = m_nalu.end_offset - m_nalu.start_offset;
+    if (m_bBitstreamDataSubmitted) {
+        // The bytes go to the start of another buffer, the client may still read the previous one
+        NextBitstreamBuffer((VkDeviceSize)m_nalu.start_offset, (VkDeviceSize)bufferedBytes);
+        m_nalu.start_offset = 0;
+        m_nalu.end_offset = bufferedBytes;
+    } else if (m_nalu.start_offset > 0) {
+        uint8_t* pData = m_bitstreamData.GetBitstreamPtr();
+        memmove(pData, pData + m_nalu.start_offset, (size_t)bufferedBytes);
+        m_nalu.start_offset = 0;
+        m_nalu.end_offset = bufferedBytes;
+    }
+    m_llNaluStartLocation = m_llFrameStartLocation = m_llParsedBytes - bufferedBytes;
+}
+
+// The temporal units are written at the start of the bitstream buffer. Once pictures of the buffer have been
+// handed to the client, which may decode them later (VulkanVideoParser's pipelined mode), the next temporal unit
+// takes a buffer from the client instead, with a copy of the copySize bytes at copyOffset.
+bool VulkanAV1Decoder::NextBitstreamBuffer(VkDeviceSize copyOffset, VkDeviceSize copySize)
+{
+    if (!m_bBitstreamDataSubmitted) {
+        return true;
+    }
+    m_bBitstreamDataSubmitted = false;
+    m_bitstreamDataLen = swapBitstreamBuffer(copyOffset, copySize);
+    return (m_bitstreamDataLen != 0);
+}
+
+// A packet holds a whole temporal unit, which is parsed in place: the segments are
+// gathered right into the bitstream buffer, instead of ParseByteStream() copying them.
+bool VulkanAV1Decoder::ParseByteStreamSegments(const VkParserBitstreamPacket* pck, const VkParserBitstreamSegment* pSegments,
+                                               uint32_t numSegments, size_t* pParsedBytes)
+{
+    if (pParsedBytes) {
+        *pParsedBytes = 0;
+    }
+    if (m_bitstreamData.GetBitstreamPtr() == nullptr) {
+        return false;
+    }
+    // The segments are parts of the byte stream, as any other packet
+    if (m_bStreamingInput || m_obuAnnexB) {
+        return VulkanVideoDecoder::ParseByteStreamSegments(pck, pSegments, numSegments, pParsedBytes);
+    }
+    size_t dataSize = 0;
+    for (uint32_t i = 0; i < numSegments; i++) {
+        dataSize += pSegments[i].size;
+    }
+    if (!NextBitstreamBuffer(0, 0) ||
+        ((dataSize > (size_t)m_bitstreamDataLen) && !resizeBitstreamBuffer(dataSize - m_bitstreamDataLen))) {
+        return false;
+    }
+    uint8_t* pData = m_bitstreamData.GetBitstreamPtr();
+    size_t offset = 0;
+    for (uint32_t i = 0; i < numSegments; i++) {
+        if (pSegments[i].size > 0) {
+            memcpy(pData + offset, pSegments[i].pData, pSegments[i].size);
+            offset += pSegments[i].size;
+        }
+    }
+    VkParserBitstreamPacket packet = *pck;
+    packet.pByteStream = pData;
+    packet.nDataLength = dataSize;
+    packet.pBitstreamBuffer = nullptr;
+    packet.bitstreamBufferOffset = 0;
+    return ParseByteStream(&packet, pParsedBytes);
+}
+
 const char* av1_seq_param_s::m_refClassId = "av1SpsVideoPictureParametersSet";
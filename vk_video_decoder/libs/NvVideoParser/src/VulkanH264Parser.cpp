@@ -60,6 +60,19 @@ enum Nal_Unit_Type
 static inline int Min(int x, int y) { return (x <= y) ? x : y; } // (5-11)
 static inline int Max(int x, int y) { return (x >= y) ? x : y; } // (5-12)
 
+// Units of the frame cropping offsets, from ChromaArrayType (7-19 to 7-22)
+static inline int CropUnitX(const seq_parameter_set_s* sps)
+{
+    const bool hasChroma = !sps->flags.separate_colour_plane_flag && (sps->chroma_format_idc != 0);
+    return (hasChroma && (sps->chroma_format_idc != 3)) ? 2 : 1; // SubWidthC
+}
+
+static inline int CropUnitY(const seq_parameter_set_s* sps)
+{
+    const bool hasChroma = !sps->flags.separate_colour_plane_flag && (sps->chroma_format_idc != 0);
+    return ((hasChroma && (sps->chroma_format_idc == 1)) ? 2 : 1) * (2 - sps->flags.frame_mbs_only_flag); // SubHeightC
+}
+
 VulkanH264Decoder::VulkanH264Decoder(VkVideoCodecOperationFlagBitsKHR std)
   : VulkanVideoDecoder(std),
     m_pParserData(NULL),
@@ -67,10 +80,12 @@ VulkanH264Decoder::VulkanH264Decoder(VkVideoCodecOperationFlagBitsKHR std)
     m_prefix_nalu_valid(false),
     m_spsme(NULL),
     m_bUseMVC(false),
+    m_pMvcState(NULL),
     m_bUseSVC(false),
+    m_bSvcSupported(false),
+    m_pSvcState(NULL),
     m_slice_group_map()
 {
-    memset(m_spsmes, 0, sizeof(m_spsmes));
     memset(&m_nhe, 0, sizeof(nalu_header_extension_u));
 }
 
@@ -83,6 +98,10 @@ VulkanH264Decoder::~VulkanH264Decoder()
         m_slice_group_map = nullptr;
     }
 
+    delete m_pMvcState;
+    m_pMvcState = NULL;
+    delete m_pSvcState;
+    m_pSvcState = NULL;
 }
 
 
@@ -113,31 +132,68 @@ void VulkanH264Decoder::InitParser()
     m_MaxDpbSize = 0;
     decoder_caps = (m_pClient) ? m_pClient->GetDecodeCaps() : 0;
     m_bUseMVC = !!(decoder_caps & VK_PARSER_CAPS_MVC);
-    m_bUseSVC = !!(decoder_caps & VK_PARSER_CAPS_SVC);
+    // The SVC decoding process only starts with the first SVC NAL unit (see alloc_extension_state())
+    m_bUseSVC = false;
+    m_bSvcSupported = !!(decoder_caps & VK_PARSER_CAPS_SVC);
     m_aso = false;
 }
 
+// The MVC/SVC state is only allocated by the first prefix NAL unit, subset SPS or coded slice
+// extension of the stream, so that plain AVC streams never pay for it.
+void VulkanH264Decoder::alloc_extension_state(int nal_unit_type)
+{
+    if ((nal_unit_type != NAL_UNIT_CODED_SLICE_PREFIX) && (nal_unit_type != NAL_UNIT_SUBSET_SPS) &&
+        (nal_unit_type != NAL_UNIT_CODED_SLICE_SCALABLE))
+    {
+        return;
+    }
+    if (m_bUseMVC && !m_pMvcState)
+    {
+        m_pMvcState = new H264MvcState();
+    }
+    if (m_bSvcSupported && !m_bUseSVC)
+    {
+        if (!m_pSvcState)
+        {
+            m_pSvcState = new H264SvcState();
+        }
+        // IsPictureBoundary() ended the last picture decoded with the AVC DPB
+        release_decoded_picture_buffer();
+        m_bUseSVC = true;
+    }
+}
 
-void VulkanH264Decoder::EndOfStream()
+seq_parameter_set_mvc_extension_s *VulkanH264Decoder::get_spsme(int32_t sps_id) const
 {
-    if (!m_bUseSVC)
+    return m_pMvcState ? m_pMvcState->pSpsmes[sps_id] : NULL;
+}
+
+void VulkanH264Decoder::release_decoded_picture_buffer()
+{
+    flush_decoded_picture_buffer();
+    for (int i = 0; i <= MAX_DPB_SIZE; i++)
     {
-        flush_decoded_picture_buffer();
-        for (int i = 0; i <= MAX_DPB_SIZE; i++)
+        if (dpb[i].pPicBuf)
         {
-            if (dpb[i].pPicBuf)
-            {
-                dpb[i].pPicBuf->Release();
-                dpb[i].pPicBuf = NULL;
-            }
+            dpb[i].pPicBuf->Release();
+            dpb[i].pPicBuf = NULL;
         }
     }
+}
+
+
+void VulkanH264Decoder::EndOfStream()
+{
+    if (!m_bUseSVC)
+    {
+        release_decoded_picture_buffer();
+    }
     else
     {
         for (int did = 0; did < 8; did++)
         {
-            dependency_state_s *ds = &m_dependency_state[did];
-            dependency_data_s *dd = &m_dependency_data[did];
+            dependency_state_s *ds = &m_pSvcState->dependency_state[did];
+            dependency_data_s *dd = &m_pSvcState->dependency_data[did];
             if (dd->used)
             {
                 flush_dpb_SVC(ds);
@@ -182,19 +238,22 @@ void VulkanH264Decoder::EndOfStream()
         m_ppss[i] = nullptr;
     }
 
+    memset(&m_slh_prev, 0, sizeof(m_slh_prev));
+
     // svc
-    for (uint32_t i = 0; i < sizeof (m_layer_data) / sizeof (m_layer_data[0]); i++) {
-        m_layer_data[i] = layer_data_s();
-    }
+    if (m_pSvcState) {
+        for (uint32_t i = 0; i < sizeof (m_pSvcState->layer_data) / sizeof (m_pSvcState->layer_data[0]); i++) {
+            m_pSvcState->layer_data[i] = layer_data_s();
+        }
 
-    for (uint32_t i = 0; i < sizeof (m_spssvcs) / sizeof (m_spssvcs[0]); i++) {
-        m_spssvcs[i] = nullptr;
-    }
+        for (uint32_t i = 0; i < sizeof (m_pSvcState->spssvcs) / sizeof (m_pSvcState->spssvcs[0]); i++) {
+            m_pSvcState->spssvcs[i] = nullptr;
+        }
 
-    memset(&m_slh_prev, 0, sizeof(m_slh_prev));
-    memset(&m_prefix_nal_unit_svc, 0, sizeof(m_prefix_nal_unit_svc));
-    memset(&m_dependency_data, 0, sizeof(m_dependency_data));
-    memset(&m_dependency_state, 0, sizeof(m_dependency_state));
+        memset(&m_pSvcState->prefix_nal_unit_svc, 0, sizeof(m_pSvcState->prefix_nal_unit_svc));
+        memset(&m_pSvcState->dependency_data, 0, sizeof(m_pSvcState->dependency_data));
+        memset(&m_pSvcState->dependency_state, 0, sizeof(m_pSvcState->dependency_state));
+    }
 }
 
 
@@ -369,6 +428,21 @@ bool VulkanH264Decoder::BeginPicture(VkParserPictureData *pnvpd)
 }
 
 
+bool VulkanH264Decoder::GetRandomAccessPoint(const VkParserPictureData *pnvpd, VkParserRandomAccessPoint *pRandomAccessPoint)
+{
+    // SVC/MVC enhancement layers depend on their base layer
+    if (m_bUseSVC || (m_slh.nal_unit_type != 5)) {
+        return false;
+    }
+    pRandomAccessPoint->type = VK_PARSER_RANDOM_ACCESS_IDR;
+    pRandomAccessPoint->picOrderCnt = pnvpd->picture_order_count;
+    pRandomAccessPoint->vpsId = -1;
+    pRandomAccessPoint->spsId = pnvpd->CodecSpecific.h264.seq_parameter_set_id;
+    pRandomAccessPoint->ppsId = pnvpd->CodecSpecific.h264.pic_parameter_set_id;
+    return true;
+}
+
+
 // Called back after EndOfPicture
 void VulkanH264Decoder::EndPicture()
 {
@@ -399,8 +473,8 @@ bool VulkanH264Decoder::init_sequence_svc(const seq_parameter_set_s* sps)
     nvsi.nDisplayHeight = nvsi.nCodedHeight;
     if (sps->flags.frame_cropping_flag)
     {
-        int crop_right = sps->frame_crop_right_offset*2;
-        int crop_bottom = sps->frame_crop_bottom_offset * 2 * ( 2 - sps->flags.frame_mbs_only_flag);
+        int crop_right = sps->frame_crop_right_offset * CropUnitX(sps);
+        int crop_bottom = sps->frame_crop_bottom_offset * CropUnitY(sps);
         if ((crop_right >= 0) && (crop_right < nvsi.nCodedWidth/2)
          && (crop_bottom >= 0) && (crop_bottom < nvsi.nCodedHeight/2))
         {
@@ -460,16 +534,16 @@ bool VulkanH264Decoder::init_sequence_svc(const seq_parameter_set_s* sps)
 bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
 {
     {
-        // Reset m_dependency_data array
-        for (size_t i = 0; i < sizeof(m_dependency_data) / sizeof(m_dependency_data[0]); i++) {
-            m_dependency_data[i] = dependency_data_s();
+        // Reset the dependency_data array
+        for (size_t i = 0; i < sizeof(m_pSvcState->dependency_data) / sizeof(m_pSvcState->dependency_data[0]); i++) {
+            m_pSvcState->dependency_data[i] = dependency_data_s();
         }
     }
 
     // determine target layer
     int32_t DQIdMax = 0;
     for (DQIdMax = 127; DQIdMax >= 0; DQIdMax--) {
-        if (m_layer_data[DQIdMax].available)
+        if (m_pSvcState->layer_data[DQIdMax].available)
             break;
     }
 
@@ -481,42 +555,42 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
     m_iDQIdMax = DQIdMax;
     int dependencyIdMax = DQIdMax >> 4; // dependency_id of target dependency representation
 
-    if (!init_sequence_svc(m_layer_data[DQIdMax].sps))
+    if (!init_sequence_svc(m_pSvcState->layer_data[DQIdMax].sps))
         return false;
 
     // layer and dependency representations required for decoding (G.8.1.1)
     int dqid_next = -1;
-    for (int dqid = DQIdMax; dqid >= 0; dqid = m_layer_data[dqid].MaxRefLayerDQId)
+    for (int dqid = DQIdMax; dqid >= 0; dqid = m_pSvcState->layer_data[dqid].MaxRefLayerDQId)
     {
-        nvParserLog("  DQId = %d (0x%x) max:%d\n", dqid, dqid, m_layer_data[dqid].MaxRefLayerDQId);
+        nvParserLog("  DQId = %d (0x%x) max:%d\n", dqid, dqid, m_pSvcState->layer_data[dqid].MaxRefLayerDQId);
         if (dqid_next >= 0 && !(dqid < dqid_next)) // has to be strictly monotonically decreasing (prevents infinite loop)
         {
             nvParserLog("ref_layer_dq_id > DQId - 1");
             return false;
         }
-        if (!m_layer_data[dqid].available)
+        if (!m_pSvcState->layer_data[dqid].available)
         {
             nvParserLog("invalid ref_layer_dq_id: %d, reference layer representation not available", dqid);
             return false;
         }
 
-        m_dependency_data[dqid >> 4].used = 1;
-        m_layer_data[dqid].used = 1;
-        m_layer_data[dqid].dqid_next = dqid_next;
+        m_pSvcState->dependency_data[dqid >> 4].used = 1;
+        m_pSvcState->layer_data[dqid].used = 1;
+        m_pSvcState->layer_data[dqid].dqid_next = dqid_next;
         dqid_next = dqid;
     }
 
     for (int did = 0; did <= dependencyIdMax; did++)
     {
-        m_dd = &m_dependency_data[did];
+        m_dd = &m_pSvcState->dependency_data[did];
         if (m_dd->used)
         {
-            if (!m_layer_data[16 * did + 0].used) {
+            if (!m_pSvcState->layer_data[16 * did + 0].used) {
                 nvParserLog("quality_id == 0 not used\n");
             }
-            m_dd->sps = m_layer_data[16 * did + 0].sps;
-            m_dd->sps_svc = m_layer_data[16 * did + 0].sps->svc;
-            m_dd->slh = m_layer_data[16 * did + 0].slh;
+            m_dd->sps = m_pSvcState->layer_data[16 * did + 0].sps;
+            m_dd->sps_svc = m_pSvcState->layer_data[16 * did + 0].sps->svc;
+            m_dd->slh = m_pSvcState->layer_data[16 * did + 0].slh;
             m_dd->MaxDpbFrames = derive_MaxDpbFrames(m_dd->sps);
             if (did == dependencyIdMax) {
                 m_dd->MaxDpbFrames = std::min<int32_t>(m_MaxFrameBuffers, m_dd->MaxDpbFrames);
@@ -525,7 +599,7 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
                 nvParserLog("max_num_ref_frames > MaxDpbFrames");
             }
             if (m_dd->slh.IdrPicFlag) {
-                flush_dpb_SVC(&m_dependency_state[did]);
+                flush_dpb_SVC(&m_pSvcState->dependency_state[did]);
             }
         }
     }
@@ -535,8 +609,8 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
 
     for (int did = 0; did <= dependencyIdMax; did++)
     {
-        m_ds = &m_dependency_state[did];
-        m_dd = &m_dependency_data[did];
+        m_ds = &m_pSvcState->dependency_state[did];
+        m_dd = &m_pSvcState->dependency_data[did];
         if (m_dd->used)
         {
             gaps_in_frame_num_SVC();
@@ -549,7 +623,7 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
             for (uint32_t qid = 0; qid < 16; qid++)
             {
                 uint32_t DQId = 16 * did + qid;
-                layer_data_s *ld = &m_layer_data[DQId];
+                layer_data_s *ld = &m_pSvcState->layer_data[DQId];
                 if (!ld->used) { // used layers are always consecutive starting with qid=0 (i.e. no qid gaps)
                     break;
                 }
@@ -589,6 +663,7 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
     }
 
     size_t end_offset = m_pVkPictureData->bitstreamDataLen;
+    VkDeviceSize dataOffset = m_pVkPictureData->bitstreamDataOffset;
     uint32_t maxCount = 0;
     const uint32_t* pSliceOffsets = m_pVkPictureData->bitstreamData->GetStreamMarkersPtr(0, maxCount);
     uint32_t TotalSliceCnt = 0;
@@ -598,27 +673,27 @@ bool VulkanH264Decoder::BeginPicture_SVC(VkParserPictureData *pnvpd)
     uint32_t PicLayer = 0;
     for(uint32_t layer = 0; layer < 128; layer++)
     {
-        TotalSliceCnt += m_layer_data[layer].slice_count;
-        int CurrentSliceCnt = m_layer_data[layer].slice_count;
-        if (!m_layer_data[layer].used) {
+        TotalSliceCnt += m_pSvcState->layer_data[layer].slice_count;
+        int CurrentSliceCnt = m_pSvcState->layer_data[layer].slice_count;
+        if (!m_pSvcState->layer_data[layer].used) {
             continue;
         }
         // slice calculation
         uint32_t firstSlice = TotalSliceCnt - CurrentSliceCnt;
         uint32_t startoffset = pSliceOffsets[firstSlice];
         (pnvpd + PicLayer)->bitstreamData = m_pVkPictureData->bitstreamData;
-        (pnvpd + PicLayer)->bitstreamDataOffset = startoffset;
+        (pnvpd + PicLayer)->bitstreamDataOffset = dataOffset + startoffset;
         (pnvpd + PicLayer)->numSlices = CurrentSliceCnt;
         (pnvpd + PicLayer)->bitstreamDataLen = ((TotalSliceCnt == nNumSlices) ? end_offset : pSliceOffsets[TotalSliceCnt]) - startoffset;
         // When processing layers, the decoder must consider the firstSliceIndex so that offsets
         // within a layer starts at 0
         (pnvpd + PicLayer)->firstSliceIndex = firstSlice;
 
-        const seq_parameter_set_s* sps = m_layer_data[layer].sps;
-        const pic_parameter_set_s* pps = m_layer_data[layer].pps;
-        slh = &m_layer_data[layer].slh;
+        const seq_parameter_set_s* sps = m_pSvcState->layer_data[layer].sps;
+        const pic_parameter_set_s* pps = m_pSvcState->layer_data[layer].pps;
+        slh = &m_pSvcState->layer_data[layer].slh;
         h264 = &(pnvpd + PicLayer)->CodecSpecific.h264;
-        svc_dpb_entry_s *dpb_entry = m_dependency_state[layer >> 4].dpb_entry;
+        svc_dpb_entry_s *dpb_entry = m_pSvcState->dependency_state[layer >> 4].dpb_entry;
 
         (pnvpd + PicLayer)->PicWidthInMbs = sps->pic_width_in_mbs_minus1 + 1;
         (pnvpd + PicLayer)->FrameHeightInMbs = (2 - sps->flags.frame_mbs_only_flag) * (sps->pic_height_in_map_units_minus1 + 1);
@@ -767,8 +842,8 @@ void VulkanH264Decoder::EndPicture_SVC()
     int dependencyIdMax = m_iDQIdMax >> 4; // dependency_id of target dependency representation
     for (int did=0; did<=dependencyIdMax; did++)
     {
-        m_ds = &m_dependency_state[did];
-        m_dd = &m_dependency_data[did];
+        m_ds = &m_pSvcState->dependency_state[did];
+        m_dd = &m_pSvcState->dependency_data[did];
         if (m_dd->used)
         {
             if (m_dd->slh.nal_ref_idc > 0)
@@ -778,8 +853,8 @@ void VulkanH264Decoder::EndPicture_SVC()
     }
     // clear SVC layer data
     {
-        for (size_t i = 0; i < sizeof(m_layer_data) / sizeof(m_layer_data[0]); i++) {
-            m_layer_data[i] = layer_data_s();
+        for (size_t i = 0; i < sizeof(m_pSvcState->layer_data) / sizeof(m_pSvcState->layer_data[0]); i++) {
+            m_pSvcState->layer_data[i] = layer_data_s();
         }
     }
 
@@ -1020,6 +1095,11 @@ bool VulkanH264Decoder::IsPictureBoundary(int32_t rbsp_size)
     f(1, 0); // forbidden_zero_bit
     nal_ref_idc = u(2);
     nal_unit_type = u(5);
+    // The first SVC NAL unit switches from the AVC to the SVC decoding process (in ParseNalUnit())
+    if (m_bSvcSupported && !m_bUseSVC &&
+        ((nal_unit_type == NAL_UNIT_CODED_SLICE_PREFIX) || (nal_unit_type == NAL_UNIT_SUBSET_SPS) ||
+         (nal_unit_type == NAL_UNIT_CODED_SLICE_SCALABLE)))
+        return true;
     if (m_bUseMVC || m_bUseSVC)
     {
         if (nal_unit_type == 14 || nal_unit_type == 20)
@@ -1088,7 +1168,9 @@ bool VulkanH264Decoder::IsPictureBoundary(int32_t rbsp_size)
         return false;
     }
     sps_id = m_ppss[pps_id]->seq_parameter_set_id;
-    spss = base_layer ? &m_spss[0] : &m_spssvcs[0];
+    if (!base_layer && !m_pSvcState)
+        return true;
+    spss = base_layer ? &m_spss[0] : &m_pSvcState->spssvcs[0];
     
     if ((slhold->pic_parameter_set_id != pps_id) || (!spss[sps_id]))
         return true;
@@ -1177,10 +1259,11 @@ int32_t VulkanH264Decoder::ParseNalUnit()
     int nal_ref_idc, nal_unit_type, picture_boundary;
     int retval = NALU_DISCARD;
 
-    picture_boundary = (m_nalu.start_offset == 0);
+    picture_boundary = (m_nalu.start_offset == m_picStartOffset);
     f(1, 0);    // forbidden_zero_bit
     nal_ref_idc = u(2);
     nal_unit_type = u(5);
+    alloc_extension_state(nal_unit_type);
     if (nal_unit_type == NAL_UNIT_CODED_SLICE_PREFIX || nal_unit_type == NAL_UNIT_CODED_SLICE_SCALABLE)
     {
         if(m_bUseMVC || m_bUseSVC)
@@ -1194,6 +1277,11 @@ int32_t VulkanH264Decoder::ParseNalUnit()
     case NAL_UNIT_CODED_SLICE_IDR:
         if (slice_header(&slh, nal_ref_idc, nal_unit_type))
         {
+            if (is_picture_filtered(slh.IdrPicFlag, slh.nal_ref_idc != 0))
+            {
+                m_slh_prev = slh;  // The picture boundaries are still detected slice after slice
+                break;
+            }
             if (picture_boundary)
             {
                 const seq_parameter_set_s *sps = m_spss[m_ppss[slh.pic_parameter_set_id]->seq_parameter_set_id];
@@ -1233,11 +1321,16 @@ int32_t VulkanH264Decoder::ParseNalUnit()
     case NAL_UNIT_CODED_SLICE_IDR_SCALABLE:
         if ((m_bUseMVC || m_bUseSVC) && (slice_header(&slh, nal_ref_idc, nal_unit_type)))
         {
+            if (!m_bUseSVC && is_picture_filtered(slh.IdrPicFlag, slh.nal_ref_idc != 0))
+            {
+                m_slh_prev = slh;
+                break;
+            }
             if (picture_boundary)
             {
                 const seq_parameter_set_s *sps;
                 if (m_bUseSVC) {
-                    sps = m_spssvcs[m_ppss[slh.pic_parameter_set_id]->seq_parameter_set_id];
+                    sps = m_pSvcState->spssvcs[m_ppss[slh.pic_parameter_set_id]->seq_parameter_set_id];
                 } else {
                     sps = m_spss[m_ppss[slh.pic_parameter_set_id]->seq_parameter_set_id];
                 }
@@ -1297,11 +1390,15 @@ int32_t VulkanH264Decoder::ParseNalUnit()
         }
         break;
     case NAL_UNIT_SPS:
-        seq_parameter_set_rbsp();
+        if (!is_parameter_set_repeat(PARAMETER_SET_SPS)) {
+            seq_parameter_set_rbsp();
+        }
         break;
     case NAL_UNIT_SUBSET_SPS:
         if(m_bUseMVC)
         {
+            // The MVC subset SPS replaces the SPS of the same id
+            forget_parameter_sets(PARAMETER_SET_SPS);
             int32_t sps_id = seq_parameter_set_rbsp(SPS_NAL_UNIT_TARGET_SPS_MVC);
             seq_parameter_set_mvc_extension_rbsp(sps_id);
         }
@@ -1311,7 +1408,9 @@ int32_t VulkanH264Decoder::ParseNalUnit()
         }
         break;
     case NAL_UNIT_PPS:
-        pic_parameter_set_rbsp();
+        if (!is_parameter_set_repeat(PARAMETER_SET_PPS)) {
+            pic_parameter_set_rbsp();
+        }
         break;
     case NAL_UNIT_ACCESS_UNIT_DELIMITER:
         m_last_primary_pic_type = u(3);
@@ -1356,14 +1455,14 @@ int32_t VulkanH264Decoder::ParseNalUnit()
 bool VulkanH264Decoder::prefix_nal_unit_svc(int nal_ref_idc)
 {
     int additional_prefix_nal_unit_extension_flag, additional_prefix_nal_unit_extension_data_flag = false;
-    memset(&m_prefix_nal_unit_svc, 0, sizeof(m_prefix_nal_unit_svc));
+    memset(&m_pSvcState->prefix_nal_unit_svc, 0, sizeof(m_pSvcState->prefix_nal_unit_svc));
 
-    m_prefix_nal_unit_svc.nalu = m_nhe; 
+    m_pSvcState->prefix_nal_unit_svc.nalu = m_nhe; 
     if (nal_ref_idc != 0)
     {
-        m_prefix_nal_unit_svc.store_ref_base_pic_flag = u(1);
-        if ((m_nhe.svc.use_ref_base_pic_flag || m_prefix_nal_unit_svc.store_ref_base_pic_flag) && !m_nhe.svc.idr_flag)
-            m_prefix_nal_unit_svc.adaptive_ref_base_pic_marking_mode_flag = (unsigned char)dec_ref_base_pic_marking(m_prefix_nal_unit_svc.mmbco);
+        m_pSvcState->prefix_nal_unit_svc.store_ref_base_pic_flag = u(1);
+        if ((m_nhe.svc.use_ref_base_pic_flag || m_pSvcState->prefix_nal_unit_svc.store_ref_base_pic_flag) && !m_nhe.svc.idr_flag)
+            m_pSvcState->prefix_nal_unit_svc.adaptive_ref_base_pic_marking_mode_flag = (unsigned char)dec_ref_base_pic_marking(m_pSvcState->prefix_nal_unit_svc.mmbco);
 
         additional_prefix_nal_unit_extension_flag = u(1);
         if (additional_prefix_nal_unit_extension_flag == 1)
@@ -1667,6 +1766,7 @@ int32_t VulkanH264Decoder::seq_parameter_set_rbsp(SpsNalUnitTarget spsNalUnitTar
         if ((spsNalUnitTarget == SPS_NAL_UNIT_TARGET_SPS) && m_outOfBandPictureParameters && m_pClient) {
 
             sps->SetSequenceCount(m_pParserData->spssClientUpdateCount[sps_id]++);
+            sps->SetContentHash(m_parameterSetHash);
             VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(sps);
             bool success = m_pClient->UpdatePictureParameters(picParamObj, sps->client);
             assert(success);
@@ -1675,6 +1775,13 @@ int32_t VulkanH264Decoder::seq_parameter_set_rbsp(SpsNalUnitTarget spsNalUnitTar
             }
         }
         m_spss[sps_id] = sps;
+        if (spsNalUnitTarget == SPS_NAL_UNIT_TARGET_SPS) {
+            save_parameter_set(PARAMETER_SET_SPS, sps_id);
+            if (m_pProbeSequenceInfo != NULL) {
+                get_sequence_info(sps, m_pProbeSequenceInfo);
+                m_pProbeSequenceInfo = NULL;
+            }
+        }
     }
 
     return sps_id;
@@ -1728,7 +1835,7 @@ bool VulkanH264Decoder::seq_parameter_set_svc_extension_rbsp()
     if (m_outOfBandPictureParameters && m_pClient) {
 
         assert(sps_id == m_last_sps_id);
-        spssvc->SetSequenceCount(m_pParserData->spssvcsClientUpdateCount[m_last_sps_id]++);
+        spssvc->SetSequenceCount(m_pSvcState->spssvcsClientUpdateCount[m_last_sps_id]++);
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(spssvc);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, spssvc->client);
         assert(success);
@@ -1737,7 +1844,7 @@ bool VulkanH264Decoder::seq_parameter_set_svc_extension_rbsp()
         }
     }
 
-    m_spssvcs[m_last_sps_id] = spssvc;
+    m_pSvcState->spssvcs[m_last_sps_id] = spssvc;
     return true;
 }
 
@@ -1827,15 +1934,15 @@ bool VulkanH264Decoder::seq_parameter_set_mvc_extension_rbsp(int32_t sps_id)
     u(1); // mvc_vui_parameters_present_flag, should always be 0;
     u(1); // additional_extension2_flag
 
-    m_pParserData->spsmes[m_last_sps_id].release();
-    m_pParserData->spsmes[m_last_sps_id] = spstmp;
-    m_spsmes[m_last_sps_id] = &(m_pParserData->spsmes[m_last_sps_id]);
+    m_pMvcState->spsmes[m_last_sps_id].release();
+    m_pMvcState->spsmes[m_last_sps_id] = spstmp;
+    m_pMvcState->pSpsmes[m_last_sps_id] = &(m_pMvcState->spsmes[m_last_sps_id]);
 
     if (m_outOfBandPictureParameters && m_pClient) {
         assert(sps_id == m_last_sps_id);
         assert(m_spss[sps_id]);
 
-        m_spss[sps_id]->SetSequenceCount(m_pParserData->spsmesClientUpdateCount[sps_id]++);
+        m_spss[sps_id]->SetSequenceCount(m_pMvcState->spsmesClientUpdateCount[sps_id]++);
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(m_spss[sps_id]);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, m_spss[sps_id]->client);
         assert(success);
@@ -1985,7 +2092,7 @@ void VulkanH264Decoder::hrd_parameters(vui_parameters_s *vui, hrd_parameters_s *
         hrd->bit_rate = (ue() + 1) << hrd->bit_rate_scale;   // bit_rate_value_minus1[SchedSelIdx]
         hrd->cbp_size = (ue() + 1) << hrd->cpb_size_scale;   // cpb_size_value_minus1[SchedSelIdx]
         u(1);   // cbr_flag[SchedSelIdx]
-        if (m_nalu.get_offset >= m_nalu.end_offset) { // In case of bitstream error
+        if (available_bits() <= 0) { // In case of bitstream error
             break;
         }
     }
@@ -2155,6 +2262,7 @@ bool VulkanH264Decoder::pic_parameter_set_rbsp()
     if (m_outOfBandPictureParameters && m_pClient) {
 
         pps->SetSequenceCount(m_pParserData->ppssClientUpdateCount[pps_id]++);
+        pps->SetContentHash(m_parameterSetHash);
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(pps);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, pps->client);
         assert(success);
@@ -2164,6 +2272,7 @@ bool VulkanH264Decoder::pic_parameter_set_rbsp()
     }
 
     m_ppss[pps_id] = pps;
+    save_parameter_set(PARAMETER_SET_PPS, pps_id);
     return true;
 }
 
@@ -2181,7 +2290,7 @@ bool VulkanH264Decoder::slice_header(slice_header_s *slh, int nal_ref_idc, int n
     if (m_prefix_nalu_valid && (nal_unit_type == NAL_UNIT_CODED_SLICE || nal_unit_type == NAL_UNIT_CODED_SLICE_IDR))
     {
         // Store the prefix_nalu information in the slice header
-        slh->nhe = m_bUseMVC ? m_nhe : m_prefix_nal_unit_svc.nalu;
+        slh->nhe = m_bUseMVC ? m_nhe : m_pSvcState->prefix_nal_unit_svc.nalu;
         m_prefix_nalu_valid = false;
     }
     else
@@ -2206,11 +2315,11 @@ bool VulkanH264Decoder::slice_header(slice_header_s *slh, int nal_ref_idc, int n
         no_inter_layer_pred_flag = slh->nhe.svc.no_inter_layer_pred_flag;
         quality_id = slh->nhe.svc.quality_id;
         base_layer = slh->nal_unit_type == 1 || slh->nal_unit_type == 5;
-        if (base_layer)
+        if (base_layer && m_pSvcState)
         {
-            slh->store_ref_base_pic_flag = m_prefix_nal_unit_svc.store_ref_base_pic_flag;
-            slh->adaptive_ref_base_pic_marking_mode_flag = m_prefix_nal_unit_svc.adaptive_ref_base_pic_marking_mode_flag;
-            memcpy(slh->mmbco, m_prefix_nal_unit_svc.mmbco, sizeof(slh->mmbco));
+            slh->store_ref_base_pic_flag = m_pSvcState->prefix_nal_unit_svc.store_ref_base_pic_flag;
+            slh->adaptive_ref_base_pic_marking_mode_flag = m_pSvcState->prefix_nal_unit_svc.adaptive_ref_base_pic_marking_mode_flag;
+            memcpy(slh->mmbco, m_pSvcState->prefix_nal_unit_svc.mmbco, sizeof(slh->mmbco));
         }
     }
     else
@@ -2233,7 +2342,14 @@ bool VulkanH264Decoder::slice_header(slice_header_s *slh, int nal_ref_idc, int n
         return false;
     }
     pps = m_ppss[slh->pic_parameter_set_id];
-    sps = base_layer ? m_spss[pps->seq_parameter_set_id] : m_spssvcs[pps->seq_parameter_set_id];
+    if (base_layer) {
+        sps = m_spss[pps->seq_parameter_set_id];
+    } else {
+        sps = NULL;
+        if (m_pSvcState) {
+            sps = m_pSvcState->spssvcs[pps->seq_parameter_set_id];
+        }
+    }
     if (!sps)
     {
         nvParserLog("PPS with missing associated SPS!\n");
@@ -2469,23 +2585,23 @@ bool VulkanH264Decoder::slice_header(slice_header_s *slh, int nal_ref_idc, int n
 void VulkanH264Decoder::update_layer_info(seq_parameter_set_s *sps, pic_parameter_set_s *pps, slice_header_s *slh)
 {  
     int dqid = (slh->nhe.svc.dependency_id << 4) + slh->nhe.svc.quality_id;
-    if (!m_layer_data[dqid].available) // first slice of layer
+    if (!m_pSvcState->layer_data[dqid].available) // first slice of layer
     {
-        m_layer_data[dqid].available = true;
-        m_layer_data[dqid].sps = sps;
-        m_layer_data[dqid].pps = pps;
-        m_layer_data[dqid].slh = *slh;
-        m_layer_data[dqid].MaxRefLayerDQId = -1;
+        m_pSvcState->layer_data[dqid].available = true;
+        m_pSvcState->layer_data[dqid].sps = sps;
+        m_pSvcState->layer_data[dqid].pps = pps;
+        m_pSvcState->layer_data[dqid].slh = *slh;
+        m_pSvcState->layer_data[dqid].MaxRefLayerDQId = -1;
     }
 
     // keep a slice header with no_inter_layer_pred_flag==0 (if any)
-    if (m_layer_data[dqid].MaxRefLayerDQId < 0 && !slh->nhe.svc.no_inter_layer_pred_flag)
+    if (m_pSvcState->layer_data[dqid].MaxRefLayerDQId < 0 && !slh->nhe.svc.no_inter_layer_pred_flag)
     {
-        m_layer_data[dqid].slh = *slh;
-        m_layer_data[dqid].MaxRefLayerDQId = (slh->nhe.svc.quality_id == 0) ? slh->ref_layer_dq_id : dqid - 1;
+        m_pSvcState->layer_data[dqid].slh = *slh;
+        m_pSvcState->layer_data[dqid].MaxRefLayerDQId = (slh->nhe.svc.quality_id == 0) ? slh->ref_layer_dq_id : dqid - 1;
     }
 
-    m_layer_data[dqid].slice_count++;
+    m_pSvcState->layer_data[dqid].slice_count++;
     
     m_slh_prev = *slh;
     m_bLayerFirstSlice = 0;
@@ -2675,25 +2791,12 @@ void VulkanH264Decoder::dec_ref_pic_marking(slice_header_s *slh)
 // DPB management
 //
 
-bool VulkanH264Decoder::dpb_sequence_start(slice_header_s *slh)
+// Sequence information of an SPS, as reported to BeginSequence(). Returns MaxDpbSize.
+int32_t VulkanH264Decoder::get_sequence_info(const seq_parameter_set_s* sps, VkParserSequenceInfo* pnvsi)
 {
-    VkParserSequenceInfo nvsi;
+    VkParserSequenceInfo& nvsi = *pnvsi;
     int PicWidthInMbs, FrameHeightInMbs, MaxDecFrameBuffering;
-    
-    m_PrevViewId = 0;
-    m_PrevRefFrameNum = 0;
-    
-    m_slh = *slh;
-    m_slh_prev = *slh;
-    m_sps = m_spss[m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id];
-    m_spsme = m_spsmes[m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id];
-    //m_spssvc = m_spssvcs[m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id];
 
-    const seq_parameter_set_s* sps = m_sps;
-
-    if (!slh->no_output_of_prior_pics_flag) {
-        flush_decoded_picture_buffer();
-    }
     PicWidthInMbs    = sps->pic_width_in_mbs_minus1 + 1;
     FrameHeightInMbs = (2 - sps->flags.frame_mbs_only_flag) * (sps->pic_height_in_map_units_minus1 + 1);
     MaxDecFrameBuffering = std::min<int32_t>(std::max<int32_t>(sps->vui.max_dec_frame_buffering, (int)sps->max_num_ref_frames), 16);
@@ -2716,8 +2819,8 @@ bool VulkanH264Decoder::dpb_sequence_start(slice_header_s *slh)
     nvsi.nDisplayHeight = nvsi.nCodedHeight;
     if (sps->flags.frame_cropping_flag)
     {
-        int crop_right = sps->frame_crop_right_offset * 2;
-        int crop_bottom = sps->frame_crop_bottom_offset * 2 * (2 - sps->flags.frame_mbs_only_flag);
+        int crop_right = sps->frame_crop_right_offset * CropUnitX(sps);
+        int crop_bottom = sps->frame_crop_bottom_offset * CropUnitY(sps);
         if ((crop_right >= 0) && (crop_right < nvsi.nCodedWidth / 2)
          && (crop_bottom >= 0) && (crop_bottom < nvsi.nCodedHeight / 2))
         {
@@ -2775,6 +2878,29 @@ bool VulkanH264Decoder::dpb_sequence_start(slice_header_s *slh)
     }
     nvsi.nMinNumDpbSlots = std::min((MaxDpbSize + 1), (MAX_DPB_SIZE + 1)); // one extra slot for the current setup
     nvsi.codecProfile = sps->profile_idc;
+    return MaxDpbSize;
+}
+
+
+bool VulkanH264Decoder::dpb_sequence_start(slice_header_s *slh)
+{
+    VkParserSequenceInfo nvsi;
+    
+    m_PrevViewId = 0;
+    m_PrevRefFrameNum = 0;
+    
+    m_slh = *slh;
+    m_slh_prev = *slh;
+    m_sps = m_spss[m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id];
+    m_spsme = get_spsme(m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id);
+    //m_spssvc = m_pSvcState->spssvcs[m_ppss[slh->pic_parameter_set_id]->seq_parameter_set_id];
+
+    const seq_parameter_set_s* sps = m_sps;
+
+    if (!slh->no_output_of_prior_pics_flag) {
+        flush_decoded_picture_buffer();
+    }
+    int32_t MaxDpbSize = get_sequence_info(sps, &nvsi);
 
     if (!m_bUseSVC)
     {
@@ -2825,7 +2951,7 @@ bool VulkanH264Decoder::is_comp_field_pair(dpb_entry_s *dpb_local, slice_header_
 bool VulkanH264Decoder::find_comp_field_pair(slice_header_s *slh, int *icur)
 {
     int VOIdx = get_view_output_index(slh->view_id);
-    VkPicIf *pPicBuf = CurrFrmViewPic[VOIdx];
+    VkPicIf *pPicBuf = m_pMvcState ? m_pMvcState->CurrFrmViewPic[VOIdx] : NULL;
     int i;
 
     if (pPicBuf)
@@ -2850,7 +2976,7 @@ void VulkanH264Decoder::dpb_picture_start(pic_parameter_set_s *pps, slice_header
     m_slh = *slh;
     m_slh_prev = *slh;
     m_pps = pps;
-    m_spsme = m_spsmes[pps->seq_parameter_set_id];
+    m_spsme = get_spsme(pps->seq_parameter_set_id);
 
     if (slh->view_id == m_PrevViewId)
         gaps_in_frame_num();
@@ -2882,7 +3008,10 @@ void VulkanH264Decoder::dpb_picture_start(pic_parameter_set_s *pps, slice_header
         // Reset view indices when we get the base view
         if ((slh->nal_unit_type == 1) || (slh->nal_unit_type == 5))
         {
-            memset(CurrFrmViewPic, 0, sizeof(CurrFrmViewPic));
+            if (m_pMvcState)
+            {
+                memset(m_pMvcState->CurrFrmViewPic, 0, sizeof(m_pMvcState->CurrFrmViewPic));
+            }
             for (int i = 0; i <= MAX_DPB_SIZE; i++)
             {
                 dpb[i].inter_view_flag = 0; // Reset inter view flags
@@ -2917,7 +3046,10 @@ void VulkanH264Decoder::dpb_picture_start(pic_parameter_set_s *pps, slice_header
         }
         cur->view_id = slh->view_id;
         cur->VOIdx = get_view_output_index(slh->view_id);
-        CurrFrmViewPic[cur->VOIdx] = cur->pPicBuf;
+        if (m_pMvcState)
+        {
+            m_pMvcState->CurrFrmViewPic[cur->VOIdx] = cur->pPicBuf;
+        }
         cur->inter_view_flag = m_nhe.mvc.inter_view_flag;
     }
 
@@ -3159,7 +3291,16 @@ void VulkanH264Decoder::dpb_picture_end()
     }
     
     // Limit decode->display latency according to max_num_reorder_frames (no optimizations for MVC/SVC to keep things simple)
-    if (!m_bUseMVC && !m_bUseSVC && (m_sps->vui.max_num_reorder_frames < MAX_DPB_SIZE))
+    if (m_bLowLatencyOutput && !m_bUseMVC && !m_bUseSVC && (m_sps->vui.max_num_reorder_frames == 0))
+    {
+        // Immediate output: without reordering, every complete frame still in the DPB (the current one included)
+        // is displayed now rather than one per picture
+        for (int numReorderFrames = dpb_reordering_delay(); numReorderFrames > 0; numReorderFrames--)
+        {
+            display_bumping();
+        }
+    }
+    else if (!m_bUseMVC && !m_bUseSVC && (m_sps->vui.max_num_reorder_frames < MAX_DPB_SIZE))
     {
         // NOTE: Assuming that display_bumping will only output full frames (no optimizations for unpaired fields)
         if (dpb_reordering_delay() > m_sps->vui.max_num_reorder_frames)
@@ -4624,7 +4765,7 @@ void VulkanH264Decoder::sei_payload(int payloadType, int payloadSize)
                     {
                         u(sps->vui.initial_cpb_removal_delay_length);   // initial_cpb_removal_delay
                         u(sps->vui.initial_cpb_removal_delay_length);   // initial_cpb_removal_delay_offset
-                        if (m_nalu.get_offset >= m_nalu.end_offset)     // bitstream error
+                        if (available_bits() <= 0)     // bitstream error
                             break;
                     }
                 }
@@ -4634,7 +4775,7 @@ void VulkanH264Decoder::sei_payload(int payloadType, int payloadSize)
                     {
                         u(sps->vui.initial_cpb_removal_delay_length); // initial_cpb_removal_delay
                         u(sps->vui.initial_cpb_removal_delay_length); // initial_cpb_removal_delay_offset
-                        if (m_nalu.get_offset >= m_nalu.end_offset)   // bitstream error
+                        if (available_bits() <= 0)   // bitstream error
                             break;
                     }
                 }
@@ -233,6 +233,28 @@ void VulkanH265Decoder::EndPicture()
 }
 
 
+bool VulkanH265Decoder::GetRandomAccessPoint(const VkParserPictureData *pnvpd, VkParserRandomAccessPoint *pRandomAccessPoint)
+{
+    const VkParserHevcPictureData* const hevc = &pnvpd->CodecSpecific.hevc;
+
+    if ((m_nuh_layer_id != 0) || !hevc->IrapPicFlag) {
+        return false;
+    }
+    if (hevc->IdrPicFlag) {
+        pRandomAccessPoint->type = VK_PARSER_RANDOM_ACCESS_IDR;
+    } else if (m_slh.nal_unit_type == NUT_CRA_NUT) {
+        pRandomAccessPoint->type = VK_PARSER_RANDOM_ACCESS_CRA;
+    } else {
+        pRandomAccessPoint->type = VK_PARSER_RANDOM_ACCESS_BLA;
+    }
+    pRandomAccessPoint->picOrderCnt = m_dpb_cur->PicOrderCntVal;
+    pRandomAccessPoint->vpsId = hevc->vps_video_parameter_set_id;
+    pRandomAccessPoint->spsId = hevc->seq_parameter_set_id;
+    pRandomAccessPoint->ppsId = hevc->pic_parameter_set_id;
+    return true;
+}
+
+
 bool VulkanH265Decoder::IsPictureBoundary(int32_t rbsp_size)
 {
     int nal_unit_type, nuh_temporal_id_plus1;
@@ -290,13 +312,19 @@ int32_t VulkanH265Decoder::ParseNalUnit()
     switch(nal_unit_type)
     {
     case NUT_SPS_NUT:
-        seq_parameter_set_rbsp();
+        if (!is_parameter_set_repeat(PARAMETER_SET_SPS)) {
+            seq_parameter_set_rbsp();
+        }
         break;
     case NUT_PPS_NUT:
-        pic_parameter_set_rbsp();
+        if (!is_parameter_set_repeat(PARAMETER_SET_PPS)) {
+            pic_parameter_set_rbsp();
+        }
         break;
     case NUT_VPS_NUT:
-        video_parameter_set_rbsp();
+        if (!is_parameter_set_repeat(PARAMETER_SET_VPS)) {
+            video_parameter_set_rbsp();
+        }
         break;
     case NUT_PREFIX_SEI_NUT:
     case NUT_SUFFIX_SEI_NUT:
@@ -305,9 +333,34 @@ int32_t VulkanH265Decoder::ParseNalUnit()
     default:
         if ((nal_unit_type >= NUT_TRAIL_N && nal_unit_type <= NUT_RASL_R) || (nal_unit_type >= NUT_BLA_W_LP && nal_unit_type <= NUT_CRA_NUT))
         {
+            // Temporal sub-layer decimation, decided on the first slice of each picture (first_slice_segment_in_pic_flag)
+            const bool bPictureStart = (next_bits(1) != 0);
+            if (bPictureStart)
+            {
+                int32_t switchType = TEMPORAL_SWITCH_NONE;
+                if (nal_unit_type >= NUT_BLA_W_LP)
+                    switchType = TEMPORAL_SWITCH_ALL;
+                else if (nal_unit_type == NUT_TSA_N || nal_unit_type == NUT_TSA_R)
+                    switchType = TEMPORAL_SWITCH_UP;
+                else if (nal_unit_type == NUT_STSA_N || nal_unit_type == NUT_STSA_R)
+                    switchType = TEMPORAL_SWITCH_STEP;
+                update_temporal_layer_limit(nuh_temporal_id_plus1 - 1, switchType);
+            }
+            if (is_temporal_layer_dropped(nuh_temporal_id_plus1 - 1, bPictureStart))
+            {
+                break;
+            }
             // slice_layer_rbsp
             if (slice_header(nal_unit_type, nuh_temporal_id_plus1))
             {
+                // The sub-layer non-reference pictures (even types) of the highest sub-layer are never referenced
+                const hevc_seq_param_s* filterSps = m_spss[m_ppss[m_slh.pic_parameter_set_id]->pps_seq_parameter_set_id];
+                const bool isReferencePic = (nal_unit_type & 1) || (nal_unit_type > NUT_RASL_R) ||
+                                            (nuh_temporal_id_plus1 - 1 < filterSps->sps_max_sub_layers_minus1);
+                if (is_picture_filtered(nal_unit_type >= NUT_BLA_W_LP && nal_unit_type <= 23, isReferencePic))
+                {
+                    break;
+                }
                 if (!m_bPictureStarted) // 1st slice - can't rely on first_slice_segment_in_pic_flag if there are data drops
                 {
                     int discontinuity = false;
@@ -321,7 +374,8 @@ int32_t VulkanH265Decoder::ParseNalUnit()
                     }
 
                     if (isIrapPic) {
-                        NoRaslOutputFlag = (nal_unit_type <= NUT_IDR_N_LP); // BLA or IDR
+                        // BLA or IDR, or any IRAP picture with the random access filter, which drops the pictures in between
+                        NoRaslOutputFlag = (nal_unit_type <= NUT_IDR_N_LP) || (m_decodeFilter == VK_PARSER_DECODE_FILTER_RANDOM_ACCESS);
                     }
 
                     StdVideoH265SequenceParameterSet* p_active_sps(*m_active_sps[m_nuh_layer_id]);
@@ -336,7 +390,7 @@ int32_t VulkanH265Decoder::ParseNalUnit()
                     }
 
                     if ((isIrapPic && NoRaslOutputFlag) || (discontinuity) || (!m_MaxDpbSize)) {
-                        int NoOutputOfPriorPicsFlag = (slh->nal_unit_type == NUT_CRA_NUT) ? 1 : slh->no_output_of_prior_pics_flag;
+                        int NoOutputOfPriorPicsFlag = get_no_output_of_prior_pics_flag(slh);
                         if (m_nuh_layer_id == 0) {
                             flush_decoded_picture_buffer(NoOutputOfPriorPicsFlag);
                         }
@@ -697,6 +751,7 @@ void VulkanH265Decoder::seq_parameter_set_rbsp()
     if (m_outOfBandPictureParameters && m_pClient) {
 
         sps->SetSequenceCount(m_pParserData->spsClientUpdateCount[seq_parameter_set_id]++);
+        sps->SetContentHash(m_parameterSetHash);
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(sps);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, sps->client);
         assert(success);
@@ -706,6 +761,11 @@ void VulkanH265Decoder::seq_parameter_set_rbsp()
     }
 
     m_spss[seq_parameter_set_id] = sps;
+    save_parameter_set(PARAMETER_SET_SPS, seq_parameter_set_id);
+    if (m_pProbeSequenceInfo != NULL) {
+        get_sequence_info(sps, m_pProbeSequenceInfo);
+        m_pProbeSequenceInfo = NULL;
+    }
 }
 
 
@@ -891,6 +951,8 @@ void VulkanH265Decoder::pic_parameter_set_rbsp()
     if (m_outOfBandPictureParameters && m_pClient) {
 
         pps->SetSequenceCount(m_pParserData->ppsClientUpdateCount[pic_parameter_set_id]++);
+        // sps_video_parameter_set_id comes from the SPS, not from the PPS payload
+        pps->SetContentHash(m_parameterSetHash ^ ((uint64_t)pps->sps_video_parameter_set_id << 56));
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(pps);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, pps->client);
         assert(success);
@@ -900,6 +962,7 @@ void VulkanH265Decoder::pic_parameter_set_rbsp()
     }
 
     m_ppss[pic_parameter_set_id] = pps;
+    save_parameter_set(PARAMETER_SET_PPS, pic_parameter_set_id);
 }
 
 /* Decode video parameter set information from the stream. */
@@ -1071,6 +1134,7 @@ void VulkanH265Decoder::video_parameter_set_rbsp()
     if (m_outOfBandPictureParameters && m_pClient) {
 
         vps->SetSequenceCount(m_pParserData->vpsClientUpdateCount[vps_video_parameter_set_id]++);
+        vps->SetContentHash(m_parameterSetHash);
         VkSharedBaseObj<StdVideoPictureParametersSet> picParamObj(vps);
         bool success = m_pClient->UpdatePictureParameters(picParamObj, vps->client);
         assert(success);
@@ -1080,6 +1144,7 @@ void VulkanH265Decoder::video_parameter_set_rbsp()
     }
 
     m_vpss[vps_video_parameter_set_id] = vps;
+    save_parameter_set(PARAMETER_SET_VPS, vps_video_parameter_set_id);
 
     return;
 } // video_parameter_set_rbsp()
@@ -2423,13 +2488,13 @@ static int32_t GetMaxDpbSize(VkSharedBaseObj<hevc_seq_param_s>& sps)
     return std::min<int32_t>(MaxDpbSize, HEVC_DPB_SIZE);
 }
 
-bool VulkanH265Decoder::dpb_sequence_start(VkSharedBaseObj<hevc_seq_param_s>& sps)
+// Sequence information of an SPS, as reported to BeginSequence(). Returns MaxDpbSize.
+int32_t VulkanH265Decoder::get_sequence_info(VkSharedBaseObj<hevc_seq_param_s>& sps, VkParserSequenceInfo* pnvsi)
 {
-    VkParserSequenceInfo nvsi;
+    VkParserSequenceInfo& nvsi = *pnvsi;
     uint32_t pic_width_in_luma_samples, pic_height_in_luma_samples;
     uint32_t Log2SubWidthC, Log2SubHeightC;
 
-    m_active_sps[m_nuh_layer_id] = sps;
     memset(&nvsi, 0, sizeof(nvsi));
     pic_width_in_luma_samples = sps->pic_width_in_luma_samples;
     pic_height_in_luma_samples = sps->pic_height_in_luma_samples;
@@ -2495,6 +2560,15 @@ bool VulkanH265Decoder::dpb_sequence_start(VkSharedBaseObj<hevc_seq_param_s>& sp
             nvsi.codecProfile = STD_VIDEO_H265_PROFILE_IDC_MAIN_10;
         }
     }
+    return MaxDpbSize;
+}
+
+bool VulkanH265Decoder::dpb_sequence_start(VkSharedBaseObj<hevc_seq_param_s>& sps)
+{
+    VkParserSequenceInfo nvsi;
+
+    m_active_sps[m_nuh_layer_id] = sps;
+    const int32_t MaxDpbSize = get_sequence_info(sps, &nvsi);
 
     if (!init_sequence(&nvsi)) {
         return false;
@@ -2508,6 +2582,16 @@ bool VulkanH265Decoder::dpb_sequence_start(VkSharedBaseObj<hevc_seq_param_s>& sp
 }
 
 
+// C.5.2.2: inferred to 1 for a CRA picture, but the random access filter keeps all the pictures it decodes
+int VulkanH265Decoder::get_no_output_of_prior_pics_flag(const hevc_slice_header_s *slh) const
+{
+    if ((slh->nal_unit_type == NUT_CRA_NUT) && (m_decodeFilter != VK_PARSER_DECODE_FILTER_RANDOM_ACCESS)) {
+        return 1;
+    }
+    return slh->no_output_of_prior_pics_flag;
+}
+
+
 void VulkanH265Decoder::flush_decoded_picture_buffer(int NoOutputOfPriorPicsFlag)
 {
     // mark all reference pictures as "unused for reference"
@@ -2667,7 +2751,7 @@ void VulkanH265Decoder::dpb_picture_start(VkSharedBaseObj<hevc_pic_param_s>& pps
     int PicOutputFlag = (((slh->nal_unit_type == NUT_RASL_N) || (slh->nal_unit_type == NUT_RASL_R)) && NoRaslOutputFlag) ? 0 : slh->pic_output_flag;
     if (isIrapPic && NoRaslOutputFlag)
     {
-        int NoOutputOfPriorPicsFlag = (slh->nal_unit_type == NUT_CRA_NUT) ? 1 : slh->no_output_of_prior_pics_flag;
+        int NoOutputOfPriorPicsFlag = get_no_output_of_prior_pics_flag(slh);
         if (NoOutputOfPriorPicsFlag)
         {
             for (i = 0; i < HEVC_DPB_SIZE; i++)
@@ -15,15 +15,23 @@
 */
 
 #include <stdarg.h>
+#include <string.h>
 #include "vkvideo_parser/VulkanVideoParserIf.h"
 #include "VulkanVideoDecoder.h"
 #include "nvVulkanVideoUtils.h"
 #include "nvVulkanVideoParser.h"
 #include <algorithm>
+#include <chrono>
 #ifdef ENABLE_VP9_DECODER
 #include <VulkanVP9Decoder.h>
 #endif
 
+static int64_t get_time_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
 VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     : m_refCount(0)
     , m_standard(std)
@@ -36,12 +44,23 @@ VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     , m_bufferSizeAlignment(256)
     , m_bitstreamData()
     , m_bitstreamDataLen()
+    , m_picStartOffset()
+    , m_maxPictureDataLen()
+    , m_packetBitstreamBuffer()
+    , m_llPacketBufferBase()
+    , m_llNaluEndLocation(-1)
+    , m_bZeroCopy(false)
+    , m_picDataEndOffset()
     , m_BitBfr()
+    , m_bIndexStartCodes(true)
+    , m_StartCodes()
+    , m_StartCodesPos()
     , m_bEmulBytesPresent()
     , m_bNoStartCodes(false)
     , m_bFilterTimestamps(false)
     , m_MaxFrameBuffers()
     , m_nalu()
+    , m_rbsp()
     , m_lMinBytesForBoundaryDetection(256)
     , m_lClockRate()
     , m_lFrameDuration()
@@ -57,12 +76,29 @@ VulkanVideoDecoder::VulkanVideoDecoder(VkVideoCodecOperationFlagBitsKHR std)
     , m_ExtSeqInfo()
     , m_DispInfo{}
     , m_PTSQueue{}
+    , m_DecodeInfo{}
+    , m_decodedPictureCount(0)
     , m_bDiscontinuityReported()
     , m_pVkPictureData()
     , m_iTargetLayer(0)
     , m_bDecoderInitFailed()
     , m_lCheckPTS()
     , m_eError(NV_NO_ERROR)
+    , m_bIndexRandomAccessPoints(false)
+    , m_decodeFilter(VK_PARSER_DECODE_FILTER_NONE)
+    , m_bLowLatencyOutput(false)
+    , m_bReportDisplayLatency(false)
+    , m_bStreamingInput(false)
+    , m_temporalLayerStats()
+    , m_parameterSetNalus()
+    , m_randomAccessParameterSets()
+    , m_parameterSetMemos()
+    , m_parameterSetStats()
+    , m_parameterSetHash(0)
+    , m_pProbeSequenceInfo(NULL)
+    , m_nalLengthSize(0)
+    , m_nalLengthBytes(0)
+    , m_nalBytesLeft(0)
 {
     if (m_264SvcEnabled) {
         m_pVkPictureData = new VkParserPictureData[128];
@@ -93,12 +129,35 @@ VkResult VulkanVideoDecoder::Initialize(const VkParserInitDecodeParameters *pPar
         return VK_ERROR_INCOMPATIBLE_DRIVER;
     }
 
+    SIMD_ISA simdIsa = check_simd_support();
+    if (pParserPictureData->simdIsa != VK_PARSER_SIMD_ISA_AUTO) {
+        const SIMD_ISA requestedIsa = (SIMD_ISA)(pParserPictureData->simdIsa - VK_PARSER_SIMD_ISA_C);
+        // Only a narrower instruction set of the same architecture (or plain C) can be selected
+        const bool sameArch = ((requestedIsa >= NEON) == (simdIsa >= NEON));
+        if ((requestedIsa != NOSIMD) && (!sameArch || (requestedIsa > simdIsa))) {
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        simdIsa = requestedIsa;
+    }
+
     Deinitialize();
     m_pClient = pParserPictureData->pClient;
     m_defaultMinBufferSize  = pParserPictureData->defaultMinBufferSize;
     m_bufferOffsetAlignment = pParserPictureData->bufferOffsetAlignment;
     m_bufferSizeAlignment   = pParserPictureData->bufferSizeAlignment;
     m_outOfBandPictureParameters = pParserPictureData->outOfBandPictureParameters;
+    m_bIndexStartCodes = !pParserPictureData->perNaluStartCodeScan;
+    m_bIndexRandomAccessPoints = pParserPictureData->indexRandomAccessPoints;
+    m_decodeFilter = pParserPictureData->decodeFilter;
+    m_bLowLatencyOutput = pParserPictureData->lowLatencyOutput;
+    m_bReportDisplayLatency = pParserPictureData->reportDisplayLatency;
+    m_bStreamingInput = pParserPictureData->streamingInput;
+    memset(&m_temporalLayerStats, 0, sizeof(m_temporalLayerStats));
+    m_temporalLayerStats.maxTemporalLayer = VK_PARSER_TEMPORAL_LAYER_ALL;
+    m_temporalLayerStats.requestedMaxTemporalLayer = VK_PARSER_TEMPORAL_LAYER_ALL;
+    m_parameterSetNalus.clear();
+    m_parameterSetMemos.clear();
+    memset(&m_parameterSetStats, 0, sizeof(m_parameterSetStats));
     m_lClockRate = (pParserPictureData->referenceClockRate > 0) ? pParserPictureData->referenceClockRate : 10000000; // Use 10Mhz as default clock
     m_lErrorThreshold = pParserPictureData->errorThreshold;
     m_bDiscontinuityReported = false;
@@ -130,7 +189,14 @@ VkResult VulkanVideoDecoder::Initialize(const VkParserInitDecodeParameters *pPar
     memset(&m_PrevSeqInfo, 0, sizeof(m_PrevSeqInfo));
     memset(&m_DispInfo, 0, sizeof(m_DispInfo));
     memset(&m_PTSQueue, 0, sizeof(m_PTSQueue));
+    memset(&m_DecodeInfo, 0, sizeof(m_DecodeInfo));
+    m_decodedPictureCount = 0;
     m_bitstreamData.ResetStreamMarkers();
+    m_picStartOffset = 0;
+    m_maxPictureDataLen = 0;
+    m_packetBitstreamBuffer = nullptr;
+    m_llNaluEndLocation = -1;
+    m_bZeroCopy = false;
     m_BitBfr = (uint32_t)~0;
     m_MaxFrameBuffers = 0;
     m_bDecoderInitFailed = false;
@@ -138,9 +204,12 @@ VkResult VulkanVideoDecoder::Initialize(const VkParserInitDecodeParameters *pPar
     m_llNaluStartLocation = 0;
     m_llFrameStartLocation = 0;
     m_lPTSPos = 0;
+    m_nalLengthSize = 0;
+    m_nalLengthBytes = 0;
+    m_nalBytesLeft = 0;
     InitParser();
     memset(&m_nalu, 0, sizeof(m_nalu)); // reset nalu again (in case parser used init_dbits during initialization)
-    m_NextStartCode = check_simd_support();
+    m_NextStartCode = simdIsa;
 
     return VK_SUCCESS;
 }
@@ -157,51 +226,115 @@ bool VulkanVideoDecoder::Deinitialize()
 void VulkanVideoDecoder::init_dbits()
 {
     m_nalu.get_offset = m_nalu.start_offset + ((m_bNoStartCodes) ? 0 : 3);  // Skip over start_code_prefix
-    m_nalu.get_zerocnt = 0;
     m_nalu.get_emulcnt = 0;
     m_nalu.get_bfr = 0;
+    if (m_bEmulBytesPresent)
+    {
+        // Restart the RBSP view at the beginning of the NAL unit payload
+        m_rbsp.size = 0;
+        m_rbsp.readPos = 0;
+        m_rbsp.emulIdx = 0;
+        m_rbsp.numEmulPos = 0;
+        m_rbsp.rawOffset = m_nalu.get_offset;
+        m_rbsp.bfr = (uint32_t)~0;
+    }
     // prime bit buffer
-    m_nalu.get_bfroffs = 32;
+    m_nalu.get_bfroffs = 64;
     skip_bits(0);
 }
 
+void VulkanVideoDecoder::rbsp_fill()
+{
+    // Discard the RBSP bytes that have already been loaded into the bit buffer (less than 8 bytes are left)
+    if (m_rbsp.readPos >= RBSP_CHUNK_SIZE)
+    {
+        m_rbsp.size -= m_rbsp.readPos;
+        memmove(&m_rbsp.data[0], &m_rbsp.data[m_rbsp.readPos], m_rbsp.size);
+        const size_t numEmulPosLeft = m_rbsp.numEmulPos - m_rbsp.emulIdx;
+        for (size_t i = 0; i < numEmulPosLeft; i++)
+        {
+            m_rbsp.emulPos[i] = m_rbsp.emulPos[m_rbsp.emulIdx + i] - (uint32_t)m_rbsp.readPos;
+        }
+        m_rbsp.numEmulPos = numEmulPosLeft;
+        m_rbsp.emulIdx = 0;
+        m_rbsp.readPos = 0;
+    }
+    const size_t datasize = (size_t)std::min<int64_t>(m_nalu.end_offset - m_rbsp.rawOffset, RBSP_CHUNK_SIZE);
+    assert((m_rbsp.size + datasize) <= NvVkRbspView::MAX_SIZE);
+    m_rbsp.size += RemoveEmulationPreventionBytes(m_bitstreamData.GetBitstreamPtr() + m_rbsp.rawOffset, datasize);
+    m_rbsp.rawOffset += datasize;
+}
+
+static inline uint64_t load_be64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
 
-void VulkanVideoDecoder::skip_bits(uint32_t n)
+template<bool EmulBytesPresent>
+void VulkanVideoDecoder::fill_bits()
 {
-    m_nalu.get_bfroffs += n;
     while (m_nalu.get_bfroffs >= 8)
     {
-        m_nalu.get_bfr <<= 8;
-        if (m_nalu.get_offset < m_nalu.end_offset)
+        const uint8_t* pdata;
+        int64_t datasize;
+        if (EmulBytesPresent)
         {
-            VkDeviceSize c = m_bitstreamData[m_nalu.get_offset++];
-            if (m_bEmulBytesPresent)
+            // Read from the RBSP view, converting the next chunk of the NAL unit when running low
+            if (((m_rbsp.readPos + 8) > m_rbsp.size) && (m_rbsp.rawOffset < m_nalu.end_offset))
             {
-                // detect / discard emulation_prevention_three_byte
-                if (m_nalu.get_zerocnt == 2)
-                {
-                    if (c == 3)
-                    {
-                        m_nalu.get_zerocnt = 0;
-                        c = (m_nalu.get_offset < m_nalu.end_offset) ? m_bitstreamData[m_nalu.get_offset] : 0;
-                        m_nalu.get_offset++;
-                        m_nalu.get_emulcnt++;
-                    }
-                }
-                if (c != 0)
-                    m_nalu.get_zerocnt = 0;
-                else
-                    m_nalu.get_zerocnt += (m_nalu.get_zerocnt < 2);
+                rbsp_fill();
             }
-            m_nalu.get_bfr |= c;
+            pdata = m_rbsp.data + m_rbsp.readPos;
+            datasize = (int64_t)(m_rbsp.size - m_rbsp.readPos);
+        } else
+        {
+            pdata = m_bitstreamData.GetBitstreamPtr() + m_nalu.get_offset;
+            datasize = m_nalu.end_offset - m_nalu.get_offset;
+        }
+        uint32_t numBytes = std::min<uint32_t>(m_nalu.get_bfroffs >> 3, 8);
+        if (datasize >= 8)
+        {
+            // Fast path: pull in all the needed bytes with a single 64-bit load
+            const uint64_t data = load_be64(pdata);
+            m_nalu.get_bfr = (numBytes == 8) ? data : ((m_nalu.get_bfr << (numBytes * 8)) | (data >> (64 - numBytes * 8)));
+        } else if (datasize > 0)
+        {
+            // Slow path: one byte at a time
+            numBytes = 1;
+            m_nalu.get_bfr = (m_nalu.get_bfr << 8) | pdata[0];
         } else
         {
-            m_nalu.get_offset++;
+            // Past the end of the NAL unit
+            numBytes = 1;
+            m_nalu.get_bfr <<= 8;
+        }
+        m_nalu.get_offset += numBytes;
+        m_nalu.get_bfroffs -= numBytes * 8;
+        if (EmulBytesPresent)
+        {
+            // Keep get_offset in byte stream units by accounting for the emulation prevention bytes
+            // that were removed in front of the bytes just read (all of them once the data is exhausted)
+            m_rbsp.readPos = std::min<size_t>(m_rbsp.readPos + numBytes, m_rbsp.size);
+            while ((m_rbsp.emulIdx < m_rbsp.numEmulPos) &&
+                   ((m_rbsp.emulPos[m_rbsp.emulIdx] < m_rbsp.readPos) || (datasize <= 0)))
+            {
+                m_nalu.get_offset++;
+                m_nalu.get_emulcnt++;
+                m_rbsp.emulIdx++;
+            }
         }
-        m_nalu.get_bfroffs -= 8;
     }
 }
 
+template void VulkanVideoDecoder::fill_bits<true>();
+template void VulkanVideoDecoder::fill_bits<false>();
+
 void VulkanVideoDecoder::rbsp_trailing_bits()
 {
     f(1, 1); // rbsp_stop_one_bit
@@ -223,21 +356,12 @@ bool VulkanVideoDecoder::more_rbsp_data()
 uint32_t VulkanVideoDecoder::u(uint32_t n)
 {
     uint32_t bits = 0;
-    
+
     if (n > 0)
     {
-        if (n + m_nalu.get_bfroffs <= 32)
-        {
-            bits = next_bits(n);
-            skip_bits(n);
-        } else
-        {
-            // n == 26..32
-            bits = next_bits(n-25) << 25;
-            skip_bits(n-25);
-            bits |= next_bits(25);
-            skip_bits(25);
-        }
+        // n == 1..32: the cache always holds at least 32 unread bits
+        bits = next_bits(n);
+        skip_bits(n);
     }
     return bits;
 }
@@ -246,21 +370,24 @@ uint32_t VulkanVideoDecoder::u(uint32_t n)
 // 9.1
 uint32_t VulkanVideoDecoder::ue()
 {
-    int leadingZeroBits, b, codeNum;
-
-    leadingZeroBits = -1;
-    for (b = 0; (!b) && (leadingZeroBits<32); leadingZeroBits++)
-        b = u(1);
-
-    codeNum = 0;
-    if (leadingZeroBits < 32)
+    const uint32_t bits = next_bits(32);
+    if (bits == 0)
     {
-        codeNum = (1 << leadingZeroBits) - 1 + u(leadingZeroBits);
-    } else
+        // 32 or more leading zero bits (bitstream error)
+        skip_bits(33);
+        return 0xffffffff + u(32);
+    }
+
+    const uint32_t leadingZeroBits = count_leading_zeros(bits);
+    if (leadingZeroBits < 16)
     {
-        codeNum = 0xffffffff + u(leadingZeroBits);
+        // prefix, separator and suffix are all within the 32 bits already peeked
+        const uint32_t codeLen = 2 * leadingZeroBits + 1;
+        skip_bits(codeLen);
+        return (bits >> (32 - codeLen)) - 1;
     }
-    return codeNum;
+    skip_bits(leadingZeroBits + 1);
+    return ((1U << leadingZeroBits) - 1) + u(leadingZeroBits);
 }
 
 
@@ -277,28 +404,77 @@ int32_t VulkanVideoDecoder::se()
     return codeNum;
 }
 
+size_t VulkanVideoDecoder::RemoveEmulationPreventionBytes(const uint8_t *pdatain, size_t datasize)
+{
+#if defined(__x86_64__) || defined (_M_X64)
+    if (m_NextStartCode == SIMD_ISA::AVX512)
+    {
+        return RemoveEmulationPreventionBytesAVX512(pdatain, datasize);
+    }
+    else if (m_NextStartCode == SIMD_ISA::AVX2)
+    {
+        return RemoveEmulationPreventionBytesAVX2(pdatain, datasize);
+    }
+    else if (m_NextStartCode == SIMD_ISA::SSSE3)
+    {
+        return RemoveEmulationPreventionBytesSSSE3(pdatain, datasize);
+    } else
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7A__) || defined(_M_ARM64)
+#if defined(__aarch64__)
+    if (m_NextStartCode == SIMD_ISA::SVE)
+    {
+        return RemoveEmulationPreventionBytesSVE(pdatain, datasize);
+    } else
+#endif //__aarch64__
+    if (m_NextStartCode == SIMD_ISA::NEON)
+    {
+        return RemoveEmulationPreventionBytesNEON(pdatain, datasize);
+    } else
+#endif
+    {
+        return RemoveEmulationPreventionBytesC(pdatain, datasize);
+    }
+}
+
 bool VulkanVideoDecoder::resizeBitstreamBuffer(VkDeviceSize extraBytes)
 {
+    // Only the current picture moves to the new buffer: the pictures in front of it
+    // have already been submitted and still own their part of the old buffer.
+    const VkDeviceSize copyOffset = picture_data_offset();
+    const VkDeviceSize copySize = m_bitstreamDataLen - copyOffset;
     // increasing min 2MB size per resizeBitstreamBuffer()
-    VkDeviceSize newBitstreamDataLen = m_bitstreamDataLen + std::max<VkDeviceSize>(extraBytes, (2 * 1024 * 1024));
+    VkDeviceSize newBitstreamDataLen = copySize + std::max<VkDeviceSize>(extraBytes, (2 * 1024 * 1024));
 
-    VkDeviceSize retSize = m_bitstreamData.ResizeBitstreamBuffer(newBitstreamDataLen, m_bitstreamDataLen, 0);
+    // The stream markers are relative to the picture data offset, so they stay valid in the new buffer.
+    VkSharedBaseObj<VulkanBitstreamBuffer> oldBitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
+    VkDeviceSize retSize = m_bitstreamData.ResizeBitstreamBuffer(newBitstreamDataLen, copySize, copyOffset);
     if (retSize < newBitstreamDataLen)
     {
         assert(!"bitstream buffer resize failed");
         nvParserLog("ERROR: bitstream buffer resize failed\n");
         return false;
     }
+    uint32_t numMarkers = 0;
+    const uint32_t* pMarkers = oldBitstreamBuffer->GetStreamMarkersPtr(0, numMarkers);
+    for (uint32_t i = 0; i < numMarkers; i++) {
+        m_bitstreamData.AddStreamMarker(pMarkers[i]);
+    }
 
+    m_nalu.start_offset -= copyOffset;
+    m_nalu.end_offset -= copyOffset;
+    m_picStartOffset -= copyOffset;
     m_bitstreamDataLen = (VkDeviceSize)retSize;
     return true;
 }
 
-VkDeviceSize VulkanVideoDecoder::swapBitstreamBuffer(VkDeviceSize copyCurrBuffOffset, VkDeviceSize copyCurrBuffSize)
+VkDeviceSize VulkanVideoDecoder::swapBitstreamBuffer(VkDeviceSize copyCurrBuffOffset, VkDeviceSize copyCurrBuffSize,
+                                                     VkDeviceSize newBufferSize)
 {
     VkSharedBaseObj<VulkanBitstreamBuffer> currentBitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
     VkSharedBaseObj<VulkanBitstreamBuffer> newBitstreamBuffer;
-    VkDeviceSize newBufferSize = currentBitstreamBuffer->GetMaxSize();
+    if (newBufferSize == 0) {
+        newBufferSize = currentBitstreamBuffer->GetMaxSize();
+    }
     const uint8_t* pCopyData = nullptr;
     if (copyCurrBuffSize) {
         VkDeviceSize maxSize = 0;
@@ -316,6 +492,124 @@ VkDeviceSize VulkanVideoDecoder::swapBitstreamBuffer(VkDeviceSize copyCurrBuffOf
     return m_bitstreamData.SetBitstreamBuffer(newBitstreamBuffer);
 }
 
+VkDeviceSize VulkanVideoDecoder::picture_data_offset() const
+{
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(m_bufferOffsetAlignment, 1);
+    return ((VkDeviceSize)m_picStartOffset / alignment) * alignment;
+}
+
+// Make the NAL unit at m_nalu.start_offset the first one of the next picture.
+// As long as the next picture is likely to fit, it is placed right after the current one
+// in the same buffer. The buffer is only swapped (with a copy of the partial NAL unit) once
+// it runs out of space, and the client recycles it after all the pictures it holds are decoded.
+void VulkanVideoDecoder::start_next_picture()
+{
+    if (!m_bZeroCopy && m_packetBitstreamBuffer && use_packet_buffer(m_llNaluEndLocation)) {
+        return;
+    }
+    const VkDeviceSize minFreeSpace = std::max<VkDeviceSize>(2 * m_maxPictureDataLen, 64 * 1024);
+    if (m_bZeroCopy || ((m_bitstreamDataLen - m_nalu.start_offset) >= minFreeSpace)) {
+        m_picStartOffset = m_nalu.start_offset;
+    } else {
+        m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
+        m_nalu.end_offset -= m_nalu.start_offset;
+        m_nalu.start_offset = 0;
+        m_picStartOffset = 0;
+    }
+    m_bitstreamData.ResetStreamMarkers();
+}
+
+// Zero-copy parsing: when the packet data already is in a client bitstream buffer, the
+// pictures are carved out of that buffer and only the slice offsets are recorded.
+// The parser falls back to its own buffers (and copies) whenever a picture is not
+// contiguous in the client's buffer, e.g. when it straddles two imported spans.
+void VulkanVideoDecoder::begin_packet(const VkParserBitstreamPacket* pck)
+{
+    m_packetBitstreamBuffer = nullptr;
+    m_llNaluEndLocation = -1;
+    if (pck->pBitstreamBuffer && (pck->nDataLength > 0) &&
+        ((pck->bitstreamBufferOffset + pck->nDataLength) <= pck->pBitstreamBuffer->GetMaxSize())) {
+        m_packetBitstreamBuffer = pck->pBitstreamBuffer;
+        m_llPacketBufferBase = (int64_t)pck->bitstreamBufferOffset - m_llParsedBytes;
+    }
+    if (pck->nDataLength == 0) {
+        return;
+    }
+    if (m_bZeroCopy && m_packetBitstreamBuffer &&
+        (m_bitstreamData.GetBitstreamBuffer() == m_packetBitstreamBuffer) &&
+        ((int64_t)pck->bitstreamBufferOffset == m_nalu.end_offset)) {
+        return; // The packet follows the previous one in the same buffer
+    }
+    // The NAL unit being filled can move to the packet buffer, as long as no slice of the current picture is pending
+    if (m_packetBitstreamBuffer && (m_bitstreamData.GetStreamMarkersCount() == 0) && use_packet_buffer(m_llParsedBytes)) {
+        return;
+    }
+    if (m_bZeroCopy) {
+        copy_packet_buffer_data();
+    }
+}
+
+// Switch to the packet buffer, if it holds the NAL unit being filled (which ends at
+// byte count llNaluEndLocation) at the same location as the rest of the stream.
+bool VulkanVideoDecoder::use_packet_buffer(int64_t llNaluEndLocation)
+{
+    if (llNaluEndLocation < 0) {
+        return false;
+    }
+    const int64_t naluSize = m_nalu.end_offset - m_nalu.start_offset;
+    const int64_t bufferEnd = m_llPacketBufferBase + llNaluEndLocation;
+    const int64_t bufferStart = bufferEnd - naluSize;
+    if ((bufferStart < 0) || ((VkDeviceSize)bufferEnd > m_packetBitstreamBuffer->GetMaxSize())) {
+        return false;
+    }
+    if (naluSize > 0) {
+        VkDeviceSize maxSize = 0;
+        const uint8_t* pNaluData = m_packetBitstreamBuffer->GetReadOnlyDataPtr(bufferStart, maxSize);
+        if (!pNaluData || memcmp(pNaluData, m_bitstreamData.GetBitstreamPtr() + m_nalu.start_offset, (size_t)naluSize)) {
+            return false;
+        }
+    }
+    m_bitstreamDataLen = m_bitstreamData.SetBitstreamBuffer(m_packetBitstreamBuffer);
+    m_nalu.start_offset = bufferStart;
+    m_nalu.end_offset = bufferEnd;
+    m_picStartOffset = bufferStart;
+    m_bZeroCopy = true;
+    return true;
+}
+
+// Move the current picture out of the client's buffer into one of our own.
+void VulkanVideoDecoder::copy_packet_buffer_data()
+{
+    const VkDeviceSize copyOffset = picture_data_offset();
+    const VkDeviceSize copySize = m_nalu.end_offset - copyOffset;
+    VkSharedBaseObj<VulkanBitstreamBuffer> packetBitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
+    m_bitstreamDataLen = swapBitstreamBuffer(copyOffset, copySize, copySize + m_defaultMinBufferSize);
+    uint32_t numMarkers = 0;
+    const uint32_t* pMarkers = packetBitstreamBuffer->GetStreamMarkersPtr(0, numMarkers);
+    for (uint32_t i = 0; i < numMarkers; i++) {
+        m_bitstreamData.AddStreamMarker(pMarkers[i]);
+    }
+    packetBitstreamBuffer->ResetStreamMarkers();
+    m_nalu.start_offset -= copyOffset;
+    m_nalu.end_offset -= copyOffset;
+    m_picStartOffset -= copyOffset;
+    m_bZeroCopy = false;
+}
+
+size_t VulkanVideoDecoder::next_indexed_start_code(const uint8_t *pdatain, size_t pckoffset, size_t datasize, bool& found_start_code)
+{
+    if ((m_StartCodesPos < m_StartCodes.size()) && ((m_StartCodes[m_StartCodesPos] - pckoffset) <= datasize))
+    {
+        found_start_code = true;
+        m_BitBfr = 1;
+        return m_StartCodes[m_StartCodesPos++] - pckoffset;
+    }
+    // No start code in this range: keep the carry up to date, as next_start_code() would
+    m_BitBfr = (datasize >= 2) ? ((pdatain[datasize - 2] << 8) | pdatain[datasize - 1]) : ((m_BitBfr << 8) | pdatain[0]);
+    found_start_code = false;
+    return datasize;
+}
+
 bool VulkanVideoDecoder::ParseByteStream(const VkParserBitstreamPacket* pck, size_t *pParsedBytes)
 {
 #if defined(__x86_64__) || defined (_M_X64)
@@ -348,6 +642,309 @@ bool VulkanVideoDecoder::ParseByteStream(const VkParserBitstreamPacket* pck, siz
     }
 }
 
+// Each segment goes through ParseByteStream() as a packet of its own: the bytes are copied once into the
+// bitstream buffer, and m_BitBfr carries the start code scan over from one segment to the next.
+bool VulkanVideoDecoder::ParseByteStreamSegments(const VkParserBitstreamPacket* pck, const VkParserBitstreamSegment* pSegments,
+                                                 uint32_t numSegments, size_t* pParsedBytes)
+{
+    if (pParsedBytes) {
+        *pParsedBytes = 0;
+    }
+    // The PTS and the discontinuity go with the first byte of the packet, the end of picture (stream) with the last one
+    uint32_t firstSegment = 0;
+    while ((firstSegment < numSegments) && (pSegments[firstSegment].size == 0)) {
+        firstSegment++;
+    }
+    uint32_t lastSegment = numSegments;
+    while ((lastSegment > firstSegment) && (pSegments[lastSegment - 1].size == 0)) {
+        lastSegment--;
+    }
+    VkParserBitstreamPacket segment = *pck;
+    segment.pByteStream = NULL;
+    segment.nDataLength = 0;
+    segment.pBitstreamBuffer = NULL;
+    segment.bitstreamBufferOffset = 0;
+    if (firstSegment == lastSegment) {
+        return ParseByteStream(&segment, NULL);
+    }
+    size_t parsedBytes = 0;
+    for (uint32_t i = firstSegment; i < lastSegment; i++) {
+        if (pSegments[i].size == 0) {
+            continue;
+        }
+        segment.pByteStream = pSegments[i].pData;
+        segment.nDataLength = pSegments[i].size;
+        segment.bPTSValid = pck->bPTSValid && (i == firstSegment);
+        segment.bDiscontinuity = pck->bDiscontinuity && (i == firstSegment);
+        segment.bEOS = pck->bEOS && (i == (lastSegment - 1));
+        segment.bEOP = pck->bEOP && (i == (lastSegment - 1));
+        segment.pbSideData = (i == firstSegment) ? pck->pbSideData : NULL;
+        segment.nSideDataLength = (i == firstSegment) ? pck->nSideDataLength : 0;
+        size_t segmentParsedBytes = 0;
+        if (!ParseByteStream(&segment, &segmentParsedBytes)) {
+            return false;
+        }
+        parsedBytes += segmentParsedBytes;
+        if (pParsedBytes) {
+            *pParsedBytes = parsedBytes;
+        }
+        // Partial parsing stopped at a decode or display event
+        if (segmentParsedBytes < segment.nDataLength) {
+            break;
+        }
+    }
+    return true;
+}
+
+// Returns the offset of the first 00.00.01 start code at or after offset, or size
+static size_t find_start_code(const uint8_t* pData, size_t size, size_t offset)
+{
+    for (; offset + 3 <= size; offset++)
+    {
+        if ((pData[offset + 2] == 1) && (pData[offset + 1] == 0) && (pData[offset] == 0))
+            return offset;
+    }
+    return size;
+}
+
+bool VulkanVideoDecoder::ParseByteStreamAt(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                           const VkParserBitstreamPacket* pck, size_t *pParsedBytes)
+{
+    // Drop the picture being assembled and flush the parser, as at the end of the stream
+    m_nalu.start_offset = m_picStartOffset;
+    m_nalu.end_offset = m_picStartOffset;
+    m_nalLengthBytes = 0;
+    m_nalBytesLeft = 0;
+    m_bitstreamData.ResetStreamMarkers();
+    end_of_stream();
+    // Keep the byte count in sync with the stream, so that the offsets of the
+    // pictures (and of the random access points) are the same as from the start
+    m_llParsedBytes = pRandomAccessPoint->llOffset - (int64_t)pRandomAccessPoint->parameterSetsSize;
+    if ((pRandomAccessPoint->parameterSetsSize > 0) && (m_nalLengthSize != 0)) {
+        // Length-prefixed input: the parameter sets were saved with start codes, hand them over one by one
+        const uint8_t* pParameterSets = pRandomAccessPoint->pParameterSets;
+        const size_t parameterSetsSize = pRandomAccessPoint->parameterSetsSize;
+        size_t naluStart = find_start_code(pParameterSets, parameterSetsSize, 0);
+        while (naluStart < parameterSetsSize) {
+            const size_t naluEnd = find_start_code(pParameterSets, parameterSetsSize, naluStart + 3);
+            parse_nal_unit_data(pParameterSets + naluStart + 3, naluEnd - naluStart - 3);
+            naluStart = naluEnd;
+        }
+        m_llParsedBytes = pRandomAccessPoint->llOffset;
+    } else if (pRandomAccessPoint->parameterSetsSize > 0) {
+        VkParserBitstreamPacket parameterSets;
+        memset(&parameterSets, 0, sizeof(parameterSets));
+        parameterSets.pByteStream = pRandomAccessPoint->pParameterSets;
+        parameterSets.nDataLength = pRandomAccessPoint->parameterSetsSize;
+        if (!ParseByteStream(&parameterSets, NULL)) {
+            return false;
+        }
+    }
+    return ParseByteStream(pck, pParsedBytes);
+}
+
+bool VulkanVideoDecoder::ProbeSequenceInfo(const VkParserBitstreamPacket* pck, VkParserSequenceInfo* pSequenceInfo, size_t* pParsedBytes)
+{
+    const uint8_t* pData = pck->pByteStream;
+    const size_t dataSize = pck->nDataLength;
+    size_t parsedBytes = 0;
+
+    if (pParsedBytes)
+        *pParsedBytes = 0;
+    if ((m_bitstreamData.GetBitstreamPtr() == NULL) || (m_llParsedBytes != 0) || m_bZeroCopy || (m_nalLengthSize != 0))
+        return false;
+
+    // Parse one NAL unit at a time (a NAL unit that may continue after the end of pck is not
+    // complete), until the codec fills in the sequence information of the first SPS.
+    VkParserSequenceInfo nvsi;
+    memset(&nvsi, 0, sizeof(nvsi));
+    m_pProbeSequenceInfo = &nvsi;
+    size_t naluStart = find_start_code(pData, dataSize, 0);
+    while ((naluStart < dataSize) && (m_pProbeSequenceInfo != NULL))
+    {
+        const size_t naluEnd = find_start_code(pData, dataSize, naluStart + 3);
+        if ((naluEnd == dataSize) && !pck->bEOP && !pck->bEOS)
+            break;
+        const size_t naluSize = naluEnd - naluStart;
+        if (((VkDeviceSize)(m_picStartOffset + naluSize) > m_bitstreamDataLen) &&
+            !resizeBitstreamBuffer(m_picStartOffset + naluSize - m_bitstreamDataLen))
+            break;
+        VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
+        bitstreamBuffer->CopyDataFromBuffer(pData + naluStart, 0, m_picStartOffset, naluSize);
+        m_nalu.start_offset = m_picStartOffset;
+        m_nalu.end_offset = m_picStartOffset + naluSize;
+        init_dbits();
+        ParseNalUnit();
+        parsedBytes = naluEnd;
+        naluStart = naluEnd;
+    }
+    const bool found = (m_pProbeSequenceInfo == NULL);
+    m_pProbeSequenceInfo = NULL;
+    m_nalu.start_offset = m_picStartOffset;
+    m_nalu.end_offset = m_picStartOffset;
+
+    if (!found)
+        return false;
+    *pSequenceInfo = nvsi;
+    if (pParsedBytes)
+        *pParsedBytes = parsedBytes;
+    return true;
+}
+
+// Length-prefixed input: the parameter sets of the decoder configuration record (ISO/IEC 14496-15
+// AVCDecoderConfigurationRecord or HEVCDecoderConfigurationRecord) are parsed right away, each one
+// preceded by a 16-bit size. Only the arrays of parameter sets are used, the profile and level fields
+// are redundant with the SPS.
+bool VulkanVideoDecoder::SetDecoderConfigurationRecord(const uint8_t* pData, size_t size)
+{
+    if ((m_standard != VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) && (m_standard != VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR))
+        return false;
+    if ((m_bitstreamData.GetBitstreamPtr() == NULL) || (m_llParsedBytes != 0) || (size < 7) || (pData[0] != 1)) // configurationVersion
+        return false;
+
+    uint32_t nalLengthSize, numArrays;
+    size_t offset;
+    if (m_standard == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR)
+    {
+        // The SPS array is followed by the PPS array
+        nalLengthSize = (pData[4] & 3) + 1;
+        numArrays = 2;
+        offset = 5;
+    }
+    else
+    {
+        if (size < 23)
+            return false;
+        nalLengthSize = (pData[21] & 3) + 1;
+        numArrays = pData[22];
+        offset = 23;
+    }
+    if (nalLengthSize == 3)
+        return false;
+
+    for (uint32_t i = 0; i < numArrays; i++)
+    {
+        uint32_t numNalus;
+        if (m_standard == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR)
+        {
+            if (offset + 1 > size)
+                return false;
+            numNalus = (i == 0) ? (pData[offset] & 0x1f) : pData[offset];
+            offset += 1;
+        }
+        else
+        {
+            // array_completeness, reserved, NAL_unit_type, numNalus
+            if (offset + 3 > size)
+                return false;
+            numNalus = (pData[offset + 1] << 8) | pData[offset + 2];
+            offset += 3;
+        }
+        for (uint32_t j = 0; j < numNalus; j++)
+        {
+            if (offset + 2 > size)
+                return false;
+            const size_t naluSize = (pData[offset] << 8) | pData[offset + 1];
+            offset += 2;
+            if (offset + naluSize > size)
+                return false;
+            parse_nal_unit_data(pData + offset, naluSize);
+            offset += naluSize;
+        }
+    }
+    m_nalLengthSize = nalLengthSize;
+    m_nalLengthBytes = 0;
+    m_nalBytesLeft = 0;
+    return true;
+}
+
+// Length-prefixed input: appends to the current NAL unit, starting it with a start code
+// in the bitstream buffer, so that the rest of the parser sees an Annex B byte stream.
+bool VulkanVideoDecoder::append_nal_unit_data(const uint8_t* pData, size_t size)
+{
+    const VkDeviceSize startCodeSize = (m_nalu.end_offset == m_nalu.start_offset) ? 3 : 0;
+    const VkDeviceSize endOffset = (VkDeviceSize)m_nalu.end_offset + startCodeSize + size;
+    if ((endOffset > m_bitstreamDataLen) && !resizeBitstreamBuffer(endOffset - m_bitstreamDataLen))
+        return false;
+    if (startCodeSize > 0)
+    {
+        m_bitstreamData.SetSliceStartCodeAtOffset(m_nalu.end_offset);
+        m_nalu.end_offset += startCodeSize;
+    }
+    if (size > 0)
+    {
+        VkSharedBaseObj<VulkanBitstreamBuffer> bitstreamBuffer(m_bitstreamData.GetBitstreamBuffer());
+        bitstreamBuffer->CopyDataFromBuffer(pData, 0, m_nalu.end_offset, size);
+        m_nalu.end_offset += size;
+    }
+    return true;
+}
+
+// Parses a complete NAL unit (without start code) that is not part of the byte stream
+void VulkanVideoDecoder::parse_nal_unit_data(const uint8_t* pData, size_t size)
+{
+    if (append_nal_unit_data(pData, size))
+        nal_unit();
+}
+
+// Length-prefixed input: NAL unit boundaries come from the length fields, so there is no
+// start code scan. Each length field is replaced with a start code in the bitstream buffer.
+bool VulkanVideoDecoder::parse_length_prefixed_nal_units(const VkParserBitstreamPacket* pck, const uint8_t*& pdatain,
+                                                         VkDeviceSize& curr_data_size)
+{
+    if (m_bZeroCopy)
+    {
+        copy_packet_buffer_data();
+    }
+    while (curr_data_size > 0)
+    {
+        // If bPartialParsing is set, we return immediately once we decoded or displayed a frame
+        if ((pck->bPartialParsing) && (m_nCallbackEventCount != 0))
+        {
+            break;
+        }
+        if (m_nalLengthBytes < m_nalLengthSize)
+        {
+            if ((m_nalLengthBytes == 0) && (m_nalu.start_offset == m_picStartOffset))
+            {
+                m_llNaluStartLocation = m_llParsedBytes;
+            }
+            m_nalBytesLeft = (m_nalBytesLeft << 8) | *pdatain;
+            m_nalLengthBytes++;
+            m_llParsedBytes++;
+            pdatain++;
+            curr_data_size--;
+            if (m_nalLengthBytes < m_nalLengthSize)
+            {
+                continue;
+            }
+            if (!append_nal_unit_data(pdatain, 0))
+            {
+                return false;
+            }
+        }
+        const size_t bytes = (size_t)std::min<VkDeviceSize>(m_nalBytesLeft, curr_data_size);
+        if (!append_nal_unit_data(pdatain, bytes))
+        {
+            return false;
+        }
+        m_llParsedBytes += bytes;
+        m_nalBytesLeft -= bytes;
+        pdatain += bytes;
+        curr_data_size -= bytes;
+        if (m_nalBytesLeft == 0)
+        {
+            nal_unit();
+            m_nalLengthBytes = 0;
+            if (m_bDecoderInitFailed)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 void VulkanVideoDecoder::nal_unit()
 {
     if (((m_nalu.end_offset - m_nalu.start_offset) > 3) &&
@@ -357,16 +954,16 @@ void VulkanVideoDecoder::nal_unit()
         init_dbits();
         if (IsPictureBoundary(available_bits() >> 3))
         {
-            if (m_nalu.start_offset > 0)
+            if (m_nalu.start_offset > m_picStartOffset)
             {
                 end_of_picture();
-
-                // This swap will copy to the new buffer most of the time.
-                m_bitstreamDataLen = swapBitstreamBuffer(m_nalu.start_offset, m_nalu.end_offset - m_nalu.start_offset);
-                m_nalu.end_offset -= m_nalu.start_offset;
-                m_nalu.start_offset = 0;
-                m_bitstreamData.ResetStreamMarkers();
-                m_llNaluStartLocation = m_llParsedBytes - m_nalu.end_offset;
+                start_next_picture();
+                m_llNaluStartLocation = m_llParsedBytes - (m_nalu.end_offset - m_nalu.start_offset);
+                if (m_nalLengthSize != 0)
+                {
+                    // The start code took the place of the length field
+                    m_llNaluStartLocation += 3 - (int64_t)m_nalLengthSize;
+                }
             }
         }
         init_dbits();
@@ -379,9 +976,11 @@ void VulkanVideoDecoder::nal_unit()
                 if (m_bitstreamData.GetStreamMarkersCount() == 0) {
                     m_llFrameStartLocation = m_llNaluStartLocation;
                 }
-                assert(m_nalu.start_offset < std::numeric_limits<int32_t>::max());
-                m_bitstreamData.AddStreamMarker((uint32_t)m_nalu.start_offset);
+                const int64_t sliceOffset = m_nalu.start_offset - (int64_t)picture_data_offset();
+                assert(sliceOffset < std::numeric_limits<int32_t>::max());
+                m_bitstreamData.AddStreamMarker((uint32_t)sliceOffset);
             }
+            m_picDataEndOffset = m_nalu.end_offset;
             break;
         //case NALU_DISCARD:
         default:
@@ -393,17 +992,182 @@ void VulkanVideoDecoder::nal_unit()
                 assert((uint64_t)cbData < (uint64_t)std::numeric_limits<size_t>::max());
                 m_pClient->UnhandledNALU(bitstreamDataPtr + m_nalu.start_offset + 3, (size_t)cbData);
             }
-            m_nalu.end_offset = m_nalu.start_offset;
+            discard_nal_unit();
         }
     } else
     {
         // Discard invalid NALU
-        m_nalu.end_offset = m_nalu.start_offset;
+        discard_nal_unit();
     }
     m_nalu.start_offset = m_nalu.end_offset;
 }
 
 
+void VulkanVideoDecoder::discard_nal_unit()
+{
+    if (!m_bZeroCopy) {
+        m_nalu.end_offset = m_nalu.start_offset;
+    } else if (m_nalu.start_offset == m_picStartOffset) {
+        // The data can't be overwritten: skip it, as long as the picture has no slice yet
+        m_picStartOffset = m_nalu.end_offset;
+    }
+}
+
+
+static uint64_t parameter_set_hash(const uint8_t* pData, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ pData[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+// Called once the current parameter set NAL unit (start code included) has been parsed and stored:
+// keep a copy of it, so that byte-identical repeats are not parsed again, and in index mode so
+// that it can be replayed when seeking to a random access point that uses it.
+void VulkanVideoDecoder::save_parameter_set(uint32_t type, int32_t id)
+{
+    save_parameter_set(type, id, m_bitstreamData.GetBitstreamPtr() + m_nalu.start_offset,
+                       (size_t)(m_nalu.end_offset - m_nalu.start_offset));
+}
+
+
+void VulkanVideoDecoder::save_parameter_set(uint32_t type, int32_t id, const uint8_t* pData, size_t size)
+{
+    if (id < 0) {
+        return;
+    }
+    ParameterSetMemo& memo = m_parameterSetMemos[(type << 16) | (uint32_t)id];
+    memo.hash = parameter_set_hash(pData, size);
+    memo.data.assign(pData, pData + size);
+    if (m_bIndexRandomAccessPoints) {
+        m_parameterSetNalus[(type << 16) | (uint32_t)id].assign(pData, pData + size);
+    }
+}
+
+
+bool VulkanVideoDecoder::is_parameter_set_repeat(uint32_t type)
+{
+    return is_parameter_set_repeat(type, m_bitstreamData.GetBitstreamPtr() + m_nalu.start_offset,
+                                   (size_t)(m_nalu.end_offset - m_nalu.start_offset));
+}
+
+
+// Returns true if the parameter set is byte-identical to the last parsed copy of a parameter set of
+// the same type, whose id is then the same: the stored one is still current, and the parsing, the
+// allocation and the client update can be skipped. The id is not known before parsing, so all the
+// copies of the type are looked at (there are only a few of them in practice).
+bool VulkanVideoDecoder::is_parameter_set_repeat(uint32_t type, const uint8_t* pData, size_t size)
+{
+    const uint64_t hash = parameter_set_hash(pData, size);
+    // The probe needs the sequence information of the first SPS, even if it has been parsed already
+    if (m_pProbeSequenceInfo == NULL) {
+        std::map<uint32_t, ParameterSetMemo>::const_iterator it = m_parameterSetMemos.lower_bound(type << 16);
+        for (; (it != m_parameterSetMemos.end()) && ((it->first >> 16) == type); ++it) {
+            if ((it->second.hash == hash) && (it->second.data.size() == size) &&
+                (memcmp(it->second.data.data(), pData, size) == 0)) {
+                m_parameterSetStats.repeatedParameterSets++;
+                return true;
+            }
+        }
+    }
+    m_parameterSetStats.parsedParameterSets++;
+    m_parameterSetHash = hash;
+    // Parameter sets of the next types are parsed with the ones they refer to
+    // (an SPS with its VPS, a PPS with its SPS): repeats of those must be parsed again.
+    forget_parameter_sets(type + 1);
+    return false;
+}
+
+
+// Drops the copies of the parameter sets of the given type and of the next ones, when the parsed
+// parameter sets are changed by something else than save_parameter_set().
+void VulkanVideoDecoder::forget_parameter_sets(uint32_t type)
+{
+    m_parameterSetMemos.erase(m_parameterSetMemos.lower_bound(type << 16), m_parameterSetMemos.end());
+}
+
+
+void VulkanVideoDecoder::report_random_access_point(VkParserRandomAccessPoint* pRandomAccessPoint)
+{
+    const int32_t ids[] = { pRandomAccessPoint->vpsId, pRandomAccessPoint->spsId, pRandomAccessPoint->ppsId };
+    m_randomAccessParameterSets.clear();
+    for (uint32_t type = PARAMETER_SET_VPS; type <= PARAMETER_SET_PPS; type++) {
+        if (ids[type] < 0) {
+            continue;
+        }
+        std::map<uint32_t, std::vector<uint8_t>>::const_iterator it = m_parameterSetNalus.find((type << 16) | (uint32_t)ids[type]);
+        if (it != m_parameterSetNalus.end()) {
+            m_randomAccessParameterSets.insert(m_randomAccessParameterSets.end(), it->second.begin(), it->second.end());
+        }
+    }
+    pRandomAccessPoint->llOffset = m_llFrameStartLocation;
+    pRandomAccessPoint->pParameterSets = m_randomAccessParameterSets.data();
+    pRandomAccessPoint->parameterSetsSize = m_randomAccessParameterSets.size();
+    if (m_pClient != NULL) {
+        m_pClient->RandomAccessPoint(pRandomAccessPoint);
+    }
+}
+
+
+// Decode filter: returns true if a picture of this kind must be dropped. The codecs check it on the
+// first slice (AV1: frame header) of a picture, before the picture gets a DPB entry or a buffer.
+bool VulkanVideoDecoder::is_picture_filtered(bool bRandomAccess, bool bReference) const
+{
+    switch (m_decodeFilter) {
+    case VK_PARSER_DECODE_FILTER_RANDOM_ACCESS:
+        return !bRandomAccess;
+    case VK_PARSER_DECODE_FILTER_REFERENCE:
+        return !bReference;
+    default:
+        return false;
+    }
+}
+
+
+void VulkanVideoDecoder::SetMaxTemporalLayer(uint32_t maxTemporalLayer)
+{
+    m_temporalLayerStats.requestedMaxTemporalLayer = std::min<uint32_t>(maxTemporalLayer, VK_PARSER_TEMPORAL_LAYER_ALL);
+}
+
+
+// Temporal sub-layer decimation: applies the requested limit at the start of a picture of the sub-layer temporalId
+// if the picture allows it (switchType = TEMPORAL_SWITCH_XXX). The sub-layers above the limit are never referenced
+// by the ones below, so that lowering it is always safe, but raising it needs a picture from which on the new
+// sub-layers do not refer to the pictures that were dropped.
+void VulkanVideoDecoder::update_temporal_layer_limit(uint32_t temporalId, int32_t switchType)
+{
+    const uint32_t maxTemporalLayer = m_temporalLayerStats.maxTemporalLayer;
+    const uint32_t requestedMaxTemporalLayer = m_temporalLayerStats.requestedMaxTemporalLayer;
+    if ((requestedMaxTemporalLayer < maxTemporalLayer) || (switchType == TEMPORAL_SWITCH_ALL)) {
+        m_temporalLayerStats.maxTemporalLayer = requestedMaxTemporalLayer;
+    } else if ((requestedMaxTemporalLayer > maxTemporalLayer) && (temporalId == maxTemporalLayer + 1)) {
+        // TSA and STSA pictures only allow switching from the sub-layer right below theirs
+        if (switchType == TEMPORAL_SWITCH_UP) {
+            m_temporalLayerStats.maxTemporalLayer = requestedMaxTemporalLayer;
+        } else if (switchType == TEMPORAL_SWITCH_STEP) {
+            m_temporalLayerStats.maxTemporalLayer = temporalId;
+        }
+    }
+}
+
+
+// Returns true if the NAL unit (OBU) of the sub-layer temporalId must be discarded, counting the dropped
+// pictures on their first NAL unit (bPictureStart)
+bool VulkanVideoDecoder::is_temporal_layer_dropped(uint32_t temporalId, bool bPictureStart)
+{
+    if (temporalId <= m_temporalLayerStats.maxTemporalLayer) {
+        return false;
+    }
+    if (bPictureStart) {
+        m_temporalLayerStats.droppedPictures++;
+    }
+    return true;
+}
+
+
 bool VulkanVideoDecoder::IsSequenceChange(VkParserSequenceInfo *pnvsi)
 {
     if (m_pClient)
@@ -451,16 +1215,20 @@ int VulkanVideoDecoder::init_sequence(VkParserSequenceInfo *pnvsi)
 
 void VulkanVideoDecoder::end_of_picture()
 {
-    if ((m_nalu.end_offset > 3) && (m_bitstreamData.GetStreamMarkersCount() > 0))
+    if (((m_nalu.end_offset - m_picStartOffset) > 3) && (m_bitstreamData.GetStreamMarkersCount() > 0))
     {
         assert(!m_264SvcEnabled);
         // memset(m_pVkPictureData, 0, (m_264SvcEnabled ? 128 : 1) * sizeof(VkParserPictureData));
+        const VkDeviceSize dataOffset = picture_data_offset();
+        // Without zero-copy, the discarded NAL units were already overwritten by the next ones
+        const VkDeviceSize dataLen = (m_bZeroCopy ? m_picDataEndOffset : m_nalu.start_offset) - dataOffset;
         m_pVkPictureData[0] = VkParserPictureData();
-        m_pVkPictureData->bitstreamDataOffset = 0;
+        m_pVkPictureData->bitstreamDataOffset = dataOffset;
         m_pVkPictureData->firstSliceIndex = 0;
         m_pVkPictureData->bitstreamData = m_bitstreamData.GetBitstreamBuffer();
-        assert((uint64_t)m_nalu.start_offset < (uint64_t)std::numeric_limits<size_t>::max());
-        m_pVkPictureData->bitstreamDataLen = (size_t)m_nalu.start_offset;
+        assert((uint64_t)dataLen < (uint64_t)std::numeric_limits<size_t>::max());
+        m_pVkPictureData->bitstreamDataLen = (size_t)dataLen;
+        m_maxPictureDataLen = std::max(m_maxPictureDataLen, dataLen);
         m_pVkPictureData->numSlices = m_bitstreamData.GetStreamMarkersCount();
         if(BeginPicture(m_pVkPictureData))
         {
@@ -507,8 +1275,20 @@ void VulkanVideoDecoder::end_of_picture()
                         ndx = (ndx+1) % MAX_QUEUED_PTS;
                     }
                 }
+                if (m_bIndexRandomAccessPoints)
+                {
+                    VkParserRandomAccessPoint randomAccessPoint = VkParserRandomAccessPoint();
+                    if (!(m_pVkPictureData + m_iTargetLayer)->second_field &&
+                        GetRandomAccessPoint(m_pVkPictureData + m_iTargetLayer, &randomAccessPoint))
+                    {
+                        randomAccessPoint.llPTS = m_DispInfo[lDisp].llPTS;
+                        randomAccessPoint.bPTSValid = m_DispInfo[lDisp].bPTSValid;
+                        report_random_access_point(&randomAccessPoint);
+                    }
+                    m_DispInfo[lDisp].bSkipped = true; // Never displayed
+                }
                 // Client callback
-                if (m_pClient != NULL)
+                else if (m_pClient != NULL)
                 {
                     // Notify client
                     if (!m_pClient->DecodePicture(m_pVkPictureData))
@@ -518,6 +1298,7 @@ void VulkanVideoDecoder::end_of_picture()
                     }
                     else
                     {
+                        picture_decoded((m_pVkPictureData + m_iTargetLayer)->pCurrPic);
                         m_nCallbackEventCount++;
                     }
                 }
@@ -603,6 +1384,17 @@ void VulkanVideoDecoder::display_picture(VkPicIf *pPicBuf, bool bEvict)
         }
         if ((m_pClient != NULL) && (!m_DispInfo[lDisp].bSkipped)) {
 
+            for (i = 0; m_bReportDisplayLatency && (i < MAX_DELAY); i++) {
+                if (m_DecodeInfo[i].pPicBuf == pPicBuf) {
+                    VkParserDisplayLatency displayLatency;
+                    displayLatency.pPicBuf = pPicBuf;
+                    displayLatency.llPTS = llPTS;
+                    displayLatency.delayPictures = (uint32_t)(m_decodedPictureCount - 1 - m_DecodeInfo[i].decodeIndex);
+                    displayLatency.delayUs = (uint64_t)std::max<int64_t>(get_time_us() - m_DecodeInfo[i].llDecodeTimeUs, 0);
+                    m_pClient->DisplayLatency(&displayLatency);
+                    break;
+                }
+            }
             m_pClient->DisplayPicture(pPicBuf, llPTS);
             m_nCallbackEventCount++;
         }
@@ -619,14 +1411,43 @@ void VulkanVideoDecoder::display_picture(VkPicIf *pPicBuf, bool bEvict)
 }
 
 
+// Records when pPicBuf was sent to DecodePicture(), for the decode-to-display latency of display_picture().
+// The entry of the picture buffer is reused, or else the oldest one.
+void VulkanVideoDecoder::picture_decoded(VkPicIf *pPicBuf)
+{
+    if (!m_bReportDisplayLatency) {
+        return;
+    }
+    int32_t lDecode = 0;
+    for (int32_t i = 0; i < MAX_DELAY; i++) {
+        if (m_DecodeInfo[i].pPicBuf == pPicBuf) {
+            lDecode = i;
+            break;
+        }
+        if (m_DecodeInfo[i].decodeIndex < m_DecodeInfo[lDecode].decodeIndex) {
+            lDecode = i;
+        }
+    }
+    m_DecodeInfo[lDecode].pPicBuf = pPicBuf;
+    m_DecodeInfo[lDecode].decodeIndex = m_decodedPictureCount++;
+    m_DecodeInfo[lDecode].llDecodeTimeUs = get_time_us();
+}
+
+
 void VulkanVideoDecoder::end_of_stream()
 {
     EndOfStream();
+    // The codecs may drop their parameter sets
+    m_parameterSetMemos.clear();
     // Reset common parser state
     memset(&m_nalu, 0, sizeof(m_nalu));
     memset(&m_PrevSeqInfo, 0, sizeof(m_PrevSeqInfo));
     memset(&m_PTSQueue, 0, sizeof(m_PTSQueue));
+    // Pictures in front of m_picStartOffset may still be in flight: keep filling the buffer after them
+    m_nalu.start_offset = m_picStartOffset;
+    m_nalu.end_offset = m_picStartOffset;
     m_bitstreamData.ResetStreamMarkers();
+    m_maxPictureDataLen = 0;
     m_BitBfr = (uint32_t)~0;
     m_llParsedBytes = 0;
     m_llNaluStartLocation = 0;
@@ -737,7 +1558,7 @@ VkResult CreateVulkanVideoDecodeParser(VkVideoCodecOperationFlagBitsKHR videoCod
                     VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_SPEC_VERSION, VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_EXTENSION_NAME);
              return VK_ERROR_INCOMPATIBLE_DRIVER;
         }
-        nvVideoDecodeParser =  VkSharedBaseObj<VulkanAV1Decoder>(new VulkanAV1Decoder(videoCodecOperation));
+        nvVideoDecodeParser =  VkSharedBaseObj<VulkanAV1Decoder>(new VulkanAV1Decoder(videoCodecOperation, pParserPictureData->av1AnnexB));
         break;
 #ifdef ENABLE_VP9_DECODER
     case VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR:
@@ -747,6 +1568,7 @@ VkResult CreateVulkanVideoDecodeParser(VkVideoCodecOperationFlagBitsKHR videoCod
 #endif
     default:
         nvParserErrorLog("Unsupported codec type!!!\n");
+        return VK_ERROR_VIDEO_PROFILE_CODEC_NOT_SUPPORTED_KHR;
     }
     VkResult result = nvVideoDecodeParser->Initialize(pParserPictureData);
     if (result != VK_SUCCESS) {
@@ -15,9 +15,12 @@
  */
 
 #include <string.h>
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 #include "mio/mio.hpp"
 #include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
 
 class ElementaryStream : public VideoStreamDemuxer {
 
@@ -31,6 +34,11 @@ public:
           m_width(defaultWidth)
         , m_height(defaultHeight)
         , m_bitDepth(defaultBitDepth)
+        , m_chromaBitDepth(defaultBitDepth)
+        , m_hasSequenceInfo(false)
+        , m_av1AnnexB(false)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
         , m_videoCodecType(forceParserType)
         , m_inputVideoStreamMmap()
         , m_pBitstreamData(nullptr)
@@ -53,6 +61,11 @@ public:
         : m_width(176)
         , m_height(144)
         , m_bitDepth(8)
+        , m_chromaBitDepth(8)
+        , m_hasSequenceInfo(false)
+        , m_av1AnnexB(false)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
         , m_videoCodecType(codecType)
         , m_inputVideoStreamMmap()
         , m_pBitstreamData(pInput)
@@ -61,7 +74,40 @@ public:
 
     }
 
-    int32_t Initialize() { return 0; }
+    // The codec and the format come from the first sequence header of the stream, when the probe finds one,
+    // rather than from the caller and from the defaults
+    int32_t Initialize()
+    {
+        if (m_bitstreamDataSize == 0) {
+            return 0;
+        }
+
+        VideoStreamFormat format;
+        const size_t probeSize = (size_t)std::min<VkDeviceSize>(m_bitstreamDataSize, VIDEO_STREAM_PROBE_SIZE);
+        if ((VideoStreamProbe(m_pBitstreamData, probeSize, (probeSize == m_bitstreamDataSize), format) == 0) ||
+            (format.container != VideoStreamFormat::CONTAINER_ELEMENTARY)) {
+            return 0;
+        }
+        if ((m_videoCodecType != VK_VIDEO_CODEC_OPERATION_NONE_KHR) && (m_videoCodecType != format.codec)) {
+            if (!format.hasSequenceInfo) {
+                return 0;
+            }
+            std::cerr << "Elementary stream: the stream is " << format.pName << ", not the codec requested" << std::endl;
+        }
+        m_videoCodecType = format.codec;
+        m_av1AnnexB = format.av1AnnexB;
+
+        if (format.hasSequenceInfo) {
+            m_hasSequenceInfo = true;
+            m_profileIdc = format.profileIdc;
+            m_chromaSubsampling = format.chromaSubsampling;
+            m_bitDepth = format.lumaBitDepth;
+            m_chromaBitDepth = format.chromaBitDepth;
+            m_width = format.codedWidth;
+            m_height = format.codedHeight;
+        }
+        return 0;
+    }
 
     static VkResult Create(const char *pFilePath,
                            VkVideoCodecOperationFlagBitsKHR codecType,
@@ -112,12 +158,15 @@ public:
 
     virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
     {
-        return VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+        return m_chromaSubsampling;
     }
 
     virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
     {
-        switch (m_bitDepth) {
+        if (m_chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) {
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+        }
+        switch (m_chromaBitDepth) {
         case 8:
             return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
             break;
@@ -133,9 +182,20 @@ public:
         assert(!"Unknown Chroma Bit Depth!");
         return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
     }
+    // The Main profile of the codec if the stream has no sequence header where the probe looked
     virtual uint32_t GetProfileIdc() const
     {
-        return STD_VIDEO_H264_PROFILE_IDC_MAIN;
+        if (m_hasSequenceInfo) {
+            return m_profileIdc;
+        }
+        switch ((uint32_t)m_videoCodecType) {
+        case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+            return STD_VIDEO_H265_PROFILE_IDC_MAIN;
+        case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+            return STD_VIDEO_AV1_PROFILE_MAIN;
+        default:
+            return STD_VIDEO_H264_PROFILE_IDC_MAIN;
+        }
     }
 
     virtual int32_t GetWidth() const { return m_width; }
@@ -144,6 +204,9 @@ public:
     virtual int64_t DemuxFrame(const uint8_t**) {
         return -1;
     }
+    virtual int64_t GetFrameTimestamp() const { return 0; }
+
+    virtual bool HasFrameDiscontinuity() const { return false; }
     virtual int64_t ReadBitstreamData(const uint8_t **ppVideo, int64_t offset)
     {
         assert(m_bitstreamDataSize != 0);
@@ -154,11 +217,22 @@ public:
         return m_bitstreamDataSize - offset;
     }
 
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        size = 0;
+        return nullptr;
+    }
+    virtual bool IsAv1AnnexB() const { return m_av1AnnexB; }
+
     virtual void DumpStreamParameters() const {
     }
 
 private:
     int32_t    m_width, m_height, m_bitDepth;
+    int32_t    m_chromaBitDepth;
+    bool       m_hasSequenceInfo;
+    bool       m_av1AnnexB;
+    uint32_t   m_profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
     VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
     mio::basic_mmap<mio::access_mode::read, uint8_t> m_inputVideoStreamMmap;
     const uint8_t* m_pBitstreamData;
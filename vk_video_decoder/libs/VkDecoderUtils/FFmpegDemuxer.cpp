@@ -131,7 +131,14 @@ private:
         pktFiltered->data = NULL;
         pktFiltered->size = 0;
 
-        if (isStreamDemuxer) {
+        // H.264/H.265 samples with an avcC/hvcC record go to the parser as they are (length-prefixed NAL
+        // units), instead of being rewritten to Annex B by the mp4toannexb bitstream filters
+        const AVCodecParameters *codecpar = fmtc->streams[videoStream]->codecpar;
+        lengthPrefixedNalUnits = isStreamDemuxer &&
+                                 ((videoCodec == AV_CODEC_ID_H264) || (videoCodec == AV_CODEC_ID_HEVC)) &&
+                                 (codecpar->extradata_size >= 7) && (codecpar->extradata[0] == 1);
+
+        if (isStreamDemuxer && !lengthPrefixedNalUnits) {
             const AVBitStreamFilter *bsf = NULL;
 
             if (videoCodec == AV_CODEC_ID_H264) {
@@ -213,6 +220,7 @@ private:
         , bsfc()
         , videoStream()
         , isStreamDemuxer()
+        , lengthPrefixedNalUnits()
         , videoCodec()
         , codedWidth()
         , codedHeight()
@@ -468,7 +476,7 @@ public:
             return e;
         }
 
-        if (isStreamDemuxer) {
+        if (isStreamDemuxer && !lengthPrefixedNalUnits) {
             if (pktFiltered->data) {
                 av_packet_unref(pktFiltered);
             }
@@ -482,10 +490,35 @@ public:
         }
     }
 
+    virtual int64_t GetFrameTimestamp() const {
+        if (!pPkt->data || (pPkt->pts == AV_NOPTS_VALUE)) {
+            return 0;
+        }
+        return pPkt->pts;
+    }
+
+    // The MPEG-TS demuxer of FFmpeg flags the packets with a continuity error as corrupt
+    virtual bool HasFrameDiscontinuity() const {
+        return pPkt->data && (pPkt->flags & AV_PKT_FLAG_CORRUPT);
+    }
+
     virtual int64_t ReadBitstreamData(const uint8_t**, int64_t) {
         return -1;
     }
 
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        if (!lengthPrefixedNalUnits) {
+            size = 0;
+            return nullptr;
+        }
+        size = (size_t)fmtc->streams[videoStream]->codecpar->extradata_size;
+        return fmtc->streams[videoStream]->codecpar->extradata;
+    }
+
+    virtual bool IsAv1AnnexB() const {
+        return false;
+    }
+
     static int ReadPacket(void *opaque, uint8_t *pBuf, int nBuf) {
         return ((DataProvider *)opaque)->GetData(pBuf, nBuf);
     }
@@ -607,6 +640,7 @@ private:
 
     int videoStream;
     bool isStreamDemuxer;
+    bool lengthPrefixedNalUnits;
     AVCodecID videoCodec;
     int codedWidth, codedHeight, codedLumaBitDepth, codedChromaBitDepth;
 
@@ -0,0 +1,535 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "mio/mio.hpp"
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+
+// IVF container: a 32-byte file header followed by frames, each one made of
+// a 12-byte frame header and of the frame data. All fields are little-endian.
+//   char     signature[4]    "DKIF"
+//   uint16_t version         0
+//   uint16_t headerSize      32
+//   char     fourCC[4]       "AV01", "VP90"
+//   uint16_t width, height
+//   uint32_t timebaseDenominator, timebaseNumerator
+//   uint32_t frameCount
+//   uint32_t unused
+// Frame header:
+//   uint32_t frameSize
+//   uint64_t pts
+// An AV1 frame holds a whole temporal unit (low-overhead bitstream format), a
+// VP9 frame a whole superframe, so each frame is a parser packet of its own.
+class IvfDemuxer : public VideoStreamDemuxer {
+
+    enum { IVF_FILE_HEADER_SIZE = 32, IVF_FRAME_HEADER_SIZE = 12 };
+
+    struct FrameEntry {
+        VkDeviceSize offset; // Of the frame data, past the frame header
+        uint32_t     size;
+        int64_t      pts;
+    };
+
+    // Reads the fixed-length fields of the sequence and frame headers
+    class BitReader {
+    public:
+        BitReader(const uint8_t* pData, size_t size)
+            : m_pData(pData), m_size(size), m_bitOffset(0) { }
+
+        uint32_t u(uint32_t numBits) {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < numBits; i++) {
+                uint32_t bit = 0;
+                if ((m_bitOffset >> 3) < m_size) {
+                    bit = (m_pData[m_bitOffset >> 3] >> (7 - (m_bitOffset & 7))) & 1;
+                }
+                value = (value << 1) | bit;
+                m_bitOffset++;
+            }
+            return value;
+        }
+
+        uint32_t uvlc() {
+            uint32_t leadingZeros = 0;
+            while ((leadingZeros < 32) && !IsOverrun() && (u(1) == 0)) {
+                leadingZeros++;
+            }
+            if (leadingZeros >= 32) {
+                return ~0U;
+            }
+            return u(leadingZeros) + ((1U << leadingZeros) - 1);
+        }
+
+        bool IsOverrun() const { return (m_bitOffset >> 3) > m_size; }
+
+    private:
+        const uint8_t* m_pData;
+        size_t         m_size;
+        size_t         m_bitOffset;
+    };
+
+    static uint16_t ReadLE16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    static uint32_t ReadLE32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+    static uint64_t ReadLE64(const uint8_t* p) { return (uint64_t)ReadLE32(p) | ((uint64_t)ReadLE32(p + 4) << 32); }
+
+public:
+    IvfDemuxer(const char *pFilePath,
+               int32_t defaultWidth,
+               int32_t defaultHeight,
+               int32_t defaultBitDepth)
+        : VideoStreamDemuxer(),
+          m_width(defaultWidth)
+        , m_height(defaultHeight)
+        , m_bitDepth(defaultBitDepth)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
+        , m_videoCodecType(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , m_timebaseNumerator(1)
+        , m_timebaseDenominator(1)
+        , m_headerFrameCount(0)
+        , m_inputVideoStreamMmap()
+        , m_pBitstreamData(nullptr)
+        , m_bitstreamDataSize(0)
+        , m_frames()
+        , m_currentFrame(0)
+        , m_frameTimestamp(0) {
+
+        std::error_code error;
+        m_inputVideoStreamMmap.map(pFilePath, 0, mio::map_entire_file, error);
+        if (error) {
+            return;
+        }
+
+        m_bitstreamDataSize = m_inputVideoStreamMmap.mapped_length();
+
+        m_pBitstreamData = m_inputVideoStreamMmap.data();
+    }
+
+    static bool IsIvfFile(const uint8_t* pData, size_t size)
+    {
+        return (size >= IVF_FILE_HEADER_SIZE) && (memcmp(pData, "DKIF", 4) == 0);
+    }
+
+    int32_t Initialize()
+    {
+        if ((m_pBitstreamData == nullptr) || !IsIvfFile(m_pBitstreamData, (size_t)m_bitstreamDataSize)) {
+            return -1;
+        }
+
+        const uint8_t* pHeader = m_pBitstreamData;
+        const uint32_t headerSize = ReadLE16(pHeader + 6);
+        if (memcmp(pHeader + 8, "AV01", 4) == 0) {
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+#ifdef VK_EXT_video_decode_vp9
+        } else if (memcmp(pHeader + 8, "VP90", 4) == 0) {
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+#endif // VK_EXT_video_decode_vp9
+        } else {
+            std::cerr << "IVF: unsupported FourCC " << std::string((const char*)pHeader + 8, 4) << std::endl;
+            return -1;
+        }
+
+        if (ReadLE16(pHeader + 12) && ReadLE16(pHeader + 14)) {
+            m_width = ReadLE16(pHeader + 12);
+            m_height = ReadLE16(pHeader + 14);
+        }
+        if (ReadLE32(pHeader + 16) && ReadLE32(pHeader + 20)) {
+            m_timebaseDenominator = ReadLE32(pHeader + 16);
+            m_timebaseNumerator = ReadLE32(pHeader + 20);
+        }
+        m_headerFrameCount = ReadLE32(pHeader + 24);
+
+        IndexFrames(std::max<uint32_t>(headerSize, IVF_FILE_HEADER_SIZE));
+        if (m_frames.empty()) {
+            std::cerr << "IVF: no frame in the stream" << std::endl;
+            return -1;
+        }
+
+        const FrameEntry& firstFrame = m_frames[0];
+        if (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+            ParseAv1SequenceHeader(m_pBitstreamData + firstFrame.offset, firstFrame.size);
+        } else {
+            ParseVp9FrameHeader(m_pBitstreamData + firstFrame.offset, firstFrame.size);
+        }
+
+        return 0;
+    }
+
+    static VkResult Create(const char *pFilePath,
+                           int32_t defaultWidth,
+                           int32_t defaultHeight,
+                           int32_t defaultBitDepth,
+                           VkSharedBaseObj<IvfDemuxer>& ivfDemuxer)
+    {
+        VkSharedBaseObj<IvfDemuxer> newIvfDemuxer(new IvfDemuxer(pFilePath,
+                                                                 defaultWidth,
+                                                                 defaultHeight,
+                                                                 defaultBitDepth));
+
+         if ((newIvfDemuxer) && (newIvfDemuxer->Initialize() >= 0)) {
+             ivfDemuxer = newIvfDemuxer;
+             return VK_SUCCESS;
+         }
+         return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual ~IvfDemuxer() {
+        m_inputVideoStreamMmap.unmap();
+    }
+
+    virtual bool IsStreamDemuxerEnabled() const { return true; }
+    virtual bool HasFramePreparser() const { return true; }
+    virtual void Rewind() { SeekFrame(0); }
+    virtual VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_videoCodecType; }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetLumaBitDepth() const
+    {
+        switch (m_bitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+            break;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+            break;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+            break;
+        default:
+            assert(!"Unknown Luma Bit Depth!");
+        }
+        assert(!"Unknown Luma Bit Depth!");
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
+    {
+        return m_chromaSubsampling;
+    }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
+    {
+        if (m_chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) {
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+        }
+        return GetLumaBitDepth();
+    }
+
+    virtual uint32_t GetProfileIdc() const
+    {
+        return m_profileIdc;
+    }
+
+    virtual int32_t GetWidth() const { return m_width; }
+    virtual int32_t GetHeight() const { return m_height; }
+    virtual int32_t GetBitDepth() const { return m_bitDepth; }
+
+    // Returns the frame data in place in the mapped file
+    virtual int64_t DemuxFrame(const uint8_t **ppVideo) {
+
+        if (m_currentFrame >= m_frames.size()) {
+            m_frameTimestamp = 0;
+            return 0;
+        }
+
+        const FrameEntry& frame = m_frames[m_currentFrame++];
+        *ppVideo = m_pBitstreamData + frame.offset;
+        m_frameTimestamp = frame.pts;
+        return frame.size;
+    }
+
+    virtual int64_t GetFrameTimestamp() const { return m_frameTimestamp; }
+
+    virtual bool HasFrameDiscontinuity() const { return false; }
+
+    virtual int64_t ReadBitstreamData(const uint8_t**, int64_t) {
+        return -1;
+    }
+
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        size = 0;
+        return nullptr;
+    }
+    virtual bool IsAv1AnnexB() const { return false; }
+
+    // The next DemuxFrame() returns the frameIndex frame of the file
+    bool SeekFrame(size_t frameIndex)
+    {
+        if (frameIndex > m_frames.size()) {
+            return false;
+        }
+        m_currentFrame = frameIndex;
+        m_frameTimestamp = 0;
+        return true;
+    }
+
+    virtual void DumpStreamParameters() const {
+
+        std::cout << "Container: IVF" << std::endl;
+        std::cout << "Width: "    << m_width << std::endl;
+        std::cout << "Height: "   << m_height <<  std::endl;
+        std::cout << "BitDepth: " << m_bitDepth << std::endl;
+        std::cout << "Profile: "  << m_profileIdc << std::endl;
+        std::cout << "Time base: " << m_timebaseNumerator << "/" << m_timebaseDenominator << std::endl;
+        std::cout << "Frames: "   << m_frames.size() << " (header: " << m_headerFrameCount << ")" << std::endl;
+    }
+
+private:
+
+    // Builds the frame index, up to the first truncated frame
+    void IndexFrames(uint32_t headerSize)
+    {
+        // The frame count of the header is not trusted: each frame takes at least its frame header
+        if ((m_headerFrameCount != 0) && (headerSize < m_bitstreamDataSize)) {
+            m_frames.reserve(std::min<VkDeviceSize>(m_headerFrameCount,
+                                                    (m_bitstreamDataSize - headerSize) / IVF_FRAME_HEADER_SIZE));
+        }
+
+        VkDeviceSize offset = headerSize;
+        while ((offset + IVF_FRAME_HEADER_SIZE) <= m_bitstreamDataSize) {
+            const uint8_t* pFrameHeader = m_pBitstreamData + offset;
+            FrameEntry frame;
+            frame.offset = offset + IVF_FRAME_HEADER_SIZE;
+            frame.size = ReadLE32(pFrameHeader);
+            frame.pts = (int64_t)ReadLE64(pFrameHeader + 4);
+            if ((frame.offset + frame.size) > m_bitstreamDataSize) {
+                std::cerr << "IVF: truncated frame " << m_frames.size() << std::endl;
+                break;
+            }
+            m_frames.push_back(frame);
+            offset = frame.offset + frame.size;
+        }
+    }
+
+    // Fills in the profile, size, bit depth and chroma subsampling from the sequence
+    // header OBU of the first temporal unit, see section 5.5 of the AV1 specification
+    void ParseAv1SequenceHeader(const uint8_t* pData, size_t size)
+    {
+        enum { OBU_SEQUENCE_HEADER = 1 };
+
+        size_t offset = 0;
+        while (offset < size) {
+            const uint8_t obuHeader = pData[offset];
+            const uint32_t obuType = (obuHeader >> 3) & 0xf;
+            const bool hasExtension = (obuHeader >> 2) & 1;
+            const bool hasSizeField = (obuHeader >> 1) & 1;
+            offset += hasExtension ? 2 : 1;
+
+            uint64_t obuSize = size - std::min(offset, size);
+            if (hasSizeField) {
+                obuSize = 0;
+                for (uint32_t i = 0; (i < 8) && (offset < size); i++) {
+                    const uint8_t byte = pData[offset++];
+                    obuSize |= (uint64_t)(byte & 0x7f) << (i * 7);
+                    if (!(byte & 0x80)) {
+                        break;
+                    }
+                }
+            }
+            if ((offset > size) || (obuSize > (size - offset))) {
+                return;
+            }
+
+            if (obuType == OBU_SEQUENCE_HEADER) {
+                ParseAv1SequenceHeaderObu(pData + offset, (size_t)obuSize);
+                return;
+            }
+            offset += (size_t)obuSize;
+        }
+    }
+
+    void ParseAv1SequenceHeaderObu(const uint8_t* pData, size_t size)
+    {
+        BitReader bs(pData, size);
+
+        const uint32_t seqProfile = bs.u(3);
+        bs.u(1); // still_picture
+        const bool reducedStillPictureHeader = bs.u(1);
+        if (reducedStillPictureHeader) {
+            bs.u(5); // seq_level_idx[0]
+        } else {
+            bool decoderModelInfoPresent = false;
+            uint32_t bufferDelayLength = 0;
+            if (bs.u(1)) { // timing_info_present_flag
+                bs.u(32); // num_units_in_display_tick
+                bs.u(32); // time_scale
+                if (bs.u(1)) { // equal_picture_interval
+                    bs.uvlc(); // num_ticks_per_picture_minus_1
+                }
+                decoderModelInfoPresent = bs.u(1);
+                if (decoderModelInfoPresent) {
+                    bufferDelayLength = bs.u(5) + 1;
+                    bs.u(32); // num_units_in_decoding_tick
+                    bs.u(5);  // buffer_removal_time_length_minus_1
+                    bs.u(5);  // frame_presentation_time_length_minus_1
+                }
+            }
+            const bool initialDisplayDelayPresent = bs.u(1);
+            const uint32_t operatingPointsCnt = bs.u(5) + 1;
+            for (uint32_t i = 0; i < operatingPointsCnt; i++) {
+                bs.u(12); // operating_point_idc[i]
+                if (bs.u(5) > 7) { // seq_level_idx[i]
+                    bs.u(1); // seq_tier[i]
+                }
+                if (decoderModelInfoPresent && bs.u(1)) { // decoder_model_present_for_this_op[i]
+                    bs.u(bufferDelayLength); // decoder_buffer_delay
+                    bs.u(bufferDelayLength); // encoder_buffer_delay
+                    bs.u(1); // low_delay_mode_flag
+                }
+                if (initialDisplayDelayPresent && bs.u(1)) { // initial_display_delay_present_for_this_op[i]
+                    bs.u(4); // initial_display_delay_minus_1[i]
+                }
+            }
+        }
+
+        const uint32_t frameWidthBits = bs.u(4) + 1;
+        const uint32_t frameHeightBits = bs.u(4) + 1;
+        const int32_t maxFrameWidth = (int32_t)bs.u(frameWidthBits) + 1;
+        const int32_t maxFrameHeight = (int32_t)bs.u(frameHeightBits) + 1;
+        if (!reducedStillPictureHeader && bs.u(1)) { // frame_id_numbers_present_flag
+            bs.u(4); // delta_frame_id_length_minus_2
+            bs.u(3); // additional_frame_id_length_minus_1
+        }
+        bs.u(1); // use_128x128_superblock
+        bs.u(1); // enable_filter_intra
+        bs.u(1); // enable_intra_edge_filter
+        if (!reducedStillPictureHeader) {
+            bs.u(4); // enable_interintra_compound, enable_masked_compound, enable_warped_motion, enable_dual_filter
+            const bool enableOrderHint = bs.u(1);
+            if (enableOrderHint) {
+                bs.u(2); // enable_jnt_comp, enable_ref_frame_mvs
+            }
+            uint32_t seqForceScreenContentTools = 2; // SELECT_SCREEN_CONTENT_TOOLS
+            if (!bs.u(1)) { // seq_choose_screen_content_tools
+                seqForceScreenContentTools = bs.u(1);
+            }
+            if ((seqForceScreenContentTools > 0) && !bs.u(1)) { // seq_choose_integer_mv
+                bs.u(1); // seq_force_integer_mv
+            }
+            if (enableOrderHint) {
+                bs.u(3); // order_hint_bits_minus_1
+            }
+        }
+        bs.u(3); // enable_superres, enable_cdef, enable_restoration
+
+        // color_config()
+        int32_t bitDepth = 8;
+        if (bs.u(1)) { // high_bitdepth
+            bitDepth = ((seqProfile == 2) && bs.u(1)) ? 12 : 10; // twelve_bit
+        }
+        const bool monoChrome = (seqProfile == 1) ? false : bs.u(1);
+        uint32_t colorPrimaries = 2, transferCharacteristics = 2, matrixCoefficients = 2; // CP/TC/MC_UNSPECIFIED
+        if (bs.u(1)) { // color_description_present_flag
+            colorPrimaries = bs.u(8);
+            transferCharacteristics = bs.u(8);
+            matrixCoefficients = bs.u(8);
+        }
+        VkVideoChromaSubsamplingFlagsKHR chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+        if (monoChrome) {
+            chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+        } else if ((colorPrimaries == 1) && (transferCharacteristics == 13) && (matrixCoefficients == 0)) { // sRGB
+            chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        } else {
+            bs.u(1); // color_range
+            if (seqProfile == 1) {
+                chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+            } else if (seqProfile == 2) {
+                chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+                if ((bitDepth == 12) && bs.u(1)) { // subsampling_x
+                    chromaSubsampling = bs.u(1) ? VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR : // subsampling_y
+                                                  VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+                } else if (bitDepth == 12) {
+                    chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+                }
+            }
+        }
+
+        if (bs.IsOverrun()) {
+            std::cerr << "IVF: truncated AV1 sequence header" << std::endl;
+            return;
+        }
+
+        m_profileIdc = seqProfile;
+        m_width = maxFrameWidth;
+        m_height = maxFrameHeight;
+        m_bitDepth = bitDepth;
+        m_chromaSubsampling = chromaSubsampling;
+    }
+
+    // Fills in the profile and, for the key frames of the profiles 2 and 3, the bit depth
+    // from the uncompressed header of the first frame, see section 6.2 of the VP9 specification.
+    // The frame size stays the one of the IVF header.
+    void ParseVp9FrameHeader(const uint8_t* pData, size_t size)
+    {
+        BitReader bs(pData, size);
+
+        if (bs.u(2) != 2) { // frame_marker
+            return;
+        }
+        const uint32_t profileLowBit = bs.u(1);
+        const uint32_t profileHighBit = bs.u(1);
+        const uint32_t profile = (profileHighBit << 1) + profileLowBit;
+        if (profile == 3) {
+            bs.u(1); // reserved_zero
+        }
+        m_profileIdc = profile;
+
+        if (bs.u(1)) { // show_existing_frame
+            return;
+        }
+        const bool keyFrame = (bs.u(1) == 0); // frame_type
+        bs.u(2); // show_frame, error_resilient_mode
+        if (keyFrame && (bs.u(24) == 0x498342) && (profile >= 2)) { // frame_sync_code
+            m_bitDepth = bs.u(1) ? 12 : 10; // ten_or_twelve_bit
+        }
+    }
+
+    int32_t    m_width, m_height, m_bitDepth;
+    uint32_t   m_profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
+    VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
+    uint32_t   m_timebaseNumerator;
+    uint32_t   m_timebaseDenominator;
+    uint32_t   m_headerFrameCount;
+    mio::basic_mmap<mio::access_mode::read, uint8_t> m_inputVideoStreamMmap;
+    const uint8_t* m_pBitstreamData;
+    VkDeviceSize   m_bitstreamDataSize;
+    std::vector<FrameEntry> m_frames;
+    size_t         m_currentFrame;
+    int64_t        m_frameTimestamp;
+};
+
+VkResult IvfDemuxerCreate(const char *pFilePath,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    VkSharedBaseObj<IvfDemuxer> ivfDemuxer;
+    VkResult result = IvfDemuxer::Create(pFilePath,
+                                         defaultWidth,
+                                         defaultHeight,
+                                         defaultBitDepth,
+                                         ivfDemuxer);
+    if (result == VK_SUCCESS) {
+        videoStreamDemuxer = ivfDemuxer;
+    }
+
+    return result;
+}
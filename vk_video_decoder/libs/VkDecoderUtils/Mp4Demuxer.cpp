@@ -0,0 +1,996 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "mio/mio.hpp"
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+
+// ISO base media file format (MP4) demuxer of the first video track of a file, see
+// ISO/IEC 14496-12 and 14496-15. The sample tables of the track (stsz/stz2, stco/co64,
+// stsc, stts, ctts, stss) and the track fragments of the fragmented files (moof/traf/trun)
+// are flattened into one index of the samples in decode order when the file is opened.
+// The samples are then returned in place in the mapped file: H.264/H.265 samples keep
+// their length-prefixed NAL units, to be parsed along with the avcC/hvcC record of
+// GetDecoderConfigurationRecord(), AV1 samples are whole temporal units.
+// All the offsets and box sizes are 64-bit, for files larger than 4 GB.
+class Mp4Demuxer : public VideoStreamDemuxer {
+
+    static uint32_t FourCC(const char* pName)
+    {
+        return ((uint32_t)pName[0] << 24) | ((uint32_t)pName[1] << 16) | ((uint32_t)pName[2] << 8) | (uint32_t)pName[3];
+    }
+
+    struct Box {
+        uint32_t     type;
+        VkDeviceSize offset;  // Of the box header
+        VkDeviceSize payload; // Of the box payload, past the (large) size and the type
+        VkDeviceSize end;
+    };
+
+    struct Sample {
+        VkDeviceSize offset;
+        uint32_t     size;
+        bool         isSync;
+        int64_t      dts;
+        int64_t      pts;
+    };
+
+    // Defaults of the track fragments, from the trex box of the movie
+    struct TrackExtends {
+        uint32_t trackId;
+        uint32_t defaultSampleDuration;
+        uint32_t defaultSampleSize;
+        uint32_t defaultSampleFlags;
+    };
+
+    enum {
+        // tfhd flags
+        TFHD_BASE_DATA_OFFSET_PRESENT         = 0x000001,
+        TFHD_SAMPLE_DESCRIPTION_INDEX_PRESENT = 0x000002,
+        TFHD_DEFAULT_SAMPLE_DURATION_PRESENT  = 0x000008,
+        TFHD_DEFAULT_SAMPLE_SIZE_PRESENT      = 0x000010,
+        TFHD_DEFAULT_SAMPLE_FLAGS_PRESENT     = 0x000020,
+        // trun flags
+        TRUN_DATA_OFFSET_PRESENT                     = 0x000001,
+        TRUN_FIRST_SAMPLE_FLAGS_PRESENT              = 0x000004,
+        TRUN_SAMPLE_DURATION_PRESENT                 = 0x000100,
+        TRUN_SAMPLE_SIZE_PRESENT                     = 0x000200,
+        TRUN_SAMPLE_FLAGS_PRESENT                    = 0x000400,
+        TRUN_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT = 0x000800,
+        // sample_flags
+        SAMPLE_IS_NON_SYNC_SAMPLE = 0x10000,
+    };
+
+    static uint16_t ReadBE16(const uint8_t* p) { return (uint16_t)((p[0] << 8) | p[1]); }
+    static uint32_t ReadBE32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+    static uint64_t ReadBE64(const uint8_t* p) { return ((uint64_t)ReadBE32(p) << 32) | (uint64_t)ReadBE32(p + 4); }
+
+public:
+    Mp4Demuxer(const char *pFilePath,
+               int32_t defaultWidth,
+               int32_t defaultHeight,
+               int32_t defaultBitDepth)
+        : VideoStreamDemuxer(),
+          m_width(defaultWidth)
+        , m_height(defaultHeight)
+        , m_bitDepth(defaultBitDepth)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
+        , m_videoCodecType(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , m_trackId(0)
+        , m_timescale(0)
+        , m_movieTimescale(0)
+        , m_presentationOffset(0)
+        , m_pConfigurationRecord(nullptr)
+        , m_configurationRecordSize(0)
+        , m_inputVideoStreamMmap()
+        , m_pBitstreamData(nullptr)
+        , m_bitstreamDataSize(0)
+        , m_trackExtends()
+        , m_samples()
+        , m_syncSamples()
+        , m_nextFragmentDts(0)
+        , m_currentSample(0)
+        , m_frameTimestamp(0) {
+
+        std::error_code error;
+        m_inputVideoStreamMmap.map(pFilePath, 0, mio::map_entire_file, error);
+        if (error) {
+            return;
+        }
+
+        m_bitstreamDataSize = m_inputVideoStreamMmap.mapped_length();
+
+        m_pBitstreamData = m_inputVideoStreamMmap.data();
+    }
+
+    // An MP4 file starts with a ftyp box (styp in segments), or with another top-level box in old
+    // QuickTime files. The same boxes as in the MP4 probe of VideoStreamProbe.cpp.
+    static bool IsMp4File(const uint8_t* pData, size_t size)
+    {
+        static const char* const firstBoxes[] = { "ftyp", "styp", "moov", "mdat", "moof", "free", "skip", "wide", "pdin" };
+        if (size < 8) {
+            return false;
+        }
+        const uint32_t type = ReadBE32(pData + 4);
+        for (size_t i = 0; i < sizeof(firstBoxes) / sizeof(firstBoxes[0]); i++) {
+            if (type == FourCC(firstBoxes[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int32_t Initialize()
+    {
+        if ((m_pBitstreamData == nullptr) || !IsMp4File(m_pBitstreamData, (size_t)m_bitstreamDataSize)) {
+            return -1;
+        }
+
+        // The moov box comes first in streamable files, after the mdat box otherwise,
+        // and always before the movie fragments it describes.
+        std::vector<VkDeviceSize> movieFragments;
+        VkDeviceSize offset = 0;
+        Box box;
+        while (ReadBox(offset, m_bitstreamDataSize, box)) {
+            if (box.type == FourCC("moov")) {
+                ParseMovie(box);
+            } else if (box.type == FourCC("moof")) {
+                movieFragments.push_back(box.offset);
+            }
+            offset = box.end;
+        }
+
+        if (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+            std::cerr << "MP4: no supported video track" << std::endl;
+            return -1;
+        }
+
+        for (size_t i = 0; i < movieFragments.size(); i++) {
+            offset = movieFragments[i];
+            if (ReadBox(offset, m_bitstreamDataSize, box)) {
+                ParseMovieFragment(box);
+            }
+        }
+
+        if (m_samples.empty()) {
+            std::cerr << "MP4: no sample in the video track" << std::endl;
+            return -1;
+        }
+
+        for (size_t i = 0; i < m_samples.size(); i++) {
+            if (m_samples[i].isSync) {
+                m_syncSamples.push_back(i);
+            }
+        }
+
+        return 0;
+    }
+
+    static VkResult Create(const char *pFilePath,
+                           int32_t defaultWidth,
+                           int32_t defaultHeight,
+                           int32_t defaultBitDepth,
+                           VkSharedBaseObj<Mp4Demuxer>& mp4Demuxer)
+    {
+        VkSharedBaseObj<Mp4Demuxer> newMp4Demuxer(new Mp4Demuxer(pFilePath,
+                                                                 defaultWidth,
+                                                                 defaultHeight,
+                                                                 defaultBitDepth));
+
+         if ((newMp4Demuxer) && (newMp4Demuxer->Initialize() >= 0)) {
+             mp4Demuxer = newMp4Demuxer;
+             return VK_SUCCESS;
+         }
+         return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual ~Mp4Demuxer() {
+        m_inputVideoStreamMmap.unmap();
+    }
+
+    virtual bool IsStreamDemuxerEnabled() const { return true; }
+    virtual bool HasFramePreparser() const { return true; }
+    virtual void Rewind() { SeekFrame(0); }
+    virtual VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_videoCodecType; }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetLumaBitDepth() const
+    {
+        switch (m_bitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+            break;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+            break;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+            break;
+        default:
+            assert(!"Unknown Luma Bit Depth!");
+        }
+        assert(!"Unknown Luma Bit Depth!");
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
+    {
+        return m_chromaSubsampling;
+    }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
+    {
+        if (m_chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) {
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+        }
+        return GetLumaBitDepth();
+    }
+
+    virtual uint32_t GetProfileIdc() const
+    {
+        return m_profileIdc;
+    }
+
+    virtual int32_t GetWidth() const { return m_width; }
+    virtual int32_t GetHeight() const { return m_height; }
+    virtual int32_t GetBitDepth() const { return m_bitDepth; }
+
+    // Returns the sample data in place in the mapped file
+    virtual int64_t DemuxFrame(const uint8_t **ppVideo) {
+
+        if (m_currentSample >= m_samples.size()) {
+            m_frameTimestamp = 0;
+            return 0;
+        }
+
+        const Sample& sample = m_samples[m_currentSample++];
+        *ppVideo = m_pBitstreamData + sample.offset;
+        m_frameTimestamp = sample.pts;
+        return sample.size;
+    }
+
+    // In the media timescale of the track
+    virtual int64_t GetFrameTimestamp() const { return m_frameTimestamp; }
+
+    virtual bool HasFrameDiscontinuity() const { return false; }
+
+    virtual int64_t ReadBitstreamData(const uint8_t**, int64_t) {
+        return -1;
+    }
+
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        size = m_configurationRecordSize;
+        return m_pConfigurationRecord;
+    }
+    virtual bool IsAv1AnnexB() const { return false; }
+
+    // The next DemuxFrame() returns the sampleIndex sample of the track, in decode order
+    bool SeekFrame(size_t sampleIndex)
+    {
+        if (sampleIndex > m_samples.size()) {
+            return false;
+        }
+        m_currentSample = sampleIndex;
+        m_frameTimestamp = 0;
+        return true;
+    }
+
+    // The next DemuxFrame() returns the last sync sample presented at or before pts, or the first one
+    bool SeekKeyFrame(int64_t pts)
+    {
+        if (m_syncSamples.empty()) {
+            return false;
+        }
+        // The sync samples have increasing presentation time stamps
+        size_t first = 0, count = m_syncSamples.size();
+        while (count > 0) {
+            const size_t step = count / 2;
+            if (m_samples[m_syncSamples[first + step]].pts <= pts) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return SeekFrame(m_syncSamples[(first > 0) ? (first - 1) : 0]);
+    }
+
+    virtual void DumpStreamParameters() const {
+
+        std::cout << "Container: MP4" << std::endl;
+        std::cout << "Width: "    << m_width << std::endl;
+        std::cout << "Height: "   << m_height <<  std::endl;
+        std::cout << "BitDepth: " << m_bitDepth << std::endl;
+        std::cout << "Profile: "  << m_profileIdc << std::endl;
+        std::cout << "Track: "    << m_trackId << ", timescale " << m_timescale << std::endl;
+        std::cout << "Samples: "  << m_samples.size() << " (" << m_syncSamples.size() << " sync samples)" << std::endl;
+    }
+
+private:
+
+    // Reads the header of the box at offset, which must end before end
+    bool ReadBox(VkDeviceSize offset, VkDeviceSize end, Box& box) const
+    {
+        if ((offset + 8) > end) {
+            return false;
+        }
+        const uint8_t* pHeader = m_pBitstreamData + offset;
+        uint64_t size = ReadBE32(pHeader);
+        box.type = ReadBE32(pHeader + 4);
+        box.offset = offset;
+        box.payload = offset + 8;
+        if (size == 1) { // largesize
+            if ((offset + 16) > end) {
+                return false;
+            }
+            size = ReadBE64(pHeader + 8);
+            box.payload += 8;
+        } else if (size == 0) { // Up to the end of the enclosing box
+            size = end - offset;
+        }
+        if ((size < (box.payload - offset)) || (size > (end - offset))) {
+            return false;
+        }
+        box.end = offset + size;
+        return true;
+    }
+
+    // Finds the first child box of the given type
+    bool FindBox(const Box& parent, VkDeviceSize childrenOffset, const char* pType, Box& box) const
+    {
+        const uint32_t type = FourCC(pType);
+        for (VkDeviceSize offset = childrenOffset; ReadBox(offset, parent.end, box); offset = box.end) {
+            if (box.type == type) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FindBox(const Box& parent, const char* pType, Box& box) const
+    {
+        return FindBox(parent, parent.payload, pType, box);
+    }
+
+    // Returns the payload size of a full box, past its version and flags, or 0 if it is truncated
+    VkDeviceSize FullBoxPayloadSize(const Box& box, VkDeviceSize minSize) const
+    {
+        const VkDeviceSize size = box.end - box.payload;
+        return (size >= (4 + minSize)) ? size : 0;
+    }
+
+    void ParseMovie(const Box& moov)
+    {
+        Box box;
+        for (VkDeviceSize offset = moov.payload; ReadBox(offset, moov.end, box); offset = box.end) {
+            if ((box.type == FourCC("mvhd")) && (FullBoxPayloadSize(box, 20) != 0)) {
+                const uint8_t* p = m_pBitstreamData + box.payload;
+                m_movieTimescale = ReadBE32(p + ((p[0] == 1) ? 20 : 12));
+            } else if (box.type == FourCC("mvex")) {
+                Box trex;
+                for (VkDeviceSize trexOffset = box.payload; FindBox(box, trexOffset, "trex", trex); trexOffset = trex.end) {
+                    if (FullBoxPayloadSize(trex, 20) != 0) {
+                        const uint8_t* p = m_pBitstreamData + trex.payload + 4;
+                        TrackExtends trackExtends = { ReadBE32(p), ReadBE32(p + 8), ReadBE32(p + 12), ReadBE32(p + 16) };
+                        m_trackExtends.push_back(trackExtends);
+                    }
+                }
+            } else if ((box.type == FourCC("trak")) && (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR)) {
+                ParseTrack(box);
+            }
+        }
+    }
+
+    void ParseTrack(const Box& trak)
+    {
+        Box tkhd, mdia, mdhd, hdlr, minf, stbl;
+        if (!FindBox(trak, "tkhd", tkhd) || !FindBox(trak, "mdia", mdia) ||
+            !FindBox(mdia, "mdhd", mdhd) || !FindBox(mdia, "hdlr", hdlr) ||
+            !FindBox(mdia, "minf", minf) || !FindBox(minf, "stbl", stbl)) {
+            return;
+        }
+        if ((FullBoxPayloadSize(hdlr, 8) == 0) || (ReadBE32(m_pBitstreamData + hdlr.payload + 8) != FourCC("vide"))) {
+            return;
+        }
+
+        const uint8_t* p = m_pBitstreamData + tkhd.payload;
+        const bool tkhdVersion1 = (p[0] == 1);
+        if (FullBoxPayloadSize(tkhd, tkhdVersion1 ? 20 : 12) == 0) {
+            return;
+        }
+        const uint32_t trackId = ReadBE32(p + (tkhdVersion1 ? 20 : 12));
+
+        p = m_pBitstreamData + mdhd.payload;
+        const bool mdhdVersion1 = (p[0] == 1);
+        if (FullBoxPayloadSize(mdhd, mdhdVersion1 ? 20 : 12) == 0) {
+            return;
+        }
+        const uint32_t timescale = ReadBE32(p + (mdhdVersion1 ? 20 : 12));
+
+        Box stsd;
+        if (!FindBox(stbl, "stsd", stsd) || !ParseSampleDescription(stsd)) {
+            return;
+        }
+
+        m_trackId = trackId;
+        m_timescale = timescale;
+        Box edts;
+        if (FindBox(trak, "edts", edts)) {
+            ParseEditList(edts);
+        }
+        BuildSampleTable(stbl);
+    }
+
+    // Only the start of the presentation is taken from the edit list: the initial empty edits delay
+    // it, the media time of the first edit is presented first. The other edits are ignored.
+    void ParseEditList(const Box& edts)
+    {
+        Box elst;
+        if (!FindBox(edts, "elst", elst) || (FullBoxPayloadSize(elst, 4) == 0)) {
+            return;
+        }
+        const uint8_t* p = m_pBitstreamData + elst.payload;
+        const bool version1 = (p[0] == 1);
+        const uint32_t entrySize = version1 ? 20 : 12;
+        const uint64_t numEntries = std::min<uint64_t>(ReadBE32(p + 4), (elst.end - elst.payload - 8) / entrySize);
+        p += 8;
+
+        int64_t emptyDuration = 0;
+        for (uint64_t i = 0; i < numEntries; i++, p += entrySize) {
+            const uint64_t segmentDuration = version1 ? ReadBE64(p) : ReadBE32(p);
+            const int64_t mediaTime = version1 ? (int64_t)ReadBE64(p + 8) : (int32_t)ReadBE32(p + 4);
+            if (mediaTime == -1) {
+                // In the movie timescale
+                if (m_movieTimescale != 0) {
+                    emptyDuration += (int64_t)(segmentDuration * m_timescale / m_movieTimescale);
+                }
+                continue;
+            }
+            m_presentationOffset = emptyDuration - mediaTime;
+            return;
+        }
+    }
+
+    // Selects the codec from the first sample entry, the other ones are ignored
+    bool ParseSampleDescription(const Box& stsd)
+    {
+        Box entry;
+        if ((FullBoxPayloadSize(stsd, 4) == 0) || !ReadBox(stsd.payload + 8, stsd.end, entry)) {
+            return false;
+        }
+
+        // VisualSampleEntry: 78 bytes of fields, then the child boxes
+        static const VkDeviceSize visualSampleEntrySize = 78;
+        if ((entry.end - entry.payload) < visualSampleEntrySize) {
+            return false;
+        }
+        const uint8_t* p = m_pBitstreamData + entry.payload;
+        const int32_t width = ReadBE16(p + 24);
+        const int32_t height = ReadBE16(p + 26);
+
+        Box config;
+        Box children = entry;
+        children.payload = entry.payload + visualSampleEntrySize;
+        if ((entry.type == FourCC("avc1")) || (entry.type == FourCC("avc3"))) {
+            if (!FindBox(children, "avcC", config) || !ParseAvcConfigurationRecord(config)) {
+                return false;
+            }
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+        } else if ((entry.type == FourCC("hvc1")) || (entry.type == FourCC("hev1"))) {
+            if (!FindBox(children, "hvcC", config) || !ParseHevcConfigurationRecord(config)) {
+                return false;
+            }
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+        } else if (entry.type == FourCC("av01")) {
+            if (!FindBox(children, "av1C", config) || !ParseAv1ConfigurationRecord(config)) {
+                return false;
+            }
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+#ifdef VK_EXT_video_decode_vp9
+        } else if (entry.type == FourCC("vp09")) {
+            if (!FindBox(children, "vpcC", config) || !ParseVpxConfigurationRecord(config)) {
+                return false;
+            }
+            m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+#endif // VK_EXT_video_decode_vp9
+        } else {
+            return false;
+        }
+
+        if ((width != 0) && (height != 0)) {
+            m_width = width;
+            m_height = height;
+        }
+        return true;
+    }
+
+    // AVCDecoderConfigurationRecord, ISO/IEC 14496-15 5.3.3.1. The chroma format and the bit depths
+    // are only present after the parameter sets with the High profiles.
+    bool ParseAvcConfigurationRecord(const Box& avcC)
+    {
+        const uint8_t* p = m_pBitstreamData + avcC.payload;
+        const size_t size = (size_t)(avcC.end - avcC.payload);
+        if ((size < 7) || (p[0] != 1)) {
+            return false;
+        }
+        m_profileIdc = p[1];
+        m_bitDepth = 8;
+        m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+
+        size_t offset = 5;
+        for (uint32_t type = 0; type < 2; type++) {
+            if (offset >= size) {
+                return false;
+            }
+            uint32_t numParameterSets = p[offset++] & ((type == 0) ? 0x1f : 0xff);
+            for (uint32_t i = 0; i < numParameterSets; i++) {
+                if ((offset + 2) > size) {
+                    return false;
+                }
+                offset += 2 + ReadBE16(p + offset);
+            }
+        }
+        if (offset > size) {
+            return false;
+        }
+        const bool hasHighProfileFields = (m_profileIdc != STD_VIDEO_H264_PROFILE_IDC_BASELINE) &&
+                                          (m_profileIdc != STD_VIDEO_H264_PROFILE_IDC_MAIN) &&
+                                          (m_profileIdc != 88); // Extended
+        if (hasHighProfileFields && ((offset + 3) <= size)) {
+            m_chromaSubsampling = ChromaFormatIdcToSubsampling(p[offset] & 3);
+            m_bitDepth = (p[offset + 1] & 7) + 8;
+        }
+
+        m_pConfigurationRecord = p;
+        m_configurationRecordSize = size;
+        return true;
+    }
+
+    // HEVCDecoderConfigurationRecord, ISO/IEC 14496-15 8.3.3.1
+    bool ParseHevcConfigurationRecord(const Box& hvcC)
+    {
+        const uint8_t* p = m_pBitstreamData + hvcC.payload;
+        const size_t size = (size_t)(hvcC.end - hvcC.payload);
+        if (size < 23) {
+            return false;
+        }
+        m_profileIdc = p[1] & 0x1f;
+        m_chromaSubsampling = ChromaFormatIdcToSubsampling(p[16] & 3);
+        m_bitDepth = (p[17] & 7) + 8;
+
+        m_pConfigurationRecord = p;
+        m_configurationRecordSize = size;
+        return true;
+    }
+
+    // AV1CodecConfigurationRecord, AV1 Codec ISO Media File Format Binding 2.3.3. The sequence
+    // header is repeated in the sync samples, so the configuration OBUs are not needed.
+    bool ParseAv1ConfigurationRecord(const Box& av1C)
+    {
+        const uint8_t* p = m_pBitstreamData + av1C.payload;
+        if (((av1C.end - av1C.payload) < 4) || (p[0] != 0x81)) { // marker, version
+            return false;
+        }
+        m_profileIdc = p[1] >> 5;
+        const bool highBitdepth = (p[2] >> 6) & 1;
+        const bool twelveBit = (p[2] >> 5) & 1;
+        const bool monochrome = (p[2] >> 4) & 1;
+        const bool subsamplingX = (p[2] >> 3) & 1;
+        const bool subsamplingY = (p[2] >> 2) & 1;
+        m_bitDepth = highBitdepth ? (twelveBit ? 12 : 10) : 8;
+        if (monochrome) {
+            m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+        } else if (subsamplingX) {
+            m_chromaSubsampling = subsamplingY ? VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR : VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+        } else {
+            m_chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        }
+        return true;
+    }
+
+#ifdef VK_EXT_video_decode_vp9
+    // VPCodecConfigurationRecord, VP Codec ISO Media File Format Binding 2.3.3
+    bool ParseVpxConfigurationRecord(const Box& vpcC)
+    {
+        if (FullBoxPayloadSize(vpcC, 3) == 0) {
+            return false;
+        }
+        const uint8_t* p = m_pBitstreamData + vpcC.payload + 4;
+        m_profileIdc = p[0];
+        m_bitDepth = p[2] >> 4;
+        const uint32_t chromaSubsampling = (p[2] >> 1) & 7;
+        m_chromaSubsampling = (chromaSubsampling <= 1) ? VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR :
+                              (chromaSubsampling == 2) ? VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR :
+                                                         VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        return true;
+    }
+#endif // VK_EXT_video_decode_vp9
+
+    static VkVideoChromaSubsamplingFlagsKHR ChromaFormatIdcToSubsampling(uint32_t chromaFormatIdc)
+    {
+        switch (chromaFormatIdc) {
+        case 0:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+        case 2:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+        case 3:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+        default:
+            return VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+        }
+    }
+
+    // Flattens the sample tables of a non-fragmented track. The samples are added up to the
+    // end of the shortest table, or up to the first one past the end of a truncated file.
+    void BuildSampleTable(const Box& stbl)
+    {
+        Box stsz, stsc, stco, stts, ctts, stss;
+        bool hasCompactSampleSizes = false;
+        if (!FindBox(stbl, "stsz", stsz)) {
+            hasCompactSampleSizes = true;
+            if (!FindBox(stbl, "stz2", stsz)) {
+                return;
+            }
+        }
+        bool hasLargeChunkOffsets = false;
+        if (!FindBox(stbl, "stco", stco)) {
+            hasLargeChunkOffsets = true;
+            if (!FindBox(stbl, "co64", stco)) {
+                return;
+            }
+        }
+        if (!FindBox(stbl, "stsc", stsc) || !FindBox(stbl, "stts", stts) ||
+            (FullBoxPayloadSize(stsz, 8) == 0) || (FullBoxPayloadSize(stco, 4) == 0) ||
+            (FullBoxPayloadSize(stsc, 4) == 0) || (FullBoxPayloadSize(stts, 4) == 0)) {
+            return; // Empty track, the samples are in the movie fragments if any
+        }
+
+        // stsz: sample_size, sample_count, entry_size[] / stz2: reserved, field_size, sample_count, entry_size[]
+        const uint8_t* pSizes = m_pBitstreamData + stsz.payload + 4;
+        const uint32_t constantSampleSize = hasCompactSampleSizes ? 0 : ReadBE32(pSizes);
+        const uint32_t sizeFieldBits = hasCompactSampleSizes ? (pSizes[3] & 0xff) : 32;
+        if ((sizeFieldBits != 4) && (sizeFieldBits != 8) && (sizeFieldBits != 16) && (sizeFieldBits != 32)) {
+            return;
+        }
+        uint64_t numSamples = ReadBE32(pSizes + 4);
+        if ((constantSampleSize == 0) &&
+            ((numSamples * sizeFieldBits + 7) / 8 > (stsz.end - stsz.payload - 12))) {
+            return;
+        }
+        pSizes += 8;
+
+        const uint8_t* pChunkOffsets = m_pBitstreamData + stco.payload + 8;
+        const uint32_t numChunks = (uint32_t)std::min<uint64_t>(ReadBE32(pChunkOffsets - 4),
+                                                                (stco.end - stco.payload - 8) / (hasLargeChunkOffsets ? 8 : 4));
+
+        const uint8_t* pSampleToChunk = m_pBitstreamData + stsc.payload + 8;
+        const uint32_t numSampleToChunkEntries = (uint32_t)std::min<uint64_t>(ReadBE32(pSampleToChunk - 4),
+                                                                              (stsc.end - stsc.payload - 8) / 12);
+
+        const uint8_t* pTimeToSample = m_pBitstreamData + stts.payload + 8;
+        const uint32_t numTimeToSampleEntries = (uint32_t)std::min<uint64_t>(ReadBE32(pTimeToSample - 4),
+                                                                             (stts.end - stts.payload - 8) / 8);
+
+        const uint8_t* pCompositionOffsets = nullptr;
+        uint32_t numCompositionOffsetEntries = 0;
+        if (FindBox(stbl, "ctts", ctts) && (FullBoxPayloadSize(ctts, 4) != 0)) {
+            pCompositionOffsets = m_pBitstreamData + ctts.payload + 8;
+            numCompositionOffsetEntries = (uint32_t)std::min<uint64_t>(ReadBE32(pCompositionOffsets - 4),
+                                                                       (ctts.end - ctts.payload - 8) / 8);
+        }
+
+        // Without a stss box, all the samples are sync samples
+        const uint8_t* pSyncSamples = nullptr;
+        uint32_t numSyncSamples = 0;
+        if (FindBox(stbl, "stss", stss) && (FullBoxPayloadSize(stss, 4) != 0)) {
+            pSyncSamples = m_pBitstreamData + stss.payload + 8;
+            numSyncSamples = (uint32_t)std::min<uint64_t>(ReadBE32(pSyncSamples - 4), (stss.end - stss.payload - 8) / 4);
+        }
+
+        // sample_count is not checked against the size of the box when the samples have a constant size:
+        // don't reserve more samples than the chunks hold and the file can contain
+        uint64_t maxSamplesPerChunk = 0;
+        for (uint32_t entry = 0; entry < numSampleToChunkEntries; entry++) {
+            maxSamplesPerChunk = std::max<uint64_t>(maxSamplesPerChunk, ReadBE32(pSampleToChunk + entry * 12 + 4));
+        }
+        uint64_t numReservedSamples = std::min<uint64_t>(numSamples, maxSamplesPerChunk * numChunks);
+        if (constantSampleSize != 0) {
+            numReservedSamples = std::min<uint64_t>(numReservedSamples, m_bitstreamDataSize / constantSampleSize);
+        }
+        m_samples.reserve((size_t)numReservedSamples);
+        uint32_t sampleToChunkEntry = 0, timeToSampleEntry = 0, timeToSampleCount = 0;
+        uint32_t compositionOffsetEntry = 0, compositionOffsetCount = 0, syncSample = 0;
+        int64_t dts = 0;
+        uint64_t sampleIndex = 0;
+        for (uint32_t chunk = 0; (chunk < numChunks) && (numSampleToChunkEntries > 0) && (sampleIndex < numSamples); chunk++) {
+            // stsc entries: first_chunk (1-based), samples_per_chunk, sample_description_index
+            while (((sampleToChunkEntry + 1) < numSampleToChunkEntries) &&
+                   (ReadBE32(pSampleToChunk + (sampleToChunkEntry + 1) * 12) <= (chunk + 1))) {
+                sampleToChunkEntry++;
+            }
+            const uint32_t samplesPerChunk = ReadBE32(pSampleToChunk + sampleToChunkEntry * 12 + 4);
+
+            VkDeviceSize offset = hasLargeChunkOffsets ? ReadBE64(pChunkOffsets + (size_t)chunk * 8) :
+                                                         ReadBE32(pChunkOffsets + (size_t)chunk * 4);
+            for (uint32_t i = 0; (i < samplesPerChunk) && (sampleIndex < numSamples); i++, sampleIndex++) {
+                Sample sample;
+                sample.offset = offset;
+                sample.size = (constantSampleSize != 0) ? constantSampleSize : ReadSampleSize(pSizes, sizeFieldBits, sampleIndex);
+                if ((sample.offset + sample.size) > m_bitstreamDataSize) {
+                    std::cerr << "MP4: truncated sample " << sampleIndex << std::endl;
+                    return;
+                }
+                offset += sample.size;
+
+                sample.dts = dts;
+                // stts entries: sample_count, sample_delta
+                while ((timeToSampleEntry < numTimeToSampleEntries) &&
+                       (timeToSampleCount >= ReadBE32(pTimeToSample + timeToSampleEntry * 8))) {
+                    timeToSampleEntry++;
+                    timeToSampleCount = 0;
+                }
+                if (timeToSampleEntry < numTimeToSampleEntries) {
+                    dts += ReadBE32(pTimeToSample + timeToSampleEntry * 8 + 4);
+                    timeToSampleCount++;
+                }
+
+                // ctts entries: sample_count, sample_offset (signed in version 1, used as such in version 0 too)
+                sample.pts = sample.dts + m_presentationOffset;
+                while ((compositionOffsetEntry < numCompositionOffsetEntries) &&
+                       (compositionOffsetCount >= ReadBE32(pCompositionOffsets + compositionOffsetEntry * 8))) {
+                    compositionOffsetEntry++;
+                    compositionOffsetCount = 0;
+                }
+                if (compositionOffsetEntry < numCompositionOffsetEntries) {
+                    sample.pts += (int32_t)ReadBE32(pCompositionOffsets + compositionOffsetEntry * 8 + 4);
+                    compositionOffsetCount++;
+                }
+
+                // stss entries: sample_number (1-based), in increasing order
+                sample.isSync = (pSyncSamples == nullptr);
+                while ((syncSample < numSyncSamples) && (ReadBE32(pSyncSamples + syncSample * 4) < (sampleIndex + 1))) {
+                    syncSample++;
+                }
+                if ((syncSample < numSyncSamples) && (ReadBE32(pSyncSamples + syncSample * 4) == (sampleIndex + 1))) {
+                    sample.isSync = true;
+                }
+
+                m_samples.push_back(sample);
+            }
+        }
+        m_nextFragmentDts = dts;
+    }
+
+    static uint32_t ReadSampleSize(const uint8_t* pSizes, uint32_t sizeFieldBits, uint64_t sampleIndex)
+    {
+        switch (sizeFieldBits) {
+        case 4:
+            return (pSizes[sampleIndex / 2] >> ((sampleIndex & 1) ? 0 : 4)) & 0xf;
+        case 8:
+            return pSizes[sampleIndex];
+        case 16:
+            return ReadBE16(pSizes + sampleIndex * 2);
+        default:
+            return ReadBE32(pSizes + sampleIndex * 4);
+        }
+    }
+
+    // Adds the samples of the track fragments of the video track
+    void ParseMovieFragment(const Box& moof)
+    {
+        Box traf;
+        for (VkDeviceSize offset = moof.payload; FindBox(moof, offset, "traf", traf); offset = traf.end) {
+            Box tfhd;
+            if (!FindBox(traf, "tfhd", tfhd) || (FullBoxPayloadSize(tfhd, 4) == 0)) {
+                continue;
+            }
+            const uint8_t* p = m_pBitstreamData + tfhd.payload;
+            const uint32_t tfhdFlags = ReadBE32(p) & 0xffffff;
+            if (ReadBE32(p + 4) != m_trackId) {
+                continue;
+            }
+
+            TrackExtends defaults = { m_trackId, 0, 0, 0 };
+            for (size_t i = 0; i < m_trackExtends.size(); i++) {
+                if (m_trackExtends[i].trackId == m_trackId) {
+                    defaults = m_trackExtends[i];
+                }
+            }
+
+            // The optional tfhd fields follow the track_ID in the order of their flags
+            const VkDeviceSize tfhdSize = tfhd.end - tfhd.payload;
+            VkDeviceSize fieldOffset = 8;
+            // Without base_data_offset, the base is the start of the moof box (default-base-is-moof, or
+            // first track fragment of the movie fragment; the data of the other tracks is skipped anyway)
+            VkDeviceSize baseDataOffset = moof.offset;
+            if ((tfhdFlags & TFHD_BASE_DATA_OFFSET_PRESENT) && ((fieldOffset + 8) <= tfhdSize)) {
+                baseDataOffset = ReadBE64(p + fieldOffset);
+                fieldOffset += 8;
+            }
+            if (tfhdFlags & TFHD_SAMPLE_DESCRIPTION_INDEX_PRESENT) {
+                fieldOffset += 4;
+            }
+            if ((tfhdFlags & TFHD_DEFAULT_SAMPLE_DURATION_PRESENT) && ((fieldOffset + 4) <= tfhdSize)) {
+                defaults.defaultSampleDuration = ReadBE32(p + fieldOffset);
+                fieldOffset += 4;
+            }
+            if ((tfhdFlags & TFHD_DEFAULT_SAMPLE_SIZE_PRESENT) && ((fieldOffset + 4) <= tfhdSize)) {
+                defaults.defaultSampleSize = ReadBE32(p + fieldOffset);
+                fieldOffset += 4;
+            }
+            if ((tfhdFlags & TFHD_DEFAULT_SAMPLE_FLAGS_PRESENT) && ((fieldOffset + 4) <= tfhdSize)) {
+                defaults.defaultSampleFlags = ReadBE32(p + fieldOffset);
+            }
+
+            Box tfdt;
+            if (FindBox(traf, "tfdt", tfdt) && (FullBoxPayloadSize(tfdt, 4) != 0)) {
+                const uint8_t* pTfdt = m_pBitstreamData + tfdt.payload;
+                if (pTfdt[0] == 1) {
+                    if (FullBoxPayloadSize(tfdt, 8) != 0) {
+                        m_nextFragmentDts = (int64_t)ReadBE64(pTfdt + 4);
+                    }
+                } else {
+                    m_nextFragmentDts = ReadBE32(pTfdt + 4);
+                }
+            }
+
+            VkDeviceSize dataOffset = baseDataOffset;
+            Box trun;
+            for (VkDeviceSize trunOffset = traf.payload; FindBox(traf, trunOffset, "trun", trun); trunOffset = trun.end) {
+                if (!ParseTrackRun(trun, baseDataOffset, defaults, dataOffset)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    // dataOffset is the end of the data of the previous track run, where this one starts
+    // unless it has a data_offset
+    bool ParseTrackRun(const Box& trun, VkDeviceSize baseDataOffset, const TrackExtends& defaults, VkDeviceSize& dataOffset)
+    {
+        if (FullBoxPayloadSize(trun, 4) == 0) {
+            return true;
+        }
+        const uint8_t* p = m_pBitstreamData + trun.payload;
+        const uint8_t* pEnd = m_pBitstreamData + trun.end;
+        const uint32_t version = p[0];
+        const uint32_t trunFlags = ReadBE32(p) & 0xffffff;
+        const uint32_t numSamples = ReadBE32(p + 4);
+        p += 8;
+
+        if (trunFlags & TRUN_DATA_OFFSET_PRESENT) {
+            if ((p + 4) > pEnd) {
+                return false;
+            }
+            dataOffset = baseDataOffset + (int32_t)ReadBE32(p);
+            p += 4;
+        }
+        uint32_t firstSampleFlags = defaults.defaultSampleFlags;
+        const bool hasFirstSampleFlags = (trunFlags & TRUN_FIRST_SAMPLE_FLAGS_PRESENT) != 0;
+        if (hasFirstSampleFlags) {
+            if ((p + 4) > pEnd) {
+                return false;
+            }
+            firstSampleFlags = ReadBE32(p);
+            p += 4;
+        }
+
+        const uint32_t sampleFieldsSize = ((trunFlags & TRUN_SAMPLE_DURATION_PRESENT) ? 4 : 0) +
+                                          ((trunFlags & TRUN_SAMPLE_SIZE_PRESENT) ? 4 : 0) +
+                                          ((trunFlags & TRUN_SAMPLE_FLAGS_PRESENT) ? 4 : 0) +
+                                          ((trunFlags & TRUN_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT) ? 4 : 0);
+        if (((uint64_t)numSamples * sampleFieldsSize) > (uint64_t)(pEnd - p)) {
+            return false;
+        }
+        // Without per-sample sizes, numSamples is only bounded by the data the samples take in the file
+        const bool hasSampleSizes = (trunFlags & TRUN_SAMPLE_SIZE_PRESENT) != 0;
+        if (!hasSampleSizes && (numSamples > 0) && (defaults.defaultSampleSize == 0)) {
+            return false;
+        }
+
+        uint64_t numReservedSamples = numSamples;
+        if (!hasSampleSizes) {
+            const VkDeviceSize dataSize = (dataOffset < m_bitstreamDataSize) ? (m_bitstreamDataSize - dataOffset) : 0;
+            numReservedSamples = std::min<uint64_t>(numReservedSamples, dataSize / defaults.defaultSampleSize);
+        }
+        m_samples.reserve(m_samples.size() + (size_t)numReservedSamples);
+        for (uint32_t i = 0; i < numSamples; i++) {
+            uint32_t duration = defaults.defaultSampleDuration;
+            uint32_t size = defaults.defaultSampleSize;
+            uint32_t flags = ((i == 0) && hasFirstSampleFlags) ? firstSampleFlags : defaults.defaultSampleFlags;
+            int32_t compositionOffset = 0;
+            if (trunFlags & TRUN_SAMPLE_DURATION_PRESENT) {
+                duration = ReadBE32(p);
+                p += 4;
+            }
+            if (hasSampleSizes) {
+                size = ReadBE32(p);
+                p += 4;
+            }
+            if (trunFlags & TRUN_SAMPLE_FLAGS_PRESENT) {
+                const uint32_t sampleFlags = ReadBE32(p);
+                if (!((i == 0) && hasFirstSampleFlags)) {
+                    flags = sampleFlags;
+                }
+                p += 4;
+            }
+            if (trunFlags & TRUN_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT) {
+                // Unsigned in version 0, but the values written by the muxers fit in 31 bits
+                compositionOffset = (version == 0) ? (int32_t)std::min<uint32_t>(ReadBE32(p), INT32_MAX) : (int32_t)ReadBE32(p);
+                p += 4;
+            }
+
+            Sample sample;
+            sample.offset = dataOffset;
+            sample.size = size;
+            sample.isSync = !(flags & SAMPLE_IS_NON_SYNC_SAMPLE);
+            sample.dts = m_nextFragmentDts;
+            sample.pts = m_nextFragmentDts + compositionOffset + m_presentationOffset;
+            if ((sample.offset + sample.size) > m_bitstreamDataSize) {
+                std::cerr << "MP4: truncated sample " << m_samples.size() << std::endl;
+                return false;
+            }
+            m_samples.push_back(sample);
+
+            dataOffset += size;
+            m_nextFragmentDts += duration;
+        }
+        return true;
+    }
+
+    int32_t    m_width, m_height, m_bitDepth;
+    uint32_t   m_profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
+    VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
+    uint32_t   m_trackId;
+    uint32_t   m_timescale;
+    uint32_t   m_movieTimescale;
+    int64_t    m_presentationOffset; // From the edit list, added to the composition times of the samples
+    const uint8_t* m_pConfigurationRecord; // avcC/hvcC payload, in the mapped file
+    size_t         m_configurationRecordSize;
+    mio::basic_mmap<mio::access_mode::read, uint8_t> m_inputVideoStreamMmap;
+    const uint8_t* m_pBitstreamData;
+    VkDeviceSize   m_bitstreamDataSize;
+    std::vector<TrackExtends> m_trackExtends;
+    std::vector<Sample> m_samples;     // In decode order
+    std::vector<size_t> m_syncSamples; // Indices in m_samples
+    int64_t        m_nextFragmentDts;
+    size_t         m_currentSample;
+    int64_t        m_frameTimestamp;
+};
+
+VkResult Mp4DemuxerCreate(const char *pFilePath,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    VkSharedBaseObj<Mp4Demuxer> mp4Demuxer;
+    VkResult result = Mp4Demuxer::Create(pFilePath,
+                                         defaultWidth,
+                                         defaultHeight,
+                                         defaultBitDepth,
+                                         mp4Demuxer);
+    if (result == VK_SUCCESS) {
+        videoStreamDemuxer = mp4Demuxer;
+    }
+
+    return result;
+}
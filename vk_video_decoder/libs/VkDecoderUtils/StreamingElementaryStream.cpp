@@ -0,0 +1,510 @@
+/*
+* Copyright 2023 NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__unix__)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
+
+#if defined(__unix__)
+
+// Elementary stream read from a pipe, a FIFO or a socket, which can't be mapped like a file.
+// A reader thread fills a fixed-size ring buffer with large read()s, and ReadBitstreamData()
+// hands out the data at the offset the parser got to, up to the write position or to the end
+// of the ring, whichever comes first: the parser takes the data in pieces of any size, so the
+// views don't have to be copied to be contiguous across the wrap. The data before the offset
+// is released to the reader, which blocks while the ring is full (back-pressure).
+class StreamingElementaryStream : public VideoStreamDemuxer {
+
+    enum {
+        RING_SIZE = 16 * 1024 * 1024,   // A power of 2
+        MAX_READ_SIZE = 1024 * 1024,
+        POLL_TIMEOUT_MS = 100,          // How long the reader takes to notice that it is stopped
+    };
+
+    // End of the data of a read() and when it returned, to measure how long the data stays in the ring
+    struct ReadRecord {
+        uint64_t                              endPosition;
+        std::chrono::steady_clock::time_point time;
+    };
+
+public:
+    // Takes fd over, unless it is the standard input. The prefix is data already read from it.
+    StreamingElementaryStream(int fd,
+                              const uint8_t* pPrefix,
+                              size_t prefixSize,
+                              VkVideoCodecOperationFlagBitsKHR forceParserType,
+                              int32_t defaultWidth,
+                              int32_t defaultHeight,
+                              int32_t defaultBitDepth)
+        : VideoStreamDemuxer(),
+          m_width(defaultWidth)
+        , m_height(defaultHeight)
+        , m_bitDepth(defaultBitDepth)
+        , m_chromaBitDepth(defaultBitDepth)
+        , m_hasSequenceInfo(false)
+        , m_av1AnnexB(false)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
+        , m_videoCodecType(forceParserType)
+        , m_fd(fd)
+        , m_ring(RING_SIZE)
+        , m_readerThread()
+        , m_mutex()
+        , m_dataAvailable()
+        , m_spaceAvailable()
+        , m_stop(false)
+        , m_endOfStream(false)
+        , m_readError(0)
+        , m_writePosition(0)
+        , m_readPosition(0)
+        , m_reads()
+        , m_readCalls(0)
+        , m_producerStalls(0)
+        , m_producerStallTime(std::chrono::steady_clock::duration::zero())
+        , m_consumerStalls(0)
+        , m_consumerStallTime(std::chrono::steady_clock::duration::zero())
+        , m_maxBufferedBytes(prefixSize)
+        , m_releasedReads(0)
+        , m_totalLatency(std::chrono::steady_clock::duration::zero())
+        , m_maxLatency(std::chrono::steady_clock::duration::zero()) {
+
+        assert(prefixSize <= RING_SIZE);
+        prefixSize = std::min<size_t>(prefixSize, RING_SIZE);
+        if (prefixSize > 0) {
+            memcpy(m_ring.data(), pPrefix, prefixSize);
+            m_writePosition = prefixSize;
+            ReadRecord record = { m_writePosition, std::chrono::steady_clock::now() };
+            m_reads.push_back(record);
+        }
+    }
+
+    // The codec and the format come from the probe of the prefix, as for ElementaryStream
+    int32_t Initialize(const VideoStreamFormat& format)
+    {
+        if (format.container == VideoStreamFormat::CONTAINER_ELEMENTARY) {
+            if ((m_videoCodecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR) ||
+                ((m_videoCodecType != format.codec) && format.hasSequenceInfo)) {
+                if (m_videoCodecType != VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+                    std::cerr << "Streaming elementary stream: the stream is " << format.pName
+                              << ", not the codec requested" << std::endl;
+                }
+                m_videoCodecType = format.codec;
+            }
+            m_av1AnnexB = format.av1AnnexB && (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR);
+            if (format.hasSequenceInfo && (format.codec == m_videoCodecType)) {
+                m_hasSequenceInfo = true;
+                m_profileIdc = format.profileIdc;
+                m_chromaSubsampling = format.chromaSubsampling;
+                m_bitDepth = format.lumaBitDepth;
+                m_chromaBitDepth = format.chromaBitDepth;
+                m_width = format.codedWidth;
+                m_height = format.codedHeight;
+            }
+        }
+        if (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR) {
+            std::cerr << "Streaming elementary stream: unknown codec, it has to be set" << std::endl;
+            return -1;
+        }
+
+        m_readerThread = std::thread(&StreamingElementaryStream::ReaderThread, this);
+        return 0;
+    }
+
+    static VkResult Create(int fd,
+                           const uint8_t* pPrefix,
+                           size_t prefixSize,
+                           const VideoStreamFormat& format,
+                           VkVideoCodecOperationFlagBitsKHR forceParserType,
+                           int32_t defaultWidth,
+                           int32_t defaultHeight,
+                           int32_t defaultBitDepth,
+                           VkSharedBaseObj<StreamingElementaryStream>& streamingElementaryStream)
+    {
+        VkSharedBaseObj<StreamingElementaryStream> newStream(new StreamingElementaryStream(fd,
+                                                                                           pPrefix,
+                                                                                           prefixSize,
+                                                                                           forceParserType,
+                                                                                           defaultWidth,
+                                                                                           defaultHeight,
+                                                                                           defaultBitDepth));
+
+         if ((newStream) && (newStream->Initialize(format) >= 0)) {
+             streamingElementaryStream = newStream;
+             return VK_SUCCESS;
+         }
+         return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual ~StreamingElementaryStream() {
+        m_stop = true;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_spaceAvailable.notify_all();
+        }
+        if (m_readerThread.joinable()) {
+            m_readerThread.join();
+        }
+        if ((m_fd >= 0) && (m_fd != STDIN_FILENO)) {
+            close(m_fd);
+        }
+    }
+
+    virtual bool IsStreamDemuxerEnabled() const { return false; }
+    virtual bool HasFramePreparser() const { return false; }
+
+    // The data handed out is gone
+    virtual void Rewind()
+    {
+        std::cerr << "Streaming elementary stream: the input can't be rewound" << std::endl;
+    }
+
+    virtual VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_videoCodecType; }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetLumaBitDepth() const
+    {
+        return GetComponentBitDepth(m_bitDepth);
+    }
+
+    virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
+    {
+        return m_chromaSubsampling;
+    }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
+    {
+        if (m_chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) {
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+        }
+        return GetComponentBitDepth(m_chromaBitDepth);
+    }
+
+    // The Main profile of the codec if the prefix has no sequence header
+    virtual uint32_t GetProfileIdc() const
+    {
+        if (m_hasSequenceInfo) {
+            return m_profileIdc;
+        }
+        switch ((uint32_t)m_videoCodecType) {
+        case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+            return STD_VIDEO_H265_PROFILE_IDC_MAIN;
+        case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+            return STD_VIDEO_AV1_PROFILE_MAIN;
+        default:
+            return STD_VIDEO_H264_PROFILE_IDC_MAIN;
+        }
+    }
+
+    virtual int32_t GetWidth() const { return m_width; }
+    virtual int32_t GetHeight() const { return m_height; }
+    virtual int32_t GetBitDepth() const { return m_bitDepth; }
+
+    virtual int64_t DemuxFrame(const uint8_t**) {
+        return -1;
+    }
+    virtual int64_t GetFrameTimestamp() const { return 0; }
+
+    virtual bool HasFrameDiscontinuity() const { return false; }
+
+    // The data before offset has been parsed: it is released to the reader thread. Blocks until there
+    // is data at offset, and returns 0 at the end of the stream.
+    virtual int64_t ReadBitstreamData(const uint8_t **ppVideo, int64_t offset)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (((uint64_t)offset < m_readPosition) || ((uint64_t)offset > m_writePosition)) {
+            // Only the data not released yet can be read again
+            *ppVideo = nullptr;
+            return 0;
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        m_readPosition = (uint64_t)offset;
+        while (!m_reads.empty() && (m_reads.front().endPosition <= m_readPosition)) {
+            const std::chrono::steady_clock::duration latency = now - m_reads.front().time;
+            m_totalLatency += latency;
+            m_maxLatency = std::max(m_maxLatency, latency);
+            m_releasedReads++;
+            m_reads.pop_front();
+        }
+        m_spaceAvailable.notify_one();
+
+        if ((m_writePosition == m_readPosition) && !m_endOfStream) {
+            m_consumerStalls++;
+            m_dataAvailable.wait(lock, [this] { return (m_writePosition > m_readPosition) || m_endOfStream; });
+            m_consumerStallTime += std::chrono::steady_clock::now() - now;
+        }
+
+        const size_t ringOffset = (size_t)(m_readPosition & (RING_SIZE - 1));
+        *ppVideo = m_ring.data() + ringOffset;
+        return (int64_t)std::min<uint64_t>(m_writePosition - m_readPosition, RING_SIZE - ringOffset);
+    }
+
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        size = 0;
+        return nullptr;
+    }
+    virtual bool IsAv1AnnexB() const { return m_av1AnnexB; }
+
+    virtual void DumpStreamParameters() const {
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const double msPerTick = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::duration(1)).count();
+        std::cout << "Container: streamed elementary stream (" << (RING_SIZE >> 20) << " MB ring buffer)" << std::endl;
+        std::cout << "Width: "    << m_width << std::endl;
+        std::cout << "Height: "   << m_height <<  std::endl;
+        std::cout << "BitDepth: " << m_bitDepth << std::endl;
+        std::cout << "Profile: "  << GetProfileIdc() << std::endl;
+        std::cout << "Read: " << m_writePosition << " bytes in " << m_readCalls << " reads, at most "
+                  << m_maxBufferedBytes << " bytes buffered" << (m_readError ? ", read error" : "") << std::endl;
+        std::cout << "Back-pressure: the reader waited " << m_producerStalls << " times for space, "
+                  << (m_producerStallTime.count() * msPerTick) << " ms" << std::endl;
+        std::cout << "Underruns: the parser waited " << m_consumerStalls << " times for data, "
+                  << (m_consumerStallTime.count() * msPerTick) << " ms" << std::endl;
+        std::cout << "Buffering latency: average "
+                  << ((m_totalLatency.count() * msPerTick) / (double)std::max<uint64_t>(m_releasedReads, 1))
+                  << " ms, max " << (m_maxLatency.count() * msPerTick) << " ms" << std::endl;
+    }
+
+private:
+
+    static VkVideoComponentBitDepthFlagsKHR GetComponentBitDepth(int32_t bitDepth)
+    {
+        switch (bitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        default:
+            assert(!"Unknown Bit Depth!");
+        }
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    // Returns the number of bytes read, 0 at the end of the input or once stopped, -1 on error.
+    // The input is polled so that a reader blocked on an idle pipe notices that it is stopped.
+    ssize_t ReadInput(uint8_t* pData, size_t size)
+    {
+        while (!m_stop) {
+            struct pollfd pollFd = { m_fd, POLLIN, 0 };
+            const int ready = poll(&pollFd, 1, POLL_TIMEOUT_MS);
+            if ((ready < 0) && (errno != EINTR)) {
+                return -1;
+            }
+            if (ready <= 0) {
+                continue;
+            }
+            const ssize_t readSize = read(m_fd, pData, size);
+            if ((readSize >= 0) || ((errno != EINTR) && (errno != EAGAIN))) {
+                return readSize;
+            }
+        }
+        return 0;
+    }
+
+    void ReaderThread()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop) {
+            const uint64_t freeSize = RING_SIZE - (m_writePosition - m_readPosition);
+            if (freeSize == 0) {
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                m_producerStalls++;
+                m_spaceAvailable.wait(lock, [this] { return m_stop || (m_writePosition - m_readPosition) < RING_SIZE; });
+                m_producerStallTime += std::chrono::steady_clock::now() - start;
+                continue;
+            }
+
+            // The reads stop at the end of the ring, the data the parser has not released is never overwritten
+            const size_t ringOffset = (size_t)(m_writePosition & (RING_SIZE - 1));
+            const size_t readSize = (size_t)std::min<uint64_t>(std::min<uint64_t>(freeSize, RING_SIZE - ringOffset), MAX_READ_SIZE);
+            lock.unlock();
+            const ssize_t bytesRead = ReadInput(m_ring.data() + ringOffset, readSize);
+            const int readError = (bytesRead < 0) ? errno : 0;
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            lock.lock();
+
+            if (bytesRead <= 0) {
+                m_readError = readError;
+                break;
+            }
+            m_readCalls++;
+            m_writePosition += (uint64_t)bytesRead;
+            m_maxBufferedBytes = std::max(m_maxBufferedBytes, m_writePosition - m_readPosition);
+            ReadRecord record = { m_writePosition, now };
+            m_reads.push_back(record);
+            m_dataAvailable.notify_one();
+        }
+        if (m_readError != 0) {
+            std::cerr << "Streaming elementary stream: read error " << strerror(m_readError) << std::endl;
+        }
+        m_endOfStream = true;
+        m_dataAvailable.notify_one();
+    }
+
+    int32_t    m_width, m_height, m_bitDepth;
+    int32_t    m_chromaBitDepth;
+    bool       m_hasSequenceInfo;
+    bool       m_av1AnnexB;
+    uint32_t   m_profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
+    VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
+    int        m_fd;
+    std::vector<uint8_t>    m_ring;
+    std::thread             m_readerThread;
+    mutable std::mutex      m_mutex;           // Of the positions, of the records and of the counters
+    std::condition_variable m_dataAvailable;
+    std::condition_variable m_spaceAvailable;
+    std::atomic<bool>       m_stop;
+    bool       m_endOfStream;
+    int        m_readError;
+    uint64_t   m_writePosition;                // Bytes read from the input
+    uint64_t   m_readPosition;                 // Bytes released by the parser
+    std::deque<ReadRecord> m_reads;            // Of the data not released yet
+    uint64_t   m_readCalls;
+    uint64_t   m_producerStalls;
+    std::chrono::steady_clock::duration m_producerStallTime;
+    uint64_t   m_consumerStalls;
+    std::chrono::steady_clock::duration m_consumerStallTime;
+    uint64_t   m_maxBufferedBytes;
+    uint64_t   m_releasedReads;
+    std::chrono::steady_clock::duration m_totalLatency;
+    std::chrono::steady_clock::duration m_maxLatency;
+};
+
+// "-" is the standard input. Unix sockets are connected to, anything else is opened.
+static int OpenStreamingInput(const char* pFilePath)
+{
+    if (strcmp(pFilePath, "-") == 0) {
+        return STDIN_FILENO;
+    }
+
+    struct stat fileStat;
+    if ((stat(pFilePath, &fileStat) == 0) && S_ISSOCK(fileStat.st_mode)) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(pFilePath) >= sizeof(address.sun_path)) {
+            return -1;
+        }
+        strcpy(address.sun_path, pFilePath);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ((fd >= 0) && (connect(fd, (const struct sockaddr*)&address, sizeof(address)) != 0)) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    return open(pFilePath, O_RDONLY);
+}
+
+VkResult StreamingDemuxerCreate(const char *pFilePath,
+                                VkVideoCodecOperationFlagBitsKHR codecType,
+                                int32_t defaultWidth,
+                                int32_t defaultHeight,
+                                int32_t defaultBitDepth,
+                                VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    const int fd = OpenStreamingInput(pFilePath);
+    if (fd < 0) {
+        std::cerr << "Streaming input: can't open " << pFilePath << std::endl;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // The first bytes are read until a probe is sure of the format, as a live input may be slow to fill
+    // the whole probe size. They can't be put back, so they are handed over to the demuxer.
+    std::vector<uint8_t> prefix(VIDEO_STREAM_PROBE_SIZE);
+    size_t prefixSize = 0;
+    bool endOfStream = false;
+    VideoStreamFormat format;
+    uint32_t confidence = 0;
+    while ((prefixSize < prefix.size()) && !endOfStream && (confidence < VIDEO_STREAM_PROBE_CONFIDENCE_MAX)) {
+        const ssize_t readSize = read(fd, prefix.data() + prefixSize, prefix.size() - prefixSize);
+        if ((readSize < 0) && (errno == EINTR)) {
+            continue;
+        }
+        endOfStream = (readSize <= 0);
+        prefixSize += (size_t)std::max<ssize_t>(readSize, 0);
+        confidence = VideoStreamProbe(prefix.data(), prefixSize, endOfStream, format);
+    }
+    if (confidence == 0) {
+        format.container = VideoStreamFormat::CONTAINER_UNKNOWN;
+    }
+
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    if (format.container == VideoStreamFormat::CONTAINER_TS) {
+        FILE* pFile = fdopen(fd, "rb");
+        if (pFile != nullptr) {
+            return TsDemuxerCreate(pFile, prefix.data(), prefixSize,
+                                   defaultWidth, defaultHeight, defaultBitDepth,
+                                   videoStreamDemuxer);
+        }
+    } else if ((format.container == VideoStreamFormat::CONTAINER_ELEMENTARY) ||
+               ((format.container == VideoStreamFormat::CONTAINER_UNKNOWN) && (codecType != VK_VIDEO_CODEC_OPERATION_NONE_KHR))) {
+        VkSharedBaseObj<StreamingElementaryStream> streamingElementaryStream;
+        result = StreamingElementaryStream::Create(fd, prefix.data(), prefixSize, format, codecType,
+                                                   defaultWidth, defaultHeight, defaultBitDepth,
+                                                   streamingElementaryStream);
+        if (result == VK_SUCCESS) {
+            videoStreamDemuxer = streamingElementaryStream;
+        }
+        // The stream owns the file descriptor from now on
+        return result;
+    } else {
+        std::cerr << "Streaming input: " << ((format.container == VideoStreamFormat::CONTAINER_UNKNOWN) ? "unknown" : format.pName)
+                  << " input, only MPEG-TS and elementary streams can be streamed" << std::endl;
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return result;
+}
+
+#else
+
+VkResult StreamingDemuxerCreate(const char *pFilePath,
+                                VkVideoCodecOperationFlagBitsKHR,
+                                int32_t,
+                                int32_t,
+                                int32_t,
+                                VkSharedBaseObj<VideoStreamDemuxer>&)
+{
+    std::cerr << "Streaming input: " << pFilePath << " can't be streamed on this platform" << std::endl;
+    return VK_ERROR_FEATURE_NOT_PRESENT;
+}
+
+#endif
@@ -0,0 +1,686 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
+
+// MPEG-2 transport stream demuxer (ISO/IEC 13818-1) of the first H.264 or H.265 stream of
+// the first program. The input is read sequentially with large reads, so that it can be a
+// pipe or a FIFO as well as a file, and the 192-byte packets of the M2TS files (a 4-byte
+// time code before each packet) are accepted as well.
+// The PAT and the PMT select the video PID, then the PES packets of that PID are reassembled,
+// each one holding an Annex B access unit, into a buffer that is reused from one PES packet
+// to the next. The continuity counters of the video PID are checked: the PES packet a
+// packet is missing from is dropped, and the next frame is flagged as a discontinuity, as
+// is the frame after a discontinuity_indicator of the adaptation field.
+class TsDemuxer : public VideoStreamDemuxer {
+
+    enum {
+        TS_PACKET_SIZE = 188,
+        M2TS_PACKET_SIZE = 192,
+        TS_SYNC_BYTE = 0x47,
+        PID_PAT = 0x0000,
+        PID_NULL = 0x1fff,
+        INVALID_PID = 0xffff,
+        STREAM_TYPE_H264 = 0x1b,
+        STREAM_TYPE_H265 = 0x24,
+        READ_SIZE = 1024 * M2TS_PACKET_SIZE,
+        MAX_PROBE_SIZE = 4 * 1024 * 1024, // The PAT and the PMT are expected within the first 4 MB
+    };
+
+    // Section of the PAT or of the PMT, reassembled from the payload of the packets of its PID
+    struct PsiSection {
+        std::vector<uint8_t> data;
+        bool                 started;
+    };
+
+public:
+    // Takes pFile over. The prefix is data already read from it, demuxed first.
+    TsDemuxer(FILE* pFile,
+              const uint8_t* pPrefix,
+              size_t prefixSize,
+              int32_t defaultWidth,
+              int32_t defaultHeight,
+              int32_t defaultBitDepth)
+        : VideoStreamDemuxer(),
+          m_width(defaultWidth)
+        , m_height(defaultHeight)
+        , m_bitDepth(defaultBitDepth)
+        , m_chromaBitDepth(defaultBitDepth)
+        , m_hasSequenceInfo(false)
+        , m_profileIdc(0)
+        , m_chromaSubsampling(VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR)
+        , m_videoCodecType(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        , m_pFile(pFile)
+        , m_isSeekable(false)
+        , m_endOfFile(false)
+        , m_packetSize(TS_PACKET_SIZE)
+        , m_readBuffer(pPrefix, pPrefix + prefixSize)
+        , m_readOffset(0)
+        , m_readSize(prefixSize)
+        , m_pmtPid(INVALID_PID)
+        , m_videoPid(INVALID_PID)
+        , m_pat()
+        , m_pmt()
+        , m_continuityCounter(-1)
+        , m_pesBuffer()
+        , m_pesStarted(false)
+        , m_pesPayloadSize(0)
+        , m_pesTimestamp(0)
+        , m_pesDiscontinuity(false)
+        , m_discontinuityPending(false)
+        , m_frameBuffer()
+        , m_frameTimestamp(0)
+        , m_frameDiscontinuity(false)
+        , m_continuityErrors(0)
+        , m_syncLosses(0) {
+
+        if ((m_pFile != nullptr) && (prefixSize == 0)) {
+            m_isSeekable = (fseek(m_pFile, 0, SEEK_SET) == 0);
+        }
+    }
+
+    // 3 sync bytes in a row, at the 188 or at the 192-byte packet interval
+    static uint32_t GetPacketSize(const uint8_t* pData, size_t size)
+    {
+        static const uint32_t packetSizes[] = { TS_PACKET_SIZE, M2TS_PACKET_SIZE };
+        for (uint32_t i = 0; i < sizeof(packetSizes) / sizeof(packetSizes[0]); i++) {
+            const uint32_t syncOffset = packetSizes[i] - TS_PACKET_SIZE;
+            if ((size >= (3 * packetSizes[i])) &&
+                (pData[syncOffset] == TS_SYNC_BYTE) &&
+                (pData[syncOffset + packetSizes[i]] == TS_SYNC_BYTE) &&
+                (pData[syncOffset + 2 * packetSizes[i]] == TS_SYNC_BYTE)) {
+                return packetSizes[i];
+            }
+        }
+        return 0;
+    }
+
+    // Reads the input up to the PMT, which selects the video PID. All the data read is kept
+    // to be demuxed, as the input may be a pipe.
+    int32_t Initialize()
+    {
+        if (m_pFile == nullptr) {
+            return -1;
+        }
+
+        // The prefix read by the streaming demuxer may already hold the whole stream
+        m_readBuffer.resize(std::max<size_t>(m_readSize, READ_SIZE));
+        FillReadBuffer();
+        if ((m_readSize == 0) || ((m_packetSize = GetPacketSize(m_readBuffer.data(), m_readSize)) == 0)) {
+            return -1;
+        }
+
+        size_t probeOffset = 0;
+        while (m_videoPid == INVALID_PID) {
+            for (; (probeOffset + m_packetSize) <= m_readSize; probeOffset += m_packetSize) {
+                const uint8_t* pPacket = m_readBuffer.data() + probeOffset + (m_packetSize - TS_PACKET_SIZE);
+                if (pPacket[0] == TS_SYNC_BYTE) {
+                    ProcessPsiPacket(pPacket);
+                }
+                if (m_videoPid != INVALID_PID) {
+                    break;
+                }
+            }
+            if ((m_videoPid != INVALID_PID) || m_endOfFile || (m_readSize >= MAX_PROBE_SIZE)) {
+                break;
+            }
+            m_readBuffer.resize(m_readSize + READ_SIZE);
+            FillReadBuffer();
+        }
+
+        if (m_videoPid == INVALID_PID) {
+            std::cerr << "TS: no H.264 or H.265 stream in the first program" << std::endl;
+            return -1;
+        }
+        ProbeSequenceInfo();
+
+        // The video packets before the PMT are demuxed as well
+        m_readOffset = 0;
+        return 0;
+    }
+
+    static VkResult Create(FILE* pFile,
+                           const uint8_t* pPrefix,
+                           size_t prefixSize,
+                           int32_t defaultWidth,
+                           int32_t defaultHeight,
+                           int32_t defaultBitDepth,
+                           VkSharedBaseObj<TsDemuxer>& tsDemuxer)
+    {
+        VkSharedBaseObj<TsDemuxer> newTsDemuxer(new TsDemuxer(pFile,
+                                                              pPrefix,
+                                                              prefixSize,
+                                                              defaultWidth,
+                                                              defaultHeight,
+                                                              defaultBitDepth));
+
+         if ((newTsDemuxer) && (newTsDemuxer->Initialize() >= 0)) {
+             tsDemuxer = newTsDemuxer;
+             return VK_SUCCESS;
+         }
+         return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    virtual ~TsDemuxer() {
+        if (m_pFile != nullptr) {
+            fclose(m_pFile);
+        }
+    }
+
+    virtual bool IsStreamDemuxerEnabled() const { return true; }
+    virtual bool HasFramePreparser() const { return true; }
+
+    // Only files can be rewound, the data read from a pipe is gone
+    virtual void Rewind()
+    {
+        if (!m_isSeekable || (fseek(m_pFile, 0, SEEK_SET) != 0)) {
+            std::cerr << "TS: the input can't be rewound" << std::endl;
+            return;
+        }
+        m_endOfFile = false;
+        m_readOffset = 0;
+        m_readSize = 0;
+        m_continuityCounter = -1;
+        m_pesBuffer.clear();
+        m_pesStarted = false;
+        m_discontinuityPending = false;
+        m_frameTimestamp = 0;
+        m_frameDiscontinuity = false;
+    }
+
+    virtual VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_videoCodecType; }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetLumaBitDepth() const
+    {
+        switch (m_bitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+            break;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+            break;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+            break;
+        default:
+            assert(!"Unknown Luma Bit Depth!");
+        }
+        assert(!"Unknown Luma Bit Depth!");
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    virtual VkVideoChromaSubsamplingFlagsKHR GetChromaSubsampling() const
+    {
+        return m_chromaSubsampling;
+    }
+
+    virtual VkVideoComponentBitDepthFlagsKHR GetChromaBitDepth() const
+    {
+        if (m_chromaSubsampling == VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR) {
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+        }
+        switch (m_chromaBitDepth) {
+        case 8:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        case 10:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        case 12:
+            return VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        default:
+            assert(!"Unknown Chroma Bit Depth!");
+        }
+        return VK_VIDEO_COMPONENT_BIT_DEPTH_INVALID_KHR;
+    }
+
+    // The Main profile of the codec if no SPS was found in the data read by Initialize()
+    virtual uint32_t GetProfileIdc() const
+    {
+        if (m_hasSequenceInfo) {
+            return m_profileIdc;
+        }
+        return (m_videoCodecType == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) ? (uint32_t)STD_VIDEO_H265_PROFILE_IDC_MAIN :
+                                                                                   (uint32_t)STD_VIDEO_H264_PROFILE_IDC_MAIN;
+    }
+
+    virtual int32_t GetWidth() const { return m_width; }
+    virtual int32_t GetHeight() const { return m_height; }
+    virtual int32_t GetBitDepth() const { return m_bitDepth; }
+
+    // Returns the next PES packet of the video PID. The data stays valid up to the next call.
+    virtual int64_t DemuxFrame(const uint8_t **ppVideo) {
+
+        for (;;) {
+            if ((m_readOffset + m_packetSize) > m_readSize) {
+                if (!FillReadBuffer()) {
+                    // The last PES packet ends with the stream
+                    if (!CompletePesPacket()) {
+                        m_frameTimestamp = 0;
+                        m_frameDiscontinuity = false;
+                        return 0;
+                    }
+                    break;
+                }
+                continue;
+            }
+
+            const uint8_t* pPacket = m_readBuffer.data() + m_readOffset + (m_packetSize - TS_PACKET_SIZE);
+            if (pPacket[0] != TS_SYNC_BYTE) {
+                Resync();
+                continue;
+            }
+            m_readOffset += m_packetSize;
+
+            if (ProcessVideoPacket(pPacket)) {
+                break;
+            }
+        }
+
+        *ppVideo = m_frameBuffer.data();
+        return (int64_t)m_frameBuffer.size();
+    }
+
+    // The 33-bit PTS of the PES packet, in the 90 kHz clock, 0 if it has none
+    virtual int64_t GetFrameTimestamp() const { return m_frameTimestamp; }
+
+    virtual bool HasFrameDiscontinuity() const { return m_frameDiscontinuity; }
+
+    virtual int64_t ReadBitstreamData(const uint8_t**, int64_t) {
+        return -1;
+    }
+
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const {
+        size = 0;
+        return nullptr;
+    }
+    virtual bool IsAv1AnnexB() const { return false; }
+
+    virtual void DumpStreamParameters() const {
+
+        std::cout << "Container: MPEG-TS (" << m_packetSize << "-byte packets" << (m_isSeekable ? "" : ", not seekable") << ")" << std::endl;
+        std::cout << "PMT PID: "  << m_pmtPid << ", video PID: " << m_videoPid << std::endl;
+        std::cout << "Width: "    << m_width << std::endl;
+        std::cout << "Height: "   << m_height <<  std::endl;
+        std::cout << "BitDepth: " << m_bitDepth << std::endl;
+        std::cout << "Profile: "  << GetProfileIdc() << std::endl;
+        std::cout << "Continuity errors: " << m_continuityErrors << ", sync losses: " << m_syncLosses << std::endl;
+    }
+
+private:
+
+    // Fills the format in from the first SPS of the video PID in the data read so far, without
+    // touching the demuxing state. The PES headers are skipped, packet loss is not handled.
+    void ProbeSequenceInfo()
+    {
+        std::vector<uint8_t> videoData;
+        for (size_t offset = 0; (offset + m_packetSize) <= m_readSize; offset += m_packetSize) {
+            const uint8_t* pPacket = m_readBuffer.data() + offset + (m_packetSize - TS_PACKET_SIZE);
+            const uint32_t pid = ((pPacket[1] & 0x1f) << 8) | pPacket[2];
+            size_t payloadSize = 0;
+            const uint8_t* pPayload = (pPacket[0] == TS_SYNC_BYTE) && (pid == m_videoPid) && !(pPacket[1] & 0x80) ?
+                                      GetPayload(pPacket, payloadSize) : nullptr;
+            if (pPayload == nullptr) {
+                continue;
+            }
+            if (pPacket[1] & 0x40) {
+                if ((payloadSize < 9) || (pPayload[0] != 0) || (pPayload[1] != 0) || (pPayload[2] != 1)) {
+                    continue;
+                }
+                const size_t headerSize = 9 + pPayload[8];
+                if (headerSize > payloadSize) {
+                    continue;
+                }
+                pPayload += headerSize;
+                payloadSize -= headerSize;
+            }
+            videoData.insert(videoData.end(), pPayload, pPayload + payloadSize);
+        }
+
+        VideoStreamFormat format;
+        if (!VideoStreamProbeSequenceInfo(m_videoCodecType, false, videoData.data(), videoData.size(),
+                                          m_endOfFile, format)) {
+            return;
+        }
+        m_hasSequenceInfo = true;
+        m_profileIdc = format.profileIdc;
+        m_chromaSubsampling = format.chromaSubsampling;
+        m_bitDepth = format.lumaBitDepth;
+        m_chromaBitDepth = format.chromaBitDepth;
+        m_width = format.codedWidth;
+        m_height = format.codedHeight;
+    }
+
+    // Moves the partial packet left to the start of the read buffer, then fills the rest of it
+    bool FillReadBuffer()
+    {
+        if (m_endOfFile) {
+            return false;
+        }
+        if (m_readOffset > 0) {
+            m_readSize -= std::min(m_readOffset, m_readSize);
+            memmove(m_readBuffer.data(), m_readBuffer.data() + m_readOffset, m_readSize);
+            m_readOffset = 0;
+        }
+        const size_t readSize = fread(m_readBuffer.data() + m_readSize, 1, m_readBuffer.size() - m_readSize, m_pFile);
+        if (readSize == 0) {
+            m_endOfFile = true;
+            return false;
+        }
+        m_readSize += readSize;
+        return true;
+    }
+
+    // Skips the bytes up to the next sync byte followed by another one, one packet later
+    void Resync()
+    {
+        const size_t syncOffset = m_packetSize - TS_PACKET_SIZE;
+        m_syncLosses++;
+        m_readOffset++;
+        while ((m_readOffset + syncOffset + m_packetSize) < m_readSize) {
+            const uint8_t* pData = m_readBuffer.data() + m_readOffset + syncOffset;
+            if ((pData[0] == TS_SYNC_BYTE) && (pData[m_packetSize] == TS_SYNC_BYTE)) {
+                break;
+            }
+            m_readOffset++;
+        }
+        // Packets were lost
+        DropPesPacket();
+    }
+
+    // Returns the payload of the packet, or nullptr if it has none
+    const uint8_t* GetPayload(const uint8_t* pPacket, size_t& payloadSize, bool* pDiscontinuityIndicator = nullptr) const
+    {
+        const uint32_t adaptationFieldControl = (pPacket[3] >> 4) & 3;
+        size_t offset = 4;
+        if (adaptationFieldControl & 2) {
+            const uint32_t adaptationFieldLength = pPacket[4];
+            if ((pDiscontinuityIndicator != nullptr) && (adaptationFieldLength > 0)) {
+                *pDiscontinuityIndicator = (pPacket[5] & 0x80) != 0;
+            }
+            offset += 1 + adaptationFieldLength;
+        }
+        if (!(adaptationFieldControl & 1) || (offset >= TS_PACKET_SIZE)) {
+            payloadSize = 0;
+            return nullptr;
+        }
+        payloadSize = TS_PACKET_SIZE - offset;
+        return pPacket + offset;
+    }
+
+    void ProcessPsiPacket(const uint8_t* pPacket)
+    {
+        const uint32_t pid = ((pPacket[1] & 0x1f) << 8) | pPacket[2];
+        if ((pid != PID_PAT) && (pid != m_pmtPid)) {
+            return;
+        }
+        PsiSection& section = (pid == PID_PAT) ? m_pat : m_pmt;
+
+        size_t payloadSize = 0;
+        const uint8_t* pPayload = GetPayload(pPacket, payloadSize);
+        if (pPayload == nullptr) {
+            return;
+        }
+        if (pPacket[1] & 0x40) { // payload_unit_start_indicator: pointer_field, then the new section
+            const size_t pointerField = pPayload[0];
+            if ((pointerField + 1) >= payloadSize) {
+                return;
+            }
+            section.data.assign(pPayload + 1 + pointerField, pPayload + payloadSize);
+            section.started = true;
+        } else if (section.started) {
+            section.data.insert(section.data.end(), pPayload, pPayload + payloadSize);
+        } else {
+            return;
+        }
+
+        if (section.data.size() < 3) {
+            return;
+        }
+        const size_t sectionSize = 3 + (((section.data[1] & 0x0f) << 8) | section.data[2]);
+        if (section.data.size() < sectionSize) {
+            return;
+        }
+        section.started = false;
+        // The CRC_32 is not checked: a corrupted table selects no stream, or a wrong one, either way the parser reports it
+        if (pid == PID_PAT) {
+            ParsePat(section.data.data(), sectionSize);
+        } else {
+            ParsePmt(section.data.data(), sectionSize);
+        }
+    }
+
+    // Selects the PMT of the first program
+    void ParsePat(const uint8_t* pSection, size_t sectionSize)
+    {
+        if ((pSection[0] != 0x00) || (sectionSize < 12)) { // table_id of the program_association_section
+            return;
+        }
+        for (size_t offset = 8; (offset + 4 + 4) <= sectionSize; offset += 4) {
+            const uint32_t programNumber = (pSection[offset] << 8) | pSection[offset + 1];
+            if (programNumber != 0) { // Not the network PID
+                m_pmtPid = ((pSection[offset + 2] & 0x1f) << 8) | pSection[offset + 3];
+                return;
+            }
+        }
+    }
+
+    // Selects the first H.264 or H.265 stream of the program
+    void ParsePmt(const uint8_t* pSection, size_t sectionSize)
+    {
+        if ((pSection[0] != 0x02) || (sectionSize < 16)) { // table_id of the TS_program_map_section
+            return;
+        }
+        const size_t programInfoLength = ((pSection[10] & 0x0f) << 8) | pSection[11];
+        for (size_t offset = 12 + programInfoLength; (offset + 5 + 4) <= sectionSize;) {
+            const uint32_t streamType = pSection[offset];
+            const uint32_t elementaryPid = ((pSection[offset + 1] & 0x1f) << 8) | pSection[offset + 2];
+            const size_t esInfoLength = ((pSection[offset + 3] & 0x0f) << 8) | pSection[offset + 4];
+            if (streamType == STREAM_TYPE_H264) {
+                m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR;
+                m_videoPid = elementaryPid;
+                return;
+            } else if (streamType == STREAM_TYPE_H265) {
+                m_videoCodecType = VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR;
+                m_videoPid = elementaryPid;
+                return;
+            }
+            offset += 5 + esInfoLength;
+        }
+    }
+
+    // Returns true when the packet completes a PES packet, moved to m_frameBuffer
+    bool ProcessVideoPacket(const uint8_t* pPacket)
+    {
+        const uint32_t pid = ((pPacket[1] & 0x1f) << 8) | pPacket[2];
+        if (pid != m_videoPid) {
+            return false;
+        }
+        if (pPacket[1] & 0x80) { // transport_error_indicator
+            m_continuityErrors++;
+            DropPesPacket();
+            return false;
+        }
+
+        bool discontinuityIndicator = false;
+        size_t payloadSize = 0;
+        const uint8_t* pPayload = GetPayload(pPacket, payloadSize, &discontinuityIndicator);
+
+        // The continuity_counter is incremented by the packets with a payload only, which may be sent twice
+        const int32_t continuityCounter = pPacket[3] & 0x0f;
+        if (discontinuityIndicator) {
+            m_discontinuityPending = true;
+        } else if ((pPayload != nullptr) && (m_continuityCounter >= 0)) {
+            if (continuityCounter == m_continuityCounter) {
+                return false; // Duplicate packet
+            }
+            if (continuityCounter != ((m_continuityCounter + 1) & 0x0f)) {
+                m_continuityErrors++;
+                DropPesPacket();
+            }
+        }
+        if (pPayload == nullptr) {
+            return false;
+        }
+        m_continuityCounter = continuityCounter;
+
+        bool completed = false;
+        if (pPacket[1] & 0x40) { // payload_unit_start_indicator: a new PES packet starts
+            completed = CompletePesPacket();
+            StartPesPacket(pPayload, payloadSize);
+        } else if (m_pesStarted) {
+            m_pesBuffer.insert(m_pesBuffer.end(), pPayload, pPayload + payloadSize);
+        }
+
+        // A PES packet with a length is complete as soon as its last byte arrives, without waiting
+        // for the next one. Only one PES packet can be returned at a time though.
+        if (!completed && m_pesStarted && (m_pesPayloadSize != 0) && (m_pesBuffer.size() >= m_pesPayloadSize)) {
+            m_pesBuffer.resize(m_pesPayloadSize);
+            completed = CompletePesPacket();
+        }
+        return completed;
+    }
+
+    // Parses the PES packet header, see 2.4.3.6 of ISO/IEC 13818-1
+    void StartPesPacket(const uint8_t* pPayload, size_t payloadSize)
+    {
+        m_pesBuffer.clear();
+        m_pesStarted = false;
+        if ((payloadSize < 9) || (pPayload[0] != 0) || (pPayload[1] != 0) || (pPayload[2] != 1)) {
+            return;
+        }
+        const size_t pesPacketLength = (pPayload[4] << 8) | pPayload[5];
+        const size_t pesHeaderDataLength = pPayload[8];
+        const size_t headerSize = 9 + pesHeaderDataLength;
+        const uint32_t ptsDtsFlags = pPayload[7] >> 6;
+        if ((headerSize > payloadSize) || ((pesPacketLength != 0) && (pesPacketLength < (headerSize - 6)))) {
+            return;
+        }
+
+        // The DTS is not needed: the parser derives the decode order from the bitstream
+        m_pesTimestamp = 0;
+        if ((ptsDtsFlags & 2) && (pesHeaderDataLength >= 5)) {
+            const uint8_t* p = pPayload + 9;
+            m_pesTimestamp = ((int64_t)(p[0] & 0x0e) << 29) | ((int64_t)p[1] << 22) | ((int64_t)(p[2] & 0xfe) << 14) |
+                             ((int64_t)p[3] << 7) | ((int64_t)p[4] >> 1);
+        }
+        m_pesPayloadSize = (pesPacketLength != 0) ? (pesPacketLength + 6 - headerSize) : 0;
+        m_pesDiscontinuity = m_discontinuityPending;
+        m_discontinuityPending = false;
+        m_pesStarted = true;
+        m_pesBuffer.insert(m_pesBuffer.end(), pPayload + headerSize, pPayload + payloadSize);
+    }
+
+    // Hands the PES packet being reassembled over to DemuxFrame()
+    bool CompletePesPacket()
+    {
+        if (!m_pesStarted || m_pesBuffer.empty()) {
+            return false;
+        }
+        m_frameBuffer.swap(m_pesBuffer);
+        m_pesBuffer.clear();
+        m_pesStarted = false;
+        m_frameTimestamp = m_pesTimestamp;
+        m_frameDiscontinuity = m_pesDiscontinuity;
+        return true;
+    }
+
+    // The rest of the PES packet is skipped, up to the next payload_unit_start_indicator
+    void DropPesPacket()
+    {
+        m_pesBuffer.clear();
+        m_pesStarted = false;
+        m_discontinuityPending = true;
+    }
+
+    int32_t    m_width, m_height, m_bitDepth;
+    int32_t    m_chromaBitDepth;
+    bool       m_hasSequenceInfo;
+    uint32_t   m_profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR m_chromaSubsampling;
+    VkVideoCodecOperationFlagBitsKHR m_videoCodecType;
+    FILE*      m_pFile;
+    bool       m_isSeekable;
+    bool       m_endOfFile;
+    uint32_t   m_packetSize;
+    std::vector<uint8_t> m_readBuffer;
+    size_t     m_readOffset;           // Of the next packet in m_readBuffer
+    size_t     m_readSize;             // Bytes of m_readBuffer filled
+    uint32_t   m_pmtPid;
+    uint32_t   m_videoPid;
+    PsiSection m_pat;
+    PsiSection m_pmt;
+    int32_t    m_continuityCounter;    // Of the last video packet with a payload, -1 before the first one
+    std::vector<uint8_t> m_pesBuffer;  // PES packet being reassembled, without its header
+    bool       m_pesStarted;
+    size_t     m_pesPayloadSize;       // 0 if the PES packet has no length
+    int64_t    m_pesTimestamp;
+    bool       m_pesDiscontinuity;
+    bool       m_discontinuityPending; // For the next PES packet
+    std::vector<uint8_t> m_frameBuffer; // Last PES packet returned by DemuxFrame(), swapped with m_pesBuffer
+    int64_t    m_frameTimestamp;
+    bool       m_frameDiscontinuity;
+    uint64_t   m_continuityErrors;
+    uint64_t   m_syncLosses;
+};
+
+VkResult TsDemuxerCreate(const char *pFilePath,
+                         int32_t defaultWidth,
+                         int32_t defaultHeight,
+                         int32_t defaultBitDepth,
+                         VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    VkSharedBaseObj<TsDemuxer> tsDemuxer;
+    VkResult result = TsDemuxer::Create(fopen(pFilePath, "rb"),
+                                        nullptr,
+                                        0,
+                                        defaultWidth,
+                                        defaultHeight,
+                                        defaultBitDepth,
+                                        tsDemuxer);
+    if (result == VK_SUCCESS) {
+        videoStreamDemuxer = tsDemuxer;
+    }
+
+    return result;
+}
+
+VkResult TsDemuxerCreate(FILE* pFile,
+                         const uint8_t* pPrefix,
+                         size_t prefixSize,
+                         int32_t defaultWidth,
+                         int32_t defaultHeight,
+                         int32_t defaultBitDepth,
+                         VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
+{
+    VkSharedBaseObj<TsDemuxer> tsDemuxer;
+    VkResult result = TsDemuxer::Create(pFile,
+                                        pPrefix,
+                                        prefixSize,
+                                        defaultWidth,
+                                        defaultHeight,
+                                        defaultBitDepth,
+                                        tsDemuxer);
+    if (result == VK_SUCCESS) {
+        videoStreamDemuxer = tsDemuxer;
+    }
+
+    return result;
+}
@@ -14,7 +14,10 @@
 * limitations under the License.
 */
 
+#include <sys/stat.h>
+#include <iostream>
 #include "VkDecoderUtils/VideoStreamDemuxer.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
 
 VkResult FFmpegDemuxerCreate(const char *pFilePath,
                              VkVideoCodecOperationFlagBitsKHR codecType,
@@ -24,12 +27,11 @@ VkResult FFmpegDemuxerCreate(const char *pFilePath,
                              int32_t defaultBitDepth,
                              VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
 
-VkResult ElementaryStreamCreate(const char *pFilePath,
-                                VkVideoCodecOperationFlagBitsKHR codecType,
-                                int32_t defaultWidth,
-                                int32_t defaultHeight,
-                                int32_t defaultBitDepth,
-                                VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+static bool IsRegularFile(const char *pFilePath)
+{
+    struct stat fileStat;
+    return (stat(pFilePath, &fileStat) == 0) && ((fileStat.st_mode & S_IFMT) == S_IFREG);
+}
 
 VkResult VideoStreamDemuxer::Create(const char *pFilePath,
                                     VkVideoCodecOperationFlagBitsKHR codecType,
@@ -39,6 +41,76 @@ VkResult VideoStreamDemuxer::Create(const char *pFilePath,
                                     int32_t defaultBitDepth,
                                     VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer)
 {
+    // IVF, MP4 and MPEG-TS files are demuxed natively, whatever the demuxing mode. The probe picks the
+    // demuxer from the first bytes of the file, rather than from its name or the codec the caller expects.
+    VideoStreamFormat format;
+    if (VideoStreamProbeFile(pFilePath, format) == 0) {
+        format.container = VideoStreamFormat::CONTAINER_UNKNOWN;
+    }
+
+    VkResult result = VK_ERROR_FORMAT_NOT_SUPPORTED;
+    switch (format.container) {
+    case VideoStreamFormat::CONTAINER_IVF:
+        result = IvfDemuxerCreate(pFilePath,
+                                  defaultWidth,
+                                  defaultHeight,
+                                  defaultBitDepth,
+                                  videoStreamDemuxer);
+        break;
+    case VideoStreamFormat::CONTAINER_MP4:
+        result = Mp4DemuxerCreate(pFilePath,
+                                  defaultWidth,
+                                  defaultHeight,
+                                  defaultBitDepth,
+                                  videoStreamDemuxer);
+        break;
+    case VideoStreamFormat::CONTAINER_TS:
+        result = TsDemuxerCreate(pFilePath,
+                                 defaultWidth,
+                                 defaultHeight,
+                                 defaultBitDepth,
+                                 videoStreamDemuxer);
+        break;
+    case VideoStreamFormat::CONTAINER_ELEMENTARY:
+        if ((codecType != VK_VIDEO_CODEC_OPERATION_NONE_KHR) && (codecType != format.codec)) {
+            std::cerr << "Demuxer: " << pFilePath << " looks like " << format.pName
+                      << ", not the codec requested" << std::endl;
+        }
+        codecType = format.codec;
+        break;
+    default:
+        // Pipes, FIFOs and sockets can't be probed in place, which VideoStreamProbeFile() doesn't try:
+        // the streaming demuxer reads their first bytes and probes them itself. Regular files that no
+        // probe recognized go to FFmpeg.
+        if (!IsRegularFile(pFilePath)) {
+            return StreamingDemuxerCreate(pFilePath,
+                                          codecType,
+                                          defaultWidth,
+                                          defaultHeight,
+                                          defaultBitDepth,
+                                          videoStreamDemuxer);
+        }
+        break;
+    }
+
+    if ((format.container == VideoStreamFormat::CONTAINER_IVF) ||
+        (format.container == VideoStreamFormat::CONTAINER_MP4) ||
+        (format.container == VideoStreamFormat::CONTAINER_TS)) {
+        if (result == VK_SUCCESS) {
+            return result;
+        }
+        // The probe only looks at the first bytes of the file, which FFmpeg may still be able to demux
+        std::cerr << "Demuxer: " << pFilePath << " looks like " << format.pName
+                  << ", but can't be demuxed natively, trying FFmpeg" << std::endl;
+        return FFmpegDemuxerCreate(pFilePath,
+                                   codecType,
+                                   true,
+                                   defaultWidth,
+                                   defaultHeight,
+                                   defaultBitDepth,
+                                   videoStreamDemuxer);
+    }
+
     if (requiresStreamDemuxing || (codecType == VK_VIDEO_CODEC_OPERATION_NONE_KHR)) {
         return FFmpegDemuxerCreate(pFilePath,
                                    codecType,
@@ -56,6 +128,3 @@ VkResult VideoStreamDemuxer::Create(const char *pFilePath,
                                       videoStreamDemuxer);
     }
 }
-
-
-
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <stdio.h>
 #include <atomic>
 #include <vulkan_interfaces.h>
 #include "VkCodecUtils/VkVideoRefCountBase.h"
@@ -62,7 +63,15 @@ public:
     virtual bool IsStreamDemuxerEnabled() const = 0;
     virtual bool HasFramePreparser() const = 0;
     virtual int64_t DemuxFrame(const uint8_t **ppVideo) = 0;
+    // Presentation time stamp of the frame last returned by DemuxFrame(), in the time base of the stream, 0 if unknown
+    virtual int64_t GetFrameTimestamp() const = 0;
+    // True if data was lost, or the stream restarted, before the frame last returned by DemuxFrame()
+    virtual bool HasFrameDiscontinuity() const = 0;
     virtual int64_t ReadBitstreamData(const uint8_t **ppVideo, int64_t offset) = 0;
+    // avcC/hvcC record of a stream demuxed into length-prefixed NAL units, NULL for Annex B
+    virtual const uint8_t* GetDecoderConfigurationRecord(size_t& size) const = 0;
+    // AV1 OBUs in the length delimited format of the AV1 spec Annex B instead of the low overhead format
+    virtual bool IsAv1AnnexB() const = 0;
     virtual void Rewind() = 0;
 
     virtual void DumpStreamParameters() const = 0;
@@ -84,3 +93,43 @@ VkResult ElementaryStreamCreate(const char *pFilePath,
                                 int32_t defaultHeight,
                                 int32_t defaultBitDepth,
                                 VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+// Fails with VK_ERROR_INITIALIZATION_FAILED if pFilePath is not an AV1 or VP9 IVF file
+VkResult IvfDemuxerCreate(const char *pFilePath,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+// Fails with VK_ERROR_INITIALIZATION_FAILED if pFilePath is not an MP4 file with an H.264, H.265, AV1 or VP9 track
+VkResult Mp4DemuxerCreate(const char *pFilePath,
+                          int32_t defaultWidth,
+                          int32_t defaultHeight,
+                          int32_t defaultBitDepth,
+                          VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+// Fails with VK_ERROR_INITIALIZATION_FAILED if pFilePath is not an MPEG-TS file or pipe with an H.264 or H.265 stream
+VkResult TsDemuxerCreate(const char *pFilePath,
+                         int32_t defaultWidth,
+                         int32_t defaultHeight,
+                         int32_t defaultBitDepth,
+                         VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+// Same on a file already opened, which the demuxer takes over. The prefix was read from it already.
+VkResult TsDemuxerCreate(FILE* pFile,
+                         const uint8_t* pPrefix,
+                         size_t prefixSize,
+                         int32_t defaultWidth,
+                         int32_t defaultHeight,
+                         int32_t defaultBitDepth,
+                         VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
+
+// Demuxer of a pipe, a FIFO or a Unix socket ("-" is the standard input), which can neither be mapped nor
+// probed in place: its first bytes are read and probed, then MPEG-TS goes to the TS demuxer and elementary
+// streams are read through a ring buffer. codecType is only needed if the probe can't tell the codec.
+VkResult StreamingDemuxerCreate(const char *pFilePath,
+                                VkVideoCodecOperationFlagBitsKHR codecType,
+                                int32_t defaultWidth,
+                                int32_t defaultHeight,
+                                int32_t defaultBitDepth,
+                                VkSharedBaseObj<VideoStreamDemuxer>& videoStreamDemuxer);
@@ -0,0 +1,427 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "NvVideoParser/nvVulkanVideoParser.h"
+#include "VkCodecUtils/VulkanBitstreamBufferHostImpl.h"
+#include "VkDecoderUtils/VideoStreamProbe.h"
+
+// Confidence of an elementary stream whose first units have valid headers, but no sequence header the parser
+// could get to. A container signature or a sequence header always wins over it.
+static const uint32_t ELEMENTARY_STREAM_HEADER_CONFIDENCE = 25;
+
+// Parser client of the sequence header probe: it hands out the host memory bitstream buffer the parser
+// copies the NAL units (OBUs) to, nothing is ever decoded.
+class VideoStreamProbeClient : public VkParserVideoDecodeClient {
+public:
+    virtual ~VideoStreamProbeClient() { }
+
+    virtual int32_t BeginSequence(const VkParserSequenceInfo*) { return 0; }
+    virtual bool AllocPictureBuffer(VkPicIf**) { return false; }
+    virtual bool DecodePicture(VkParserPictureData*) { return false; }
+    virtual bool UpdatePictureParameters(VkSharedBaseObj<StdVideoPictureParametersSet>&,
+                                         VkSharedBaseObj<VkVideoRefCountBase>&) { return true; }
+    virtual bool DisplayPicture(VkPicIf*, int64_t) { return false; }
+    virtual void UnhandledNALU(const uint8_t*, size_t) { }
+
+    virtual VkDeviceSize GetBitstreamBuffer(VkDeviceSize size, VkDeviceSize minBitstreamBufferOffsetAlignment,
+                                            VkDeviceSize minBitstreamBufferSizeAlignment, const uint8_t* pInitializeBufferMemory,
+                                            VkDeviceSize initializeBufferMemorySize,
+                                            VkSharedBaseObj<VulkanBitstreamBuffer>& bitstreamBuffer)
+    {
+        VkSharedBaseObj<VulkanBitstreamBufferHostImpl> hostBuffer;
+        if (VulkanBitstreamBufferHostImpl::Create(size, minBitstreamBufferOffsetAlignment, minBitstreamBufferSizeAlignment,
+                                                  pInitializeBufferMemory, initializeBufferMemorySize,
+                                                  hostBuffer) != VK_SUCCESS) {
+            return 0;
+        }
+        bitstreamBuffer = hostBuffer;
+        return hostBuffer->GetMaxSize();
+    }
+};
+
+static bool GetStdExtensionVersion(VkVideoCodecOperationFlagBitsKHR codec, VkExtensionProperties& stdExtensionVersion)
+{
+    memset(&stdExtensionVersion, 0, sizeof(stdExtensionVersion));
+    switch ((uint32_t)codec) {
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_H264_DECODE_SPEC_VERSION;
+        return true;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_H265_DECODE_SPEC_VERSION;
+        return true;
+    case VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR:
+        strcpy(stdExtensionVersion.extensionName, VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_EXTENSION_NAME);
+        stdExtensionVersion.specVersion = VK_STD_VULKAN_VIDEO_CODEC_AV1_DECODE_SPEC_VERSION;
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+static VkVideoChromaSubsamplingFlagsKHR ChromaFormatIdcToSubsampling(uint32_t chromaFormatIdc)
+{
+    switch (chromaFormatIdc) {
+    case 0:
+        return VK_VIDEO_CHROMA_SUBSAMPLING_MONOCHROME_BIT_KHR;
+    case 2:
+        return VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+    case 3:
+        return VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+    default:
+        return VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+    }
+}
+
+// Reads a leb128() value, see 4.10.5 of the AV1 specification. Returns its size in bytes, 0 if it is truncated.
+static size_t ReadLeb128(const uint8_t* pData, size_t size, uint64_t& value)
+{
+    value = 0;
+    for (size_t i = 0; (i < 8) && (i < size); i++) {
+        value |= (uint64_t)(pData[i] & 0x7f) << (i * 7);
+        if (!(pData[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+bool VideoStreamProbeSequenceInfo(VkVideoCodecOperationFlagBitsKHR codec, bool av1AnnexB,
+                                  const uint8_t* pData, size_t size, bool endOfStream,
+                                  VideoStreamFormat& format)
+{
+    VkExtensionProperties stdExtensionVersion;
+    if ((size == 0) || !GetStdExtensionVersion(codec, stdExtensionVersion)) {
+        return false;
+    }
+
+    // The sequence header probe of the parser walks the OBUs of a single frame unit
+    if (av1AnnexB) {
+        uint64_t temporalUnitSize = 0, frameUnitSize = 0;
+        size_t lengthSize = ReadLeb128(pData, size, temporalUnitSize);
+        if (lengthSize == 0) {
+            return false;
+        }
+        pData += lengthSize;
+        size -= lengthSize;
+        lengthSize = ReadLeb128(pData, size, frameUnitSize);
+        if ((lengthSize == 0) || (frameUnitSize > temporalUnitSize)) {
+            return false;
+        }
+        pData += lengthSize;
+        size -= lengthSize;
+        if (frameUnitSize < size) {
+            size = (size_t)frameUnitSize;
+        }
+    }
+
+    VideoStreamProbeClient client;
+    VkParserInitDecodeParameters initParams;
+    memset(&initParams, 0, sizeof(initParams));
+    initParams.interfaceVersion = NV_VULKAN_VIDEO_PARSER_API_VERSION;
+    initParams.pClient = &client;
+    initParams.defaultMinBufferSize = 64 * 1024;
+    initParams.bufferOffsetAlignment = 256;
+    initParams.bufferSizeAlignment = 256;
+    initParams.outOfBandPictureParameters = true;
+    initParams.av1AnnexB = av1AnnexB;
+
+    VkSharedBaseObj<VulkanVideoDecodeParser> parser;
+    if (CreateVulkanVideoDecodeParser(codec, &stdExtensionVersion, nullptr, 0, &initParams, parser) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkParserBitstreamPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.pByteStream = pData;
+    packet.nDataLength = size;
+    packet.bEOS = endOfStream;
+    VkParserSequenceInfo nvsi;
+    memset(&nvsi, 0, sizeof(nvsi));
+    if (!parser->ProbeSequenceInfo(&packet, &nvsi)) {
+        return false;
+    }
+
+    format.hasSequenceInfo = true;
+    format.profileIdc = nvsi.codecProfile;
+    format.chromaSubsampling = ChromaFormatIdcToSubsampling(nvsi.nChromaFormat);
+    format.lumaBitDepth = nvsi.uBitDepthLumaMinus8 + 8;
+    format.chromaBitDepth = nvsi.uBitDepthChromaMinus8 + 8;
+    format.codedWidth = nvsi.nCodedWidth;
+    format.codedHeight = nvsi.nCodedHeight;
+    format.displayWidth = (nvsi.nDisplayWidth != 0) ? nvsi.nDisplayWidth : nvsi.nCodedWidth;
+    format.displayHeight = (nvsi.nDisplayHeight != 0) ? nvsi.nDisplayHeight : nvsi.nCodedHeight;
+    return true;
+}
+
+// The probes of the registry. Each one returns its confidence that pData is the start of a stream of its format,
+// and fills format in if it is not 0.
+
+static uint32_t ProbeIvf(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    if ((size < 32) || (memcmp(pData, "DKIF", 4) != 0)) {
+        return 0;
+    }
+    format.container = VideoStreamFormat::CONTAINER_IVF;
+    if (memcmp(pData + 8, "AV01", 4) == 0) {
+        format.codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+        // The first frame starts with the sequence header, past the file and the frame headers
+        const size_t headerSize = std::max<size_t>(pData[6] | (pData[7] << 8), 32);
+        if ((headerSize + 12) < size) {
+            const size_t frameSize = (size_t)pData[headerSize] | ((size_t)pData[headerSize + 1] << 8) |
+                                     ((size_t)pData[headerSize + 2] << 16) | ((size_t)pData[headerSize + 3] << 24);
+            const size_t availableSize = size - (headerSize + 12);
+            VideoStreamProbeSequenceInfo(format.codec, false, pData + headerSize + 12, std::min(frameSize, availableSize),
+                                         endOfStream || (frameSize <= availableSize), format);
+        }
+#ifdef VK_EXT_video_decode_vp9
+    } else if (memcmp(pData + 8, "VP90", 4) == 0) {
+        format.codec = VK_VIDEO_CODEC_OPERATION_DECODE_VP9_BIT_KHR;
+#endif // VK_EXT_video_decode_vp9
+    }
+    return VIDEO_STREAM_PROBE_CONFIDENCE_MAX;
+}
+
+// The first box of an MP4 file is usually ftyp, some writers start with other top-level boxes
+static uint32_t ProbeMp4(const uint8_t* pData, size_t size, bool, VideoStreamFormat& format)
+{
+    static const char* const topLevelBoxes[] = { "moov", "mdat", "moof", "free", "skip", "wide", "pdin" };
+    if (size < 8) {
+        return 0;
+    }
+    const uint32_t boxSize = ((uint32_t)pData[0] << 24) | ((uint32_t)pData[1] << 16) | ((uint32_t)pData[2] << 8) | pData[3];
+    if ((boxSize != 0) && (boxSize != 1) && (boxSize < 8)) {
+        return 0;
+    }
+    uint32_t confidence = 0;
+    if ((memcmp(pData + 4, "ftyp", 4) == 0) || (memcmp(pData + 4, "styp", 4) == 0)) {
+        confidence = VIDEO_STREAM_PROBE_CONFIDENCE_MAX;
+    } else {
+        for (size_t i = 0; i < sizeof(topLevelBoxes) / sizeof(topLevelBoxes[0]); i++) {
+            if (memcmp(pData + 4, topLevelBoxes[i], 4) == 0) {
+                confidence = VIDEO_STREAM_PROBE_CONFIDENCE_MAX / 2;
+            }
+        }
+    }
+    if (confidence != 0) {
+        // The sample description may well be at the end of the file, the demuxer finds it
+        format.container = VideoStreamFormat::CONTAINER_MP4;
+    }
+    return confidence;
+}
+
+// Sync bytes at the 188-byte interval of TS packets, or at the 192-byte one of M2TS packets
+static uint32_t ProbeTs(const uint8_t* pData, size_t size, bool, VideoStreamFormat& format)
+{
+    static const size_t packetSizes[] = { 188, 192 };
+    for (size_t i = 0; i < sizeof(packetSizes) / sizeof(packetSizes[0]); i++) {
+        const size_t syncOffset = packetSizes[i] - 188;
+        const size_t numPackets = std::min<size_t>(size / packetSizes[i], 8);
+        size_t numSyncBytes = 0;
+        while ((numSyncBytes < numPackets) && (pData[syncOffset + numSyncBytes * packetSizes[i]] == 0x47)) {
+            numSyncBytes++;
+        }
+        if ((numSyncBytes >= 3) && (numSyncBytes == numPackets)) {
+            format.container = VideoStreamFormat::CONTAINER_TS;
+            return VIDEO_STREAM_PROBE_CONFIDENCE_MAX;
+        }
+    }
+    return 0;
+}
+
+// An Annex B byte stream starts with zero bytes and a start code, see B.2 of the H.264 and H.265 specifications
+static uint32_t ProbeAnnexB(VkVideoCodecOperationFlagBitsKHR codec, const uint8_t* pData, size_t size, bool endOfStream,
+                            VideoStreamFormat& format)
+{
+    size_t offset = 0;
+    while ((offset < size) && (offset < 64) && (pData[offset] == 0x00)) {
+        offset++;
+    }
+    if ((offset < 2) || ((offset + 2) >= size) || (pData[offset] != 0x01)) {
+        return 0;
+    }
+    const uint8_t* pNalUnitHeader = pData + offset + 1;
+
+    // forbidden_zero_bit, and a NAL unit type that can start a stream
+    if (pNalUnitHeader[0] & 0x80) {
+        return 0;
+    }
+    if (codec == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+        const uint32_t nalUnitType = pNalUnitHeader[0] & 0x1f;
+        if ((nalUnitType != 1) && (nalUnitType != 5) && ((nalUnitType < 6) || (nalUnitType > 15))) {
+            return 0;
+        }
+    } else {
+        const uint32_t nalUnitType = (pNalUnitHeader[0] >> 1) & 0x3f;
+        const uint32_t temporalIdPlus1 = pNalUnitHeader[1] & 0x07;
+        if ((temporalIdPlus1 == 0) || ((nalUnitType > 21) && ((nalUnitType < 32) || (nalUnitType > 40)))) {
+            return 0;
+        }
+    }
+
+    format.container = VideoStreamFormat::CONTAINER_ELEMENTARY;
+    format.codec = codec;
+    return VideoStreamProbeSequenceInfo(codec, false, pData, size, endOfStream, format) ?
+               VIDEO_STREAM_PROBE_CONFIDENCE_MAX : ELEMENTARY_STREAM_HEADER_CONFIDENCE;
+}
+
+static uint32_t ProbeH264(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    return ProbeAnnexB(VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR, pData, size, endOfStream, format);
+}
+
+static uint32_t ProbeH265(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    return ProbeAnnexB(VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR, pData, size, endOfStream, format);
+}
+
+// OBU header, see 5.3.2 of the AV1 specification: forbidden bit, a defined type and a zero reserved bit
+static bool IsAv1ObuHeader(uint8_t obuHeader)
+{
+    const uint32_t obuType = (obuHeader >> 3) & 0xf;
+    return !(obuHeader & 0x80) && !(obuHeader & 0x01) && (((obuType >= 1) && (obuType <= 8)) || (obuType == 15));
+}
+
+// Low-overhead bitstream format (Section 5): a temporal unit starts with a temporal delimiter, every OBU has a size
+static uint32_t ProbeAv1Obu(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    size_t offset = 0;
+    uint32_t numObus = 0;
+    while (offset < size) {
+        const uint8_t obuHeader = pData[offset];
+        const bool hasExtension = (obuHeader >> 2) & 1;
+        const bool hasSizeField = (obuHeader >> 1) & 1;
+        if (!IsAv1ObuHeader(obuHeader) || !hasSizeField || ((numObus == 0) && (((obuHeader >> 3) & 0xf) != 2))) { // OBU_TEMPORAL_DELIMITER
+            return 0;
+        }
+        offset += hasExtension ? 2 : 1;
+        uint64_t obuSize = 0;
+        const size_t lengthSize = (offset < size) ? ReadLeb128(pData + offset, size - offset, obuSize) : 0;
+        if (lengthSize == 0) {
+            break; // Truncated by the probe size
+        }
+        offset += lengthSize + (size_t)obuSize;
+        numObus++;
+    }
+    if (numObus == 0) {
+        return 0;
+    }
+
+    format.container = VideoStreamFormat::CONTAINER_ELEMENTARY;
+    format.codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+    return VideoStreamProbeSequenceInfo(format.codec, false, pData, size, endOfStream, format) ?
+               VIDEO_STREAM_PROBE_CONFIDENCE_MAX : ELEMENTARY_STREAM_HEADER_CONFIDENCE;
+}
+
+// Length-delimited bitstream format (Annex B): the temporal units, frame units and OBUs are preceded by their size,
+// the first OBU of a temporal unit is a temporal delimiter
+static uint32_t ProbeAv1AnnexB(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    uint64_t temporalUnitSize = 0, frameUnitSize = 0, obuLength = 0;
+    size_t offset = ReadLeb128(pData, size, temporalUnitSize);
+    if ((offset == 0) || (temporalUnitSize == 0)) {
+        return 0;
+    }
+    size_t lengthSize = ReadLeb128(pData + offset, size - offset, frameUnitSize);
+    if ((lengthSize == 0) || (frameUnitSize == 0) || ((lengthSize + frameUnitSize) > temporalUnitSize)) {
+        return 0;
+    }
+    offset += lengthSize;
+    lengthSize = ReadLeb128(pData + offset, size - offset, obuLength);
+    if ((lengthSize == 0) || (obuLength == 0) || ((lengthSize + obuLength) > frameUnitSize) || ((offset + lengthSize) >= size)) {
+        return 0;
+    }
+    const uint8_t obuHeader = pData[offset + lengthSize];
+    if (!IsAv1ObuHeader(obuHeader) || (((obuHeader >> 3) & 0xf) != 2)) { // OBU_TEMPORAL_DELIMITER
+        return 0;
+    }
+
+    format.container = VideoStreamFormat::CONTAINER_ELEMENTARY;
+    format.codec = VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR;
+    format.av1AnnexB = true;
+    return VideoStreamProbeSequenceInfo(format.codec, true, pData, size, endOfStream, format) ?
+               VIDEO_STREAM_PROBE_CONFIDENCE_MAX : ELEMENTARY_STREAM_HEADER_CONFIDENCE;
+}
+
+struct VideoStreamProbeEntry {
+    const char* pName;
+    uint32_t (*pfnProbe)(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format);
+};
+
+// Containers first: a tie goes to the first probe
+static const VideoStreamProbeEntry s_videoStreamProbes[] = {
+    { "IVF",         ProbeIvf },
+    { "MP4",         ProbeMp4 },
+    { "MPEG-TS",     ProbeTs },
+    { "H.264",       ProbeH264 },
+    { "H.265",       ProbeH265 },
+    { "AV1 OBU",     ProbeAv1Obu },
+    { "AV1 Annex B", ProbeAv1AnnexB },
+};
+
+uint32_t VideoStreamProbe(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format)
+{
+    memset(&format, 0, sizeof(format));
+    format.codec = VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+    if ((pData == nullptr) || (size == 0)) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(s_videoStreamProbes) / sizeof(s_videoStreamProbes[0]); i++) {
+        VideoStreamFormat probeFormat;
+        memset(&probeFormat, 0, sizeof(probeFormat));
+        probeFormat.codec = VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+        const uint32_t confidence = s_videoStreamProbes[i].pfnProbe(pData, size, endOfStream, probeFormat);
+        if (confidence > format.confidence) {
+            format = probeFormat;
+            format.pName = s_videoStreamProbes[i].pName;
+            format.confidence = confidence;
+            if (confidence >= VIDEO_STREAM_PROBE_CONFIDENCE_MAX) {
+                break;
+            }
+        }
+    }
+    return format.confidence;
+}
+
+uint32_t VideoStreamProbeFile(const char* pFilePath, VideoStreamFormat& format)
+{
+    memset(&format, 0, sizeof(format));
+    format.codec = VK_VIDEO_CODEC_OPERATION_NONE_KHR;
+
+    // Reading a pipe would take the data away from the demuxer
+    struct stat fileStat;
+    if ((stat(pFilePath, &fileStat) != 0) || ((fileStat.st_mode & S_IFMT) != S_IFREG)) {
+        return 0;
+    }
+    FILE* pFile = fopen(pFilePath, "rb");
+    if (pFile == nullptr) {
+        return 0;
+    }
+    std::vector<uint8_t> data(VIDEO_STREAM_PROBE_SIZE);
+    data.resize(fread(data.data(), 1, data.size(), pFile));
+    fclose(pFile);
+
+    return VideoStreamProbe(data.data(), data.size(), (data.size() < VIDEO_STREAM_PROBE_SIZE), format);
+}
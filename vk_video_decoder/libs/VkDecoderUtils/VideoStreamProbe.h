@@ -0,0 +1,68 @@
+/*
+* Copyright 2023 NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan_interfaces.h>
+
+// Format of a video stream, as far as its first bytes tell
+struct VideoStreamFormat {
+
+    enum Container {
+        CONTAINER_UNKNOWN = 0,
+        CONTAINER_ELEMENTARY,   // Annex B H.264/H.265, AV1 low-overhead (Section 5) or Annex B OBUs
+        CONTAINER_IVF,
+        CONTAINER_MP4,
+        CONTAINER_TS,
+    };
+
+    Container container;
+    const char* pName;                                  // Of the probe that recognized the stream
+    uint32_t confidence;                                // 0 to VIDEO_STREAM_PROBE_CONFIDENCE_MAX
+    VkVideoCodecOperationFlagBitsKHR codec;             // NONE if only the container is known
+    bool av1AnnexB;                                     // AV1 OBUs in the Annex B length-delimited format
+    // Filled in from the first sequence header (H.264/H.265 SPS, AV1 sequence header), if any
+    bool hasSequenceInfo;
+    uint32_t profileIdc;
+    VkVideoChromaSubsamplingFlagsKHR chromaSubsampling;
+    int32_t lumaBitDepth;
+    int32_t chromaBitDepth;
+    int32_t codedWidth, codedHeight;                    // AV1: the maximum frame size
+    int32_t displayWidth, displayHeight;
+};
+
+enum {
+    // Size of the prefix of the stream the probes look at
+    VIDEO_STREAM_PROBE_SIZE = 64 * 1024,
+    // A container signature, or a sequence header the parser accepted
+    VIDEO_STREAM_PROBE_CONFIDENCE_MAX = 100,
+};
+
+// Runs all the registered probes on pData, a prefix of the stream (the whole stream if endOfStream is set),
+// and fills format in from the most confident one. Returns its confidence, 0 if no probe recognized the data.
+uint32_t VideoStreamProbe(const uint8_t* pData, size_t size, bool endOfStream, VideoStreamFormat& format);
+
+// Same on the first VIDEO_STREAM_PROBE_SIZE bytes of a file. The file is read, so it must not be a pipe.
+uint32_t VideoStreamProbeFile(const char* pFilePath, VideoStreamFormat& format);
+
+// Fills the sequence information of format in from the first sequence header of pData, an elementary stream of
+// the given codec (for AV1: low-overhead OBUs, or Annex B temporal units if av1AnnexB is set).
+// Returns false if pData has no complete sequence header.
+bool VideoStreamProbeSequenceInfo(VkVideoCodecOperationFlagBitsKHR codec, bool av1AnnexB,
+                                  const uint8_t* pData, size_t size, bool endOfStream,
+                                  VideoStreamFormat& format);
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2023 NVIDIA Corporation.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "VkDecoderUtils/VulkanVideoRandomAccessIndex.h"
+
+static const char s_indexMagic[4] = { 'V', 'K', 'R', 'A' };
+static const uint32_t s_noParameterSets = ~0U;
+static const size_t s_entrySize = 8 + 8 + 4 * 7;
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (uint32_t i = 0; i < 4; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void PutU64(std::vector<uint8_t>& out, uint64_t value)
+{
+    for (uint32_t i = 0; i < 8; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+static uint32_t GetU32(const uint8_t* pData)
+{
+    return (uint32_t)pData[0] | ((uint32_t)pData[1] << 8) | ((uint32_t)pData[2] << 16) | ((uint32_t)pData[3] << 24);
+}
+
+static uint64_t GetU64(const uint8_t* pData)
+{
+    return (uint64_t)GetU32(pData) | ((uint64_t)GetU32(pData + 4) << 32);
+}
+
+void VulkanVideoRandomAccessIndex::Reset(VkVideoCodecOperationFlagBitsKHR codec)
+{
+    m_codec = codec;
+    m_parameterSets.clear();
+    m_entries.clear();
+}
+
+void VulkanVideoRandomAccessIndex::Add(const VkParserRandomAccessPoint* pRandomAccessPoint)
+{
+    Entry entry;
+    entry.offset = pRandomAccessPoint->llOffset;
+    entry.pts = pRandomAccessPoint->llPTS;
+    entry.ptsValid = pRandomAccessPoint->bPTSValid;
+    entry.type = pRandomAccessPoint->type;
+    entry.picOrderCnt = pRandomAccessPoint->picOrderCnt;
+    entry.vpsId = pRandomAccessPoint->vpsId;
+    entry.spsId = pRandomAccessPoint->spsId;
+    entry.ppsId = pRandomAccessPoint->ppsId;
+    entry.parameterSetsIndex = s_noParameterSets;
+
+    if (pRandomAccessPoint->parameterSetsSize > 0) {
+        const uint8_t* pParameterSets = pRandomAccessPoint->pParameterSets;
+        const size_t parameterSetsSize = pRandomAccessPoint->parameterSetsSize;
+        // Most random access points share the same parameter sets, search the most recent ones first
+        for (size_t i = m_parameterSets.size(); i > 0; i--) {
+            const std::vector<uint8_t>& parameterSets = m_parameterSets[i - 1];
+            if ((parameterSets.size() == parameterSetsSize) &&
+                (memcmp(parameterSets.data(), pParameterSets, parameterSetsSize) == 0)) {
+                entry.parameterSetsIndex = (uint32_t)(i - 1);
+                break;
+            }
+        }
+        if (entry.parameterSetsIndex == s_noParameterSets) {
+            entry.parameterSetsIndex = (uint32_t)m_parameterSets.size();
+            m_parameterSets.push_back(std::vector<uint8_t>(pParameterSets, pParameterSets + parameterSetsSize));
+        }
+    }
+
+    m_entries.push_back(entry);
+}
+
+bool VulkanVideoRandomAccessIndex::GetRandomAccessPoint(size_t index, VkParserRandomAccessPoint* pRandomAccessPoint) const
+{
+    if (index >= m_entries.size()) {
+        return false;
+    }
+
+    const Entry& entry = m_entries[index];
+    *pRandomAccessPoint = VkParserRandomAccessPoint();
+    pRandomAccessPoint->llOffset = entry.offset;
+    pRandomAccessPoint->llPTS = entry.pts;
+    pRandomAccessPoint->bPTSValid = entry.ptsValid;
+    pRandomAccessPoint->type = entry.type;
+    pRandomAccessPoint->picOrderCnt = entry.picOrderCnt;
+    pRandomAccessPoint->vpsId = entry.vpsId;
+    pRandomAccessPoint->spsId = entry.spsId;
+    pRandomAccessPoint->ppsId = entry.ppsId;
+    if (entry.parameterSetsIndex != s_noParameterSets) {
+        const std::vector<uint8_t>& parameterSets = m_parameterSets[entry.parameterSetsIndex];
+        pRandomAccessPoint->pParameterSets = parameterSets.data();
+        pRandomAccessPoint->parameterSetsSize = parameterSets.size();
+    }
+    return true;
+}
+
+size_t VulkanVideoRandomAccessIndex::FindByOffset(int64_t offset) const
+{
+    // The entries are in stream order
+    size_t found = invalidIndex;
+    size_t first = 0, last = m_entries.size();
+    while (first < last) {
+        const size_t middle = first + (last - first) / 2;
+        if (m_entries[middle].offset <= offset) {
+            found = middle;
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return found;
+}
+
+size_t VulkanVideoRandomAccessIndex::FindByPTS(int64_t pts) const
+{
+    // Time stamps are not necessarily monotonic in decode order
+    size_t found = invalidIndex;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].ptsValid && (m_entries[i].pts <= pts) &&
+            ((found == invalidIndex) || (m_entries[i].pts >= m_entries[found].pts))) {
+            found = i;
+        }
+    }
+    return found;
+}
+
+bool VulkanVideoRandomAccessIndex::Write(const char* pFilePath) const
+{
+    std::vector<uint8_t> data(s_indexMagic, s_indexMagic + sizeof(s_indexMagic));
+    PutU32(data, version);
+    PutU32(data, (uint32_t)m_codec);
+    PutU32(data, (uint32_t)m_parameterSets.size());
+    PutU32(data, (uint32_t)m_entries.size());
+    for (size_t i = 0; i < m_parameterSets.size(); i++) {
+        PutU32(data, (uint32_t)m_parameterSets[i].size());
+        data.insert(data.end(), m_parameterSets[i].begin(), m_parameterSets[i].end());
+    }
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const Entry& entry = m_entries[i];
+        PutU64(data, (uint64_t)entry.offset);
+        PutU64(data, (uint64_t)entry.pts);
+        PutU32(data, entry.ptsValid ? 1 : 0);
+        PutU32(data, entry.type);
+        PutU32(data, (uint32_t)entry.picOrderCnt);
+        PutU32(data, (uint32_t)entry.vpsId);
+        PutU32(data, (uint32_t)entry.spsId);
+        PutU32(data, (uint32_t)entry.ppsId);
+        PutU32(data, entry.parameterSetsIndex);
+    }
+
+    FILE* pFile = fopen(pFilePath, "wb");
+    if (pFile == NULL) {
+        fprintf(stderr, "Can't open the random access index file %s for writing\n", pFilePath);
+        return false;
+    }
+    const bool success = fwrite(data.data(), 1, data.size(), pFile) == data.size();
+    fclose(pFile);
+    return success;
+}
+
+bool VulkanVideoRandomAccessIndex::Read(const char* pFilePath)
+{
+    FILE* pFile = fopen(pFilePath, "rb");
+    if (pFile == NULL) {
+        fprintf(stderr, "Can't open the random access index file %s\n", pFilePath);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0) {
+        data.insert(data.end(), buffer, buffer + bytesRead);
+    }
+    fclose(pFile);
+
+    const size_t headerSize = sizeof(s_indexMagic) + 4 * 4;
+    if ((data.size() < headerSize) || (memcmp(data.data(), s_indexMagic, sizeof(s_indexMagic)) != 0) ||
+        (GetU32(&data[4]) != version)) {
+        fprintf(stderr, "%s is not a supported random access index file\n", pFilePath);
+        return false;
+    }
+
+    Reset((VkVideoCodecOperationFlagBitsKHR)GetU32(&data[8]));
+    const uint32_t numParameterSets = GetU32(&data[12]);
+    const uint32_t numEntries = GetU32(&data[16]);
+    size_t offset = headerSize;
+    for (uint32_t i = 0; i < numParameterSets; i++) {
+        if (data.size() - offset < 4) {
+            break;
+        }
+        const uint32_t size = GetU32(&data[offset]);
+        offset += 4;
+        if (data.size() - offset < size) {
+            break;
+        }
+        m_parameterSets.push_back(std::vector<uint8_t>(&data[offset], &data[offset] + size));
+        offset += size;
+    }
+    if ((m_parameterSets.size() != numParameterSets) || ((data.size() - offset) / s_entrySize < numEntries)) {
+        fprintf(stderr, "The random access index file %s is truncated\n", pFilePath);
+        Reset(VK_VIDEO_CODEC_OPERATION_NONE_KHR);
+        return false;
+    }
+
+    m_entries.resize(numEntries);
+    for (uint32_t i = 0; i < numEntries; i++, offset += s_entrySize) {
+        const uint8_t* pEntry = &data[offset];
+        Entry& entry = m_entries[i];
+        entry.offset = (int64_t)GetU64(pEntry);
+        entry.pts = (int64_t)GetU64(pEntry + 8);
+        entry.ptsValid = (GetU32(pEntry + 16) & 1) != 0;
+        entry.type = GetU32(pEntry + 20);
+        entry.picOrderCnt = (int32_t)GetU32(pEntry + 24);
+        entry.vpsId = (int32_t)GetU32(pEntry + 28);
+        entry.spsId = (int32_t)GetU32(pEntry + 32);
+        entry.ppsId = (int32_t)GetU32(pEntry + 36);
+        entry.parameterSetsIndex = GetU32(pEntry + 40);
+        if ((entry.parameterSetsIndex != s_noParameterSets) && (entry.parameterSetsIndex >= numParameterSets)) {
+            fprintf(stderr, "The random access index file %s is corrupted\n", pFilePath);
+            Reset(VK_VIDEO_CODEC_OPERATION_NONE_KHR);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+/*
+* Copyright 2023 NVIDIA Corporation.  All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*    http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+
+// Random access index of an elementary stream, built from the
+// VkParserVideoDecodeClient::RandomAccessPoint() callbacks of an index pass
+// (VkParserInitDecodeParameters::indexRandomAccessPoints) and stored in a
+// binary sidecar file next to the stream. The parameter sets to replay are
+// shared by all the random access points that use them. vk-video-parse-bench --index
+// builds the index, and vk-video-dec --seekIndex starts decoding at one of its points.
+//
+// Sidecar layout (all fields little-endian):
+//   char     magic[4]               "VKRA"
+//   uint32_t version                VulkanVideoRandomAccessIndex::version
+//   uint32_t codec                  VkVideoCodecOperationFlagBitsKHR
+//   uint32_t numParameterSets
+//   uint32_t numEntries
+//   numParameterSets x { uint32_t size; uint8_t data[size]; }
+//   numEntries x { int64_t offset; int64_t pts; uint32_t flags; uint32_t type; int32_t picOrderCnt;
+//                  int32_t vpsId; int32_t spsId; int32_t ppsId; uint32_t parameterSetsIndex; }
+class VulkanVideoRandomAccessIndex {
+
+public:
+    static const uint32_t version = 1;
+    static const size_t invalidIndex = (size_t)-1;
+
+    VulkanVideoRandomAccessIndex(VkVideoCodecOperationFlagBitsKHR codec = VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+        : m_codec(codec)
+        , m_parameterSets()
+        , m_entries() { }
+
+    void Reset(VkVideoCodecOperationFlagBitsKHR codec);
+    void Add(const VkParserRandomAccessPoint* pRandomAccessPoint);
+
+    VkVideoCodecOperationFlagBitsKHR GetVideoCodec() const { return m_codec; }
+    size_t GetCount() const { return m_entries.size(); }
+    // The parameter sets of the returned random access point are owned by the index
+    bool GetRandomAccessPoint(size_t index, VkParserRandomAccessPoint* pRandomAccessPoint) const;
+
+    // Returns the last random access point at or before the byte offset / time stamp, or invalidIndex
+    size_t FindByOffset(int64_t offset) const;
+    size_t FindByPTS(int64_t pts) const;
+
+    bool Write(const char* pFilePath) const;
+    bool Read(const char* pFilePath);
+
+private:
+    struct Entry {
+        int64_t  offset;
+        int64_t  pts;
+        bool     ptsValid;
+        uint32_t type;
+        int32_t  picOrderCnt;
+        int32_t  vpsId;
+        int32_t  spsId;
+        int32_t  ppsId;
+        uint32_t parameterSetsIndex;  // In m_parameterSets, ~0U if none
+    };
+
+    VkVideoCodecOperationFlagBitsKHR  m_codec;
+    std::vector<std::vector<uint8_t>> m_parameterSets;
+    std::vector<Entry>                m_entries;
+};
@@ -384,6 +384,60 @@ bool VkParserVideoPictureParameters::UpdatePictureParametersHierarchy(
     return true;
 }
 
+int32_t VkParserVideoPictureParameters::GetPictureParametersSetKey(const StdVideoPictureParametersSet* pStdPictureParametersSet)
+{
+    bool isId = false;
+    int32_t id = -1;
+    switch (pStdPictureParametersSet->GetParameterType()) {
+    case StdVideoPictureParametersSet::PPS_TYPE:
+        id = pStdPictureParametersSet->GetPpsId(isId);
+        break;
+    case StdVideoPictureParametersSet::SPS_TYPE:
+        id = pStdPictureParametersSet->GetSpsId(isId);
+        break;
+    case StdVideoPictureParametersSet::VPS_TYPE:
+        id = pStdPictureParametersSet->GetVpsId(isId);
+        break;
+    case StdVideoPictureParametersSet::AV1_SPS_TYPE:
+        return (StdVideoPictureParametersSet::AV1_SPS_TYPE << 16);
+    default:
+        return -1;
+    }
+    if (!isId || (id < 0)) {
+        return -1;
+    }
+    return (pStdPictureParametersSet->GetParameterType() << 16) | id;
+}
+
+bool VkParserVideoPictureParameters::HasSamePictureParametersSet(const StdVideoPictureParametersSet* pStdPictureParametersSet,
+                                                                 const VkSharedBaseObj<VulkanVideoSession>& videoSession) const
+{
+    // Parameter sets still in the queue are created with the object, for the first session it is used with
+    if ((m_sessionParameters != VK_NULL_HANDLE) && (m_videoSession != videoSession)) {
+        return false;
+    }
+    const uint64_t contentHash = pStdPictureParametersSet->GetContentHash();
+    const int32_t key = GetPictureParametersSetKey(pStdPictureParametersSet);
+    if ((contentHash == 0) || (key < 0)) {
+        return false;
+    }
+    std::unordered_map<int32_t, uint64_t>::const_iterator it = m_contentHashes.find(key);
+    return (it != m_contentHashes.end()) && (it->second == contentHash);
+}
+
+void VkParserVideoPictureParameters::SetPictureParametersSetContent(const StdVideoPictureParametersSet* pStdPictureParametersSet)
+{
+    const int32_t key = GetPictureParametersSetKey(pStdPictureParametersSet);
+    if (key < 0) {
+        return;
+    }
+    if (pStdPictureParametersSet->GetContentHash() != 0) {
+        m_contentHashes[key] = pStdPictureParametersSet->GetContentHash();
+    } else {
+        m_contentHashes.erase(key);
+    }
+}
+
 VkResult VkParserVideoPictureParameters::AddPictureParametersToQueue(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersSet)
 {
     m_pictureParametersQueue.push(pictureParametersSet);
@@ -478,6 +532,10 @@ VkParserVideoPictureParameters::AddPictureParameters(const VulkanDeviceContext*
 
     if (currentVideoPictureParameters) {
         currentVideoPictureParameters->FlushPictureParametersQueue(videoSession);
+        if (currentVideoPictureParameters->HasSamePictureParametersSet(stdPictureParametersSet, videoSession)) {
+            // A resent, unchanged parameter set maps back to the current object
+            return VK_SUCCESS;
+        }
     }
 
     VkResult result;
@@ -492,6 +550,9 @@ VkParserVideoPictureParameters::AddPictureParameters(const VulkanDeviceContext*
     } else {
         result = currentVideoPictureParameters->AddPictureParametersToQueue(stdPictureParametersSet);
     }
+    if (result == VK_SUCCESS) {
+        currentVideoPictureParameters->SetPictureParametersSetContent(stdPictureParametersSet);
+    }
 
     return result;
 }
@@ -111,6 +111,14 @@ public:
 
     bool UpdatePictureParametersHierarchy(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject);
 
+    // Content cache: returns true if this object already has a parameter set of the same type and id
+    // with the same content, for videoSession, so that stdPictureParametersSet needs no create or update.
+    bool HasSamePictureParametersSet(const StdVideoPictureParametersSet* pStdPictureParametersSet,
+                                     const VkSharedBaseObj<VulkanVideoSession>& videoSession) const;
+    // Records the content of a parameter set added to this object (an unknown content clears the entry)
+    void SetPictureParametersSetContent(const StdVideoPictureParametersSet* pStdPictureParametersSet);
+    static int32_t GetPictureParametersSetKey(const StdVideoPictureParametersSet* pStdPictureParametersSet);
+
     VkResult AddPictureParametersToQueue(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersSet);
     int32_t FlushPictureParametersQueue(VkSharedBaseObj<VulkanVideoSession>& videoSession);
 
@@ -123,7 +131,13 @@ protected:
           m_vkDevCtx(vkDevCtx),
           m_videoSession(),
           m_sessionParameters(),
-          m_templatePictureParameters(templatePictureParameters) { }
+          m_templatePictureParameters(templatePictureParameters),
+          m_contentHashes() {
+        if (templatePictureParameters) {
+            // The new object starts from the parameter sets of the template
+            m_contentHashes = templatePictureParameters->m_contentHashes;
+        }
+    }
 
     virtual ~VkParserVideoPictureParameters();
 
@@ -141,6 +155,7 @@ private:
     std::bitset<MAX_PPS_IDS>        m_ppsIdsUsed;
     std::bitset<MAX_SPS_IDS>        m_av1SpsIdsUsed;
     VkSharedBaseObj<VkParserVideoPictureParameters> m_templatePictureParameters; // needed only for the create
+    std::unordered_map<int32_t, uint64_t> m_contentHashes; // content hash of each parameter set (key = type << 16 | id)
 
     std::queue<VkSharedBaseObj<StdVideoPictureParametersSet>>  m_pictureParametersQueue;
     VkSharedBaseObj<StdVideoPictureParametersSet>              m_lastPictParamsQueue[StdVideoPictureParametersSet::NUM_OF_TYPES];
@@ -22,9 +22,11 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
-#include <queue>
 #include <bitset> // std::bitset
 
 #include "vkvideo_parser/VulkanVideoParserIf.h"
@@ -33,8 +35,10 @@
 #include "vkvideo_parser/PictureBufferBase.h"
 #include "VkVideoCore/VkVideoCoreProfile.h"
 #include "vkvideo_parser/StdVideoPictureParametersSet.h"
+#include "VkCodecUtils/VkLockFreeSpscQueue.h"
 
 #include "vkvideo_parser/VulkanVideoParser.h"
+#include "vkvideo_parser/VulkanVideoParserTrace.h"
 
 #undef min
 #undef max
@@ -178,6 +182,104 @@ static vkPicBuffBase* GetPic(VkPicIf* pPicBuf)
     return (vkPicBuffBase*)pPicBuf;
 }
 
+/*******************************************************/
+//! \struct VulkanVideoParserPicture
+//! Decode or display request of the pipelined mode, filled
+//! in by the parser thread and executed by the submit thread.
+//! All the pointers of a decode request point into the request
+//! itself and it references every object it uses, so that it
+//! stays valid while the parser moves on to the next pictures.
+/*******************************************************/
+struct VulkanVideoParserPicture {
+    enum Type { DECODE_PICTURE, DISPLAY_PICTURE };
+
+    Type type;
+    vkPicBuffBase* pPicBuf; // The picture decoded or displayed
+    VulkanVideoDisplayPictureInfo displayInfo;
+    VkParserDecodePictureInfo decodePictureInfo;
+    VkParserPerFrameDecodeParameters pictureParams;
+    VkVideoReferenceSlotInfoKHR referenceSlots[VkParserPerFrameDecodeParameters::MAX_DPB_REF_AND_SETUP_SLOTS];
+    VkVideoReferenceSlotInfoKHR setupReferenceSlot;
+    // union {
+    nvVideoH264PicParameters h264;
+    nvVideoH265PicParameters hevc;
+    nvVideoAV1PicParameters av1;
+    // };
+    VkParserAv1PictureData av1PictureData; // The parser overwrites its own with the next picture
+    std::vector<uint32_t> sliceOffsets;    // The parser resets the stream markers for the next picture
+    VkSharedBaseObj<StdVideoPictureParametersSet> stdParameterSets[3]; // VPS, SPS and PPS
+    uint32_t numReferencePictures;
+    vkPicBuffBase* referencePictures[VkParserPerFrameDecodeParameters::MAX_DPB_REF_AND_SETUP_SLOTS];
+
+    VulkanVideoParserPicture()
+        : type(DECODE_PICTURE)
+        , pPicBuf(NULL)
+        , numReferencePictures(0)
+    {
+    }
+
+    void SetPicture(vkPicBuffBase* pPic)
+    {
+        pPic->AddRef();
+        pPicBuf = pPic;
+    }
+
+    void AddReferencePicture(vkPicBuffBase* pPic)
+    {
+        assert(numReferencePictures < ARRAYSIZE(referencePictures));
+        if (pPic && (numReferencePictures < ARRAYSIZE(referencePictures))) {
+            pPic->AddRef();
+            referencePictures[numReferencePictures++] = pPic;
+        }
+    }
+
+    const uint32_t* SaveSliceOffsets(const uint32_t* pSliceOffsets, uint32_t numSlices)
+    {
+        sliceOffsets.assign(pSliceOffsets, pSliceOffsets + numSlices);
+        return sliceOffsets.data();
+    }
+
+    void SaveParameterSets(const VkParserPerFrameDecodeParameters* pParams)
+    {
+        stdParameterSets[0] = const_cast<StdVideoPictureParametersSet*>(pParams->pStdVps);
+        stdParameterSets[1] = const_cast<StdVideoPictureParametersSet*>(pParams->pStdSps);
+        stdParameterSets[2] = const_cast<StdVideoPictureParametersSet*>(pParams->pStdPps);
+    }
+
+    void Release()
+    {
+        if (pPicBuf) {
+            pPicBuf->Release();
+            pPicBuf = NULL;
+        }
+        for (uint32_t i = 0; i < numReferencePictures; i++) {
+            referencePictures[i]->Release();
+        }
+        numReferencePictures = 0;
+        pictureParams.bitstreamData = nullptr;
+        for (uint32_t i = 0; i < ARRAYSIZE(stdParameterSets); i++) {
+            stdParameterSets[i] = nullptr;
+        }
+    }
+};
+
+// Waiting side of the pipelined mode: yield for a while, since the other thread usually
+// is about to finish with its current picture, then sleep so that a stalled pipeline
+// does not keep a core busy.
+static void PipelineWait(uint32_t& waitCount)
+{
+    if (waitCount++ < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+static uint64_t PipelineTimeNs(std::chrono::steady_clock::duration duration)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
 // Keeps track of data associated with active internal reference frames
 class DpbSlot {
 public:
@@ -240,7 +342,8 @@ public:
         : m_dpbMaxSize(0)
         , m_slotInUseMask(0)
         , m_dpb(m_dpbMaxSize)
-        , m_dpbSlotsAvailable()
+        , m_dpbSlotsAvailableHead(0)
+        , m_numDpbSlotsAvailable(0)
     {
         Init(dpbMaxSize, false);
     }
@@ -267,7 +370,7 @@ public:
         }
 
         for (uint8_t dpbIndx = oldDpbMaxSize; dpbIndx < m_dpbMaxSize; dpbIndx++) {
-            m_dpbSlotsAvailable.push(dpbIndx);
+            PushAvailableSlot(dpbIndx);
         }
 
         return m_dpbMaxSize;
@@ -279,9 +382,8 @@ public:
             m_dpb[ndx].Invalidate();
         }
 
-        while (!m_dpbSlotsAvailable.empty()) {
-            m_dpbSlotsAvailable.pop();
-        }
+        m_dpbSlotsAvailableHead = 0;
+        m_numDpbSlotsAvailable = 0;
 
         m_dpbMaxSize = 0;
         m_slotInUseMask = 0;
@@ -291,14 +393,15 @@ public:
 
     int8_t AllocateSlot()
     {
-        if (m_dpbSlotsAvailable.empty()) {
+        if (m_numDpbSlotsAvailable == 0) {
             assert(!"No more DPB slots are available");
             return -1;
         }
-        int8_t slot = (int8_t)m_dpbSlotsAvailable.front();
+        int8_t slot = (int8_t)m_dpbSlotsAvailable[m_dpbSlotsAvailableHead];
         assert((slot >= 0) && ((uint8_t)slot < m_dpbMaxSize));
         m_slotInUseMask |= (1 << slot);
-        m_dpbSlotsAvailable.pop();
+        m_dpbSlotsAvailableHead = (m_dpbSlotsAvailableHead + 1) % MAX_DPB_REF_AND_SETUP_SLOTS;
+        m_numDpbSlotsAvailable--;
         m_dpb[slot].Reserve();
         return slot;
     }
@@ -310,7 +413,7 @@ public:
         assert(m_slotInUseMask & (1 << slot));
 
         m_dpb[slot].Invalidate();
-        m_dpbSlotsAvailable.push(slot);
+        PushAvailableSlot(slot);
         m_slotInUseMask &= ~(1 << slot);
     }
 
@@ -350,10 +453,21 @@ public:
     uint32_t getMaxSize() { return m_dpbMaxSize; }
 
 private:
+    void PushAvailableSlot(uint8_t slot)
+    {
+        assert(m_numDpbSlotsAvailable < MAX_DPB_REF_AND_SETUP_SLOTS);
+        m_dpbSlotsAvailable[(m_dpbSlotsAvailableHead + m_numDpbSlotsAvailable) % MAX_DPB_REF_AND_SETUP_SLOTS] = slot;
+        m_numDpbSlotsAvailable++;
+    }
+
     uint32_t m_dpbMaxSize;
     uint32_t m_slotInUseMask;
     std::vector<DpbSlot> m_dpb;
-    std::queue<uint8_t> m_dpbSlotsAvailable;
+    // The free slots in the order they were freed, in a fixed ring instead of a
+    // std::queue so that allocating and freeing slots never touches the heap.
+    uint8_t m_dpbSlotsAvailable[MAX_DPB_REF_AND_SETUP_SLOTS];
+    uint32_t m_dpbSlotsAvailableHead;
+    uint32_t m_numDpbSlotsAvailable;
 };
 
 class VulkanVideoParser : public VkParserVideoDecodeClient,
@@ -583,6 +697,24 @@ public:
     virtual VkResult ParseVideoData(VkParserSourceDataPacket* pPacket,
                                     size_t* pParsedBytes,
                                     bool doPartialParsing = false);
+    virtual VkResult ProbeVideoFormat(VkParserSourceDataPacket* pPacket,
+                                      VkParserDetectedVideoFormat* pVideoFormat,
+                                      size_t* pParsedBytes = NULL);
+    virtual VkResult SeekVideoData(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                   VkParserSourceDataPacket* pPacket,
+                                   size_t* pParsedBytes,
+                                   bool doPartialParsing = false);
+    virtual VkResult SetDecoderConfigurationRecord(const uint8_t* pData, size_t size);
+    virtual VkResult EnablePipelinedDecode(uint32_t maxPicturesInFlight);
+    virtual void GetPipelineStats(VulkanVideoParserPipelineStats* pStats);
+    virtual VkResult EnableTraceCapture(const char* fileName);
+    virtual VkResult SetDecodeFilter(uint32_t decodeFilter);
+    virtual VkResult SetMaxTemporalLayer(uint32_t maxTemporalLayer);
+    virtual void GetTemporalLayerStats(VkParserTemporalLayerStats* pStats);
+    virtual VkResult EnableLowLatencyOutput();
+    virtual void GetDisplayLatencyStats(VulkanVideoParserLatencyStats* pStats);
+    virtual VkResult EnableStreamingInput();
+    virtual VkResult EnableAv1AnnexBInput();
 
     // Interface to allow decoder to communicate with the client implementing
     // INvVideoDecoderClient
@@ -599,6 +731,8 @@ public:
         int64_t llPTS); // Called when a picture is ready to be displayed
     virtual void UnhandledNALU(
         const uint8_t* /*pbData*/, size_t /*cbData*/) {}; // Called for custom NAL parsing (not required)
+    virtual void DisplayLatency(
+        const VkParserDisplayLatency* pDisplayLatency); // Called before DisplayPicture() with the delay of the picture
 
     virtual uint32_t GetDecodeCaps()
     {
@@ -628,6 +762,8 @@ public:
 
 protected:
     void Deinitialize();
+    VkResult ParsePacket(const VkParserRandomAccessPoint* pRandomAccessPoint, VkParserSourceDataPacket* pPacket,
+                         size_t* pParsedBytes, bool doPartialParsing);
     VkResult Initialize(
         VkSharedBaseObj<IVulkanVideoDecoderHandler>& decoderHandler,
         VkSharedBaseObj<IVulkanVideoFrameBufferParserCb>& videoFrameBufferCb,
@@ -659,6 +795,9 @@ protected:
     uint32_t ResetPicDpbSlots(uint32_t picIndexSlotValidMask);
     bool GetFieldPicFlag(int8_t picIndex);
     bool SetFieldPicFlag(int8_t picIndex, bool fieldPicFlag);
+    static uint32_t GetConfigDpbSlots(const VkParserSequenceInfo* pnvsi);
+    static void GetDetectedVideoFormat(const VkParserSequenceInfo* pnvsi,
+                                       VkParserDetectedVideoFormat* pDetectedFormat);
 
     uint32_t FillDpbH264State(const VkParserPictureData* pd,
         const VkParserH264DpbEntry* dpbIn,
@@ -693,10 +832,20 @@ protected:
                                          int8_t presetDpbSlot);
     int8_t AllocateDpbSlotForCurrentAV1(vkPicBuffBase* pPic, bool isReference,
                                          int8_t presetDpbSlot);
-    
+
+    // Pipelined mode
+    VulkanVideoParserPicture* GetPipelinePicture();
+    void DrainPipeline();
+    void DisablePipelinedDecode();
+    void SubmitThread();
+    bool SubmitPicture(VulkanVideoParserPicture* pPicture);
+
+    VkResult ReinitializeParser();
 
 protected:
     VkSharedBaseObj<VulkanVideoDecodeParser>    m_vkParser;
+    VkParserInitDecodeParameters m_parserInitParams; // Kept to initialize m_vkParser again with other options
+    uint32_t m_maxTemporalLayer;                     // Set again after initializing m_vkParser again
     VkSharedBaseObj<IVulkanVideoDecoderHandler> m_decoderHandler;
     VkSharedBaseObj<IVulkanVideoFrameBufferParserCb> m_videoFrameBufferCb;
     std::atomic<int32_t> m_refCount;
@@ -712,6 +861,15 @@ protected:
     uint32_t m_outOfBandPictureParameters : 1;
     uint32_t m_inlinedPictureParametersUseBeginCoding : 1;
     int8_t m_pictureToDpbSlotMap[MAX_FRM_CNT];
+    // Pipelined mode: the parser thread produces the pictures, the submit thread consumes them
+    std::unique_ptr<VkLockFreeSpscQueue<VulkanVideoParserPicture>> m_pipelineQueue;
+    std::thread m_submitThread;
+    std::atomic<bool> m_pipelineExit;
+    std::atomic<bool> m_pipelineError;
+    VulkanVideoParserPipelineStats m_pipelineStats;
+    std::chrono::steady_clock::time_point m_pipelineStartTime;
+    VulkanVideoParserTraceWriter m_traceWriter;
+    VulkanVideoParserLatencyStats m_latencyStats;
 
 public:
     static bool m_dumpParserData;
@@ -806,7 +964,22 @@ bool VulkanVideoParser::DisplayPicture(VkPicIf* pPicBuff, int64_t timestamp)
     assert(picIdx != -1);
 
     assert(m_videoFrameBufferCb);
-    if (m_videoFrameBufferCb && (picIdx != -1)) {
+    if (m_traceWriter.IsOpen() && (picIdx != -1)) {
+        VulkanVideoDisplayPictureInfo dispInfo = VulkanVideoDisplayPictureInfo();
+        dispInfo.timestamp = (VkVideotimestamp)timestamp;
+        m_traceWriter.WriteDisplayPicture((int8_t)picIdx, &dispInfo);
+    }
+
+    if (m_videoFrameBufferCb && (picIdx != -1) && m_pipelineQueue) {
+        // Displayed in order with the decodes queued before it
+        VulkanVideoParserPicture* pPicture = GetPipelinePicture();
+        pPicture->type = VulkanVideoParserPicture::DISPLAY_PICTURE;
+        pPicture->SetPicture(pVkPicBuff);
+        pPicture->displayInfo = VulkanVideoDisplayPictureInfo();
+        pPicture->displayInfo.timestamp = (VkVideotimestamp)timestamp;
+        m_pipelineQueue->PushProducerNode();
+        result = !m_pipelineError;
+    } else if (m_videoFrameBufferCb && (picIdx != -1)) {
         VulkanVideoDisplayPictureInfo dispInfo = VulkanVideoDisplayPictureInfo();
         dispInfo.timestamp = (VkVideotimestamp)timestamp;
 
@@ -881,6 +1054,8 @@ VulkanVideoParser::VulkanVideoParser(VkVideoCodecOperationFlagBitsKHR codecType,
     uint32_t maxNumDpbSurfaces,
     uint64_t clockRate)
     : m_vkParser()
+    , m_parserInitParams()
+    , m_maxTemporalLayer(VK_PARSER_TEMPORAL_LAYER_ALL)
     , m_decoderHandler()
     , m_videoFrameBufferCb()
     , m_refCount(0)
@@ -894,8 +1069,16 @@ VulkanVideoParser::VulkanVideoParser(VkVideoCodecOperationFlagBitsKHR codecType,
     , m_dpb(3)
     , m_outOfBandPictureParameters(true)
     , m_inlinedPictureParametersUseBeginCoding(false)
+    , m_pipelineQueue()
+    , m_submitThread()
+    , m_pipelineExit(false)
+    , m_pipelineError(false)
+    , m_pipelineStartTime()
+    , m_traceWriter()
 {
     memset(&m_nvsi, 0, sizeof(m_nvsi));
+    memset(&m_pipelineStats, 0, sizeof(m_pipelineStats));
+    memset(&m_latencyStats, 0, sizeof(m_latencyStats));
     for (uint32_t picId = 0; picId < MAX_FRM_CNT; picId++) {
         m_pictureToDpbSlotMap[picId] = -1;
     }
@@ -926,7 +1109,7 @@ VkResult VulkanVideoParser::Initialize(
 
     memset(&m_nvsi, 0, sizeof(m_nvsi));
 
-    VkParserInitDecodeParameters nvdp;
+    VkParserInitDecodeParameters& nvdp = m_parserInitParams;
 
     memset(&nvdp, 0, sizeof(nvdp));
     nvdp.interfaceVersion = NV_VULKAN_VIDEO_PARSER_API_VERSION;
@@ -962,6 +1145,8 @@ VkResult VulkanVideoParser::Initialize(
 void VulkanVideoParser::Deinitialize()
 {
     m_vkParser = nullptr;
+    DisablePipelinedDecode();
+    m_traceWriter.Close();
     m_decoderHandler = nullptr;
     m_videoFrameBufferCb = nullptr;
 }
@@ -969,10 +1154,36 @@ void VulkanVideoParser::Deinitialize()
 VkResult VulkanVideoParser::ParseVideoData(VkParserSourceDataPacket* pPacket,
                                            size_t *pParsedBytes,
                                            bool doPartialParsing)
+{
+    return ParsePacket(NULL, pPacket, pParsedBytes, doPartialParsing);
+}
+
+VkResult VulkanVideoParser::SeekVideoData(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                          VkParserSourceDataPacket* pPacket,
+                                          size_t* pParsedBytes,
+                                          bool doPartialParsing)
+{
+    if (pRandomAccessPoint == NULL) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    return ParsePacket(pRandomAccessPoint, pPacket, pParsedBytes, doPartialParsing);
+}
+
+// Parses pPacket, after seeking to pRandomAccessPoint if it is set
+VkResult VulkanVideoParser::ParsePacket(const VkParserRandomAccessPoint* pRandomAccessPoint,
+                                        VkParserSourceDataPacket* pPacket,
+                                        size_t* pParsedBytes,
+                                        bool doPartialParsing)
 {
     VkParserBitstreamPacket pkt;
     VkResult result;
 
+    const std::chrono::steady_clock::time_point parseStartTime = std::chrono::steady_clock::now();
+    const uint64_t parseWaitTimeNs = m_pipelineStats.parseWaitTimeNs;
+    if (m_pipelineQueue && (m_pipelineStartTime == std::chrono::steady_clock::time_point())) {
+        m_pipelineStartTime = parseStartTime;
+    }
+
     memset(&pkt, 0, sizeof(pkt));
     if (pPacket->flags & VK_PARSER_PKT_DISCONTINUITY) {
         // Handle discontinuity separately, in order to flush before any new
@@ -987,7 +1198,9 @@ VkResult VulkanVideoParser::ParseVideoData(VkParserSourceDataPacket* pPacket,
     pkt.bPTSValid = !!(pPacket->flags & VK_PARSER_PKT_TIMESTAMP);
     pkt.llPTS = pPacket->timestamp;
     pkt.bPartialParsing = doPartialParsing;
-    if (m_vkParser->ParseByteStream(&pkt, pParsedBytes)) {
+    const bool parsed = (pRandomAccessPoint != NULL) ? m_vkParser->ParseByteStreamAt(pRandomAccessPoint, &pkt, pParsedBytes) :
+                                                       m_vkParser->ParseByteStream(&pkt, pParsedBytes);
+    if (parsed) {
         result = VK_SUCCESS;
     } else {
         result = VK_ERROR_INITIALIZATION_FAILED;
@@ -995,10 +1208,265 @@ VkResult VulkanVideoParser::ParseVideoData(VkParserSourceDataPacket* pPacket,
 
     if (pkt.bEOS) {
         // Flush any pending frames after EOS
+        DrainPipeline();
+    }
+
+    if (m_pipelineQueue) {
+        m_pipelineStats.parseTimeNs += PipelineTimeNs(std::chrono::steady_clock::now() - parseStartTime) -
+                                       (m_pipelineStats.parseWaitTimeNs - parseWaitTimeNs);
+        if (m_pipelineError) {
+            result = VK_ERROR_INITIALIZATION_FAILED;
+        }
     }
     return result;
 }
 
+VkResult VulkanVideoParser::ProbeVideoFormat(VkParserSourceDataPacket* pPacket,
+                                             VkParserDetectedVideoFormat* pVideoFormat,
+                                             size_t* pParsedBytes)
+{
+    VkParserBitstreamPacket pkt;
+    VkParserSequenceInfo nvsi;
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.pByteStream = pPacket->payload;
+    pkt.nDataLength = pPacket->payload_size;
+    pkt.bEOS = !!(pPacket->flags & VK_PARSER_PKT_ENDOFSTREAM);
+    pkt.bEOP = !!(pPacket->flags & VK_PARSER_PKT_ENDOFPICTURE);
+    pkt.bPTSValid = !!(pPacket->flags & VK_PARSER_PKT_TIMESTAMP);
+    pkt.llPTS = pPacket->timestamp;
+    if (!m_vkParser->ProbeSequenceInfo(&pkt, &nvsi, pParsedBytes)) {
+        return VK_NOT_READY;
+    }
+
+    // Same format as StartVideoSequence() would get, without starting the sequence
+    GetDetectedVideoFormat(&nvsi, pVideoFormat);
+    return VK_SUCCESS;
+}
+
+VkResult VulkanVideoParser::EnablePipelinedDecode(uint32_t maxPicturesInFlight)
+{
+    if ((maxPicturesInFlight == 0) || m_pipelineQueue) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    m_pipelineQueue.reset(new VkLockFreeSpscQueue<VulkanVideoParserPicture>(maxPicturesInFlight));
+    m_pipelineExit = false;
+    m_pipelineError = false;
+    memset(&m_pipelineStats, 0, sizeof(m_pipelineStats));
+    m_pipelineStartTime = std::chrono::steady_clock::time_point();
+    m_submitThread = std::thread(&VulkanVideoParser::SubmitThread, this);
+
+    return VK_SUCCESS;
+}
+
+void VulkanVideoParser::GetPipelineStats(VulkanVideoParserPipelineStats* pStats)
+{
+    // The submit thread only updates its counters while it has pictures to process
+    DrainPipeline();
+    *pStats = m_pipelineStats;
+}
+
+VkResult VulkanVideoParser::EnableTraceCapture(const char* fileName)
+{
+    return m_traceWriter.Open(fileName, m_codecType);
+}
+
+// The parser has not parsed anything yet: initializing it again only changes its options. The temporal
+// sub-layer limit is not one of them, and is reset by Initialize(), so it is set again.
+VkResult VulkanVideoParser::ReinitializeParser()
+{
+    VkResult result = m_vkParser->Initialize(&m_parserInitParams);
+    if ((result == VK_SUCCESS) && (m_maxTemporalLayer != VK_PARSER_TEMPORAL_LAYER_ALL)) {
+        m_vkParser->SetMaxTemporalLayer(m_maxTemporalLayer);
+    }
+    return result;
+}
+
+VkResult VulkanVideoParser::SetDecodeFilter(uint32_t decodeFilter)
+{
+    if (!m_vkParser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    m_parserInitParams.decodeFilter = decodeFilter;
+    return ReinitializeParser();
+}
+
+VkResult VulkanVideoParser::SetMaxTemporalLayer(uint32_t maxTemporalLayer)
+{
+    if (!m_vkParser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    m_maxTemporalLayer = maxTemporalLayer;
+    m_vkParser->SetMaxTemporalLayer(maxTemporalLayer);
+    return VK_SUCCESS;
+}
+
+void VulkanVideoParser::GetTemporalLayerStats(VkParserTemporalLayerStats* pStats)
+{
+    if (!m_vkParser) {
+        memset(pStats, 0, sizeof(*pStats));
+        return;
+    }
+    m_vkParser->GetTemporalLayerStats(pStats);
+}
+
+VkResult VulkanVideoParser::EnableLowLatencyOutput()
+{
+    if (!m_vkParser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    m_parserInitParams.lowLatencyOutput = true;
+    // For GetDisplayLatencyStats()
+    m_parserInitParams.reportDisplayLatency = true;
+    return ReinitializeParser();
+}
+
+void VulkanVideoParser::GetDisplayLatencyStats(VulkanVideoParserLatencyStats* pStats)
+{
+    *pStats = m_latencyStats;
+}
+
+VkResult VulkanVideoParser::EnableStreamingInput()
+{
+    if (!m_vkParser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    m_parserInitParams.streamingInput = true;
+    return ReinitializeParser();
+}
+
+VkResult VulkanVideoParser::EnableAv1AnnexBInput()
+{
+    if (!m_vkParser) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (m_codecType != VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    }
+    m_parserInitParams.av1AnnexB = true;
+    return ReinitializeParser();
+}
+
+void VulkanVideoParser::DisplayLatency(const VkParserDisplayLatency* pDisplayLatency)
+{
+    m_latencyStats.displayedPictures++;
+    m_latencyStats.delayPictures += pDisplayLatency->delayPictures;
+    m_latencyStats.delayUs += pDisplayLatency->delayUs;
+    m_latencyStats.maxDelayPictures = std::max(m_latencyStats.maxDelayPictures, pDisplayLatency->delayPictures);
+    m_latencyStats.maxDelayUs = std::max(m_latencyStats.maxDelayUs, pDisplayLatency->delayUs);
+}
+
+void VulkanVideoParser::DisablePipelinedDecode()
+{
+    if (!m_pipelineQueue) {
+        return;
+    }
+
+    // The submit thread exits once it has processed all the queued pictures
+    m_pipelineExit = true;
+    if (m_submitThread.joinable()) {
+        m_submitThread.join();
+    }
+    m_pipelineQueue.reset();
+}
+
+// Returns the next free picture of the pipeline queue, waiting for the submit thread if needed
+VulkanVideoParserPicture* VulkanVideoParser::GetPipelinePicture()
+{
+    VulkanVideoParserPicture* pPicture = m_pipelineQueue->GetProducerNode();
+    if (pPicture != NULL) {
+        return pPicture;
+    }
+
+    const std::chrono::steady_clock::time_point waitStartTime = std::chrono::steady_clock::now();
+    uint32_t waitCount = 0;
+    while ((pPicture = m_pipelineQueue->GetProducerNode()) == NULL) {
+        PipelineWait(waitCount);
+    }
+    m_pipelineStats.parseWaitTimeNs += PipelineTimeNs(std::chrono::steady_clock::now() - waitStartTime);
+
+    return pPicture;
+}
+
+// Waits for the submit thread to process all the queued pictures. This is needed before
+// anything the decoder handler may be using from the submit thread changes, and before
+// the client expects all the pictures parsed so far to be decoded.
+void VulkanVideoParser::DrainPipeline()
+{
+    if (!m_pipelineQueue || m_pipelineQueue->Empty()) {
+        return;
+    }
+
+    const std::chrono::steady_clock::time_point waitStartTime = std::chrono::steady_clock::now();
+    uint32_t waitCount = 0;
+    while (!m_pipelineQueue->Empty()) {
+        PipelineWait(waitCount);
+    }
+    const std::chrono::steady_clock::time_point waitEndTime = std::chrono::steady_clock::now();
+    m_pipelineStats.parseWaitTimeNs += PipelineTimeNs(waitEndTime - waitStartTime);
+    m_pipelineStats.elapsedTimeNs = PipelineTimeNs(waitEndTime - m_pipelineStartTime);
+}
+
+void VulkanVideoParser::SubmitThread()
+{
+    std::chrono::steady_clock::time_point idleStartTime = std::chrono::steady_clock::now();
+    uint32_t waitCount = 0;
+    for (;;) {
+        VulkanVideoParserPicture* pPicture = m_pipelineQueue->GetConsumerNode();
+        if (pPicture == NULL) {
+            if (m_pipelineExit) {
+                break;
+            }
+            PipelineWait(waitCount);
+            continue;
+        }
+        waitCount = 0;
+
+        const std::chrono::steady_clock::time_point submitStartTime = std::chrono::steady_clock::now();
+        m_pipelineStats.submitIdleTimeNs += PipelineTimeNs(submitStartTime - idleStartTime);
+
+        if (!SubmitPicture(pPicture)) {
+            m_pipelineError = true;
+        }
+        pPicture->Release();
+
+        idleStartTime = std::chrono::steady_clock::now();
+        m_pipelineStats.submitTimeNs += PipelineTimeNs(idleStartTime - submitStartTime);
+
+        // Hands the picture back to the parser thread, along with the counters updated above
+        m_pipelineQueue->PopConsumerNode();
+    }
+}
+
+bool VulkanVideoParser::SubmitPicture(VulkanVideoParserPicture* pPicture)
+{
+    const int32_t picIdx = pPicture->pPicBuf->m_picIdx;
+
+    if (pPicture->type == VulkanVideoParserPicture::DISPLAY_PICTURE) {
+        m_pipelineStats.displayedPictures++;
+        int32_t retVal = m_videoFrameBufferCb->QueueDecodedPictureForDisplay((int8_t)picIdx, &pPicture->displayInfo);
+        if (picIdx != retVal) {
+            assert(!"QueueDecodedPictureForDisplay failed");
+            return false;
+        }
+        return true;
+    }
+
+    m_pipelineStats.decodedPictures++;
+    bool bRet = (m_decoderHandler->DecodePictureWithParameters(&pPicture->pictureParams, &pPicture->decodePictureInfo) >= 0);
+
+    if (m_dumpParserData) {
+        std::cout << "\t <== VulkanVideoParser::SubmitPicture " << picIdx << std::endl;
+    }
+    return bRet;
+}
+
+VkResult VulkanVideoParser::SetDecoderConfigurationRecord(const uint8_t* pData, size_t size)
+{
+    return m_vkParser->SetDecoderConfigurationRecord(pData, size) ? VK_SUCCESS : VK_ERROR_FORMAT_NOT_SUPPORTED;
+}
+
 int8_t VulkanVideoParser::GetPicIdx(vkPicBuffBase* pPicBuf)
 {
     if (pPicBuf) {
@@ -1088,10 +1556,8 @@ uint32_t VulkanVideoParser::ResetPicDpbSlots(uint32_t picIndexSlotValidMask)
     return m_dpbSlotsMask;
 }
 
-int32_t VulkanVideoParser::BeginSequence(const VkParserSequenceInfo* pnvsi)
+uint32_t VulkanVideoParser::GetConfigDpbSlots(const VkParserSequenceInfo* pnvsi)
 {
-    bool sequenceUpdate = ((m_nvsi.nMaxWidth != 0) && (m_nvsi.nMaxHeight != 0)) ? true : false;
-
     uint32_t maxDpbSlots =  (pnvsi->eCodec == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) ?
         MAX_DPB_REF_AND_SETUP_SLOTS : MAX_DPB_REF_SLOTS;
 
@@ -1100,7 +1566,91 @@ int32_t VulkanVideoParser::BeginSequence(const VkParserSequenceInfo* pnvsi)
     }
 
     uint32_t configDpbSlots = (pnvsi->nMinNumDpbSlots > 0) ? pnvsi->nMinNumDpbSlots : maxDpbSlots;
-    configDpbSlots = std::min<uint32_t>(configDpbSlots, maxDpbSlots);
+    return std::min<uint32_t>(configDpbSlots, maxDpbSlots);
+}
+
+void VulkanVideoParser::GetDetectedVideoFormat(const VkParserSequenceInfo* pnvsi,
+                                               VkParserDetectedVideoFormat* pDetectedFormat)
+{
+    uint8_t raw_seqhdr_data[1024]; /* Output the sequence header data, currently
+                                  not used */
+
+    memset(pDetectedFormat, 0, sizeof(*pDetectedFormat));
+
+    pDetectedFormat->codec = pnvsi->eCodec;
+    pDetectedFormat->frame_rate.numerator = NV_FRAME_RATE_NUM(pnvsi->frameRate);
+    pDetectedFormat->frame_rate.denominator = NV_FRAME_RATE_DEN(pnvsi->frameRate);
+    pDetectedFormat->progressive_sequence = pnvsi->bProgSeq;
+    pDetectedFormat->coded_width = pnvsi->nCodedWidth;
+    pDetectedFormat->coded_height = pnvsi->nCodedHeight;
+    pDetectedFormat->display_area.right = pnvsi->nDisplayWidth;
+    pDetectedFormat->display_area.bottom = pnvsi->nDisplayHeight;
+    pDetectedFormat->filmGrainUsed = pnvsi->hasFilmGrain;
+
+    if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_420) {
+        pDetectedFormat->chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
+    } else if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_422) {
+        pDetectedFormat->chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
+    } else if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_444) {
+        pDetectedFormat->chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
+    } else {
+        assert(!"Invalid chroma sub-sampling format");
+    }
+
+    switch (pnvsi->uBitDepthLumaMinus8) {
+    case 0:
+        pDetectedFormat->lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        break;
+    case 2:
+        pDetectedFormat->lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        break;
+    case 4:
+        pDetectedFormat->lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        break;
+    default:
+        assert(false);
+    }
+
+    switch (pnvsi->uBitDepthChromaMinus8) {
+    case 0:
+        pDetectedFormat->chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
+        break;
+    case 2:
+        pDetectedFormat->chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
+        break;
+    case 4:
+        pDetectedFormat->chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
+        break;
+    default:
+        assert(false);
+    }
+
+    pDetectedFormat->bit_depth_luma_minus8 = pnvsi->uBitDepthLumaMinus8;
+    pDetectedFormat->bit_depth_chroma_minus8 = pnvsi->uBitDepthChromaMinus8;
+    pDetectedFormat->bitrate = pnvsi->lBitrate;
+    pDetectedFormat->display_aspect_ratio.x = pnvsi->lDARWidth;
+    pDetectedFormat->display_aspect_ratio.y = pnvsi->lDARHeight;
+    pDetectedFormat->video_signal_description.video_format = pnvsi->lVideoFormat;
+    pDetectedFormat->video_signal_description.video_full_range_flag = pnvsi->uVideoFullRange;
+    pDetectedFormat->video_signal_description.color_primaries = pnvsi->lColorPrimaries;
+    pDetectedFormat->video_signal_description.transfer_characteristics = pnvsi->lTransferCharacteristics;
+    pDetectedFormat->video_signal_description.matrix_coefficients = pnvsi->lMatrixCoefficients;
+    pDetectedFormat->seqhdr_data_length = (uint32_t)std::min((size_t)pnvsi->cbSequenceHeader, sizeof(raw_seqhdr_data));
+    pDetectedFormat->minNumDecodeSurfaces = pnvsi->nMinNumDecodeSurfaces;
+    pDetectedFormat->maxNumDpbSlots = GetConfigDpbSlots(pnvsi);
+    pDetectedFormat->codecProfile = pnvsi->codecProfile;
+
+    if (pDetectedFormat->seqhdr_data_length > 0) {
+        memcpy(raw_seqhdr_data, pnvsi->SequenceHeaderData,
+            pDetectedFormat->seqhdr_data_length);
+    }
+}
+
+int32_t VulkanVideoParser::BeginSequence(const VkParserSequenceInfo* pnvsi)
+{
+    bool sequenceUpdate = ((m_nvsi.nMaxWidth != 0) && (m_nvsi.nMaxHeight != 0)) ? true : false;
+
+    const uint32_t configDpbSlots = GetConfigDpbSlots(pnvsi);
 
     bool sequenceReconfigureFormat = false;
     bool sequenceReconfigureCodedExtent = false;
@@ -1126,82 +1676,17 @@ int32_t VulkanVideoParser::BeginSequence(const VkParserSequenceInfo* pnvsi)
 
     if (m_decoderHandler) {
         VkParserDetectedVideoFormat detectedFormat;
-        uint8_t raw_seqhdr_data[1024]; /* Output the sequence header data, currently
-                                      not used */
-
-        memset(&detectedFormat, 0, sizeof(detectedFormat));
+        GetDetectedVideoFormat(pnvsi, &detectedFormat);
 
         detectedFormat.sequenceUpdate = sequenceUpdate;
         detectedFormat.sequenceReconfigureFormat = sequenceReconfigureFormat;
         detectedFormat.sequenceReconfigureCodedExtent = sequenceReconfigureCodedExtent;
 
-        detectedFormat.codec = pnvsi->eCodec;
-        detectedFormat.frame_rate.numerator = NV_FRAME_RATE_NUM(pnvsi->frameRate);
-        detectedFormat.frame_rate.denominator = NV_FRAME_RATE_DEN(pnvsi->frameRate);
-        detectedFormat.progressive_sequence = pnvsi->bProgSeq;
-        detectedFormat.coded_width = pnvsi->nCodedWidth;
-        detectedFormat.coded_height = pnvsi->nCodedHeight;
-        detectedFormat.display_area.right = pnvsi->nDisplayWidth;
-        detectedFormat.display_area.bottom = pnvsi->nDisplayHeight;
-        detectedFormat.filmGrainUsed = pnvsi->hasFilmGrain;
-
-        if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_420) {
-            detectedFormat.chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_420_BIT_KHR;
-        } else if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_422) {
-            detectedFormat.chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_422_BIT_KHR;
-        } else if ((StdChromaFormatIdc)pnvsi->nChromaFormat == chroma_format_idc_444) {
-            detectedFormat.chromaSubsampling = VK_VIDEO_CHROMA_SUBSAMPLING_444_BIT_KHR;
-        } else {
-            assert(!"Invalid chroma sub-sampling format");
-        }
-
-        switch (pnvsi->uBitDepthLumaMinus8) {
-        case 0:
-            detectedFormat.lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
-            break;
-        case 2:
-            detectedFormat.lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
-            break;
-        case 4:
-            detectedFormat.lumaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
-            break;
-        default:
-            assert(false);
-        }
-
-        switch (pnvsi->uBitDepthChromaMinus8) {
-        case 0:
-            detectedFormat.chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_8_BIT_KHR;
-            break;
-        case 2:
-            detectedFormat.chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_10_BIT_KHR;
-            break;
-        case 4:
-            detectedFormat.chromaBitDepth = VK_VIDEO_COMPONENT_BIT_DEPTH_12_BIT_KHR;
-            break;
-        default:
-            assert(false);
-        }
-
-        detectedFormat.bit_depth_luma_minus8 = pnvsi->uBitDepthLumaMinus8;
-        detectedFormat.bit_depth_chroma_minus8 = pnvsi->uBitDepthChromaMinus8;
-        detectedFormat.bitrate = pnvsi->lBitrate;
-        detectedFormat.display_aspect_ratio.x = pnvsi->lDARWidth;
-        detectedFormat.display_aspect_ratio.y = pnvsi->lDARHeight;
-        detectedFormat.video_signal_description.video_format = pnvsi->lVideoFormat;
-        detectedFormat.video_signal_description.video_full_range_flag = pnvsi->uVideoFullRange;
-        detectedFormat.video_signal_description.color_primaries = pnvsi->lColorPrimaries;
-        detectedFormat.video_signal_description.transfer_characteristics = pnvsi->lTransferCharacteristics;
-        detectedFormat.video_signal_description.matrix_coefficients = pnvsi->lMatrixCoefficients;
-        detectedFormat.seqhdr_data_length = (uint32_t)std::min((size_t)pnvsi->cbSequenceHeader, sizeof(raw_seqhdr_data));
-        detectedFormat.minNumDecodeSurfaces = pnvsi->nMinNumDecodeSurfaces;
-        detectedFormat.maxNumDpbSlots = configDpbSlots;
-        detectedFormat.codecProfile = pnvsi->codecProfile;
-
-        if (detectedFormat.seqhdr_data_length > 0) {
-            memcpy(raw_seqhdr_data, pnvsi->SequenceHeaderData,
-                detectedFormat.seqhdr_data_length);
+        if (m_traceWriter.IsOpen()) {
+            m_traceWriter.WriteSequence(&detectedFormat);
         }
+
+        DrainPipeline();
         int32_t maxDecodeRTs = m_decoderHandler->StartVideoSequence(&detectedFormat);
         // nDecodeRTs <= 0 means SequenceCallback failed
         // nDecodeRTs  = 1 means SequenceCallback succeeded
@@ -1925,6 +2410,11 @@ bool VulkanVideoParser::UpdatePictureParameters(
     }
 
     if (pictureParametersObject) {
+        // The pictures queued so far are decoded with the current parameters
+        if (m_traceWriter.IsOpen()) {
+            m_traceWriter.WriteParameterSet(pictureParametersObject);
+        }
+        DrainPipeline();
         return m_decoderHandler->UpdatePictureParameters(pictureParametersObject, client);
     }
 
@@ -1932,17 +2422,11 @@ bool VulkanVideoParser::UpdatePictureParameters(
 }
 
 bool VulkanVideoParser::DecodePicture(
-    VkParserPictureData* pd, vkPicBuffBase* /*pVkPicBuff*/,
+    VkParserPictureData* pd, vkPicBuffBase* pVkPicBuff,
     VkParserDecodePictureInfo* pDecodePictureInfo)
 {
     bool bRet = false;
 
-    // union {
-    nvVideoH264PicParameters h264;
-    nvVideoH265PicParameters hevc;
-    nvVideoAV1PicParameters av1;
-    // };
-
     if (m_decoderHandler == NULL) {
         assert(!"m_pDecoderHandler is NULL");
         return false;
@@ -1958,7 +2442,24 @@ bool VulkanVideoParser::DecodePicture(
         return false;
     }
 
-    VkParserPerFrameDecodeParameters pictureParams = VkParserPerFrameDecodeParameters();
+    if (m_pipelineError) {
+        return false;
+    }
+
+    // The pipelined mode fills in the next picture of the submit thread queue
+    VulkanVideoParserPicture currentPicture;
+    VulkanVideoParserPicture* pPicture = m_pipelineQueue ? GetPipelinePicture() : &currentPicture;
+    const std::chrono::steady_clock::time_point fillStartTime = std::chrono::steady_clock::now();
+    pPicture->type = VulkanVideoParserPicture::DECODE_PICTURE;
+    pPicture->decodePictureInfo = *pDecodePictureInfo;
+    pDecodePictureInfo = &pPicture->decodePictureInfo;
+
+    nvVideoH264PicParameters& h264 = pPicture->h264;
+    nvVideoH265PicParameters& hevc = pPicture->hevc;
+    nvVideoAV1PicParameters& av1 = pPicture->av1;
+
+    VkParserPerFrameDecodeParameters& pictureParams = pPicture->pictureParams;
+    pictureParams = VkParserPerFrameDecodeParameters();
     VkParserPerFrameDecodeParameters* pCurrFrameDecParams = &pictureParams;
     pCurrFrameDecParams->currPicIdx = PicIdx;
     pCurrFrameDecParams->numSlices = pd->numSlices;
@@ -1967,9 +2468,9 @@ bool VulkanVideoParser::DecodePicture(
     pCurrFrameDecParams->bitstreamDataLen = pd->bitstreamDataLen;
     pCurrFrameDecParams->bitstreamData = pd->bitstreamData;
 
-    VkVideoReferenceSlotInfoKHR
-        referenceSlots[VkParserPerFrameDecodeParameters::MAX_DPB_REF_AND_SETUP_SLOTS];
-    VkVideoReferenceSlotInfoKHR setupReferenceSlot = {
+    VkVideoReferenceSlotInfoKHR* referenceSlots = pPicture->referenceSlots;
+    VkVideoReferenceSlotInfoKHR& setupReferenceSlot = pPicture->setupReferenceSlot;
+    setupReferenceSlot = {
         VK_STRUCTURE_TYPE_VIDEO_REFERENCE_SLOT_INFO_KHR, NULL,
         -1, // slotIndex
         NULL // pPictureResource
@@ -2036,6 +2537,9 @@ bool VulkanVideoParser::DecodePicture(
         assert(pd->firstSliceIndex == 0); // No slice and MV modes are supported yet
         pPictureInfo->pSliceOffsets = pd->bitstreamData->GetStreamMarkersPtr(pd->firstSliceIndex, maxSliceCount);
         assert(maxSliceCount == pd->numSlices);
+        if (m_pipelineQueue) {
+            pPictureInfo->pSliceOffsets = pPicture->SaveSliceOffsets(pPictureInfo->pSliceOffsets, pd->numSlices);
+        }
 
         StdVideoDecodeH264PictureInfoFlags currPicFlags = StdVideoDecodeH264PictureInfoFlags();
         currPicFlags.is_intra = (pd->intra_pic_flag != 0);
@@ -2149,6 +2653,9 @@ bool VulkanVideoParser::DecodePicture(
         assert(pd->firstSliceIndex == 0); // No slice and MV modes are supported yet
         pPictureInfo->pSliceSegmentOffsets = pd->bitstreamData->GetStreamMarkersPtr(pd->firstSliceIndex, maxSliceCount);
         assert(maxSliceCount == pd->numSlices);
+        if (m_pipelineQueue) {
+            pPictureInfo->pSliceSegmentOffsets = pPicture->SaveSliceOffsets(pPictureInfo->pSliceSegmentOffsets, pd->numSlices);
+        }
 
         pStdPictureInfo->pps_pic_parameter_set_id   = pin->pic_parameter_set_id;       // PPS ID
         pStdPictureInfo->pps_seq_parameter_set_id   = pin->seq_parameter_set_id;       // SPS ID
@@ -2228,6 +2735,11 @@ bool VulkanVideoParser::DecodePicture(
     }
     else if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
         VkParserAv1PictureData* pin = &pd->CodecSpecific.av1;
+        if (m_pipelineQueue) {
+            // All the AV1 picture info pointers below then point to the copy
+            pPicture->av1PictureData = *pin;
+            pin = &pPicture->av1PictureData;
+        }
 
         av1 = nvVideoAV1PicParameters();
         VkVideoDecodeAV1PictureInfoKHR* pPictureInfo = &av1.pictureInfo;
@@ -2321,7 +2833,26 @@ bool VulkanVideoParser::DecodePicture(
     pDecodePictureInfo->displayWidth  = m_nvsi.nDisplayWidth;
     pDecodePictureInfo->displayHeight = m_nvsi.nDisplayHeight;
 
-    bRet = (m_decoderHandler->DecodePictureWithParameters(pCurrFrameDecParams, pDecodePictureInfo) >= 0);
+    if (m_traceWriter.IsOpen()) {
+        m_traceWriter.WriteDecodePicture(pCurrFrameDecParams, pDecodePictureInfo);
+    }
+
+    if (m_pipelineQueue) {
+        // Keep the pictures and the parameter sets alive until the submit thread is done
+        // with them, even if the parser drops them from its DPB in the meantime.
+        pPicture->SetPicture(pVkPicBuff);
+        for (int32_t i = 0; i < pCurrFrameDecParams->numGopReferenceSlots; i++) {
+            if ((referenceSlots[i].slotIndex >= 0) && ((uint32_t)referenceSlots[i].slotIndex < m_dpb.getMaxSize())) {
+                pPicture->AddReferencePicture(m_dpb[referenceSlots[i].slotIndex].getPictureResource());
+            }
+        }
+        pPicture->SaveParameterSets(pCurrFrameDecParams);
+        m_pipelineQueue->PushProducerNode();
+        m_pipelineStats.fillTimeNs += PipelineTimeNs(std::chrono::steady_clock::now() - fillStartTime);
+        bRet = true;
+    } else {
+        bRet = (m_decoderHandler->DecodePictureWithParameters(pCurrFrameDecParams, pDecodePictureInfo) >= 0);
+    }
 
     if (m_dumpParserData) {
         std::cout << "\t <== VulkanVideoParser::DecodePicture " << PicIdx << std::endl;
@@ -0,0 +1,1290 @@
+/*
+ * Copyright 2024 NVIDIA Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+#include "vkvideo_parser/VulkanVideoParserIf.h"
+#include "NvVideoParser/nvVulkanVideoUtils.h"
+#include "vkvideo_parser/PictureBufferBase.h"
+#include "vkvideo_parser/StdVideoPictureParametersSet.h"
+#include "vkvideo_parser/VulkanVideoParser.h"
+#include "vkvideo_parser/VulkanVideoParserTrace.h"
+
+#undef min
+#undef max
+
+/*******************************************************/
+//! \class VulkanVideoParserTraceStorage
+//! Zero-initialized memory of the structures read back
+//! from a trace, released all at once.
+/*******************************************************/
+class VulkanVideoParserTraceStorage {
+public:
+    void* Allocate(size_t size)
+    {
+        m_blocks.emplace_back(new uint64_t[(size + sizeof(uint64_t) - 1) / sizeof(uint64_t)]());
+        return m_blocks.back().get();
+    }
+
+    void Reset() { m_blocks.clear(); }
+
+private:
+    std::vector<std::unique_ptr<uint64_t[]>> m_blocks;
+};
+
+/*******************************************************/
+//! \class VulkanVideoParserTraceRecord
+//! Payload of a trace record. A pointer is written as its
+//! element count followed by the elements, a count of 0
+//! standing for a NULL pointer.
+/*******************************************************/
+class VulkanVideoParserTraceRecord {
+public:
+    VulkanVideoParserTraceRecord()
+        : m_data()
+        , m_readOffset(0)
+        , m_readFailed(false)
+    {
+    }
+
+    std::vector<uint8_t>& GetData() { return m_data; }
+
+    void Reset()
+    {
+        m_data.clear();
+        m_readOffset = 0;
+        m_readFailed = false;
+    }
+
+    void Write(const void* pData, size_t size)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        m_data.insert(m_data.end(), pBytes, pBytes + size);
+    }
+
+    template<class T> void Write(const T& value)
+    {
+        Write(&value, sizeof(value));
+    }
+
+    template<class T> void WritePointer(const T* pData, uint32_t count = 1)
+    {
+        const uint32_t numElements = (pData != NULL) ? count : 0;
+        Write(numElements);
+        if (numElements != 0) {
+            Write(pData, numElements * sizeof(T));
+        }
+    }
+
+    bool Read(void* pData, size_t size)
+    {
+        if (m_readFailed || (size > (m_data.size() - m_readOffset))) {
+            m_readFailed = true;
+            return false;
+        }
+        memcpy(pData, &m_data[m_readOffset], size);
+        m_readOffset += size;
+        return true;
+    }
+
+    template<class T> bool Read(T& value)
+    {
+        return Read(&value, sizeof(value));
+    }
+
+    // Returns the elements copied to storage, or NULL for a NULL pointer or a truncated record
+    template<class T> T* ReadPointer(VulkanVideoParserTraceStorage& storage, uint32_t* pCount = NULL)
+    {
+        uint32_t numElements = 0;
+        if (pCount) {
+            *pCount = 0;
+        }
+        if (!Read(numElements) || (numElements == 0)) {
+            return NULL;
+        }
+        if (((uint64_t)numElements * sizeof(T)) > (m_data.size() - m_readOffset)) {
+            m_readFailed = true;
+            return NULL;
+        }
+        T* pData = (T*)storage.Allocate(numElements * sizeof(T));
+        Read(pData, numElements * sizeof(T));
+        if (pCount) {
+            *pCount = numElements;
+        }
+        return pData;
+    }
+
+    bool ReadFailed() const { return m_readFailed; }
+
+private:
+    std::vector<uint8_t> m_data;
+    size_t               m_readOffset;
+    bool                 m_readFailed;
+};
+
+static const void* FindChainedStruct(const void* pNext, VkStructureType sType)
+{
+    for (const VkBaseInStructure* pStruct = (const VkBaseInStructure*)pNext; pStruct != NULL; pStruct = pStruct->pNext) {
+        if (pStruct->sType == sType) {
+            return pStruct;
+        }
+    }
+    return NULL;
+}
+
+static StdVideoPictureParametersSet::ParameterType GetParameterType(StdVideoPictureParametersSet::StdType stdType)
+{
+    switch (stdType) {
+    case StdVideoPictureParametersSet::TYPE_H264_SPS:
+    case StdVideoPictureParametersSet::TYPE_H265_SPS:
+        return StdVideoPictureParametersSet::SPS_TYPE;
+    case StdVideoPictureParametersSet::TYPE_H264_PPS:
+    case StdVideoPictureParametersSet::TYPE_H265_PPS:
+        return StdVideoPictureParametersSet::PPS_TYPE;
+    case StdVideoPictureParametersSet::TYPE_H265_VPS:
+        return StdVideoPictureParametersSet::VPS_TYPE;
+    case StdVideoPictureParametersSet::TYPE_AV1_SPS:
+        return StdVideoPictureParametersSet::AV1_SPS_TYPE;
+    }
+    return StdVideoPictureParametersSet::INVALID_TYPE;
+}
+
+// Parameter sets of the same type and id replace each other
+static uint32_t GetParameterSetKey(const StdVideoPictureParametersSet* pParameterSet)
+{
+    bool isId = false;
+    int32_t id = -1;
+    switch (pParameterSet->GetParameterType()) {
+    case StdVideoPictureParametersSet::PPS_TYPE:
+        id = pParameterSet->GetPpsId(isId);
+        break;
+    case StdVideoPictureParametersSet::SPS_TYPE:
+        id = pParameterSet->GetSpsId(isId);
+        break;
+    case StdVideoPictureParametersSet::VPS_TYPE:
+        id = pParameterSet->GetVpsId(isId);
+        break;
+    default:
+        break;
+    }
+    return ((uint32_t)pParameterSet->GetStdType() << 16) | (isId ? ((uint32_t)id & 0xffff) : 0);
+}
+
+/*******************************************************/
+// Standard parameter sets
+/*******************************************************/
+
+static void WriteH265Hrd(VulkanVideoParserTraceRecord& record, const StdVideoH265HrdParameters* pHrd, uint32_t numSubLayers)
+{
+    if (pHrd == NULL) {
+        record.WritePointer(pHrd);
+        return;
+    }
+    StdVideoH265HrdParameters hrd = *pHrd;
+    hrd.pSubLayerHrdParametersNal = NULL;
+    hrd.pSubLayerHrdParametersVcl = NULL;
+    record.WritePointer(&hrd);
+    record.WritePointer(pHrd->pSubLayerHrdParametersNal, numSubLayers);
+    record.WritePointer(pHrd->pSubLayerHrdParametersVcl, numSubLayers);
+}
+
+static const StdVideoH265HrdParameters* ReadH265Hrd(VulkanVideoParserTraceRecord& record, VulkanVideoParserTraceStorage& storage)
+{
+    StdVideoH265HrdParameters* pHrd = record.ReadPointer<StdVideoH265HrdParameters>(storage);
+    if (pHrd) {
+        pHrd->pSubLayerHrdParametersNal = record.ReadPointer<StdVideoH265SubLayerHrdParameters>(storage);
+        pHrd->pSubLayerHrdParametersVcl = record.ReadPointer<StdVideoH265SubLayerHrdParameters>(storage);
+    }
+    return pHrd;
+}
+
+static bool WriteStdParameterSet(VulkanVideoParserTraceRecord& record, const StdVideoPictureParametersSet* pParameterSet)
+{
+    switch (pParameterSet->GetStdType()) {
+    case StdVideoPictureParametersSet::TYPE_H264_SPS: {
+        const StdVideoH264SequenceParameterSet* pSps = pParameterSet->GetStdH264Sps();
+        StdVideoH264SequenceParameterSet sps = *pSps;
+        sps.pOffsetForRefFrame = NULL;
+        sps.pScalingLists = NULL;
+        sps.pSequenceParameterSetVui = NULL;
+        record.WritePointer(&sps);
+        record.WritePointer(pSps->pOffsetForRefFrame, pSps->num_ref_frames_in_pic_order_cnt_cycle);
+        record.WritePointer(pSps->pScalingLists);
+        if (pSps->pSequenceParameterSetVui) {
+            StdVideoH264SequenceParameterSetVui vui = *pSps->pSequenceParameterSetVui;
+            vui.pHrdParameters = NULL;
+            record.WritePointer(&vui);
+            record.WritePointer(pSps->pSequenceParameterSetVui->pHrdParameters);
+        } else {
+            record.WritePointer(pSps->pSequenceParameterSetVui);
+        }
+        return true;
+    }
+    case StdVideoPictureParametersSet::TYPE_H264_PPS: {
+        const StdVideoH264PictureParameterSet* pPps = pParameterSet->GetStdH264Pps();
+        StdVideoH264PictureParameterSet pps = *pPps;
+        pps.pScalingLists = NULL;
+        record.WritePointer(&pps);
+        record.WritePointer(pPps->pScalingLists);
+        return true;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_VPS: {
+        const StdVideoH265VideoParameterSet* pVps = pParameterSet->GetStdH265Vps();
+        StdVideoH265VideoParameterSet vps = *pVps;
+        vps.pDecPicBufMgr = NULL;
+        vps.pHrdParameters = NULL;
+        vps.pProfileTierLevel = NULL;
+        record.WritePointer(&vps);
+        record.WritePointer(pVps->pDecPicBufMgr);
+        // The std structure does not carry vps_num_hrd_parameters, only the first entry is kept
+        WriteH265Hrd(record, pVps->pHrdParameters, pVps->vps_max_sub_layers_minus1 + 1);
+        record.WritePointer(pVps->pProfileTierLevel);
+        return true;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_SPS: {
+        const StdVideoH265SequenceParameterSet* pSps = pParameterSet->GetStdH265Sps();
+        StdVideoH265SequenceParameterSet sps = *pSps;
+        sps.pProfileTierLevel = NULL;
+        sps.pDecPicBufMgr = NULL;
+        sps.pScalingLists = NULL;
+        sps.pShortTermRefPicSet = NULL;
+        sps.pLongTermRefPicsSps = NULL;
+        sps.pSequenceParameterSetVui = NULL;
+        sps.pPredictorPaletteEntries = NULL;
+        record.WritePointer(&sps);
+        record.WritePointer(pSps->pProfileTierLevel);
+        record.WritePointer(pSps->pDecPicBufMgr);
+        record.WritePointer(pSps->pScalingLists);
+        record.WritePointer(pSps->pShortTermRefPicSet, pSps->num_short_term_ref_pic_sets);
+        record.WritePointer(pSps->pLongTermRefPicsSps);
+        if (pSps->pSequenceParameterSetVui) {
+            StdVideoH265SequenceParameterSetVui vui = *pSps->pSequenceParameterSetVui;
+            vui.pHrdParameters = NULL;
+            record.WritePointer(&vui);
+            WriteH265Hrd(record, pSps->pSequenceParameterSetVui->pHrdParameters, pSps->sps_max_sub_layers_minus1 + 1);
+        } else {
+            record.WritePointer(pSps->pSequenceParameterSetVui);
+        }
+        record.WritePointer(pSps->pPredictorPaletteEntries);
+        return true;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_PPS: {
+        const StdVideoH265PictureParameterSet* pPps = pParameterSet->GetStdH265Pps();
+        StdVideoH265PictureParameterSet pps = *pPps;
+        pps.pScalingLists = NULL;
+        pps.pPredictorPaletteEntries = NULL;
+        record.WritePointer(&pps);
+        record.WritePointer(pPps->pScalingLists);
+        record.WritePointer(pPps->pPredictorPaletteEntries);
+        return true;
+    }
+    case StdVideoPictureParametersSet::TYPE_AV1_SPS: {
+        const StdVideoAV1SequenceHeader* pSequenceHeader = pParameterSet->GetStdAV1Sps();
+        StdVideoAV1SequenceHeader sequenceHeader = *pSequenceHeader;
+        sequenceHeader.pColorConfig = NULL;
+        sequenceHeader.pTimingInfo = NULL;
+        record.WritePointer(&sequenceHeader);
+        record.WritePointer(pSequenceHeader->pColorConfig);
+        record.WritePointer(pSequenceHeader->pTimingInfo);
+        return true;
+    }
+    }
+    return false;
+}
+
+static const void* ReadStdParameterSet(VulkanVideoParserTraceRecord& record, VulkanVideoParserTraceStorage& storage,
+                                       StdVideoPictureParametersSet::StdType stdType)
+{
+    switch (stdType) {
+    case StdVideoPictureParametersSet::TYPE_H264_SPS: {
+        StdVideoH264SequenceParameterSet* pSps = record.ReadPointer<StdVideoH264SequenceParameterSet>(storage);
+        if (pSps) {
+            pSps->pOffsetForRefFrame = record.ReadPointer<int32_t>(storage);
+            pSps->pScalingLists = record.ReadPointer<StdVideoH264ScalingLists>(storage);
+            StdVideoH264SequenceParameterSetVui* pVui = record.ReadPointer<StdVideoH264SequenceParameterSetVui>(storage);
+            if (pVui) {
+                pVui->pHrdParameters = record.ReadPointer<StdVideoH264HrdParameters>(storage);
+            }
+            pSps->pSequenceParameterSetVui = pVui;
+        }
+        return pSps;
+    }
+    case StdVideoPictureParametersSet::TYPE_H264_PPS: {
+        StdVideoH264PictureParameterSet* pPps = record.ReadPointer<StdVideoH264PictureParameterSet>(storage);
+        if (pPps) {
+            pPps->pScalingLists = record.ReadPointer<StdVideoH264ScalingLists>(storage);
+        }
+        return pPps;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_VPS: {
+        StdVideoH265VideoParameterSet* pVps = record.ReadPointer<StdVideoH265VideoParameterSet>(storage);
+        if (pVps) {
+            pVps->pDecPicBufMgr = record.ReadPointer<StdVideoH265DecPicBufMgr>(storage);
+            pVps->pHrdParameters = ReadH265Hrd(record, storage);
+            pVps->pProfileTierLevel = record.ReadPointer<StdVideoH265ProfileTierLevel>(storage);
+        }
+        return pVps;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_SPS: {
+        StdVideoH265SequenceParameterSet* pSps = record.ReadPointer<StdVideoH265SequenceParameterSet>(storage);
+        if (pSps) {
+            pSps->pProfileTierLevel = record.ReadPointer<StdVideoH265ProfileTierLevel>(storage);
+            pSps->pDecPicBufMgr = record.ReadPointer<StdVideoH265DecPicBufMgr>(storage);
+            pSps->pScalingLists = record.ReadPointer<StdVideoH265ScalingLists>(storage);
+            pSps->pShortTermRefPicSet = record.ReadPointer<StdVideoH265ShortTermRefPicSet>(storage);
+            pSps->pLongTermRefPicsSps = record.ReadPointer<StdVideoH265LongTermRefPicsSps>(storage);
+            StdVideoH265SequenceParameterSetVui* pVui = record.ReadPointer<StdVideoH265SequenceParameterSetVui>(storage);
+            if (pVui) {
+                pVui->pHrdParameters = ReadH265Hrd(record, storage);
+            }
+            pSps->pSequenceParameterSetVui = pVui;
+            pSps->pPredictorPaletteEntries = record.ReadPointer<StdVideoH265PredictorPaletteEntries>(storage);
+        }
+        return pSps;
+    }
+    case StdVideoPictureParametersSet::TYPE_H265_PPS: {
+        StdVideoH265PictureParameterSet* pPps = record.ReadPointer<StdVideoH265PictureParameterSet>(storage);
+        if (pPps) {
+            pPps->pScalingLists = record.ReadPointer<StdVideoH265ScalingLists>(storage);
+            pPps->pPredictorPaletteEntries = record.ReadPointer<StdVideoH265PredictorPaletteEntries>(storage);
+        }
+        return pPps;
+    }
+    case StdVideoPictureParametersSet::TYPE_AV1_SPS: {
+        StdVideoAV1SequenceHeader* pSequenceHeader = record.ReadPointer<StdVideoAV1SequenceHeader>(storage);
+        if (pSequenceHeader) {
+            pSequenceHeader->pColorConfig = record.ReadPointer<StdVideoAV1ColorConfig>(storage);
+            pSequenceHeader->pTimingInfo = record.ReadPointer<StdVideoAV1TimingInfo>(storage);
+        }
+        return pSequenceHeader;
+    }
+    }
+    return NULL;
+}
+
+/*******************************************************/
+// Codec picture info and reference slots
+/*******************************************************/
+
+// VulkanVideoParser builds the H.264 flags by value, so only their named bits are defined: the
+// others are cleared in the trace, which would otherwise depend on the build of the parser.
+static void WriteStdPictureInfo(VulkanVideoParserTraceRecord& record, const StdVideoDecodeH264PictureInfo* pStdPictureInfo)
+{
+    StdVideoDecodeH264PictureInfo stdPictureInfo = *pStdPictureInfo;
+    memset(&stdPictureInfo.flags, 0, sizeof(stdPictureInfo.flags));
+    stdPictureInfo.flags.field_pic_flag = pStdPictureInfo->flags.field_pic_flag;
+    stdPictureInfo.flags.is_intra = pStdPictureInfo->flags.is_intra;
+    stdPictureInfo.flags.IdrPicFlag = pStdPictureInfo->flags.IdrPicFlag;
+    stdPictureInfo.flags.bottom_field_flag = pStdPictureInfo->flags.bottom_field_flag;
+    stdPictureInfo.flags.is_reference = pStdPictureInfo->flags.is_reference;
+    stdPictureInfo.flags.complementary_field_pair = pStdPictureInfo->flags.complementary_field_pair;
+    record.WritePointer(&stdPictureInfo);
+}
+
+static void WriteStdReferenceInfo(VulkanVideoParserTraceRecord& record, const StdVideoDecodeH264ReferenceInfo* pStdReferenceInfo)
+{
+    if (pStdReferenceInfo == NULL) {
+        record.WritePointer(pStdReferenceInfo);
+        return;
+    }
+    StdVideoDecodeH264ReferenceInfo stdReferenceInfo = *pStdReferenceInfo;
+    memset(&stdReferenceInfo.flags, 0, sizeof(stdReferenceInfo.flags));
+    stdReferenceInfo.flags.top_field_flag = pStdReferenceInfo->flags.top_field_flag;
+    stdReferenceInfo.flags.bottom_field_flag = pStdReferenceInfo->flags.bottom_field_flag;
+    stdReferenceInfo.flags.used_for_long_term_reference = pStdReferenceInfo->flags.used_for_long_term_reference;
+    stdReferenceInfo.flags.is_non_existing = pStdReferenceInfo->flags.is_non_existing;
+    record.WritePointer(&stdReferenceInfo);
+}
+
+template<class StdReferenceInfo>
+static void WriteStdReferenceInfo(VulkanVideoParserTraceRecord& record, const StdReferenceInfo* pStdReferenceInfo)
+{
+    record.WritePointer(pStdReferenceInfo);
+}
+
+template<class DpbSlotInfo>
+static void WriteReferenceSlot(VulkanVideoParserTraceRecord& record, const VkVideoReferenceSlotInfoKHR* pSlot,
+                               VkStructureType dpbSlotInfoType)
+{
+    const DpbSlotInfo* pDpbSlotInfo = pSlot ? (const DpbSlotInfo*)FindChainedStruct(pSlot->pNext, dpbSlotInfoType) : NULL;
+    record.Write<int32_t>(pSlot ? pSlot->slotIndex : -1);
+    WriteStdReferenceInfo(record, pDpbSlotInfo ? pDpbSlotInfo->pStdReferenceInfo : NULL);
+}
+
+template<class DpbSlotInfo>
+static void WriteReferenceSlots(VulkanVideoParserTraceRecord& record, const VkVideoDecodeInfoKHR* pDecodeInfo,
+                                VkStructureType dpbSlotInfoType)
+{
+    WriteReferenceSlot<DpbSlotInfo>(record, pDecodeInfo->pSetupReferenceSlot, dpbSlotInfoType);
+    record.Write(pDecodeInfo->referenceSlotCount);
+    for (uint32_t i = 0; i < pDecodeInfo->referenceSlotCount; i++) {
+        WriteReferenceSlot<DpbSlotInfo>(record, &pDecodeInfo->pReferenceSlots[i], dpbSlotInfoType);
+    }
+}
+
+template<class DpbSlotInfo, class StdReferenceInfo>
+static bool ReadReferenceSlot(VulkanVideoParserTraceRecord& record, VulkanVideoParserTraceStorage& storage,
+                              VkVideoReferenceSlotInfoKHR* pSlot, VkStructureType dpbSlotInfoType)
+{
+    int32_t slotIndex = -1;
+    record.Read(slotIndex);
+    const StdReferenceInfo* pStdReferenceInfo = record.template ReadPointer<StdReferenceInfo>(storage);
+
+    pSlot->sType = VK_STRUCTURE_TYPE_VIDEO_REFERENCE_SLOT_INFO_KHR;
+    pSlot->pNext = NULL;
+    pSlot->slotIndex = slotIndex;
+    if (pStdReferenceInfo) {
+        DpbSlotInfo* pDpbSlotInfo = (DpbSlotInfo*)storage.Allocate(sizeof(DpbSlotInfo));
+        pDpbSlotInfo->sType = dpbSlotInfoType;
+        pDpbSlotInfo->pStdReferenceInfo = pStdReferenceInfo;
+        pSlot->pNext = pDpbSlotInfo;
+    }
+    return !record.ReadFailed();
+}
+
+static bool WriteAV1PictureInfo(VulkanVideoParserTraceRecord& record, const VkVideoDecodeAV1PictureInfoKHR* pPictureInfo)
+{
+    const StdVideoDecodeAV1PictureInfo* pStdPictureInfo = pPictureInfo->pStdPictureInfo;
+    if (pStdPictureInfo == NULL) {
+        return false;
+    }
+
+    record.Write(pPictureInfo->referenceNameSlotIndices);
+    record.Write(pPictureInfo->frameHeaderOffset);
+    record.WritePointer(pPictureInfo->pTileOffsets, pPictureInfo->tileCount);
+    record.WritePointer(pPictureInfo->pTileSizes, pPictureInfo->tileCount);
+
+    StdVideoDecodeAV1PictureInfo stdPictureInfo = *pStdPictureInfo;
+    stdPictureInfo.pTileInfo = NULL;
+    stdPictureInfo.pQuantization = NULL;
+    stdPictureInfo.pSegmentation = NULL;
+    stdPictureInfo.pLoopFilter = NULL;
+    stdPictureInfo.pCDEF = NULL;
+    stdPictureInfo.pLoopRestoration = NULL;
+    stdPictureInfo.pGlobalMotion = NULL;
+    stdPictureInfo.pFilmGrain = NULL;
+    record.WritePointer(&stdPictureInfo);
+
+    const StdVideoAV1TileInfo* pTileInfo = pStdPictureInfo->pTileInfo;
+    if (pTileInfo) {
+        // The parser keeps up to 64 tile columns and rows
+        const uint32_t maxTileStarts = 64;
+        StdVideoAV1TileInfo tileInfo = *pTileInfo;
+        tileInfo.pMiColStarts = NULL;
+        tileInfo.pMiRowStarts = NULL;
+        tileInfo.pWidthInSbsMinus1 = NULL;
+        tileInfo.pHeightInSbsMinus1 = NULL;
+        record.WritePointer(&tileInfo);
+        record.WritePointer(pTileInfo->pMiColStarts, std::min<uint32_t>(pTileInfo->TileCols + 1, maxTileStarts));
+        record.WritePointer(pTileInfo->pMiRowStarts, std::min<uint32_t>(pTileInfo->TileRows + 1, maxTileStarts));
+        record.WritePointer(pTileInfo->pWidthInSbsMinus1, std::min<uint32_t>(pTileInfo->TileCols, maxTileStarts));
+        record.WritePointer(pTileInfo->pHeightInSbsMinus1, std::min<uint32_t>(pTileInfo->TileRows, maxTileStarts));
+    } else {
+        record.WritePointer(pTileInfo);
+    }
+    record.WritePointer(pStdPictureInfo->pQuantization);
+    record.WritePointer(pStdPictureInfo->pSegmentation);
+    record.WritePointer(pStdPictureInfo->pLoopFilter);
+    record.WritePointer(pStdPictureInfo->pCDEF);
+    record.WritePointer(pStdPictureInfo->pLoopRestoration);
+    record.WritePointer(pStdPictureInfo->pGlobalMotion);
+    record.WritePointer(pStdPictureInfo->pFilmGrain);
+    return true;
+}
+
+static VkVideoDecodeAV1PictureInfoKHR* ReadAV1PictureInfo(VulkanVideoParserTraceRecord& record, VulkanVideoParserTraceStorage& storage)
+{
+    VkVideoDecodeAV1PictureInfoKHR* pPictureInfo = (VkVideoDecodeAV1PictureInfoKHR*)storage.Allocate(sizeof(VkVideoDecodeAV1PictureInfoKHR));
+    pPictureInfo->sType = VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_PICTURE_INFO_KHR;
+    record.Read(pPictureInfo->referenceNameSlotIndices);
+    record.Read(pPictureInfo->frameHeaderOffset);
+    pPictureInfo->pTileOffsets = record.ReadPointer<uint32_t>(storage, &pPictureInfo->tileCount);
+    pPictureInfo->pTileSizes = record.ReadPointer<uint32_t>(storage);
+
+    StdVideoDecodeAV1PictureInfo* pStdPictureInfo = record.ReadPointer<StdVideoDecodeAV1PictureInfo>(storage);
+    if (pStdPictureInfo == NULL) {
+        return NULL;
+    }
+    StdVideoAV1TileInfo* pTileInfo = record.ReadPointer<StdVideoAV1TileInfo>(storage);
+    if (pTileInfo) {
+        pTileInfo->pMiColStarts = record.ReadPointer<uint16_t>(storage);
+        pTileInfo->pMiRowStarts = record.ReadPointer<uint16_t>(storage);
+        pTileInfo->pWidthInSbsMinus1 = record.ReadPointer<uint16_t>(storage);
+        pTileInfo->pHeightInSbsMinus1 = record.ReadPointer<uint16_t>(storage);
+    }
+    pStdPictureInfo->pTileInfo = pTileInfo;
+    pStdPictureInfo->pQuantization = record.ReadPointer<StdVideoAV1Quantization>(storage);
+    pStdPictureInfo->pSegmentation = record.ReadPointer<StdVideoAV1Segmentation>(storage);
+    pStdPictureInfo->pLoopFilter = record.ReadPointer<StdVideoAV1LoopFilter>(storage);
+    pStdPictureInfo->pCDEF = record.ReadPointer<StdVideoAV1CDEF>(storage);
+    pStdPictureInfo->pLoopRestoration = record.ReadPointer<StdVideoAV1LoopRestoration>(storage);
+    pStdPictureInfo->pGlobalMotion = record.ReadPointer<StdVideoAV1GlobalMotion>(storage);
+    pStdPictureInfo->pFilmGrain = record.ReadPointer<StdVideoAV1FilmGrain>(storage);
+    pPictureInfo->pStdPictureInfo = pStdPictureInfo;
+    return pPictureInfo;
+}
+
+/*******************************************************/
+//! \class VulkanVideoParserTraceWriter
+/*******************************************************/
+
+VulkanVideoParserTraceWriter::VulkanVideoParserTraceWriter()
+    : m_file(NULL)
+    , m_codecType(VK_VIDEO_CODEC_OPERATION_NONE_KHR)
+    , m_nextParameterSetTraceId(1)
+    , m_parameterSets()
+{
+}
+
+VulkanVideoParserTraceWriter::~VulkanVideoParserTraceWriter()
+{
+    Close();
+}
+
+VkResult VulkanVideoParserTraceWriter::Open(const char* fileName, VkVideoCodecOperationFlagBitsKHR codecType)
+{
+    Close();
+
+    m_file = fopen(fileName, "wb");
+    if (m_file == NULL) {
+        fprintf(stderr, "\nERROR: Could not create the parser trace file %s\n", fileName);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VulkanVideoParserTraceFileHeader fileHeader = VulkanVideoParserTraceFileHeader();
+    fileHeader.magic = VulkanVideoParserTraceFileHeader::MAGIC;
+    fileHeader.version = VulkanVideoParserTraceFileHeader::VERSION;
+    fileHeader.codec = (uint32_t)codecType;
+    if (fwrite(&fileHeader, sizeof(fileHeader), 1, m_file) != 1) {
+        Close();
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    m_codecType = codecType;
+    m_nextParameterSetTraceId = 1;
+    return VK_SUCCESS;
+}
+
+void VulkanVideoParserTraceWriter::Close()
+{
+    if (m_file) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+    m_parameterSets.clear();
+}
+
+void VulkanVideoParserTraceWriter::WriteRecord(uint32_t recordType, const std::vector<uint8_t>& payload)
+{
+    if (m_file == NULL) {
+        return;
+    }
+
+    VulkanVideoParserTraceRecordHeader recordHeader;
+    recordHeader.recordType = recordType;
+    recordHeader.recordSize = (uint32_t)payload.size();
+    if ((fwrite(&recordHeader, sizeof(recordHeader), 1, m_file) != 1) ||
+        (!payload.empty() && (fwrite(payload.data(), payload.size(), 1, m_file) != 1))) {
+        fprintf(stderr, "\nERROR: Could not write to the parser trace file, the capture stops here\n");
+        Close();
+    }
+}
+
+void VulkanVideoParserTraceWriter::WriteSequence(const VkParserDetectedVideoFormat* pVideoFormat)
+{
+    VulkanVideoParserTraceRecord record;
+    record.Write(*pVideoFormat);
+    WriteRecord(VulkanVideoParserTraceRecordHeader::RECORD_SEQUENCE, record.GetData());
+}
+
+void VulkanVideoParserTraceWriter::WriteParameterSet(VkSharedBaseObj<StdVideoPictureParametersSet>& pictureParametersObject)
+{
+    const StdVideoPictureParametersSet* pParameterSet = pictureParametersObject;
+
+    ParameterSetEntry& entry = m_parameterSets[GetParameterSetKey(pParameterSet)];
+    entry.object = pictureParametersObject;
+    entry.traceId = m_nextParameterSetTraceId++;
+
+    bool isId[3] = { false, false, false };
+    int32_t ids[3];
+    ids[0] = pParameterSet->GetVpsId(isId[0]);
+    ids[1] = pParameterSet->GetSpsId(isId[1]);
+    ids[2] = pParameterSet->GetPpsId(isId[2]);
+    uint32_t idMask = 0;
+    for (uint32_t i = 0; i < 3; i++) {
+        idMask |= (isId[i] ? (1 << i) : 0);
+    }
+
+    VulkanVideoParserTraceRecord record;
+    record.Write(entry.traceId);
+    record.Write((uint32_t)pParameterSet->GetStdType());
+    record.Write(pParameterSet->GetUpdateSequenceCount());
+    record.Write(ids);
+    record.Write(idMask);
+    if (!WriteStdParameterSet(record, pParameterSet)) {
+        assert(!"Unknown parameter set type");
+        return;
+    }
+    WriteRecord(VulkanVideoParserTraceRecordHeader::RECORD_PARAMETER_SET, record.GetData());
+}
+
+uint32_t VulkanVideoParserTraceWriter::GetParameterSetTraceId(const StdVideoPictureParametersSet* pParameterSet)
+{
+    if (pParameterSet == NULL) {
+        return 0;
+    }
+
+    for (std::map<uint32_t, ParameterSetEntry>::const_iterator it = m_parameterSets.begin(); it != m_parameterSets.end(); ++it) {
+        if (it->second.object.Get() == pParameterSet) {
+            return it->second.traceId;
+        }
+    }
+
+    // A parameter set the client was not updated with, record it right before its first use
+    VkSharedBaseObj<StdVideoPictureParametersSet> pictureParametersObject(const_cast<StdVideoPictureParametersSet*>(pParameterSet));
+    WriteParameterSet(pictureParametersObject);
+    return m_parameterSets[GetParameterSetKey(pParameterSet)].traceId;
+}
+
+void VulkanVideoParserTraceWriter::WriteDecodePicture(const VkParserPerFrameDecodeParameters* pPicParams,
+                                                      const VkParserDecodePictureInfo* pDecodePictureInfo)
+{
+    if (pPicParams->useInlinedPictureParameters) {
+        assert(!"The parser trace does not support inlined picture parameters");
+        return;
+    }
+
+    // The parameter set records go first
+    const uint32_t parameterSetIds[3] = { GetParameterSetTraceId(pPicParams->pStdVps),
+                                          GetParameterSetTraceId(pPicParams->pStdSps),
+                                          GetParameterSetTraceId(pPicParams->pStdPps) };
+    if (m_file == NULL) {
+        return;
+    }
+
+    VulkanVideoParserTraceRecord record;
+    record.Write<int32_t>(pPicParams->currPicIdx);
+    record.Write(pPicParams->firstSliceIndex);
+    record.Write(pPicParams->numSlices);
+    record.Write(parameterSetIds);
+    record.Write<int32_t>(pPicParams->numGopReferenceSlots);
+    record.Write(pPicParams->pGopReferenceImagesIndexes);
+
+    VkParserDecodePictureInfo decodePictureInfo = *pDecodePictureInfo;
+    decodePictureInfo.frameSyncinfo.pDebugInterface = NULL;
+    record.Write(decodePictureInfo);
+
+    const VkVideoDecodeInfoKHR* pDecodeInfo = &pPicParams->decodeFrameInfo;
+    bool validPictureInfo = false;
+    if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+        const VkVideoDecodeH264PictureInfoKHR* pPictureInfo = (const VkVideoDecodeH264PictureInfoKHR*)
+                FindChainedStruct(pDecodeInfo->pNext, VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_PICTURE_INFO_KHR);
+        if (pPictureInfo && pPictureInfo->pStdPictureInfo) {
+            WriteStdPictureInfo(record, pPictureInfo->pStdPictureInfo);
+            record.WritePointer(pPictureInfo->pSliceOffsets, pPictureInfo->sliceCount);
+            WriteReferenceSlots<VkVideoDecodeH264DpbSlotInfoKHR>(record, pDecodeInfo, VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_DPB_SLOT_INFO_KHR);
+            validPictureInfo = true;
+        }
+    } else if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        const VkVideoDecodeH265PictureInfoKHR* pPictureInfo = (const VkVideoDecodeH265PictureInfoKHR*)
+                FindChainedStruct(pDecodeInfo->pNext, VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_PICTURE_INFO_KHR);
+        if (pPictureInfo && pPictureInfo->pStdPictureInfo) {
+            record.WritePointer(pPictureInfo->pStdPictureInfo);
+            record.WritePointer(pPictureInfo->pSliceSegmentOffsets, pPictureInfo->sliceSegmentCount);
+            WriteReferenceSlots<VkVideoDecodeH265DpbSlotInfoKHR>(record, pDecodeInfo, VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_DPB_SLOT_INFO_KHR);
+            validPictureInfo = true;
+        }
+    } else if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        const VkVideoDecodeAV1PictureInfoKHR* pPictureInfo = (const VkVideoDecodeAV1PictureInfoKHR*)
+                FindChainedStruct(pDecodeInfo->pNext, VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_PICTURE_INFO_KHR);
+        if (pPictureInfo && WriteAV1PictureInfo(record, pPictureInfo)) {
+            WriteReferenceSlots<VkVideoDecodeAV1DpbSlotInfoKHR>(record, pDecodeInfo, VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_DPB_SLOT_INFO_KHR);
+            validPictureInfo = true;
+        }
+    }
+    if (!validPictureInfo) {
+        assert(!"Missing codec picture info");
+        return;
+    }
+
+    // Only the bitstream range of the picture is kept, the replay uploads it at offset 0
+    VkDeviceSize maxSize = 0;
+    const uint8_t* pBitstreamData = NULL;
+    if (pPicParams->bitstreamData) {
+        pBitstreamData = pPicParams->bitstreamData->GetReadOnlyDataPtr(pPicParams->bitstreamDataOffset, maxSize);
+    }
+    record.WritePointer(pBitstreamData, (uint32_t)std::min<VkDeviceSize>(pPicParams->bitstreamDataLen, maxSize));
+
+    WriteRecord(VulkanVideoParserTraceRecordHeader::RECORD_DECODE, record.GetData());
+}
+
+void VulkanVideoParserTraceWriter::WriteDisplayPicture(int8_t picIdx, const VulkanVideoDisplayPictureInfo* pDispInfo)
+{
+    VulkanVideoParserTraceRecord record;
+    record.Write<int32_t>(picIdx);
+    record.Write(*pDispInfo);
+    WriteRecord(VulkanVideoParserTraceRecordHeader::RECORD_DISPLAY, record.GetData());
+}
+
+/*******************************************************/
+//! \class VulkanVideoTraceParameterSet
+//! Parameter set read back from a trace
+/*******************************************************/
+class VulkanVideoTraceParameterSet : public StdVideoPictureParametersSet {
+public:
+    static const char* m_refClassId;
+
+    VulkanVideoTraceParameterSet(StdType stdType, uint32_t updateSequenceCount)
+        : StdVideoPictureParametersSet(stdType, ::GetParameterType(stdType), m_refClassId, updateSequenceCount)
+        , m_idMask(0)
+        , m_storage()
+        , m_pStdParameterSet(NULL)
+        , client()
+    {
+        m_ids[0] = m_ids[1] = m_ids[2] = -1;
+    }
+
+    virtual ~VulkanVideoTraceParameterSet()
+    {
+        client = nullptr;
+    }
+
+    bool Read(VulkanVideoParserTraceRecord& record)
+    {
+        record.Read(m_ids);
+        record.Read(m_idMask);
+        m_pStdParameterSet = ReadStdParameterSet(record, m_storage, GetStdType());
+        return (m_pStdParameterSet != NULL) && !record.ReadFailed();
+    }
+
+    virtual int32_t GetVpsId(bool& isVps) const { return GetId(0, isVps); }
+    virtual int32_t GetSpsId(bool& isSps) const { return GetId(1, isSps); }
+    virtual int32_t GetPpsId(bool& isPps) const { return GetId(2, isPps); }
+
+    virtual const StdVideoH264SequenceParameterSet* GetStdH264Sps() const
+    {
+        return (GetStdType() == TYPE_H264_SPS) ? (const StdVideoH264SequenceParameterSet*)m_pStdParameterSet : nullptr;
+    }
+    virtual const StdVideoH264PictureParameterSet* GetStdH264Pps() const
+    {
+        return (GetStdType() == TYPE_H264_PPS) ? (const StdVideoH264PictureParameterSet*)m_pStdParameterSet : nullptr;
+    }
+    virtual const StdVideoH265VideoParameterSet* GetStdH265Vps() const
+    {
+        return (GetStdType() == TYPE_H265_VPS) ? (const StdVideoH265VideoParameterSet*)m_pStdParameterSet : nullptr;
+    }
+    virtual const StdVideoH265SequenceParameterSet* GetStdH265Sps() const
+    {
+        return (GetStdType() == TYPE_H265_SPS) ? (const StdVideoH265SequenceParameterSet*)m_pStdParameterSet : nullptr;
+    }
+    virtual const StdVideoH265PictureParameterSet* GetStdH265Pps() const
+    {
+        return (GetStdType() == TYPE_H265_PPS) ? (const StdVideoH265PictureParameterSet*)m_pStdParameterSet : nullptr;
+    }
+    virtual const StdVideoAV1SequenceHeader* GetStdAV1Sps() const
+    {
+        return (GetStdType() == TYPE_AV1_SPS) ? (const StdVideoAV1SequenceHeader*)m_pStdParameterSet : nullptr;
+    }
+
+    virtual const char* GetRefClassId() const { return m_refClassId; }
+
+    virtual bool GetClientObject(VkSharedBaseObj<VkVideoRefCountBase>& clientObject) const
+    {
+        clientObject = client;
+        return !!clientObject;
+    }
+
+private:
+    int32_t GetId(uint32_t index, bool& isId) const
+    {
+        isId = ((m_idMask & (1 << index)) != 0);
+        return m_ids[index];
+    }
+
+    int32_t                        m_ids[3]; // VPS, SPS and PPS ids
+    uint32_t                       m_idMask;
+    VulkanVideoParserTraceStorage  m_storage;
+    const void*                    m_pStdParameterSet;
+
+public:
+    VkSharedBaseObj<VkVideoRefCountBase> client;
+};
+
+const char* VulkanVideoTraceParameterSet::m_refClassId = "VulkanVideoTraceParameterSet";
+
+/*******************************************************/
+//! \class VulkanVideoParserTraceReplayer
+/*******************************************************/
+class VulkanVideoParserTraceReplayer : public IVulkanVideoParser {
+public:
+    enum { MAX_FRM_CNT = 32 };
+
+    VulkanVideoParserTraceReplayer(VkVideoCodecOperationFlagBitsKHR codecType,
+                                   uint32_t bufferOffsetAlignment,
+                                   uint32_t bufferSizeAlignment)
+        : m_refCount(0)
+        , m_file(NULL)
+        , m_decoderHandler()
+        , m_videoFrameBufferCb()
+        , m_codecType(codecType)
+        , m_bufferOffsetAlignment(std::max<uint32_t>(bufferOffsetAlignment, 1))
+        , m_bufferSizeAlignment(std::max<uint32_t>(bufferSizeAlignment, 1))
+        , m_endOfTrace(false)
+        , m_parameterSets()
+        , m_latestParameterSets()
+        , m_record()
+        , m_pictureStorage()
+    {
+        memset(m_pictures, 0, sizeof(m_pictures));
+    }
+
+    VkResult Initialize(const char* fileName,
+                        VkSharedBaseObj<IVulkanVideoDecoderHandler>& decoderHandler,
+                        VkSharedBaseObj<IVulkanVideoFrameBufferParserCb>& videoFrameBufferCb);
+
+    virtual int32_t AddRef() { return ++m_refCount; }
+    virtual int32_t Release()
+    {
+        uint32_t ret = --m_refCount;
+        if (ret == 0) {
+            delete this;
+        }
+        return ret;
+    }
+
+    virtual VkResult ParseVideoData(VkParserSourceDataPacket* pPacket,
+                                    size_t* pParsedBytes,
+                                    bool doPartialParsing = false);
+    virtual VkResult ProbeVideoFormat(VkParserSourceDataPacket* pPacket,
+                                      VkParserDetectedVideoFormat* pVideoFormat,
+                                      size_t* pParsedBytes = NULL);
+    // The trace is replayed from its start
+    virtual VkResult SeekVideoData(const VkParserRandomAccessPoint*, VkParserSourceDataPacket*, size_t*, bool)
+    {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    // The trace already has the parameter sets
+    virtual VkResult SetDecoderConfigurationRecord(const uint8_t*, size_t) { return VK_SUCCESS; }
+    virtual VkResult EnablePipelinedDecode(uint32_t) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+    virtual void GetPipelineStats(VulkanVideoParserPipelineStats* pStats) { memset(pStats, 0, sizeof(*pStats)); }
+    virtual VkResult EnableTraceCapture(const char*) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+    virtual VkResult SetDecodeFilter(uint32_t) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+    virtual VkResult SetMaxTemporalLayer(uint32_t) { return VK_ERROR_FEATURE_NOT_PRESENT; }
+    virtual void GetTemporalLayerStats(VkParserTemporalLayerStats* pStats) { memset(pStats, 0, sizeof(*pStats)); }
+    virtual VkResult EnableLowLatencyOutput() { return VK_ERROR_FEATURE_NOT_PRESENT; }
+    virtual void GetDisplayLatencyStats(VulkanVideoParserLatencyStats* pStats) { memset(pStats, 0, sizeof(*pStats)); }
+    // The trace does not depend on how the input was split
+    virtual VkResult EnableStreamingInput() { return VK_SUCCESS; }
+    virtual VkResult EnableAv1AnnexBInput() { return VK_SUCCESS; }
+
+private:
+    virtual ~VulkanVideoParserTraceReplayer() { Deinitialize(); }
+    void Deinitialize();
+
+    bool ReadRecord(uint32_t& recordType);
+    bool ReplayRecord(uint32_t recordType);
+    bool ReplaySequence();
+    bool ReplayParameterSet();
+    bool ReplayDecodePicture();
+    bool ReplayDisplayPicture();
+    vkPicBuffBase* GetPicture(int32_t tracePicIdx);
+
+    std::atomic<int32_t>                             m_refCount;
+    FILE*                                            m_file;
+    VkSharedBaseObj<IVulkanVideoDecoderHandler>      m_decoderHandler;
+    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb> m_videoFrameBufferCb;
+    VkVideoCodecOperationFlagBitsKHR                 m_codecType;
+    uint32_t                                         m_bufferOffsetAlignment;
+    uint32_t                                         m_bufferSizeAlignment;
+    bool                                             m_endOfTrace;
+    // Trace id to parameter set, and the trace id of the latest one of each type and id
+    std::map<uint32_t, VkSharedBaseObj<VulkanVideoTraceParameterSet>> m_parameterSets;
+    std::map<uint32_t, uint32_t>                     m_latestParameterSets;
+    VulkanVideoParserTraceRecord                     m_record;
+    VulkanVideoParserTraceStorage                    m_pictureStorage;
+    // Captured picture index to the picture reserved for it in this run
+    vkPicBuffBase*                                   m_pictures[MAX_FRM_CNT];
+};
+
+VkResult VulkanVideoParserTraceReplayer::Initialize(const char* fileName,
+                                                    VkSharedBaseObj<IVulkanVideoDecoderHandler>& decoderHandler,
+                                                    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb>& videoFrameBufferCb)
+{
+    m_file = fopen(fileName, "rb");
+    if (m_file == NULL) {
+        fprintf(stderr, "\nERROR: Could not open the parser trace file %s\n", fileName);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VulkanVideoParserTraceFileHeader fileHeader;
+    if ((fread(&fileHeader, sizeof(fileHeader), 1, m_file) != 1) ||
+            (fileHeader.magic != VulkanVideoParserTraceFileHeader::MAGIC) ||
+            (fileHeader.version != VulkanVideoParserTraceFileHeader::VERSION)) {
+        fprintf(stderr, "\nERROR: %s is not a parser trace file of version %d\n", fileName,
+                VulkanVideoParserTraceFileHeader::VERSION);
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (fileHeader.codec != (uint32_t)m_codecType) {
+        fprintf(stderr, "\nERROR: The parser trace %s was captured with the codec 0x%x, not 0x%x\n", fileName,
+                fileHeader.codec, (uint32_t)m_codecType);
+        return VK_ERROR_VIDEO_PROFILE_CODEC_NOT_SUPPORTED_KHR;
+    }
+
+    m_decoderHandler = decoderHandler;
+    m_videoFrameBufferCb = videoFrameBufferCb;
+    return VK_SUCCESS;
+}
+
+void VulkanVideoParserTraceReplayer::Deinitialize()
+{
+    for (uint32_t i = 0; i < MAX_FRM_CNT; i++) {
+        if (m_pictures[i]) {
+            m_pictures[i]->Release();
+            m_pictures[i] = NULL;
+        }
+    }
+    m_parameterSets.clear();
+    m_latestParameterSets.clear();
+    if (m_file) {
+        fclose(m_file);
+        m_file = NULL;
+    }
+    m_decoderHandler = nullptr;
+    m_videoFrameBufferCb = nullptr;
+}
+
+bool VulkanVideoParserTraceReplayer::ReadRecord(uint32_t& recordType)
+{
+    VulkanVideoParserTraceRecordHeader recordHeader;
+    if (fread(&recordHeader, sizeof(recordHeader), 1, m_file) != 1) {
+        return false;
+    }
+
+    m_record.Reset();
+    std::vector<uint8_t>& data = m_record.GetData();
+    data.resize(recordHeader.recordSize);
+    if (!data.empty() && (fread(data.data(), data.size(), 1, m_file) != 1)) {
+        fprintf(stderr, "\nERROR: The parser trace is truncated\n");
+        return false;
+    }
+    recordType = recordHeader.recordType;
+    return true;
+}
+
+VkResult VulkanVideoParserTraceReplayer::ParseVideoData(VkParserSourceDataPacket* pPacket,
+                                                        size_t* pParsedBytes,
+                                                        bool)
+{
+    if (pParsedBytes) {
+        *pParsedBytes = pPacket->payload_size;
+    }
+
+    // One displayed picture per packet, everything left at the end of the stream
+    const bool endOfStream = !!(pPacket->flags & VK_PARSER_PKT_ENDOFSTREAM);
+    while (!m_endOfTrace) {
+        uint32_t recordType = 0;
+        if (!ReadRecord(recordType)) {
+            m_endOfTrace = true;
+            break;
+        }
+        if (!ReplayRecord(recordType)) {
+            fprintf(stderr, "\nERROR: Could not replay the parser trace record of type %d\n", recordType);
+            m_endOfTrace = true;
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        if ((recordType == VulkanVideoParserTraceRecordHeader::RECORD_DISPLAY) && !endOfStream) {
+            break;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+VkResult VulkanVideoParserTraceReplayer::ProbeVideoFormat(VkParserSourceDataPacket*,
+                                                          VkParserDetectedVideoFormat* pVideoFormat,
+                                                          size_t* pParsedBytes)
+{
+    if (pParsedBytes) {
+        *pParsedBytes = 0;
+    }
+
+    // The first sequence of the trace, the file position is restored for the replay
+    const long startPosition = ftell(m_file);
+    VkResult result = VK_NOT_READY;
+    uint32_t recordType = 0;
+    while (ReadRecord(recordType)) {
+        if (recordType == VulkanVideoParserTraceRecordHeader::RECORD_SEQUENCE) {
+            if (m_record.Read(*pVideoFormat)) {
+                result = VK_SUCCESS;
+            }
+            break;
+        }
+    }
+    fseek(m_file, startPosition, SEEK_SET);
+    return result;
+}
+
+bool VulkanVideoParserTraceReplayer::ReplayRecord(uint32_t recordType)
+{
+    switch (recordType) {
+    case VulkanVideoParserTraceRecordHeader::RECORD_SEQUENCE:
+        return ReplaySequence();
+    case VulkanVideoParserTraceRecordHeader::RECORD_PARAMETER_SET:
+        return ReplayParameterSet();
+    case VulkanVideoParserTraceRecordHeader::RECORD_DECODE:
+        return ReplayDecodePicture();
+    case VulkanVideoParserTraceRecordHeader::RECORD_DISPLAY:
+        return ReplayDisplayPicture();
+    default:
+        // Unknown records are skipped
+        return true;
+    }
+}
+
+bool VulkanVideoParserTraceReplayer::ReplaySequence()
+{
+    VkParserDetectedVideoFormat videoFormat;
+    if (!m_record.Read(videoFormat)) {
+        return false;
+    }
+    return (m_decoderHandler->StartVideoSequence(&videoFormat) > 0);
+}
+
+bool VulkanVideoParserTraceReplayer::ReplayParameterSet()
+{
+    uint32_t traceId = 0;
+    uint32_t stdType = 0;
+    uint32_t updateSequenceCount = 0;
+    m_record.Read(traceId);
+    m_record.Read(stdType);
+    m_record.Read(updateSequenceCount);
+    if (m_record.ReadFailed() || (stdType > StdVideoPictureParametersSet::TYPE_AV1_SPS)) {
+        return false;
+    }
+
+    VkSharedBaseObj<VulkanVideoTraceParameterSet> parameterSet(
+            new VulkanVideoTraceParameterSet((StdVideoPictureParametersSet::StdType)stdType, updateSequenceCount));
+    if (!parameterSet || !parameterSet->Read(m_record)) {
+        return false;
+    }
+
+    // The parameter set it replaces can no longer be referred to
+    uint32_t& latestTraceId = m_latestParameterSets[GetParameterSetKey(parameterSet)];
+    m_parameterSets.erase(latestTraceId);
+    latestTraceId = traceId;
+    m_parameterSets[traceId] = parameterSet;
+
+    VkSharedBaseObj<StdVideoPictureParametersSet> pictureParametersObject(parameterSet);
+    return m_decoderHandler->UpdatePictureParameters(pictureParametersObject, parameterSet->client);
+}
+
+vkPicBuffBase* VulkanVideoParserTraceReplayer::GetPicture(int32_t tracePicIdx)
+{
+    if ((tracePicIdx < 0) || (tracePicIdx >= MAX_FRM_CNT)) {
+        return NULL;
+    }
+    return m_pictures[tracePicIdx];
+}
+
+bool VulkanVideoParserTraceReplayer::ReplayDecodePicture()
+{
+    VkParserPerFrameDecodeParameters pictureParams = VkParserPerFrameDecodeParameters();
+    VkParserDecodePictureInfo decodePictureInfo = VkParserDecodePictureInfo();
+    VkVideoReferenceSlotInfoKHR referenceSlots[VkParserPerFrameDecodeParameters::MAX_DPB_REF_AND_SETUP_SLOTS];
+    VkVideoReferenceSlotInfoKHR setupReferenceSlot;
+    int32_t currPicIdx = -1;
+    int32_t numGopReferenceSlots = 0;
+    uint32_t parameterSetIds[3] = { 0, 0, 0 };
+
+    m_pictureStorage.Reset();
+    m_record.Read(currPicIdx);
+    m_record.Read(pictureParams.firstSliceIndex);
+    m_record.Read(pictureParams.numSlices);
+    m_record.Read(parameterSetIds);
+    m_record.Read(numGopReferenceSlots);
+    m_record.Read(pictureParams.pGopReferenceImagesIndexes);
+    m_record.Read(decodePictureInfo);
+    if (m_record.ReadFailed() || (currPicIdx < 0) || (currPicIdx >= MAX_FRM_CNT) ||
+            (numGopReferenceSlots < 0) || (numGopReferenceSlots > VkParserPerFrameDecodeParameters::MAX_DPB_REF_SLOTS)) {
+        return false;
+    }
+
+    const StdVideoPictureParametersSet** ppStdParameterSets[3] = { &pictureParams.pStdVps, &pictureParams.pStdSps, &pictureParams.pStdPps };
+    for (uint32_t i = 0; i < 3; i++) {
+        if (parameterSetIds[i] != 0) {
+            std::map<uint32_t, VkSharedBaseObj<VulkanVideoTraceParameterSet>>::iterator it = m_parameterSets.find(parameterSetIds[i]);
+            if (it == m_parameterSets.end()) {
+                return false;
+            }
+            *ppStdParameterSets[i] = it->second;
+        }
+    }
+
+    // The codec picture info and the reference slots, laid out as VulkanVideoParser does
+    VkVideoDecodeInfoKHR& decodeInfo = pictureParams.decodeFrameInfo;
+    uint32_t referenceSlotCount = 0;
+    bool validReferenceSlots = true;
+    if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H264_BIT_KHR) {
+        VkVideoDecodeH264PictureInfoKHR* pPictureInfo = (VkVideoDecodeH264PictureInfoKHR*)m_pictureStorage.Allocate(sizeof(VkVideoDecodeH264PictureInfoKHR));
+        pPictureInfo->sType = VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_PICTURE_INFO_KHR;
+        pPictureInfo->pStdPictureInfo = m_record.ReadPointer<StdVideoDecodeH264PictureInfo>(m_pictureStorage);
+        pPictureInfo->pSliceOffsets = m_record.ReadPointer<uint32_t>(m_pictureStorage, &pPictureInfo->sliceCount);
+        decodeInfo.pNext = pPictureInfo;
+        validReferenceSlots = ReadReferenceSlot<VkVideoDecodeH264DpbSlotInfoKHR, StdVideoDecodeH264ReferenceInfo>(
+                m_record, m_pictureStorage, &setupReferenceSlot, VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_DPB_SLOT_INFO_KHR);
+        m_record.Read(referenceSlotCount);
+        for (uint32_t i = 0; validReferenceSlots && (i < referenceSlotCount) && (i < ARRAYSIZE(referenceSlots)); i++) {
+            validReferenceSlots = ReadReferenceSlot<VkVideoDecodeH264DpbSlotInfoKHR, StdVideoDecodeH264ReferenceInfo>(
+                    m_record, m_pictureStorage, &referenceSlots[i], VK_STRUCTURE_TYPE_VIDEO_DECODE_H264_DPB_SLOT_INFO_KHR);
+        }
+    } else if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_H265_BIT_KHR) {
+        VkVideoDecodeH265PictureInfoKHR* pPictureInfo = (VkVideoDecodeH265PictureInfoKHR*)m_pictureStorage.Allocate(sizeof(VkVideoDecodeH265PictureInfoKHR));
+        pPictureInfo->sType = VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_PICTURE_INFO_KHR;
+        pPictureInfo->pStdPictureInfo = m_record.ReadPointer<StdVideoDecodeH265PictureInfo>(m_pictureStorage);
+        pPictureInfo->pSliceSegmentOffsets = m_record.ReadPointer<uint32_t>(m_pictureStorage, &pPictureInfo->sliceSegmentCount);
+        decodeInfo.pNext = pPictureInfo;
+        validReferenceSlots = ReadReferenceSlot<VkVideoDecodeH265DpbSlotInfoKHR, StdVideoDecodeH265ReferenceInfo>(
+                m_record, m_pictureStorage, &setupReferenceSlot, VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_DPB_SLOT_INFO_KHR);
+        m_record.Read(referenceSlotCount);
+        for (uint32_t i = 0; validReferenceSlots && (i < referenceSlotCount) && (i < ARRAYSIZE(referenceSlots)); i++) {
+            validReferenceSlots = ReadReferenceSlot<VkVideoDecodeH265DpbSlotInfoKHR, StdVideoDecodeH265ReferenceInfo>(
+                    m_record, m_pictureStorage, &referenceSlots[i], VK_STRUCTURE_TYPE_VIDEO_DECODE_H265_DPB_SLOT_INFO_KHR);
+        }
+    } else if (m_codecType == VK_VIDEO_CODEC_OPERATION_DECODE_AV1_BIT_KHR) {
+        decodeInfo.pNext = ReadAV1PictureInfo(m_record, m_pictureStorage);
+        validReferenceSlots = ReadReferenceSlot<VkVideoDecodeAV1DpbSlotInfoKHR, StdVideoDecodeAV1ReferenceInfo>(
+                m_record, m_pictureStorage, &setupReferenceSlot, VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_DPB_SLOT_INFO_KHR);
+        m_record.Read(referenceSlotCount);
+        for (uint32_t i = 0; validReferenceSlots && (i < referenceSlotCount) && (i < ARRAYSIZE(referenceSlots)); i++) {
+            validReferenceSlots = ReadReferenceSlot<VkVideoDecodeAV1DpbSlotInfoKHR, StdVideoDecodeAV1ReferenceInfo>(
+                    m_record, m_pictureStorage, &referenceSlots[i], VK_STRUCTURE_TYPE_VIDEO_DECODE_AV1_DPB_SLOT_INFO_KHR);
+        }
+    }
+    if ((decodeInfo.pNext == NULL) || !validReferenceSlots || (referenceSlotCount > ARRAYSIZE(referenceSlots))) {
+        return false;
+    }
+
+    uint32_t bitstreamDataLen = 0;
+    const uint8_t* pBitstreamData = m_record.ReadPointer<uint8_t>(m_pictureStorage, &bitstreamDataLen);
+    if (m_record.ReadFailed()) {
+        return false;
+    }
+
+    // A new picture of the captured run, unless this is the second field of the current one
+    vkPicBuffBase* pPicBuf = m_pictures[currPicIdx];
+    if (!(pPicBuf && decodePictureInfo.flags.fieldPic && decodePictureInfo.flags.secondField)) {
+        if (pPicBuf) {
+            pPicBuf->Release();
+        }
+        pPicBuf = m_videoFrameBufferCb->ReservePictureBuffer();
+        m_pictures[currPicIdx] = pPicBuf;
+        if (pPicBuf == NULL) {
+            return false;
+        }
+    }
+    pictureParams.currPicIdx = pPicBuf->m_picIdx;
+    decodePictureInfo.pictureIndex = pPicBuf->m_picIdx;
+    for (int32_t i = 0; i < numGopReferenceSlots; i++) {
+        vkPicBuffBase* pReferencePicBuf = GetPicture(pictureParams.pGopReferenceImagesIndexes[i]);
+        assert(pReferencePicBuf || (pictureParams.pGopReferenceImagesIndexes[i] < 0));
+        pictureParams.pGopReferenceImagesIndexes[i] = pReferencePicBuf ? (int8_t)pReferencePicBuf->m_picIdx : -1;
+    }
+
+    const VkDeviceSize bufferSize = ((std::max<VkDeviceSize>(bitstreamDataLen, 1) + m_bufferSizeAlignment - 1) /
+                                     m_bufferSizeAlignment) * m_bufferSizeAlignment;
+    VkDeviceSize allocatedSize = m_decoderHandler->GetBitstreamBuffer(bufferSize,
+                                                                      m_bufferOffsetAlignment,
+                                                                      m_bufferSizeAlignment,
+                                                                      pBitstreamData,
+                                                                      bitstreamDataLen,
+                                                                      pictureParams.bitstreamData);
+    if (!pictureParams.bitstreamData || (allocatedSize == 0)) {
+        return false;
+    }
+    if (pictureParams.bitstreamData->GetMaxSize() < bufferSize) {
+        // A smaller buffer from the pool of the decoder
+        pictureParams.bitstreamData->Resize(bufferSize);
+        pictureParams.bitstreamData->CopyDataFromBuffer(pBitstreamData, 0, 0, bitstreamDataLen);
+    }
+    pictureParams.bitstreamDataOffset = 0;
+    pictureParams.bitstreamDataLen = bitstreamDataLen;
+
+    decodeInfo.sType = VK_STRUCTURE_TYPE_VIDEO_DECODE_INFO_KHR;
+    decodeInfo.dstPictureResource.sType = VK_STRUCTURE_TYPE_VIDEO_PICTURE_RESOURCE_INFO_KHR;
+    pictureParams.dpbSetupPictureResource.sType = VK_STRUCTURE_TYPE_VIDEO_PICTURE_RESOURCE_INFO_KHR;
+    if (setupReferenceSlot.slotIndex >= 0) {
+        setupReferenceSlot.pPictureResource = &pictureParams.dpbSetupPictureResource;
+        decodeInfo.pSetupReferenceSlot = &setupReferenceSlot;
+    }
+    for (uint32_t i = 0; i < referenceSlotCount; i++) {
+        pictureParams.pictureResources[i].sType = VK_STRUCTURE_TYPE_VIDEO_PICTURE_RESOURCE_INFO_KHR;
+        referenceSlots[i].pPictureResource = &pictureParams.pictureResources[i];
+    }
+    decodeInfo.pReferenceSlots = (referenceSlotCount != 0) ? referenceSlots : NULL;
+    decodeInfo.referenceSlotCount = referenceSlotCount;
+    pictureParams.numGopReferenceSlots = numGopReferenceSlots;
+
+    return (m_decoderHandler->DecodePictureWithParameters(&pictureParams, &decodePictureInfo) >= 0);
+}
+
+bool VulkanVideoParserTraceReplayer::ReplayDisplayPicture()
+{
+    int32_t tracePicIdx = -1;
+    VulkanVideoDisplayPictureInfo dispInfo = VulkanVideoDisplayPictureInfo();
+    m_record.Read(tracePicIdx);
+    m_record.Read(dispInfo);
+
+    vkPicBuffBase* pPicBuf = GetPicture(tracePicIdx);
+    if (m_record.ReadFailed() || (pPicBuf == NULL)) {
+        return false;
+    }
+    const int32_t picIdx = pPicBuf->m_picIdx;
+    return (m_videoFrameBufferCb->QueueDecodedPictureForDisplay((int8_t)picIdx, &dispInfo) == picIdx);
+}
+
+VkResult vulkanCreateVideoParserTraceReplayer(
+    const char* fileName,
+    VkSharedBaseObj<IVulkanVideoDecoderHandler>& decoderHandler,
+    VkSharedBaseObj<IVulkanVideoFrameBufferParserCb>& videoFrameBufferCb,
+    VkVideoCodecOperationFlagBitsKHR videoCodecOperation,
+    uint32_t bufferOffsetAlignment,
+    uint32_t bufferSizeAlignment,
+    VkSharedBaseObj<IVulkanVideoParser>& vulkanVideoParser)
+{
+    if (!decoderHandler || !videoFrameBufferCb) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkSharedBaseObj<VulkanVideoParserTraceReplayer> traceReplayer(
+            new VulkanVideoParserTraceReplayer(videoCodecOperation, bufferOffsetAlignment, bufferSizeAlignment));
+    if (!traceReplayer) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkResult result = traceReplayer->Initialize(fileName, decoderHandler, videoFrameBufferCb);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    vulkanVideoParser = traceReplayer;
+    return VK_SUCCESS;
+}